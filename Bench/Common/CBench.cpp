@@ -0,0 +1,275 @@
+/** @file
+ ** @brief The CBench implementation.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CAllocationCounter.h"
+#include "CBench.h"
+
+namespace ILUBench {
+   using ILUDemo::CAllocationCounter;
+
+   /** Constructor.
+    **
+    ** Command line: [scale], where scale multiplies the number of
+    ** iterations of every case (e.g. 0.1 for a quick run).
+    **
+    ** The hardware counters are opened unless the environment variable
+    ** BENCH_PERF_COUNTERS is "no" (opening them costs nothing when they
+    ** are not available).
+    **/
+   CBench::CBench(
+      const char* szBenchmark, //< Name of the benchmark in the report.
+      const char* szOperation, //< What 1 operation is, e.g. "event" (all results are per operation).
+      int         argc,        //< Command line argument count.
+      char*       argv[]       //< Command line arguments.
+      )
+      : m_strBenchmark(szBenchmark)
+      , m_strOperation(szOperation)
+      , m_Scale       (1.0)
+      , m_Results     ()
+      , m_Failures    ()
+      , m_Start       ()
+      , m_StartCount  (0)
+      , m_StartBytes  (0)
+      , m_StartStats  ()
+   {
+      const char* const szPerf(getenv("BENCH_PERF_COUNTERS"));
+      const bool        bPerf (NULL == szPerf || 0 != strcmp(szPerf, "no"));
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         m_Counters[i] = bPerf ? new CPerfCounter(static_cast<CPerfCounter::ECounter>(i)) : NULL;
+      }
+      if(1 < argc) {
+         m_Scale = atof(argv[1]);
+      }
+      if(m_Scale <= 0) {
+         fprintf(stderr, "usage: %s [scale]\n", argv[0]);
+         m_Scale = 1.0;
+      }
+   }
+
+   /** Destructor: closes the hardware counters.
+    **/
+   CBench::~CBench(void)
+   {
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         delete m_Counters[i];
+      }
+   }
+
+   /** Scale a number of iterations as requested on the command line.
+    **
+    ** @return the number of iterations to run, at least 1.
+    **/
+   unsigned int CBench::GetIterations(
+      const unsigned int iterations //< Default number of iterations.
+      ) const
+   {
+      const unsigned int scaled(static_cast<unsigned int>(iterations * m_Scale));
+      return 0 == scaled ? 1 : scaled;
+   }
+
+   /** Get the number of times Run calls the operation, including the
+    ** calls before measuring.
+    **
+    ** @return the number of calls.
+    **/
+   unsigned int CBench::GetCalls(
+      const unsigned int iterations //< Number of iterations measured.
+      )
+   {
+      return iterations + iterations / 10 + 1;
+   }
+
+   /** Mark a case as failed (e.g. the state machine did not call the
+    ** expected handlers). The report still contains all results, but
+    ** Report returns an error.
+    **/
+   void CBench::Fail(
+      const char* szCase,  //< Name of the case.
+      const char* szReason //< What went wrong.
+      )
+   {
+      fprintf(stderr, "%s: case [%s] failed: %s\n", m_strBenchmark.c_str(), szCase, szReason);
+      m_Failures.push_back(std::string(szCase) + ": " + szReason);
+   }
+
+   /** Write the JSON report to stdout.
+    **
+    ** @return 0 when all cases succeeded, 1 otherwise (to be used as exit code).
+    **/
+   int CBench::Report(void) const
+   {
+      printf("{\n");
+      printf("   \"benchmark\": \"%s\",\n", m_strBenchmark.c_str());
+      printf("   \"operation\": \"%s\",\n", m_strOperation.c_str());
+#ifdef __OPTIMIZE__
+      printf("   \"optimized\": true,\n");
+#else
+      printf("   \"optimized\": false,\n");
+#endif
+      bool bPerf(false);
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         bPerf |= (NULL != m_Counters[i]) && m_Counters[i]->IsAvailable();
+      }
+      printf("   \"perf_counters\": %s,\n", bPerf ? "true" : "false");
+      printf("   \"results\": [");
+      for(std::vector<SResult>::const_iterator cit = m_Results.begin() ; m_Results.end() != cit ; ++cit) {
+         printf("%s\n      {\"case\": \"%s\", \"operation\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.2f, ", m_Results.begin() == cit ? "" : ",", cit->m_strCase.c_str(), cit->m_strOperation.c_str(), cit->m_Iterations, cit->m_Ns);
+         for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+            if(0 <= cit->m_Counters[i]) {
+               printf("\"%s_per_op\": %.2f, ", CPerfCounter::GetName(static_cast<CPerfCounter::ECounter>(i)), cit->m_Counters[i]);
+            } else {
+               printf("\"%s_per_op\": null, ", CPerfCounter::GetName(static_cast<CPerfCounter::ECounter>(i)));
+            }
+         }
+         printf("\"allocations_per_op\": %.2f, \"bytes_per_op\": %.1f", cit->m_Allocations, cit->m_Bytes);
+         for(std::vector<SMetric>::const_iterator citMetric = cit->m_Metrics.begin() ; cit->m_Metrics.end() != citMetric ; ++citMetric) {
+            if(citMetric->m_bAvailable) {
+               printf(", \"%s\": %.6g", citMetric->m_strName.c_str(), citMetric->m_Value);
+            } else {
+               printf(", \"%s\": null", citMetric->m_strName.c_str());
+            }
+         }
+         printf("}");
+      }
+      printf("\n   ],\n");
+      printf("   \"failures\": %u\n", static_cast<unsigned int>(m_Failures.size()));
+      printf("}\n");
+      return m_Failures.empty() ? 0 : 1;
+   }
+
+   /** Start measuring a case.
+    **/
+   void CBench::Start(void)
+   {
+      m_StartCount = CAllocationCounter::GetCount();
+      m_StartBytes = CAllocationCounter::GetBytes();
+      m_StartStats = ILULibStateMachine::CAllocationStats::GetThreadTotals();
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         if(NULL != m_Counters[i]) {
+            m_Counters[i]->Start();
+         }
+      }
+      m_Start      = std::chrono::steady_clock::now();
+   }
+
+   /** Stop measuring a case and store its result per operation.
+    **/
+   void CBench::Stop(
+      const char*        szCase,     //< Name of the case.
+      const unsigned int iterations, //< Number of operations measured.
+      const char*        szOperation //< What 1 operation is in this case, NULL for the operation of the benchmark.
+      )
+   {
+      const std::chrono::steady_clock::time_point stop(std::chrono::steady_clock::now());
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         if(NULL != m_Counters[i]) {
+            m_Counters[i]->Stop();
+         }
+      }
+      const unsigned long long count(CAllocationCounter::GetCount() - m_StartCount);
+      const unsigned long long bytes(CAllocationCounter::GetBytes() - m_StartBytes);
+
+      SResult result;
+      result.m_strCase      = szCase;
+      result.m_strOperation = NULL == szOperation ? m_strOperation : szOperation;
+      result.m_Iterations   = iterations;
+      result.m_Ns           = std::chrono::duration<double, std::nano>(stop - m_Start).count() / iterations;
+      for(unsigned int i = 0 ; i < CPerfCounter::ECounterCount ; ++i) {
+         result.m_Counters[i] = (NULL != m_Counters[i]) && m_Counters[i]->IsAvailable() ? static_cast<double>(m_Counters[i]->Read()) / iterations : -1.0;
+      }
+      result.m_Allocations  = static_cast<double>(count) / iterations;
+      result.m_Bytes        = static_cast<double>(bytes) / iterations;
+      if(ILULibStateMachine::CAllocationStats::IsEnabled()) {
+         const ILULibStateMachine::CAllocationStats& stats(ILULibStateMachine::CAllocationStats::GetThreadTotals());
+         for(unsigned int i = 0 ; i < ILULibStateMachine::EAllocationCount ; ++i) {
+            const ILULibStateMachine::EAllocation category(static_cast<ILULibStateMachine::EAllocation>(i));
+            const std::string strName(std::string("allocations_") + ILULibStateMachine::CAllocationStats::GetName(category) + "_per_op");
+            SMetric metric;
+            metric.m_strName    = strName;
+            metric.m_Value      = static_cast<double>(stats.GetCount(category) - m_StartStats.GetCount(category)) / iterations;
+            metric.m_bAvailable = true;
+            result.m_Metrics.push_back(metric);
+         }
+      }
+      m_Results.push_back(result);
+   }
+
+   /** Add a case specific metric (e.g. resident memory per state machine)
+    ** to the result of the last case stopped.
+    **/
+   void CBench::AddMetric(
+      const char*  szName, //< Name of the metric in the report.
+      const double value,     //< Value of the metric, reported as is (also when negative).
+      const bool   bAvailable //< False when the value could not be determined: reported as null.
+      )
+   {
+      if(m_Results.empty()) {
+         return;
+      }
+      SMetric metric;
+      metric.m_strName    = szName;
+      metric.m_Value      = value;
+      metric.m_bAvailable = bAvailable;
+      m_Results.back().m_Metrics.push_back(metric);
+   }
+
+   /** Get the throughput of the last case stopped.
+    **
+    ** @return the number of operations per second, negative when no case has been stopped yet.
+    **/
+   double CBench::GetOpsPerSecond(void) const
+   {
+      if(m_Results.empty() || (0 >= m_Results.back().m_Ns)) {
+         return -1.0;
+      }
+      return 1e9 / m_Results.back().m_Ns;
+   }
+
+   /** Get a hardware counter of the last case stopped.
+    **
+    ** @return the count per operation, negative when the counter is not available or no case has been stopped yet.
+    **/
+   double CBench::GetCounterPerOp(
+      const CPerfCounter::ECounter counter //< The counter.
+      ) const
+   {
+      if(m_Results.empty() || (CPerfCounter::ECounterCount <= counter)) {
+         return -1.0;
+      }
+      return m_Results.back().m_Counters[counter];
+   }
+
+   /** Get the heap allocations of the last case stopped.
+    **
+    ** @return the number of allocations per operation, negative when no case has been stopped yet.
+    **/
+   double CBench::GetAllocationsPerOp(void) const
+   {
+      if(m_Results.empty()) {
+         return -1.0;
+      }
+      return m_Results.back().m_Allocations;
+   }
+}
@@ -0,0 +1,146 @@
+/** @file
+ ** @brief The CPerfCounter implementation.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#include "CPerfCounter.h"
+
+namespace ILUBench {
+   /** Constructor: opens the counter for the calling thread, on any CPU,
+    ** user space only. The counter is not running yet.
+    **/
+   CPerfCounter::CPerfCounter(
+      const ECounter counter //< The counter to open.
+      )
+      : m_Fd(-1)
+   {
+#if defined(__linux__)
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type           = PERF_TYPE_HARDWARE;
+      attr.size           = sizeof(attr);
+      switch(counter) {
+         case ECounterCycles:          attr.config = PERF_COUNT_HW_CPU_CYCLES;       break;
+         case ECounterInstructions:    attr.config = PERF_COUNT_HW_INSTRUCTIONS;     break;
+         case ECounterL1dMisses:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+         case ECounterCacheReferences: attr.config = PERF_COUNT_HW_CACHE_REFERENCES; break;
+         case ECounterCacheMisses:     attr.config = PERF_COUNT_HW_CACHE_MISSES;     break;
+         case ECounterBranchMisses:    attr.config = PERF_COUNT_HW_BRANCH_MISSES;    break;
+         default:                      return;
+      }
+      attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.disabled       = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      m_Fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+      (void)counter;
+#endif
+   }
+
+   /** Destructor: closes the counter.
+    **/
+   CPerfCounter::~CPerfCounter(void)
+   {
+#if defined(__linux__)
+      if(0 <= m_Fd) {
+         close(m_Fd);
+      }
+#endif
+   }
+
+   /** Get the name of a counter (e.g. for reports).
+    **
+    ** @return the name.
+    **/
+   const char* CPerfCounter::GetName(
+      const ECounter counter //< The counter.
+      )
+   {
+      switch(counter) {
+         case ECounterCycles:          return "cycles";
+         case ECounterInstructions:    return "instructions";
+         case ECounterL1dMisses:       return "l1d_misses";
+         case ECounterCacheReferences: return "llc_references";
+         case ECounterCacheMisses:     return "llc_misses";
+         case ECounterBranchMisses:    return "branch_misses";
+         default:                      return "unknown";
+      }
+   }
+
+   /** Indicates whether the counter could be opened.
+    **
+    ** @return true when the counter is available.
+    **/
+   bool CPerfCounter::IsAvailable(void) const
+   {
+      return 0 <= m_Fd;
+   }
+
+   /** Reset the counter and start counting.
+    **/
+   void CPerfCounter::Start(void)
+   {
+#if defined(__linux__)
+      if(0 <= m_Fd) {
+         ioctl(m_Fd, PERF_EVENT_IOC_RESET,  0);
+         ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+   }
+
+   /** Stop counting.
+    **/
+   void CPerfCounter::Stop(void)
+   {
+#if defined(__linux__)
+      if(0 <= m_Fd) {
+         ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+      }
+#endif
+   }
+
+   /** Read the counter.
+    **
+    ** @return the count between the last Start and Stop, 0 when not available
+    ** or when the counter never got a hardware register.
+    **/
+   uint64_t CPerfCounter::Read(void) const
+   {
+      uint64_t count(0);
+#if defined(__linux__)
+      uint64_t values[3] = {0, 0, 0}; //value, time enabled, time running
+      if((0 <= m_Fd) && (static_cast<ssize_t>(sizeof(values)) == read(m_Fd, values, sizeof(values))) && (0 != values[2])) {
+         count = values[2] == values[1] ? values[0] : static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+      }
+#endif
+      return count;
+   }
+}
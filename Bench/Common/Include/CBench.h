@@ -0,0 +1,117 @@
+/** @file
+ ** @brief The CBench declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILUBench_CBench__H__
+#define __ILUBench_CBench__H__
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CAllocationStats.h"
+
+#include "CPerfCounter.h"
+
+namespace ILUBench {
+   /** @brief Runs the cases of 1 benchmark and reports them as JSON.
+    **
+    ** Each case is an operation (e.g. feeding 1 event into a state machine)
+    ** that is repeated a number of times. Per operation the benchmark
+    ** reports:
+    ** - the wall clock time (ns);
+    ** - the hardware counters: cycles, retired instructions, cache misses and
+    **   branch misses (only when the counters are available, see CPerfCounter);
+    ** - the number of allocations and bytes allocated from the heap;
+    ** - the number of allocations per category of the state machine engine
+    **   (only when the library is compiled with ALLOCATION_STATS).
+    **
+    ** Cases that are not a repeated operation (e.g. constructing a
+    ** population of state machines) call Start and Stop themselves and
+    ** can add their own metrics to the result with AddMetric.
+    **
+    ** The JSON report is written to stdout, so runs on the same machine
+    ** can be stored and compared. Everything else (e.g. errors) goes to
+    ** stderr.
+    **/
+   class CBench {
+      public:
+                              CBench(const char* szBenchmark, const char* szOperation, int argc, char* argv[]);
+                              ~CBench(void);
+
+      public:
+         unsigned int         GetIterations(const unsigned int iterations) const;
+         static unsigned int  GetCalls(const unsigned int iterations);
+         template <class TOp>
+         void                 Run(const char* szCase, const unsigned int iterations, TOp op, const char* szOperation = NULL);
+         void                 Start(void);
+         void                 Stop(const char* szCase, const unsigned int iterations, const char* szOperation = NULL);
+         void                 AddMetric(const char* szName, const double value, const bool bAvailable = true);
+         double               GetOpsPerSecond(void) const;
+         double               GetCounterPerOp(const CPerfCounter::ECounter counter) const;
+         double               GetAllocationsPerOp(void) const;
+         void                 Fail(const char* szCase, const char* szReason);
+         int                  Report(void) const;
+
+      private:
+                              CBench(CBench& ref); //defined, not implemented --> avoid copy
+         CBench               operator=(CBench& ref);   //defined, not implemented --> avoid copy
+
+      private:
+         /** @brief A case specific metric.
+          **/
+         struct SMetric {
+            std::string  m_strName;      ///< Name of the metric in the report.
+            double       m_Value;        ///< Value of the metric, can be negative.
+            bool         m_bAvailable;   ///< False when the value could not be determined (reported as null).
+         };
+
+         /** @brief The result of 1 case, per operation.
+          **/
+         struct SResult {
+            std::string  m_strCase;      ///< Name of the case.
+            std::string  m_strOperation; ///< What 1 operation is.
+            unsigned int m_Iterations;   ///< Number of operations measured.
+            double       m_Ns;           ///< Wall clock time.
+            double       m_Counters[CPerfCounter::ECounterCount]; ///< Hardware counters, negative when not available.
+            double       m_Allocations;  ///< Number of heap allocations.
+            double       m_Bytes;        ///< Number of heap bytes allocated.
+            std::vector<SMetric> m_Metrics; ///< Case specific metrics.
+         };
+
+      private:
+         const std::string                     m_strBenchmark;   ///< Name of the benchmark.
+         const std::string                     m_strOperation;   ///< What 1 operation is (e.g. "event").
+         double                                m_Scale;          ///< Scale factor for the number of iterations (command line).
+         CPerfCounter*                         m_Counters[CPerfCounter::ECounterCount]; ///< Hardware counters, NULL when disabled.
+         std::vector<SResult>                  m_Results;        ///< The results of the cases run so far.
+         std::vector<std::string>              m_Failures;       ///< Descriptions of the failed cases.
+         std::chrono::steady_clock::time_point m_Start;          ///< Start time of the running case.
+         unsigned long long                    m_StartCount;     ///< Number of allocations at the start of the running case.
+         unsigned long long                    m_StartBytes;     ///< Number of bytes allocated at the start of the running case.
+         ILULibStateMachine::CAllocationStats  m_StartStats;     ///< Allocations per category at the start of the running case.
+   };
+}
+
+//include the class template function definitions.
+#include "CBenchImpl.h"
+
+#endif //__ILUBench_CBench__H__
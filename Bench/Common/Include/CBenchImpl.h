@@ -0,0 +1,51 @@
+/** @file
+ ** @brief The CBench template function definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILUBench_CBenchImpl__H__
+#define __ILUBench_CBenchImpl__H__
+
+namespace ILUBench {
+   /** Run 1 case: call the operation iterations times and store the
+    ** result per operation.
+    **
+    ** The operation is called a number of times first without measuring,
+    ** so one-time allocations and cold caches are not part of the result.
+    **/
+   template <class TOp>
+   void CBench::Run(
+      const char*        szCase,     //< Name of the case in the report.
+      const unsigned int iterations, //< Number of times to call the operation.
+      TOp                op,         //< The operation, called without arguments.
+      const char*        szOperation //< What 1 operation is in this case, NULL for the operation of the benchmark.
+      )
+   {
+      for(unsigned int i = iterations ; i < GetCalls(iterations) ; ++i) {
+         op();
+      }
+      Start();
+      for(unsigned int i = 0 ; i < iterations ; ++i) {
+         op();
+      }
+      Stop(szCase, iterations, szOperation);
+   }
+}
+
+#endif //__ILUBench_CBenchImpl__H__
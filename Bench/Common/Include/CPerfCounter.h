@@ -0,0 +1,73 @@
+/** @file
+ ** @brief The CPerfCounter declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILUBench_CPerfCounter__H__
+#define __ILUBench_CPerfCounter__H__
+
+#include <stdint.h>
+
+namespace ILUBench {
+   /** @brief A hardware performance counter of the calling thread
+    ** (Linux perf_event_open).
+    **
+    ** When the counter cannot be opened (not Linux, no permission,
+    ** running in a container without perf support ...) the counter is
+    ** not available: the benchmarks report no value instead of failing.
+    **
+    ** When more counters are open than the CPU has registers, the kernel
+    ** multiplexes them: Read scales the count to the time the counter
+    ** was enabled.
+    **/
+   class CPerfCounter {
+      public:
+         /** @brief The counters that can be opened.
+          **/
+         enum ECounter {
+            ECounterCycles = 0,      ///< CPU cycles.
+            ECounterInstructions,    ///< Retired instructions.
+            ECounterL1dMisses,       ///< Level 1 data cache read misses.
+            ECounterCacheReferences, ///< Last level cache accesses.
+            ECounterCacheMisses,     ///< Last level cache misses.
+            ECounterBranchMisses,    ///< Mispredicted branches.
+            ECounterCount            ///< Number of counters, not a counter.
+         };
+
+      public:
+         explicit      CPerfCounter(const ECounter counter);
+                       ~CPerfCounter(void);
+
+      public:
+         static const char* GetName(const ECounter counter);
+         bool          IsAvailable(void) const;
+         void          Start(void);
+         void          Stop(void);
+         uint64_t      Read(void) const;
+
+      private:
+                       CPerfCounter(CPerfCounter& ref); //defined, not implemented --> avoid copy
+         CPerfCounter  operator=(CPerfCounter& ref);    //defined, not implemented --> avoid copy
+
+      private:
+         int           m_Fd; ///< File descriptor of the counter, -1 when not available.
+   };
+}
+
+#endif //__ILUBench_CPerfCounter__H__
@@ -0,0 +1,280 @@
+/** @file
+ ** @brief Dispatch benchmark
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "CBench.h"
+using namespace ILUBench;
+
+/****************************************************************************************
+ ** 
+ ** Events, cases and the state machine data.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork  = 1,
+   EEventsOther = 2
+};
+
+/** What the state registers, 1 state machine per case.
+ **/
+enum ECase {
+   ECaseSubIds0,
+   ECaseSubIds1,
+   ECaseSubIds2,
+   ECaseSubIds3,
+   ECaseGuards1,
+   ECaseGuards4,
+   ECaseGuards16,
+   ECaseTypeFallback,
+   ECaseDefaultFallback
+};
+
+/** The state machine data: the case and the number of handlers called.
+ **/
+class CBenchData : public CStateMachineData {
+public:
+   CBenchData(const ECase eCase)
+      : CStateMachineData()
+      , m_Case(eCase)
+      , m_Handled(0)
+   {
+   }
+
+public:
+   const ECase  m_Case;
+   unsigned int m_Handled;
+};
+
+/****************************************************************************************
+ ** 
+ ** States.
+ **
+ ***************************************************************************************/
+/** The state handling the events, registrations depend on the case.
+ **/
+class CStateWork : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWork(WPStateMachine wpStateMachine, CBenchData* const pData)
+      : CStateEvtId("work", wpStateMachine)
+      , m_pData(pData)
+   {
+      switch(m_pData->m_Case) {
+         case ECaseSubIds0:
+            EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+            break;
+         case ECaseSubIds1:
+            EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork, 1);
+            break;
+         case ECaseSubIds2:
+            EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork, 1, 2);
+            break;
+         case ECaseSubIds3:
+            EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork, 1, 2, 3);
+            break;
+         case ECaseGuards1:
+            RegisterGuards(1);
+            break;
+         case ECaseGuards4:
+            RegisterGuards(4);
+            break;
+         case ECaseGuards16:
+            RegisterGuards(16);
+            break;
+         case ECaseTypeFallback:
+            EventRegister    (HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+            EventTypeRegister(TEventEvtId<EEvents>::IdTypeInit(), HANDLER_TYPE(int, CStateWork, HandlerType), CCreateState());
+            break;
+         case ECaseDefaultFallback:
+         default:
+            break;
+      }
+   }
+
+public:
+   bool GuardReject(const int* const)
+   {
+      return false;
+   }
+
+   bool GuardAccept(const int* const)
+   {
+      return true;
+   }
+
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+   void HandlerType(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   /** Register a chain of guarded handlers: only the guard of the last
+    ** one passes, so every event runs the complete chain.
+    **/
+   void RegisterGuards(const unsigned int iCount)
+   {
+      for(unsigned int i = 1 ; i < iCount ; ++i) {
+         EventRegister(GUARD(int, CStateWork, GuardReject), HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+      }
+      EventRegister(GUARD(int, CStateWork, GuardAccept), HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+   }
+
+private:
+   CBenchData* const m_pData;
+};
+
+/** The default state, handling the events the current state does not handle.
+ **/
+class CStateDefault : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDefault(WPStateMachine wpStateMachine, CBenchData* const pData)
+      : CStateEvtId("default", wpStateMachine, true /* default state */)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateDefault, Handler), CCreateState(), EEventsWork);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CBenchData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Benchmark helpers.
+ **
+ ***************************************************************************************/
+/** Logging function that drops everything: only the engine's own cost
+ ** of the (disabled) logging is measured.
+ **/
+void LogNothing(const std::string&)
+{
+}
+
+/** Construct the state machine of a case.
+ **
+ ** @return the state machine.
+ **/
+SPStateMachine Construct(CBenchData* const pData)
+{
+   return CStateMachine::ConstructStateMachine("bench", TCreateState<CStateWork, CBenchData>(pData), TCreateState<CStateDefault, CBenchData>(pData), pData);
+}
+
+/** Check all events of a case have been handled.
+ **/
+void Check(CBench& bench, const char* szCase, const CBenchData* const pData, const unsigned int iterations)
+{
+   if(pData->m_Handled != CBench::GetCalls(iterations)) {
+      bench.Fail(szCase, "not all events have been handled");
+   }
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It measures feeding events into a state machine for different kinds
+ ** of registrations and writes the results as JSON to stdout.
+ **
+ ***************************************************************************************/
+int main (int argc, char* argv[])
+{
+   RegisterLogInfo   (LogNothing);
+   RegisterLogNotice (LogNothing);
+   RegisterLogWarning(LogNothing);
+
+   CBench             bench("dispatch", "event", argc, argv);
+   const unsigned int iterations(bench.GetIterations(200000));
+   const int          iEvtData(0);
+
+   {
+      CBenchData* const pData(new CBenchData(ECaseSubIds0));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("sub-ids-0", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "sub-ids-0", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseSubIds1));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("sub-ids-1", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork, 1); });
+      Check(bench, "sub-ids-1", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseSubIds2));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("sub-ids-2", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork, 1, 2); });
+      Check(bench, "sub-ids-2", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseSubIds3));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("sub-ids-3", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork, 1, 2, 3); });
+      Check(bench, "sub-ids-3", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseGuards1));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("guard-chain-1", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "guard-chain-1", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseGuards4));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("guard-chain-4", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "guard-chain-4", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseGuards16));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("guard-chain-16", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "guard-chain-16", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseTypeFallback));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("unguarded", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "unguarded", pData, iterations);
+      pData->m_Handled = 0;
+      bench.Run("type-fallback", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsOther); });
+      Check(bench, "type-fallback", pData, iterations);
+   }
+   {
+      CBenchData* const pData(new CBenchData(ECaseDefaultFallback));
+      SPStateMachine    spStateMachine(Construct(pData));
+      bench.Run("default-state-fallback", iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+      Check(bench, "default-state-fallback", pData, iterations);
+   }
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bench.Report();
+}
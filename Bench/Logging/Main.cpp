@@ -0,0 +1,283 @@
+/** @file
+ ** @brief Logging benchmark
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+
+//generated by autotools
+#include "config.h"
+
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "CBench.h"
+using namespace ILUBench;
+
+/****************************************************************************************
+ ** 
+ ** Events and the state machine data.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork = 1
+};
+
+/** The state machine data: the number of handlers called.
+ **/
+class CBenchData : public CStateMachineData {
+public:
+   CBenchData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+   {
+   }
+
+public:
+   unsigned int m_Handled;
+};
+
+/****************************************************************************************
+ ** 
+ ** States.
+ **
+ ***************************************************************************************/
+/** The state handling the event, without changing state.
+ **/
+class CStateWork : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWork(WPStateMachine wpStateMachine, CBenchData* const pData)
+      : CStateEvtId("work", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CBenchData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Logging sinks.
+ **
+ ***************************************************************************************/
+/** Logging function that drops everything.
+ **/
+void LogNothing(const std::string&)
+{
+}
+
+/** A user logging function doing what a typical one does: collect the
+ ** loggings in a buffer which is flushed once in a while.
+ **/
+void LogCollect(const std::string& strLog)
+{
+   static std::string s_strBuffer;
+   if(4096 < s_strBuffer.size()) {
+      s_strBuffer.clear();
+   }
+   s_strBuffer += strLog;
+}
+
+/** @brief Redirects stdout to /dev/null as long as the instance exists,
+ ** so the serial logging functions can be measured without flooding the
+ ** console (the JSON report goes to stdout when it is restored).
+ **/
+class CStdoutToNull {
+public:
+   CStdoutToNull(void)
+      : m_Fd(-1)
+   {
+      std::cout.flush();
+      fflush(stdout);
+      const int fdNull(open("/dev/null", O_WRONLY));
+      if(0 > fdNull) {
+         return;
+      }
+      m_Fd = dup(STDOUT_FILENO);
+      dup2(fdNull, STDOUT_FILENO);
+      close(fdNull);
+   }
+
+   ~CStdoutToNull(void)
+   {
+      std::cout.flush();
+      fflush(stdout);
+      if(0 > m_Fd) {
+         return;
+      }
+      dup2(m_Fd, STDOUT_FILENO);
+      close(m_Fd);
+   }
+
+private:
+   CStdoutToNull(CStdoutToNull& ref);           //defined, not implemented --> avoid copy
+   CStdoutToNull operator=(CStdoutToNull& ref); //defined, not implemented --> avoid copy
+
+private:
+   int m_Fd; ///< The original stdout, -1 when it has not been redirected.
+};
+
+/****************************************************************************************
+ ** 
+ ** Benchmark helpers.
+ **
+ ***************************************************************************************/
+/** Feed events into the state machine and check all of them have been
+ ** handled.
+ **/
+void RunDispatch(CBench& bench, const char* szCase, const unsigned int iterations)
+{
+   CBenchData* const pData(new CBenchData());
+   SPStateMachine    spStateMachine(CStateMachine::ConstructStateMachine("bench", TCreateState<CStateWork, CBenchData>(pData), pData));
+   const int         iEvtData(0);
+   bench.Run(szCase, iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsWork); });
+   if(pData->m_Handled != CBench::GetCalls(iterations)) {
+      bench.Fail(szCase, "not all events have been handled");
+   }
+}
+
+/** Measure the guarded difference: the same dispatch with the default
+ ** sinks and with the log level of the state machine off.
+ **
+ ** Both are measured in interleaved rounds of 50 events (iterations
+ ** in total) and the fastest round of each is kept: a round is much
+ ** shorter than a scheduler time slice, so a busy machine (e.g. 'make -j
+ ** check') does not make 1 of them look slower than it is.
+ **
+ ** @return the difference per event (ns).
+ **/
+double MeasureOverhead(const unsigned int iterations)
+{
+   CBenchData* const  pDataNone(new CBenchData());
+   CBenchData* const  pDataOff (new CBenchData());
+   SPStateMachine     spNone(CStateMachine::ConstructStateMachine("bench",     TCreateState<CStateWork, CBenchData>(pDataNone), pDataNone));
+   SPStateMachine     spOff (CStateMachine::ConstructStateMachine("bench-off", TCreateState<CStateWork, CBenchData>(pDataOff ), pDataOff ));
+   const int          iEvtData(0);
+   const unsigned int roundIterations(50);
+   double             nsNone(-1.0);
+   double             nsOff (-1.0);
+   CLogLevel::SetName("bench-off", ELogLevelCount);
+   for(unsigned int round = 0 ; round < iterations / 50 + 1 ; ++round) {
+      SPStateMachine* const machines[2] = {&spNone, &spOff};
+      double* const         results [2] = {&nsNone, &nsOff};
+      for(unsigned int m = 0 ; m < 2 ; ++m) {
+         const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+         for(unsigned int i = 0 ; i < roundIterations ; ++i) {
+            (*machines[m])->EventHandle(&iEvtData, EEventsWork);
+         }
+         const double ns(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / roundIterations);
+         if((0 > *results[m]) || (ns < *results[m])) {
+            *results[m] = ns;
+         }
+      }
+   }
+   CLogLevel::ResetName("bench-off");
+   return nsNone - nsOff;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It measures feeding events into a state machine with different logging
+ ** functions registered and writes the results as JSON to stdout.
+ **
+ ** It fails when the logging of a dispatch with the default sinks costs
+ ** more than LOG_OVERHEAD_LIMIT_NS per event compared with the same
+ ** dispatch with the log level of the state machine off (configure
+ ** --with-log-overhead-limit), or allocates more. So it also runs with
+ ** 'make check'.
+ **
+ ***************************************************************************************/
+int main (int argc, char* argv[])
+{
+   CBench             bench("logging", "event", argc, argv);
+   const unsigned int iterations(bench.GetIterations(20000));
+
+   //the library's default for the debug loggings (disabled), the other levels disabled the same way
+   RegisterLogInfo   (FLog());
+   RegisterLogNotice (FLog());
+   RegisterLogWarning(FLog());
+   RunDispatch(bench, "sink-none", iterations);
+   const double nsNone         (1e9 / bench.GetOpsPerSecond());
+   const double allocationsNone(bench.GetAllocationsPerOp());
+
+   //the same with the engine's logging off for the state machine: the guarded difference
+   CLogLevel::SetName("bench", ELogLevelCount);
+   RunDispatch(bench, "level-off", iterations);
+   bench.AddMetric("overhead_ns_per_event", 1e9 / bench.GetOpsPerSecond() - nsNone);
+   const double allocationsOff(bench.GetAllocationsPerOp());
+   CLogLevel::ResetName("bench");
+   const double nsOverhead(MeasureOverhead(iterations));
+   bench.AddMetric("guarded_overhead_ns_per_event", nsOverhead);
+   bench.AddMetric("limit_ns_per_event",            LOG_OVERHEAD_LIMIT_NS);
+   if(LOG_OVERHEAD_LIMIT_NS < nsOverhead) {
+      bench.Fail("level-off", "the logging with the default sinks exceeds the configured limit per event");
+   }
+   if(allocationsOff < allocationsNone) {
+      bench.Fail("level-off", "the logging with the default sinks allocates");
+   }
+
+   //the levels registered to a function dropping the loggings: formatted for nothing
+   RegisterLogInfo   (LogNothing);
+   RegisterLogNotice (LogNothing);
+   RegisterLogWarning(LogNothing);
+   RunDispatch(bench, "sink-nothing", iterations);
+   bench.AddMetric("overhead_ns_per_event", 1e9 / bench.GetOpsPerSecond() - nsNone);
+
+   //all levels to a user logging function
+   RegisterLogDebug  (LogCollect);
+   RegisterLogInfo   (LogCollect);
+   RegisterLogNotice (LogCollect);
+   RegisterLogWarning(LogCollect);
+   RunDispatch(bench, "sink-callback", iterations);
+   bench.AddMetric("overhead_ns_per_event", 1e9 / bench.GetOpsPerSecond() - nsNone);
+
+   //the serial logging functions, without and with debug logging
+   RegisterLogDebug(FLog());
+   UnRegisterLogInfo   ();
+   UnRegisterLogNotice ();
+   UnRegisterLogWarning();
+   {
+      CStdoutToNull stdoutToNull;
+      RunDispatch(bench, "sink-serial", iterations);
+   }
+   bench.AddMetric("overhead_ns_per_event", 1e9 / bench.GetOpsPerSecond() - nsNone);
+   EnableSerialLogDebug();
+   {
+      CStdoutToNull stdoutToNull;
+      RunDispatch(bench, "sink-serial-debug", iterations);
+   }
+   bench.AddMetric("overhead_ns_per_event", 1e9 / bench.GetOpsPerSecond() - nsNone);
+
+   RegisterLogDebug(FLog());
+   return bench.Report();
+}
@@ -0,0 +1,207 @@
+/** @file
+ ** @brief Scale benchmark
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <random>
+#include <vector>
+
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "Events.h"
+#include "StateMachineRoot.h"
+
+#include "CBench.h"
+using namespace ILUBench;
+
+/****************************************************************************************
+ ** 
+ ** The event mix.
+ **
+ ***************************************************************************************/
+/** 1 event of the mix: the state machine it is fed into and its ID.
+ **/
+struct SEvent {
+   uint32_t           m_Machine; ///< Index of the state machine in the population.
+   LibEvents::EEvents m_Id;      ///< Event ID.
+};
+
+/** The events of the mix, with the odds (out of 16) they are picked.
+ ** The data of the events is always odd, so the handlers of EEvent5 and
+ ** EEvent6 do not throw. EEvent8 and EEvent9 are not used: they finish
+ ** the state machine or construct a child state machine.
+ **/
+const LibEvents::EEvents g_Mix[16] = {
+   LibEvents::EEvent1, LibEvents::EEvent1, LibEvents::EEvent1, LibEvents::EEvent1,
+   LibEvents::EEvent2, LibEvents::EEvent2, LibEvents::EEvent2,
+   LibEvents::EEvent3, LibEvents::EEvent3, LibEvents::EEvent3,
+   LibEvents::EEvent4,
+   LibEvents::EEvent5, LibEvents::EEvent5,
+   LibEvents::EEvent6, LibEvents::EEvent6,
+   LibEvents::EEvent7
+};
+
+/** Generate the event mix for a population of state machines.
+ **
+ ** The mix only depends on the seed, so every run (and every build) feeds
+ ** the same events.
+ **/
+void GenerateMix(std::vector<SEvent>& events, const unsigned int machines, const unsigned int count, const uint32_t seed)
+{
+   std::mt19937                                mt(seed);
+   std::uniform_int_distribution<uint32_t>     machine(0, machines - 1);
+   std::uniform_int_distribution<unsigned int> mix(0, sizeof(g_Mix) / sizeof(g_Mix[0]) - 1);
+
+   events.resize(count);
+   for(std::vector<SEvent>::iterator it = events.begin() ; events.end() != it ; ++it) {
+      it->m_Machine = machine(mt);
+      it->m_Id      = g_Mix[mix(mt)];
+   }
+}
+
+/****************************************************************************************
+ ** 
+ ** Benchmark helpers.
+ **
+ ***************************************************************************************/
+/** Logging function that drops everything: only the engine's own cost
+ ** of the (disabled) logging is measured.
+ **/
+void LogNothing(const std::string&)
+{
+}
+
+/** Get the resident memory of the process.
+ **
+ ** @return the resident memory in bytes, 0 when not available (not Linux).
+ **/
+double GetResident(void)
+{
+   double resident(0);
+#if defined(__linux__)
+   FILE* const pFile(fopen("/proc/self/statm", "r"));
+   if(NULL != pFile) {
+      unsigned long size(0);
+      unsigned long pages(0);
+      if(2 == fscanf(pFile, "%lu %lu", &size, &pages)) {
+         resident = static_cast<double>(pages) * sysconf(_SC_PAGESIZE);
+      }
+      fclose(pFile);
+   }
+#endif
+   return resident;
+}
+
+/** Return the memory freed by the previous population to the system,
+ ** so it does not hide the memory used by the next one.
+ **/
+void ReleaseMemory(void)
+{
+#if defined(__GLIBC__)
+   malloc_trim(0);
+#endif
+}
+
+/** Construct a population of state machines, feed them the event mix
+ ** and destruct them.
+ **/
+void RunPopulation(CBench& bench, const unsigned int machines, const unsigned int count)
+{
+   char szCase[64];
+
+   //generate the events first: the mix is not part of the measurements
+   std::vector<SEvent> events;
+   GenerateMix(events, machines, count, machines);
+   const int           iEvtData(1);
+
+   //construct
+   std::vector<SPStateMachine> stateMachines;
+   stateMachines.reserve(machines);
+   const double residentBefore(GetResident());
+   snprintf(szCase, sizeof(szCase), "construct-%u", machines);
+   bench.Start();
+   for(unsigned int i = 0 ; i < machines ; ++i) {
+      stateMachines.push_back(StateMachineRoot::CreateStateMachine(i));
+   }
+   bench.Stop(szCase, machines, "machine");
+   const double residentAfter(GetResident());
+   bench.AddMetric("machines_per_second",        bench.GetOpsPerSecond());
+   bench.AddMetric("resident_bytes_per_machine", (residentAfter - residentBefore) / machines, 0 < residentBefore);
+
+   //random event mix over the population
+   unsigned int finished(0);
+   snprintf(szCase, sizeof(szCase), "events-%u", machines);
+   bench.Start();
+   for(std::vector<SEvent>::const_iterator cit = events.begin() ; events.end() != cit ; ++cit) {
+      LibEvents::CEventData eventData(iEvtData);
+      if(stateMachines[cit->m_Machine]->EventHandle(&eventData, cit->m_Id)) {
+         ++finished;
+      }
+   }
+   bench.Stop(szCase, count);
+   const double references(bench.GetCounterPerOp(CPerfCounter::ECounterCacheReferences));
+   const double misses    (bench.GetCounterPerOp(CPerfCounter::ECounterCacheMisses    ));
+   bench.AddMetric("events_per_second", bench.GetOpsPerSecond());
+   bench.AddMetric("llc_miss_rate",     (0 < references) && (0 <= misses) ? misses / references : 0.0, (0 < references) && (0 <= misses));
+   if(0 != finished) {
+      bench.Fail(szCase, "the event mix finished state machines");
+   }
+
+   //destruct
+   snprintf(szCase, sizeof(szCase), "destruct-%u", machines);
+   bench.Start();
+   stateMachines.clear();
+   bench.Stop(szCase, machines, "machine");
+   ReleaseMemory();
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It constructs populations of 10k, 100k and 1M state machines (the
+ ** StateMachineRoot test state machine), feeds them a random event mix
+ ** and writes the results as JSON to stdout.
+ **
+ ***************************************************************************************/
+int main (int argc, char* argv[])
+{
+   RegisterLogInfo   (LogNothing);
+   RegisterLogNotice (LogNothing);
+   RegisterLogWarning(LogNothing);
+
+   CBench             bench("scale", "event", argc, argv);
+   const unsigned int count(bench.GetIterations(1000000));
+
+   RunPopulation(bench, bench.GetIterations(  10000), count);
+   RunPopulation(bench, bench.GetIterations( 100000), count);
+   RunPopulation(bench, bench.GetIterations(1000000), count);
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bench.Report();
+}
@@ -0,0 +1,168 @@
+/** @file
+ ** @brief Transition benchmark
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "CBench.h"
+using namespace ILUBench;
+
+/****************************************************************************************
+ ** 
+ ** Events and the state machine data.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsNext   = 1,
+   EEventsFiller = 2
+};
+
+/** The state machine data: how the states behave and what happened.
+ **/
+class CBenchData : public CStateMachineData {
+public:
+   CBenchData(const unsigned int iHandlers, const bool bThrowInHandler, const bool bGeneric, const unsigned int iChain)
+      : CStateMachineData()
+      , m_Handlers(iHandlers)
+      , m_bThrowInHandler(bThrowInHandler)
+      , m_bGeneric(bGeneric)
+      , m_Chain(iChain)
+      , m_ThrowsLeft(0)
+      , m_Handled(0)
+   {
+   }
+
+public:
+   const unsigned int m_Handlers;        ///< Number of handlers registered by each state.
+   const bool         m_bThrowInHandler; ///< The handler changes state by throwing a CStateChangeException instead of by its registration.
+   const bool         m_bGeneric;        ///< The registration changes state with a generic FCreateState (a lambda) instead of a TCreateState.
+   const unsigned int m_Chain;           ///< Number of state constructors throwing a CStateChangeException per transition.
+   unsigned int       m_ThrowsLeft;      ///< Number of state constructors that still have to throw in the ongoing transition.
+   unsigned int       m_Handled;         ///< Number of transitions started by a handler.
+};
+
+/****************************************************************************************
+ ** 
+ ** States: ping and pong, each transitions to the other on EEventsNext.
+ **
+ ***************************************************************************************/
+template <int Side>
+class TStateSide : public ILULibStateMachine::CStateEvtId {
+public:
+   TStateSide(WPStateMachine wpStateMachine, CBenchData* const pData)
+      : CStateEvtId(0 == Side ? "ping" : "pong", wpStateMachine)
+      , m_pData(pData)
+   {
+      //constructor chain: pass on to the other side
+      if(0 < m_pData->m_ThrowsLeft) {
+         --m_pData->m_ThrowsLeft;
+         throw CStateChangeException("constructor chain", TCreateState<TStateSide<1 - Side>, CBenchData>(m_pData));
+      }
+
+      //register the handlers: fillers plus the one changing state
+      for(unsigned int i = 1 ; i < m_pData->m_Handlers ; ++i) {
+         EventRegister(HANDLER(int, TStateSide, Handler), CCreateState(), EEventsFiller, i);
+      }
+      if(m_pData->m_bThrowInHandler) {
+         EventRegister(HANDLER(int, TStateSide, HandlerThrow), CCreateState(), EEventsNext);
+      } else if(m_pData->m_bGeneric) {
+         EventRegister(HANDLER(int, TStateSide, HandlerNext), CCreateState([pData](WPStateMachine wpNext) -> CState* { return new TStateSide<1 - Side>(wpNext, pData); }), EEventsNext);
+      } else {
+         EventRegister(HANDLER(int, TStateSide, HandlerNext), TCreateState<TStateSide<1 - Side>, CBenchData>(m_pData), EEventsNext);
+      }
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+   void HandlerNext(const int* const)
+   {
+      ++m_pData->m_Handled;
+      m_pData->m_ThrowsLeft = m_pData->m_Chain;
+   }
+
+   void HandlerThrow(const int* const)
+   {
+      ++m_pData->m_Handled;
+      m_pData->m_ThrowsLeft = m_pData->m_Chain;
+      throw CStateChangeException("handler", TCreateState<TStateSide<1 - Side>, CBenchData>(m_pData));
+   }
+
+private:
+   CBenchData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Benchmark helpers.
+ **
+ ***************************************************************************************/
+/** Logging function that drops everything: only the engine's own cost
+ ** of the logging is measured.
+ **/
+void LogNothing(const std::string&)
+{
+}
+
+/** Run 1 case: every event is 1 transition between ping and pong.
+ **/
+void RunCase(CBench& bench, const char* szCase, const unsigned int iterations, const unsigned int iHandlers, const bool bThrowInHandler, const bool bGeneric, const unsigned int iChain)
+{
+   const int         iEvtData(0);
+   CBenchData* const pData(new CBenchData(iHandlers, bThrowInHandler, bGeneric, iChain));
+   SPStateMachine    spStateMachine(CStateMachine::ConstructStateMachine("bench", TCreateState<TStateSide<0>, CBenchData>(pData), pData));
+   bench.Run(szCase, iterations, [&]() { spStateMachine->EventHandle(&iEvtData, EEventsNext); });
+   if((pData->m_Handled != CBench::GetCalls(iterations)) || spStateMachine->HasFinished()) {
+      bench.Fail(szCase, "not all transitions have been made");
+   }
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It measures state transitions: with a growing number of handlers
+ ** registered by the new state, with a generic create state function, driven by a CStateChangeException instead
+ ** of by the registration and with state constructors throwing a
+ ** CStateChangeException, and writes the results as JSON to stdout.
+ **
+ ***************************************************************************************/
+int main (int argc, char* argv[])
+{
+   RegisterLogInfo   (LogNothing);
+   RegisterLogNotice (LogNothing);
+   RegisterLogWarning(LogNothing);
+
+   CBench bench("transition", "transition", argc, argv);
+   RunCase(bench, "handlers-1",                   bench.GetIterations(50000), 1,   false, false, 0);
+   RunCase(bench, "handlers-10",                  bench.GetIterations(20000), 10,  false, false, 0);
+   RunCase(bench, "handlers-100",                 bench.GetIterations(2000),  100, false, false, 0);
+   RunCase(bench, "generic-create-state",         bench.GetIterations(50000), 1,   false, true,  0);
+   RunCase(bench, "exception-in-handler",         bench.GetIterations(50000), 1,   true,  false, 0);
+   RunCase(bench, "exception-in-constructor-1",   bench.GetIterations(20000), 1,   false, false, 1);
+   RunCase(bench, "exception-in-constructor-4",   bench.GetIterations(10000), 1,   false, false, 4);
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bench.Report();
+}
@@ -0,0 +1,205 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//the allocation counter shared by the demos (linked from Demo/Common) reports
+//all heap allocations to the library, which attributes them to the state
+//machine and category of the current scope
+#include "cstdio"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** state-1 --> state-2 --> state-1 ...
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsNext = 1,
+   EEventsStay = 2
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+   {
+   }
+
+public:
+   unsigned int m_Handled;
+};
+
+class CState2;
+
+class CState1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState1(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-1", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CState1, Handler), TCreateState<CState2, CDemoData>(m_pData), EEventsNext);
+      EventRegister(HANDLER(int, CState1, Handler), CCreateState(),                            EEventsStay);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CState2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState2(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-2", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CState2, Handler), TCreateState<CState1, CDemoData>(m_pData), EEventsNext);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Logging function that drops everything. Registered for all levels the
+ ** engine logs with, including debug: a level with an empty FLog (the
+ ** debug default) is not formatted at all, this one keeps the levels on so
+ ** the logging category gets its allocations.
+ **/
+void LogNothing(const std::string&)
+{
+}
+
+/** Copy the counts of all categories.
+ **/
+void Snapshot(const CAllocationStats& stats, unsigned long long counts[EAllocationCount])
+{
+   for(unsigned int i = 0 ; i < EAllocationCount ; ++i) {
+      counts[i] = stats.GetCount(static_cast<EAllocation>(i));
+   }
+}
+
+/** Print the counts of all categories since the snapshot and check
+ ** which categories allocated.
+ **
+ ** @return true when exactly the expected categories allocated.
+ **/
+bool Check(const char* szStep, const CAllocationStats& stats, const unsigned long long before[EAllocationCount], const bool bExpected[EAllocationCount])
+{
+   bool bOk(true);
+   printf("%-24s", szStep);
+   for(unsigned int i = 0 ; i < EAllocationCount ; ++i) {
+      const EAllocation        category(static_cast<EAllocation>(i));
+      const unsigned long long count   (stats.GetCount(category) - before[i]);
+      printf(" %s %3llu", CAllocationStats::GetName(category), count);
+      if(bExpected[i] != (0 < count)) {
+         bOk = false;
+      }
+   }
+   printf("%s\n", bOk ? "" : " --> unexpected");
+   return bOk;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It feeds events into a state machine and checks which categories the
+ ** allocations of every step are attributed to.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   if(!CAllocationStats::IsEnabled()) {
+      printf("library not compiled with allocation statistics (configure --enable-allocation-stats) --> skip\n");
+      return 77;
+   }
+   RegisterLogDebug  (LogNothing);
+   RegisterLogInfo   (LogNothing);
+   RegisterLogNotice (LogNothing);
+   RegisterLogWarning(LogNothing);
+
+   //                                   registration dispatch transition logging teardown
+   const bool         bConstruct[]   = {true,        false,   true,      true,   false};
+   const bool         bStay[]        = {false,       true,    false,     true,   false};
+   const bool         bNext[]        = {true,        true,    true,      true,   false};
+   const bool         bDestruct[]    = {false,       false,   false,     false,  false};
+   bool               bOk(true);
+   unsigned long long before[EAllocationCount];
+   const int          iEvtData(0);
+
+   Snapshot(CAllocationStats::GetThreadTotals(), before);
+   {
+      CDemoData* const pData(new CDemoData());
+      SPStateMachine   spStateMachine(CStateMachine::ConstructStateMachine("allocation-stats", TCreateState<CState1, CDemoData>(pData), pData));
+      const CAllocationStats& stats(spStateMachine->GetAllocationStats());
+      bOk &= Check("construct", stats, before, bConstruct);
+
+      //an event handled without state change
+      Snapshot(stats, before);
+      spStateMachine->EventHandle(&iEvtData, EEventsStay);
+      bOk &= Check("event without transition", stats, before, bStay);
+
+      //an event changing state: the new state registers its handlers
+      Snapshot(stats, before);
+      spStateMachine->EventHandle(&iEvtData, EEventsNext);
+      bOk &= Check("event with transition", stats, before, bNext);
+
+      //the totals of the thread match the only state machine
+      for(unsigned int i = 0 ; i < EAllocationCount ; ++i) {
+         const EAllocation category(static_cast<EAllocation>(i));
+         if(stats.GetCount(category) != CAllocationStats::GetThreadTotals().GetCount(category)) {
+            printf("thread totals differ for [%s]\n", CAllocationStats::GetName(category));
+            bOk = false;
+         }
+      }
+      if(2 != pData->m_Handled) {
+         printf("not all events have been handled\n");
+         bOk = false;
+      }
+      Snapshot(CAllocationStats::GetThreadTotals(), before);
+   }
+   //the destructed state machine is only visible in the thread totals
+   bOk &= Check("destruct", CAllocationStats::GetThreadTotals(), before, bDestruct);
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   UnRegisterLogDebug  ();
+   return bOk ? 0 : 1;
+}
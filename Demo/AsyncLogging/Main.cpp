@@ -0,0 +1,185 @@
+/** @file
+ ** @brief Asynchronous serial logging demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "iostream"
+#include "sstream"
+#include "thread"
+#include "unistd.h"
+
+/****************************************************************************************
+ ** 
+ ** Helpers
+ **
+ ***************************************************************************************/
+/** @brief Redirects stdout to a pipe and collects what is written to it
+ ** in a reader thread.
+ **/
+class CCapture {
+public:
+   CCapture(void)
+      : m_SavedFd(-1)
+      , m_Reader()
+      , m_strOutput()
+   {
+      std::cout.flush();
+      if(0 != pipe(m_Pipe)) {
+         throw std::runtime_error("pipe failed");
+      }
+      m_SavedFd = dup(STDOUT_FILENO);
+      dup2(m_Pipe[1], STDOUT_FILENO);
+   }
+
+public:
+   /** Start reading the pipe (until then writers block once the pipe is full).
+    **/
+   void StartReading(void)
+   {
+      m_Reader = std::thread(&CCapture::Read, this);
+   }
+
+   /** Restore stdout and wait until everything written has been read.
+    **
+    ** @return the captured output.
+    **/
+   const std::string& Stop(void)
+   {
+      dup2(m_SavedFd, STDOUT_FILENO);
+      close(m_SavedFd);
+      close(m_Pipe[1]);
+      if(!m_Reader.joinable()) {
+         StartReading();
+      }
+      m_Reader.join();
+      close(m_Pipe[0]);
+      return m_strOutput;
+   }
+
+private:
+   void Read(void)
+   {
+      char buf[4096];
+      ssize_t size;
+      while(0 < (size = read(m_Pipe[0], buf, sizeof(buf)))) {
+         m_strOutput.append(buf, static_cast<size_t>(size));
+      }
+   }
+
+private:
+   int         m_Pipe[2];
+   int         m_SavedFd;
+   std::thread m_Reader;
+   std::string m_strOutput;
+};
+
+/** Count the occurences of a string.
+ **/
+size_t Count(const std::string& strText, const std::string& strFind)
+{
+   size_t count(0);
+   for(size_t pos = strText.find(strFind) ; std::string::npos != pos ; pos = strText.find(strFind, pos + 1)) {
+      ++count;
+   }
+   return count;
+}
+
+/****************************************************************************************
+ ** 
+ ** main
+ **
+ ***************************************************************************************/
+int main (int, char**)
+{
+   int ret = 0;
+   try {
+      const unsigned int messages(1000);
+
+      //blocking: every message is written, in order
+      {
+         CCapture capture;
+         capture.StartReading();
+         StartAsyncLog(8, EAsyncLogOverflowBlock);
+         RegisterLogInfo   (AsyncSerialLogInfo   );
+         RegisterLogWarning(AsyncSerialLogWarning);
+         for(unsigned int u = 0 ; u < messages ; ++u) {
+            LogInfo("message %u\n", u);
+         }
+         LogWarning("warning\n");
+         FlushAsyncLog();
+         const unsigned long long written(GetAsyncLogWritten());
+         StopAsyncLog();
+         const std::string& strOutput(capture.Stop());
+         std::cout << "blocking: written " << written << ", dropped " << GetAsyncLogDropped() << ", captured " << strOutput.size() << " bytes" << std::endl;
+         if(messages + 1 != written || 0 != GetAsyncLogDropped()) {
+            throw std::runtime_error("blocking: unexpected written/dropped count");
+         }
+         size_t pos(0);
+         for(unsigned int u = 0 ; u < messages ; ++u) {
+            std::ostringstream oss;
+            oss << "message " << u << "\n";
+            pos = strOutput.find(oss.str(), pos);
+            if(std::string::npos == pos) {
+               throw std::runtime_error("blocking: message missing or out of order: " + oss.str());
+            }
+         }
+         if(1 != Count(strOutput, "\033[34mwarning\n\033[0m")) {
+            throw std::runtime_error("blocking: warning not in the warning color");
+         }
+      }
+
+      //dropping: the pipe is not read, so the ring buffer fills up
+      {
+         const unsigned int burst(20000);
+         CCapture capture;
+         StartAsyncLog(16, EAsyncLogOverflowDrop);
+         for(unsigned int u = 0 ; u < burst ; ++u) {
+            LogInfo("message %u\n", u);
+         }
+         capture.StartReading();
+         StopAsyncLog();
+         const std::string& strOutput(capture.Stop());
+         const unsigned long long written(GetAsyncLogWritten() - messages - 1);
+         const unsigned long long dropped(GetAsyncLogDropped());
+         std::cout << "dropping: written " << written << ", dropped " << dropped << std::endl;
+         if(0 == dropped || burst != written + dropped) {
+            throw std::runtime_error("dropping: unexpected written/dropped count");
+         }
+         if(written != Count(strOutput, "message ")) {
+            throw std::runtime_error("dropping: captured output does not match the written count");
+         }
+      }
+
+      //stopped: the functions log synchronously
+      AsyncSerialLogInfo("synchronous\n");
+      UnRegisterLogInfo();
+      UnRegisterLogWarning();
+   } catch(std::exception& e) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      ret = 1;
+   } catch(...) {
+      std::cerr << "unknown exception" << std::endl;
+      ret = 1;
+   }
+   return ret;
+}
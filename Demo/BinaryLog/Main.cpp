@@ -0,0 +1,230 @@
+/** @file
+ ** @brief Deferred-formatting logging demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "cstdio"
+#include "fstream"
+#include "iostream"
+#include "mutex"
+#include "sstream"
+#include "thread"
+#include "vector"
+
+/****************************************************************************************
+ ** 
+ ** Helpers
+ **
+ ***************************************************************************************/
+/** @brief Collects the messages passed to the registered logging functions.
+ **/
+class CCapture {
+public:
+   CCapture(void)
+      : m_Mutex()
+      , m_Messages()
+      , m_SleepUs(0)
+   {
+   }
+
+public:
+   void Log(const std::string& strLog)
+   {
+      if(0 != m_SleepUs) {
+         std::this_thread::sleep_for(std::chrono::microseconds(m_SleepUs));
+      }
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_Messages.push_back(strLog);
+   }
+
+   std::vector<std::string> Get(void)
+   {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      std::vector<std::string> messages;
+      messages.swap(m_Messages);
+      return messages;
+   }
+
+public:
+   std::mutex               m_Mutex;
+   std::vector<std::string> m_Messages;
+   unsigned int             m_SleepUs;
+};
+
+CCapture g_Capture;
+
+void Capture(const std::string& strLog)
+{
+   g_Capture.Log(strLog);
+}
+
+/** Format immediately, to compare with.
+ **/
+std::string Expected(const char* const szFormat, ...) __printf(0);
+
+std::string Expected(const char* const szFormat, ...)
+{
+   va_list ap;
+   va_start(ap, szFormat);
+   char sz[4096];
+   vsnprintf(sz, sizeof(sz), szFormat, ap);
+   va_end(ap);
+   return sz;
+}
+
+/** Log the same message deferred and immediately formatted.
+ **/
+#define CHECK_FORMAT(EXPECTED, ...) LogInfo(__VA_ARGS__) ; EXPECTED.push_back(Expected(__VA_ARGS__))
+
+/****************************************************************************************
+ ** 
+ ** main
+ **
+ ***************************************************************************************/
+int main (int, char**)
+{
+   int ret = 0;
+   try {
+      RegisterLogInfo(Capture);
+      RegisterLogWarning(Capture);
+
+      //conversions, formatted by the background thread
+      {
+         CBinaryLog::Start(EAsyncLogOverflowBlock);
+         const std::string        strLong(1000, 'x');
+         int                      i(-42);
+         std::vector<std::string> expected;
+         CHECK_FORMAT(expected, "int %d unsigned %u hex %#x short %hd char %c\n", i, 42u, 255u, static_cast<short>(7), 'c');
+         CHECK_FORMAT(expected, "long %ld long long %lld size %zu ptrdiff %td intmax %jd\n", -1L, 1LL << 40, sizeof(strLong), static_cast<ptrdiff_t>(-3), static_cast<intmax_t>(9));
+         CHECK_FORMAT(expected, "double %5.2f %e %g long double %Lf\n", 3.14159, 1e10, 0.5, static_cast<long double>(2.5));
+         CHECK_FORMAT(expected, "string [%s] [%-8s] [%*s] [%.3s] [%.*s] %%\n", "abc", "left", 6, "right", "truncated", 2, "precision");
+         CHECK_FORMAT(expected, "pointer %p\n", static_cast<void*>(&i));
+         CHECK_FORMAT(expected, "long message %s\n", strLong.c_str());
+         CHECK_FORMAT(expected, "wide string %ls (formatted immediately, recorded in order)\n", L"wide");
+         CHECK_FORMAT(expected, "no conversions\n");
+         LogWarning("warning %d\n", 1);
+         expected.push_back("warning 1\n");
+         CBinaryLog::Flush();
+         const std::vector<std::string> messages(g_Capture.Get());
+         if(expected != messages) {
+            for(size_t u = 0 ; u < messages.size() ; ++u) {
+               std::cerr << "got: " << messages[u];
+            }
+            throw std::runtime_error("conversions: messages differ from vsnprintf");
+         }
+         if(1001 > messages[5].size()) {
+            throw std::runtime_error("conversions: long message truncated");
+         }
+         std::cout << "conversions: " << messages.size() << " messages match vsnprintf" << std::endl;
+      }
+
+      //4 threads: the order of the messages of each thread is kept
+      {
+         const unsigned int threads (4);
+         const unsigned int messages(1000);
+         std::vector<std::thread> workers;
+         for(unsigned int t = 0 ; t < threads ; ++t) {
+            workers.push_back(std::thread([t, messages](){
+                     for(unsigned int u = 0 ; u < messages ; ++u) {
+                        LogInfo("thread %u message %u\n", t, u);
+                     }
+                  }));
+         }
+         for(std::vector<std::thread>::iterator it = workers.begin() ; workers.end() != it ; ++it) {
+            it->join();
+         }
+         CBinaryLog::Stop();
+         const std::vector<std::string> captured(g_Capture.Get());
+         std::vector<unsigned int> next(threads, 0);
+         for(std::vector<std::string>::const_iterator cit = captured.begin() ; captured.end() != cit ; ++cit) {
+            unsigned int t, u;
+            if(2 != sscanf(cit->c_str(), "thread %u message %u", &t, &u) || threads <= t || next[t] != u) {
+               throw std::runtime_error("threads: unexpected message " + *cit);
+            }
+            ++next[t];
+         }
+         if(threads * messages != captured.size()) {
+            throw std::runtime_error("threads: messages missing");
+         }
+         std::cout << "threads: " << captured.size() << " messages in order" << std::endl;
+      }
+
+      //binary log file, decoded offline
+      {
+         const char* const szFile("BinaryLog.bin");
+         if(!CBinaryLog::Start(szFile)) {
+            throw std::runtime_error("file: cannot create " + std::string(szFile));
+         }
+         LogInfo("first %d\n", 1);
+         LogIndent();
+         LogWarning("indented [%s]\n", "string");
+         LogUnindent();
+         LogErr("last %.1f\n", 2.5);
+         CBinaryLog::Stop();
+         std::ifstream      in(szFile, std::ios::binary);
+         std::ostringstream out;
+         std::string        strError;
+         if(!CBinaryLog::Decode(in, out, strError)) {
+            throw std::runtime_error("file: decoding failed: " + strError);
+         }
+         in.close();
+         remove(szFile);
+         const std::string strExpected("info first 1\nwarning    indented [string]\nerr last 2.5\n");
+         if(strExpected != out.str()) {
+            throw std::runtime_error("file: unexpected decoded log:\n" + out.str());
+         }
+         std::cout << "file:" << std::endl << out.str();
+      }
+
+      //a slow logging function and a small buffer: records are dropped and counted
+      {
+         const unsigned int messages(2000);
+         CBinaryLog::SetCapacity(4096);
+         CBinaryLog::Start(EAsyncLogOverflowDrop);
+         g_Capture.m_SleepUs = 100;
+         std::thread worker([messages](){
+               for(unsigned int u = 0 ; u < messages ; ++u) {
+                  LogInfo("message %u with some text to fill the buffer\n", u);
+               }
+            });
+         worker.join();
+         CBinaryLog::Stop();
+         g_Capture.m_SleepUs = 0;
+         const size_t captured(g_Capture.Get().size());
+         std::cout << "dropping: captured " << captured << ", dropped " << CBinaryLog::GetDropped() << std::endl;
+         if(0 == CBinaryLog::GetDropped() || messages != captured + CBinaryLog::GetDropped()) {
+            throw std::runtime_error("dropping: unexpected captured/dropped count");
+         }
+      }
+
+      UnRegisterLogInfo();
+      UnRegisterLogWarning();
+   } catch(std::exception& e) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      ret = 1;
+   } catch(...) {
+      std::cerr << "unknown exception" << std::endl;
+      ret = 1;
+   }
+   return ret;
+}
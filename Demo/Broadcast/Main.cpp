@@ -0,0 +1,251 @@
+/** @file
+ ** @brief Broadcast demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "vector"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ **
+ ** Sessions: idle and active with a parent state, and a default state.
+ ** Monitor:  1 state with an event-type handler for the alarms.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsStart  = 1, //idle   --> active
+   EEventsStop   = 2, //active --> idle
+   EEventsTick   = 3, //active (counts)
+   EEventsConfig = 4, //default state (counts)
+   EEventsPing   = 5  //parent of idle and active
+};
+
+enum EAlarms {
+   EAlarmsRaised = 1  //monitor, event-type handler (counts)
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Ticks(0)
+      , m_Configs(0)
+      , m_Alarms(0)
+   {
+   }
+
+public:
+   unsigned int m_Ticks;
+   unsigned int m_Configs;
+   unsigned int m_Alarms;
+};
+
+class CStateSession : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateSession(WPStateMachine wpStateMachine, CDemoData* const)
+      : CStateEvtId("session", wpStateMachine)
+   {
+      EventRegister(HANDLER(int, CStateSession, Handler), CCreateState(), EEventsPing);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateIdle : public ILULibStateMachine::CStateEvtId {
+public:
+   typedef CStateSession TParentState;
+
+public:
+   CStateIdle(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateActive : public ILULibStateMachine::CStateEvtId {
+public:
+   typedef CStateSession TParentState;
+
+public:
+   CStateActive(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+   void Tick(const int* const)
+   {
+      ++m_pData->m_Ticks;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateDefault : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDefault(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("default", wpStateMachine, true)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateDefault, Config), CCreateState(), EEventsConfig);
+   }
+
+public:
+   void Config(const int* const)
+   {
+      ++m_pData->m_Configs;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateMonitor : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateMonitor(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("monitor", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventTypeRegister(TEventEvtId<EAlarms>::IdTypeInit().c_str(), HANDLER_TYPE(int, CStateMonitor, Alarm), CCreateState());
+   }
+
+public:
+   void Alarm(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Alarms;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** The state constructors register the handlers: all states are declared by now.
+ **
+ ***************************************************************************************/
+CStateIdle::CStateIdle(WPStateMachine wpStateMachine, CDemoData* const)
+   : CStateEvtId("idle", wpStateMachine)
+{
+   EventRegister(HANDLER(int, CStateIdle, Handler), TCreateStateShared<CStateActive, CDemoData>(), EEventsStart);
+}
+
+CStateActive::CStateActive(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateEvtId("active", wpStateMachine)
+   , m_pData(pData)
+{
+   EventRegister(HANDLER(int, CStateActive, Tick),    CCreateState(),                               EEventsTick);
+   EventRegister(HANDLER(int, CStateActive, Handler), TCreateStateShared<CStateIdle, CDemoData>(), EEventsStop);
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It subscribes 1000 sessions and a monitor to a broadcast and checks that
+ ** a broadcast event is only fed into the state machines with a handler for
+ ** it, also after they changed state.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogNotice(FLog());
+
+   const size_t                SESSIONS(1000);
+   const int                   iEvtData(0);
+   bool                        bOk(true);
+   CBroadcast                  broadcast;
+   std::vector<SPStateMachine> sessions;
+   std::vector<CDemoData*>     data;
+
+   //the sessions use an arena: the index does not keep their event ID's once they are gone
+   for(size_t session = 0 ; session < SESSIONS ; ++session) {
+      data.push_back(new CDemoData());
+      sessions.push_back(CStateMachine::ConstructStateMachine("session", TCreateStateShared<CStateIdle, CDemoData>(), TCreateStateShared<CStateDefault, CDemoData>(), data.back(), 4096));
+      broadcast.Subscribe(sessions.back());
+   }
+   CDemoData*     pMonitorData(new CDemoData());
+   SPStateMachine spMonitor(CStateMachine::ConstructStateMachine("monitor", TCreateStateShared<CStateMonitor, CDemoData>(), pMonitorData));
+   broadcast.Subscribe(spMonitor);
+   bOk &= Check("subscribers",             broadcast.GetSubscriberCount(),                    SESSIONS + 1);
+
+   //no session is active
+   bOk &= Check("tick, all idle",          broadcast.Broadcast(&iEvtData, EEventsTick),       0);
+
+   //every 10th session becomes active: the index follows the state changes
+   for(size_t session = 0 ; session < SESSIONS ; session += 10) {
+      sessions[session]->EventHandle(&iEvtData, EEventsStart);
+   }
+   bOk &= Check("tick, 10% active",        broadcast.Broadcast(&iEvtData, EEventsTick),       SESSIONS / 10);
+   size_t ticks(0);
+   for(size_t session = 0 ; session < SESSIONS ; ++session) {
+      ticks += data[session]->m_Ticks;
+      bOk   &= (data[session]->m_Ticks == (0 == session % 10 ? 1u : 0u));
+   }
+   bOk &= Check("ticks",                   ticks,                                             SESSIONS / 10);
+
+   //the parent of idle and active stays indexed while the sessions change state
+   bOk &= Check("ping",                    broadcast.Broadcast(&iEvtData, EEventsPing),       SESSIONS);
+
+   //the default states and an event-type handler
+   bOk &= Check("config",                  broadcast.Broadcast(&iEvtData, EEventsConfig),     SESSIONS);
+   bOk &= Check("alarm",                   broadcast.Broadcast(&iEvtData, EAlarmsRaised),     1);
+   bOk &= Check("monitor alarms",          pMonitorData->m_Alarms,                            1);
+
+   //a destructed session unsubscribes, its event ID's are no longer used
+   sessions[0].reset();
+   bOk &= Check("tick, 1 destructed",      broadcast.Broadcast(&iEvtData, EEventsTick),       SESSIONS / 10 - 1);
+
+   //the broadcast event changes the state of the sessions
+   bOk &= Check("stop",                    broadcast.Broadcast(&iEvtData, EEventsStop),       SESSIONS / 10 - 1);
+   bOk &= Check("tick, all idle again",    broadcast.Broadcast(&iEvtData, EEventsTick),       0);
+   bOk &= Check("ping, all idle again",    broadcast.Broadcast(&iEvtData, EEventsPing),       SESSIONS - 1);
+
+   //an unsubscribed session no longer gets the events
+   broadcast.Unsubscribe(*sessions[1]);
+   bOk &= Check("config, 1 unsubscribed",  broadcast.Broadcast(&iEvtData, EEventsConfig),     SESSIONS - 2);
+   bOk &= Check("session 1 configs",       data[1]->m_Configs,                                1);
+   bOk &= Check("subscribers",             broadcast.GetSubscriberCount(),                    SESSIONS - 1);
+
+   sessions.clear();
+   spMonitor.reset();
+   bOk &= Check("subscribers, all gone",   broadcast.GetSubscriberCount(),                    0);
+
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
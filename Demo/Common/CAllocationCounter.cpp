@@ -0,0 +1,141 @@
+/** @file
+ ** @brief The CAllocationCounter implementation.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <cstdlib>
+#include <new>
+
+#include "CAllocationStats.h"
+
+#include "CAllocationCounter.h"
+#include "Gcc.h"
+
+namespace {
+   const std::size_t  HEADER_SIZE(16); ///< Room in front of each allocation for its size, keeps the fundamental alignment.
+   unsigned long long s_Count(0);      ///< Number of allocations since the start of the program.
+   unsigned long long s_Bytes(0);      ///< Number of bytes allocated since the start of the program.
+   unsigned long long s_BytesInUse(0); ///< Number of bytes allocated and not yet freed.
+
+   /** Allocate and count, also for the allocation accounting of the
+    ** state machine library (only when compiled with ALLOCATION_STATS).
+    **
+    ** @return the allocated memory, throws std::bad_alloc on failure.
+    **/
+   void* Allocate(
+      std::size_t size //< Number of bytes.
+      )
+   {
+      char* const p(static_cast<char*>(std::malloc(HEADER_SIZE + size)));
+      if(NULL == p) {
+         throw std::bad_alloc();
+      }
+      *reinterpret_cast<std::size_t*>(p) = size;
+      ++s_Count;
+      s_Bytes      += size;
+      s_BytesInUse += size;
+      ILULibStateMachine::CAllocationStats::RecordAllocation(size);
+      return p + HEADER_SIZE;
+   }
+
+   /** Free memory returned by Allocate.
+    **/
+   void Free(
+      void* p //< Memory to free, may be NULL.
+      )
+   {
+      if(NULL == p) {
+         return;
+      }
+      char* const pBlock(static_cast<char*>(p) - HEADER_SIZE);
+      s_BytesInUse -= *reinterpret_cast<std::size_t*>(pBlock);
+      std::free(pBlock);
+   }
+}
+
+/** Replaced global operator new, counting allocations.
+ **/
+__noinline void* operator new(std::size_t size)
+{
+   return Allocate(size);
+}
+
+/** Replaced global operator new[], counting allocations.
+ **/
+__noinline void* operator new[](std::size_t size)
+{
+   return Allocate(size);
+}
+
+/** Replaced global operator delete.
+ **/
+__noinline void operator delete(void* p) noexcept
+{
+   Free(p);
+}
+
+/** Replaced global operator delete[].
+ **/
+__noinline void operator delete[](void* p) noexcept
+{
+   Free(p);
+}
+
+/** Replaced global sized operator delete.
+ **/
+__noinline void operator delete(void* p, std::size_t) noexcept
+{
+   Free(p);
+}
+
+/** Replaced global sized operator delete[].
+ **/
+__noinline void operator delete[](void* p, std::size_t) noexcept
+{
+   Free(p);
+}
+
+namespace ILUDemo {
+   /** Get the number of allocations.
+    **
+    ** @return the number of allocations since the start of the program.
+    **/
+   unsigned long long CAllocationCounter::GetCount(void)
+   {
+      return s_Count;
+   }
+
+   /** Get the number of bytes allocated.
+    **
+    ** @return the number of bytes allocated since the start of the program.
+    **/
+   unsigned long long CAllocationCounter::GetBytes(void)
+   {
+      return s_Bytes;
+   }
+
+   /** Get the number of bytes in use.
+    **
+    ** @return the number of bytes allocated and not yet freed.
+    **/
+   unsigned long long CAllocationCounter::GetBytesInUse(void)
+   {
+      return s_BytesInUse;
+   }
+}
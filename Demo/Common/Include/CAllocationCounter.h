@@ -0,0 +1,48 @@
+/** @file
+ ** @brief The CAllocationCounter declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILUDemo_CAllocationCounter__H__
+#define __ILUDemo_CAllocationCounter__H__
+
+#include <cstddef>
+
+namespace ILUDemo {
+   /** @brief Counts the allocations made through the global operator new.
+    **
+    ** Linking the demo library (the demos and the benchmarks do) replaces
+    ** the global operator new and delete: every allocation of the program
+    ** is counted, including the ones made inside the state machine library,
+    ** and reported to CAllocationStats.
+    ** The size of each allocation is kept in front of it, so the bytes in
+    ** use are known at any time.
+    **
+    ** The counters are not thread safe: the demos and benchmarks using them
+    ** allocate from 1 thread only.
+    **/
+   class CAllocationCounter {
+      public:
+         static unsigned long long GetCount(void);
+         static unsigned long long GetBytes(void);
+         static unsigned long long GetBytesInUse(void);
+   };
+}
+
+#endif //__ILUDemo_CAllocationCounter__H__
@@ -0,0 +1,47 @@
+/** @file
+ ** @brief Checks shared by the demos.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILUDemo_DemoCheck__H__
+#define __ILUDemo_DemoCheck__H__
+
+#include <stdio.h>
+
+namespace ILUDemo {
+   /** Compare a value (a count, a size, ...) with the expected value and
+    ** report it on stdout when they differ.
+    **
+    ** @return true when equal.
+    **/
+   inline bool Check(
+      const char*              szWhat,  //< What the value is, used in the report.
+      const unsigned long long value,   //< The value.
+      const unsigned long long expected //< The expected value.
+      )
+   {
+      if(value == expected) {
+         return true;
+      }
+      printf("%s is %llu, expected %llu\n", szWhat, value, expected);
+      return false;
+   }
+}
+
+#endif //__ILUDemo_DemoCheck__H__
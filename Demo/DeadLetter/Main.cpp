@@ -0,0 +1,225 @@
+/** @file
+ ** @brief Unhandled events and dead letters demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "cstring"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** The state handles 1 event, a peer sends others.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork    = 1, //handled
+   EEventsUnknown = 2, //not handled
+   EEventsOther   = 3  //not handled
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+   {
+   }
+
+public:
+   unsigned int m_Handled;
+};
+
+class CStateWork : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWork(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("work", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** The number of times the registered handlers have been logged.
+ **/
+unsigned int g_Traces(0);
+
+void LogDebugCount(const std::string& strLog)
+{
+   if(NULL != strstr(strLog.c_str(), "registered handlers")) {
+      ++g_Traces;
+   }
+}
+
+/** The dead letters received by the function.
+ **/
+unsigned int   g_Letters(0);
+CDeadLetter    g_LastLetter;
+
+/** State machine fed from within the dead-letter function.
+ **/
+SPStateMachine g_spFallback;
+
+void DeadLetter(const CDeadLetter& deadLetter)
+{
+   ++g_Letters;
+   g_LastLetter = deadLetter;
+   if(g_spFallback) {
+      //no lock is held: the function can feed events into state machines
+      const int iEvtData(0);
+      g_spFallback->EventHandle(&iEvtData, EEventsWork);
+   }
+}
+
+/** Print the number of unhandled events per key.
+ **/
+void Print(const CUnhandledKey& key, const unsigned long long count)
+{
+   printf("%-8s %-6s %-32s %llu\n", key.m_strMachine.c_str(), key.m_strState.c_str(), key.m_strEvent.c_str(), count);
+}
+
+/** The total number of unhandled events.
+ **/
+unsigned long long g_Total(0);
+
+void Sum(const CUnhandledKey&, const unsigned long long count)
+{
+   g_Total += count;
+}
+
+SPStateMachine Construct(const char* szName, CDemoData*& pData)
+{
+   pData = new CDemoData();
+   return CStateMachine::ConstructStateMachine(szName, TCreateState<CStateWork, CDemoData>(pData), pData);
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It sends a burst of unexpected events and checks that they are counted
+ ** and passed on as dead letters, while the registered handlers are only
+ ** logged once per key.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (LogDebugCount);
+   RegisterLogNotice(FLog());
+   CUnhandledEvents::RegisterDeadLetter(DeadLetter);
+   CUnhandledEvents::SetQueueCapacity(16);
+
+   bool           bOk(true);
+   const int      iEvtData(0);
+   CDemoData*     pData(NULL);
+   CDemoData*     pFallbackData(NULL);
+   SPStateMachine spStateMachine(Construct("peer", pData));
+   g_spFallback = Construct("fallback", pFallbackData);
+
+   //a burst of unexpected events: the handlers are logged once per key
+   for(unsigned int i = 0 ; i < 1000 ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsUnknown);
+   }
+   spStateMachine->EventHandle(&iEvtData, EEventsOther);
+   spStateMachine->EventHandle(&iEvtData, EEventsWork);
+   bOk &= Check("handled events",      pData->m_Handled,                       1);
+   bOk &= Check("handler loggings",    g_Traces,                               2);
+   bOk &= Check("suppressed loggings", CUnhandledEvents::GetTraceSuppressed(), 999);
+
+   //every unhandled event is a dead letter
+   bOk &= Check("dead letters",                  g_Letters,                  1001);
+   bOk &= Check("events fed by the dead letters", pFallbackData->m_Handled,   1001);
+   bOk &= Check("last letter machine ID",        g_LastLetter.m_MachineId,   spStateMachine->GetId());
+   bOk &= Check("last letter count",             g_LastLetter.m_Count,       1);
+   printf("last letter: machine [%s] state [%s] event [%s] type [%s] data [%s]\n",
+          g_LastLetter.m_strMachine.c_str(),
+          g_LastLetter.m_strState.c_str(),
+          g_LastLetter.m_strEvent.c_str(),
+          g_LastLetter.m_strEventType.c_str(),
+          g_LastLetter.m_strDataType.c_str()
+          );
+
+   //the queue keeps the most recent ones
+   CDeadLetter        deadLetter;
+   unsigned long long queued(0);
+   while(CUnhandledEvents::Pop(deadLetter)) {
+      ++queued;
+   }
+   bOk &= Check("queued letters",  queued,                              16);
+   bOk &= Check("dropped letters", CUnhandledEvents::GetQueueDropped(), 1001 - 16);
+   bOk &= Check("last queued letter count", deadLetter.m_Count, 1);
+
+   //the counts per key
+   CUnhandledEvents::ForEach(&Print);
+   CUnhandledEvents::ForEach(&Sum);
+   bOk &= Check("unhandled events", g_Total, 1001);
+
+   //without interval the handlers are logged for every unhandled event
+   CUnhandledEvents::SetTraceInterval(0);
+   g_Traces = 0;
+   for(unsigned int i = 0 ; i < 10 ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsUnknown);
+   }
+   bOk &= Check("handler loggings without interval", g_Traces, 10);
+
+   //without consumer a burst is counted without locking, the keys that do not fit are counted together
+   CUnhandledEvents::SetTraceInterval(CUnhandledEvents::DEFAULT_TRACE_INTERVAL_MS);
+   CUnhandledEvents::SetQueueCapacity(0);
+   CUnhandledEvents::UnRegisterDeadLetter();
+   CUnhandledEvents::Reset();
+   CUnhandledEvents::SetKeyCapacity(1);
+   g_Traces = 0;
+   g_Total  = 0;
+   for(unsigned int i = 0 ; i < 1000 ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsUnknown);
+   }
+   spStateMachine->EventHandle(&iEvtData, EEventsOther);
+   CUnhandledEvents::ForEach(&Sum);
+   bOk &= Check("handler loggings without consumer",  g_Traces,                           2);
+   bOk &= Check("unhandled events without consumer",  g_Total,                            1000);
+   bOk &= Check("unhandled events not fitting",       CUnhandledEvents::GetKeyOverflow(), 1);
+
+   CUnhandledEvents::SetKeyCapacity(CUnhandledEvents::DEFAULT_KEY_CAPACITY);
+   CUnhandledEvents::Reset();
+   g_spFallback.reset();
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+/** @file
+ ** @brief Dense event ID demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "chrono"
+#include "cstdio"
+
+/****************************************************************************************
+ ** 
+ ** Event enums.
+ **
+ ** EDense and ESparse have the same values, only EDense is declared dense:
+ ** its handlers are found in a flat array.
+ **
+ ***************************************************************************************/
+enum EDense {
+   EDenseFirst = 1,
+   EDenseGuard = 5, //guarded handler
+   EDenseType  = 8, //no handler: the event-type handler
+   EDenseLast  = 9,
+   EDenseMap   = 20, //outside the declared range
+   EDenseNone  = 21  //outside the declared range, no handler
+};
+EVTID_DENSE(EDense, 1, 9)
+
+enum ESparse {
+   ESparseFirst = 1,
+   ESparseGuard = 5,
+   ESparseType  = 8,
+   ESparseLast  = 9,
+   ESparseMap   = 20,
+   ESparseNone  = 21
+};
+
+enum ESub {
+   ESubA = 1
+};
+
+/****************************************************************************************
+ ** 
+ ** State machine data and the state.
+ **
+ ** The handlers count the events per data value: the data of an event is
+ ** the value expected to be counted.
+ **
+ ***************************************************************************************/
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+   {
+      for(unsigned int i = 0 ; i < sizeof(m_Counts) / sizeof(m_Counts[0]) ; ++i) {
+         m_Counts[i] = 0;
+      }
+   }
+
+public:
+   unsigned int m_Counts[100];
+};
+
+template <class EvtId> class TStateDemo : public ILULibStateMachine::CStateEvtId {
+public:
+   TStateDemo(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("demo", wpStateMachine)
+      , m_pData(pData)
+   {
+      //every ID in the range, except the one for the event-type handler
+      for(int id = 1 ; id <= 9 ; ++id) {
+         if(8 != id) {
+            EventRegister(HANDLER(int, TStateDemo, Handler), CCreateState(), static_cast<EvtId>(id));
+         }
+      }
+      //a guard before the unguarded handler
+      EventRegister(GUARD(int, TStateDemo, Guard), HANDLER(int, TStateDemo, Handler), CCreateState(), static_cast<EvtId>(5));
+      //outside the range and with a sub-ID: in the map
+      EventRegister(HANDLER(int, TStateDemo, Handler), CCreateState(), static_cast<EvtId>(20));
+      EventRegister(HANDLER(int, TStateDemo, Handler), CCreateState(), static_cast<EvtId>(1), ESubA);
+      //the other events of the type
+      EventTypeRegister(TEventEvtId<EvtId>::IdTypeInit().c_str(), HANDLER_TYPE(int, TStateDemo, HandlerType), CCreateState());
+   }
+
+public:
+   bool Guard(const int* const pEvtData)
+   {
+      return 50 == *pEvtData;
+   }
+
+   void Handler(const int* const pEvtData)
+   {
+      ++m_pData->m_Counts[*pEvtData];
+   }
+
+   void HandlerType(SPEventBase, const int* const pEvtData)
+   {
+      ++m_pData->m_Counts[*pEvtData];
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed an event and check that the handler for the data value counted it.
+ **
+ ** @return true when counted.
+ **/
+template <class EvtId>
+bool Step(SPStateMachine spStateMachine, CDemoData* const pData, const int evtId, const int iEvtData)
+{
+   const unsigned int count(pData->m_Counts[iEvtData]);
+   spStateMachine->EventHandle(&iEvtData, static_cast<EvtId>(evtId));
+   if(count + 1 == pData->m_Counts[iEvtData]) {
+      return true;
+   }
+   printf("event %d with data %d not handled as expected\n", evtId, iEvtData);
+   return false;
+}
+
+/** Feed the same events into a state machine with dense and with sparse
+ ** event ID's.
+ **
+ ** @return true when all events were handled as expected.
+ **/
+template <class EvtId>
+bool Run(const char* szName)
+{
+   bool           bOk(true);
+   CDemoData*     pData(new CDemoData());
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine(szName, TCreateStateShared<TStateDemo<EvtId>, CDemoData>(), pData));
+
+   //in the flat array
+   bOk &= Step<EvtId>(spStateMachine, pData, 1, 1);
+   bOk &= Step<EvtId>(spStateMachine, pData, 9, 9);
+   //guarded: the guard matches, then the unguarded handler
+   bOk &= Step<EvtId>(spStateMachine, pData, 5, 50);
+   bOk &= Step<EvtId>(spStateMachine, pData, 5, 51);
+   //no handler for the ID in the range: the event-type handler
+   bOk &= Step<EvtId>(spStateMachine, pData, 8, 8);
+   //outside the range: the map, or the event-type handler
+   bOk &= Step<EvtId>(spStateMachine, pData, 20, 20);
+   bOk &= Step<EvtId>(spStateMachine, pData, 21, 21);
+   //with a sub-ID: the map
+   {
+      const int iEvtData(11);
+      spStateMachine->EventHandle(&iEvtData, static_cast<EvtId>(1), ESubA);
+      bOk &= (1 == pData->m_Counts[11]);
+   }
+
+   //the cost of handling an event (without logging)
+   const unsigned int EVENTS(1000000);
+   const int          iEvtData(0);
+   CLogLevel::SetGlobal(ELogLevelCount);
+   const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+   for(unsigned int event = 0 ; event < EVENTS ; ++event) {
+      spStateMachine->EventHandle(&iEvtData, static_cast<EvtId>(1 + event % 7));
+   }
+   const long long ns(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+   CLogLevel::SetGlobal(ELogLevelDebug);
+   bOk &= (EVENTS == pData->m_Counts[0]);
+   printf("%-6s: %s, %lld ns per event\n", szName, bOk ? "ok" : "failed", ns / EVENTS);
+   return bOk;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It checks that a dense event ID type finds the same handlers as a
+ ** sparse one and shows the cost per event of both.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogInfo  (FLog());
+   RegisterLogNotice(FLog());
+
+   bool bOk(true);
+   bOk &= Run<EDense> ("dense" );
+   bOk &= Run<ESparse>("sparse");
+
+   UnRegisterLogNotice();
+   UnRegisterLogInfo  ();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
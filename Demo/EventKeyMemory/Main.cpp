@@ -0,0 +1,170 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the allocation counter shared by the demos
+#include "CAllocationCounter.h"
+using ILUDemo::CAllocationCounter;
+
+#include "string"
+#include "vector"
+
+/****************************************************************************************
+ ** 
+ ** Event enums and state.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork = 1
+};
+
+/** A state registering iCount handlers, each for another sub-ID.
+ **/
+class CStateWork : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWork(WPStateMachine wpStateMachine, unsigned int* const piCount)
+      : CStateEvtId("work", wpStateMachine)
+   {
+      for(unsigned int i = 0 ; i < *piCount ; ++i) {
+         EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork, i);
+      }
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+/** The event identification as it was before it derived its descriptions on
+ ** demand: the same key also holding the 3 textual descriptions as strings.
+ ** Only used to report the memory before and after.
+ **/
+class CStringKey : public TEventEvtId<EEvents, unsigned int> {
+public:
+   CStringKey(const unsigned int evtSubId)
+      : TEventEvtId<EEvents, unsigned int>(typeid(int), EEventsWork, evtSubId)
+      , m_strId(GetId())
+      , m_strIdType(GetIdType())
+      , m_strDataType(GetDataType())
+   {
+   }
+
+private:
+   const std::string m_strId;
+   const std::string m_strIdType;
+   const std::string m_strDataType;
+};
+
+/****************************************************************************************
+ ** 
+ ** Measurement helpers.
+ **
+ ***************************************************************************************/
+/** Get the heap bytes used by a state machine with a state registering
+ ** iCount handlers.
+ **
+ ** @return the heap bytes in use while the state machine exists.
+ **/
+size_t StateMachineBytes(unsigned int iCount)
+{
+   const unsigned long long before(CAllocationCounter::GetBytesInUse());
+   SPStateMachine           spStateMachine(CStateMachine::ConstructStateMachine("keys", TCreateState<CStateWork, unsigned int>(&iCount)));
+   return (size_t)(CAllocationCounter::GetBytesInUse() - before);
+}
+
+/** Get the heap bytes used by iCount event identifications, as created
+ ** when an event is registered or fed into a state machine.
+ **
+ ** @return the heap bytes per event identification.
+ **/
+size_t KeyBytes(const unsigned int iCount)
+{
+   std::vector<SPEventBase> keys;
+   keys.reserve(iCount);
+   const unsigned long long before(CAllocationCounter::GetBytesInUse());
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      keys.push_back(TYPESEL::make_shared<TEventEvtId<EEvents, unsigned int> >(typeid(int), EEventsWork, i));
+   }
+   return (size_t)(CAllocationCounter::GetBytesInUse() - before) / iCount;
+}
+
+/** Get the heap bytes used by iCount event identifications holding their
+ ** descriptions as strings (CStringKey), created the same way.
+ **
+ ** @return the heap bytes per event identification.
+ **/
+size_t StringKeyBytes(const unsigned int iCount)
+{
+   std::vector<SPEventBase> keys;
+   keys.reserve(iCount);
+   const unsigned long long before(CAllocationCounter::GetBytesInUse());
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      keys.push_back(TYPESEL::make_shared<CStringKey>(i));
+   }
+   return (size_t)(CAllocationCounter::GetBytesInUse() - before) / iCount;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It reports the heap memory of an event identification and of a registered
+ ** handler (event identification, handler info and map node), before (keys
+ ** holding their descriptions as strings) and after, and checks the event
+ ** identification still describes itself correctly in the logging.
+ ** A registered handler holds 1 key, so its size before is its size after
+ ** plus the difference between both keys.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   const unsigned int iCount(1000);
+   LogInfo("[%s][%u] event-key memory demo in\n", __FUNCTION__, __LINE__);
+   RegisterLogNotice(FLog());
+
+   StateMachineBytes(iCount); //warm-up: one-time allocations are not part of the report
+   const size_t keyBytes          (KeyBytes(iCount));
+   const size_t stringKeyBytes    (StringKeyBytes(iCount));
+   const size_t handlerBytes      ((StateMachineBytes(iCount) - StateMachineBytes(0)) / iCount);
+   const size_t stringHandlerBytes(handlerBytes + stringKeyBytes - keyBytes);
+
+   UnRegisterLogNotice();
+   LogInfo("[%s][%u] event identification: %lu bytes (%lu bytes object), was %lu bytes (%lu bytes object)\n", __FUNCTION__, __LINE__, (long unsigned int)keyBytes, (long unsigned int)sizeof(TEventEvtId<EEvents, unsigned int>), (long unsigned int)stringKeyBytes, (long unsigned int)sizeof(CStringKey));
+   LogInfo("[%s][%u] registered handler:   %lu bytes, was %lu bytes\n", __FUNCTION__, __LINE__, (long unsigned int)handlerBytes, (long unsigned int)stringHandlerBytes);
+
+   int iResult(0);
+   if(keyBytes > 64) {
+      LogErr("[%s][%u] an event identification should fit in 64 bytes (including its shared pointer control block)\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+   const TEventEvtId<EEvents, unsigned int> key(typeid(int), EEventsWork, 10);
+   LogInfo("[%s][%u] described as: ID [%s] ID type [%s] data type [%s]\n", __FUNCTION__, __LINE__, key.GetId().c_str(), key.GetIdType().c_str(), key.GetDataType().c_str());
+   if(key.GetId() != "0x0001-0x000A") {
+      LogErr("[%s][%u] wrong event ID description\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+
+   LogInfo("[%s][%u] event-key memory demo out\n", __FUNCTION__, __LINE__);
+   return iResult;
+}
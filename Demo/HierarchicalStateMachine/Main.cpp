@@ -0,0 +1,344 @@
+/** @file
+ ** @brief Hierarchical state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "string"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ **
+ ** off
+ ** operational
+ **    connecting
+ **    connected
+ **       idle
+ **       busy
+ **
+ ** Every state records its entry and exit in g_strLog.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsPowerOn    = 1, //off                   --> connecting
+   EEventsPowerOff   = 2, //operational (parent)  --> off
+   EEventsConnected  = 3, //connecting            --> idle
+   EEventsDisconnect = 4, //connected (parent)    --> connecting
+   EEventsWork       = 5, //idle                  --> busy
+   EEventsDone       = 6, //busy                  --> idle
+   EEventsReconnect  = 7, //idle                  --> connected (its own parent)
+   EEventsPing       = 8, //busy, operational (parent) and the default state
+   EEventsStatus     = 9  //connected (parent), shared handler
+};
+
+/** Entry and exit of the states.
+ **/
+std::string g_strLog;
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_BusyPings(0)
+      , m_ParentPings(0)
+      , m_DefaultPings(0)
+      , m_Status(0)
+   {
+   }
+
+public:
+   unsigned int m_BusyPings;
+   unsigned int m_ParentPings;
+   unsigned int m_DefaultPings;
+   unsigned int m_Status;
+};
+
+/** Base class of the demo states: records the entry and exit.
+ **/
+class CStateDemo : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDemo(const char* const szName, WPStateMachine wpStateMachine, CDemoData* const pData, const bool bDefault = false)
+      : CStateEvtId(szName, wpStateMachine, bDefault)
+      , m_pData(pData)
+   {
+      g_strLog += "+" + GetName() + " ";
+   }
+
+   ~CStateDemo(void)
+   {
+      g_strLog += "-" + GetName() + " ";
+   }
+
+protected:
+   CDemoData* const m_pData;
+};
+
+class CStateDefault : public CStateDemo {
+public:
+   CStateDefault(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Ping(const int* const)
+   {
+      ++m_pData->m_DefaultPings;
+   }
+};
+
+class CStateOff : public CStateDemo {
+public:
+   CStateOff(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateOperational : public CStateDemo {
+public:
+   CStateOperational(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+   void Ping(const int* const)
+   {
+      ++m_pData->m_ParentPings;
+   }
+};
+
+class CStateConnecting : public CStateDemo {
+public:
+   typedef CStateOperational TParentState;
+
+public:
+   CStateConnecting(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateConnected : public CStateDemo {
+public:
+   typedef CStateOperational TParentState;
+
+public:
+   CStateConnected(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+   void Status(const int* const)
+   {
+      //shared handler: only works when called with this state
+      if(0x5eed == m_Seed) {
+         ++m_pData->m_Status;
+      }
+   }
+
+private:
+   const unsigned int m_Seed;
+};
+
+class CStateIdle : public CStateDemo {
+public:
+   typedef CStateConnected TParentState;
+
+public:
+   CStateIdle(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateBusy : public CStateDemo {
+public:
+   typedef CStateConnected TParentState;
+
+public:
+   CStateBusy(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+   void Ping(const int* const)
+   {
+      ++m_pData->m_BusyPings;
+   }
+};
+
+/****************************************************************************************
+ ** 
+ ** The state constructors register the handlers: all states are declared by now.
+ ** The parents register handlers for events their substates do not handle.
+ **
+ ***************************************************************************************/
+CStateDefault::CStateDefault(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("default", wpStateMachine, pData, true)
+{
+   EventRegister(HANDLER(int, CStateDefault, Ping), CCreateState(), EEventsPing);
+}
+
+CStateOff::CStateOff(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("off", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateOff, Handler), TCreateStateShared<CStateConnecting, CDemoData>(), EEventsPowerOn);
+}
+
+CStateOperational::CStateOperational(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("operational", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateOperational, Handler), TCreateStateShared<CStateOff, CDemoData>(), EEventsPowerOff);
+   EventRegister(HANDLER(int, CStateOperational, Ping),    CCreateState(),                            EEventsPing    );
+}
+
+CStateConnecting::CStateConnecting(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("connecting", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateConnecting, Handler), TCreateStateShared<CStateIdle, CDemoData>(), EEventsConnected);
+}
+
+CStateConnected::CStateConnected(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("connected", wpStateMachine, pData)
+   , m_Seed(0x5eed)
+{
+   EventRegister(HANDLER(int, CStateConnected, Handler),        TCreateStateShared<CStateConnecting, CDemoData>(), EEventsDisconnect);
+   EventRegister(HANDLER_SHARED(int, CStateConnected, Status), CCreateState(),                                    EEventsStatus    );
+}
+
+CStateIdle::CStateIdle(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("idle", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateIdle, Handler), TCreateStateShared<CStateBusy, CDemoData>(),      EEventsWork     );
+   EventRegister(HANDLER(int, CStateIdle, Handler), TCreateStateShared<CStateConnected, CDemoData>(), EEventsReconnect);
+}
+
+CStateBusy::CStateBusy(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("busy", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateBusy, Handler), TCreateStateShared<CStateIdle, CDemoData>(), EEventsDone);
+   EventRegister(HANDLER(int, CStateBusy, Ping),    CCreateState(),                              EEventsPing);
+}
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed an event and compare the entries and exits it caused with the
+ ** expected ones.
+ **
+ ** @return true when equal.
+ **/
+bool Step(SPStateMachine spStateMachine, const EEvents event, const char* szExpected)
+{
+   const int iEvtData(0);
+   g_strLog.clear();
+   spStateMachine->EventHandle(&iEvtData, event);
+   printf("event %d: %s\n", event, g_strLog.c_str());
+   if(g_strLog == szExpected) {
+      return true;
+   }
+   printf("expected: %s\n", szExpected);
+   return false;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It walks through the hierarchy and checks that the states are entered
+ ** and exited along the path between the current and the next state and
+ ** that the parents handle the events their substates do not handle.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogNotice(FLog());
+
+   bool           bOk(true);
+   CDemoData*     pData(new CDemoData());
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine("hierarchy", TCreateStateShared<CStateOff, CDemoData>(), TCreateStateShared<CStateDefault, CDemoData>(), pData));
+
+   //entering a substate enters its parents first, outermost first
+   bOk &= Step(spStateMachine, EEventsPowerOn,    "-off +operational +connecting ");
+   bOk &= Step(spStateMachine, EEventsConnected,  "-connecting +connected +idle ");
+   bOk &= Step(spStateMachine, EEventsWork,       "-idle +busy ");
+
+   //a substate handles an event before its parents
+   bOk &= Step(spStateMachine, EEventsPing,       "");
+   bOk &= Check("busy pings",    pData->m_BusyPings,    1);
+   bOk &= Check("parent pings",  pData->m_ParentPings,  0);
+
+   //a parent 2 levels up handles the event before the default state
+   bOk &= Step(spStateMachine, EEventsDone,       "-busy +idle ");
+   bOk &= Step(spStateMachine, EEventsPing,       "");
+   bOk &= Check("parent pings",  pData->m_ParentPings,  1);
+   bOk &= Check("default pings", pData->m_DefaultPings, 0);
+
+   //a shared handler of a parent gets the parent state
+   bOk &= Step(spStateMachine, EEventsStatus,     "");
+   bOk &= Check("status",        pData->m_Status,       1);
+
+   //changing to a parent re-enters it
+   bOk &= Step(spStateMachine, EEventsReconnect,  "-idle -connected +connected ");
+   bOk &= Step(spStateMachine, EEventsDisconnect, "-connected +connecting ");
+
+   //a parent changing state exits the substates first, innermost first
+   bOk &= Step(spStateMachine, EEventsConnected,  "-connecting +connected +idle ");
+   bOk &= Step(spStateMachine, EEventsWork,       "-idle +busy ");
+   bOk &= Step(spStateMachine, EEventsDisconnect, "-busy -connected +connecting ");
+   bOk &= Step(spStateMachine, EEventsPowerOff,   "-connecting -operational +off ");
+
+   //outside the hierarchy the default state handles the event
+   bOk &= Step(spStateMachine, EEventsPing,       "");
+   bOk &= Check("default pings", pData->m_DefaultPings, 1);
+   bOk &= Check("parent pings",  pData->m_ParentPings,  1);
+
+   //destructing the state machine exits the states innermost first
+   bOk &= Step(spStateMachine, EEventsPowerOn,    "-off +operational +connecting ");
+   g_strLog.clear();
+   spStateMachine.reset();
+   printf("destruct: %s\n", g_strLog.c_str());
+   bOk &= (g_strLog == "-connecting -operational -default ");
+
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
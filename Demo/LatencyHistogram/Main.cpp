@@ -0,0 +1,226 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "chrono"
+#include "cstdio"
+#include "cstring"
+#include "thread"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** state-1 --> state-2 --> state-1 ...
+ ** One of the handlers is slow.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsFast = 1,
+   EEventsSlow = 2,
+   EEventsNext = 3
+};
+
+class CState2;
+
+class CState1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState1(WPStateMachine wpStateMachine)
+      : CStateEvtId("state-1", wpStateMachine)
+   {
+      EventRegister(HANDLER(int, CState1, Fast), CCreateState(),                   EEventsFast);
+      EventRegister(HANDLER(int, CState1, Slow), CCreateState(),                   EEventsSlow);
+      EventRegister(HANDLER(int, CState1, Fast), TCreateStateNoData<CState2>(),    EEventsNext);
+   }
+
+public:
+   void Fast(const int* const)
+   {
+   }
+
+   void Slow(const int* const)
+   {
+      //busy for 200us
+      const std::chrono::steady_clock::time_point end(std::chrono::steady_clock::now() + std::chrono::microseconds(200));
+      while(std::chrono::steady_clock::now() < end) {
+      }
+   }
+};
+
+class CState2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState2(WPStateMachine wpStateMachine)
+      : CStateEvtId("state-2", wpStateMachine)
+   {
+      EventRegister(HANDLER(int, CState2, Fast), TCreateStateNoData<CState1>(), EEventsNext);
+   }
+
+public:
+   void Fast(const int* const)
+   {
+   }
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Get the ID of an event as used in the latency keys.
+ **/
+std::string GetId(const EEvents evtId)
+{
+   return TEventEvtId<EEvents>(typeid(int), evtId).GetId();
+}
+
+/** Feed events into a new state machine.
+ **/
+void Feed(const char* szName, const unsigned int fast, const unsigned int slow, const unsigned int next)
+{
+   const int      iEvtData(0);
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine(szName, TCreateStateNoData<CState1>()));
+   for(unsigned int i = 0 ; i < fast ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsFast);
+   }
+   for(unsigned int i = 0 ; i < slow ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsSlow);
+   }
+   for(unsigned int i = 0 ; i < next ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsNext);
+   }
+}
+
+/** Result of the report: the slowest histogram and the counts to check.
+ **/
+class CReport {
+public:
+   CReport(void)
+      : m_strSlowest()
+      , m_SlowestP99(0)
+      , m_FastCount(0)
+      , m_StateChangeCount(0)
+      , m_SampledCount(0)
+      , m_DisabledCount(0)
+   {
+   }
+
+public:
+   void Add(const CLatencyKey& key, const CLatencyHistogram& histogram)
+   {
+      const std::string strKey(std::string(CLatencyKey::GetName(key.m_Latency)) + " " + key.m_strMachine + " " + key.m_strState + " " + key.m_strEvent);
+      printf("%-64s count %4llu p50 %s p99 %s max %s\n",
+             strKey.c_str(),
+             histogram.GetCount(),
+             0 < histogram.GetPercentile(50) ? "> 0" : "0",
+             100000 < histogram.GetPercentile(99) ? "> 100us" : "< 100us",
+             100000 < histogram.GetMax() ? "> 100us" : "< 100us"
+             );
+      if(m_SlowestP99 < histogram.GetPercentile(99)) {
+         m_SlowestP99 = histogram.GetPercentile(99);
+         m_strSlowest = strKey;
+      }
+      if(ELatencyHandler == key.m_Latency && "latency" == key.m_strMachine && "state-1" == key.m_strState && GetId(EEventsFast) == key.m_strEvent) {
+         m_FastCount = histogram.GetCount();
+      }
+      if(ELatencyStateChange == key.m_Latency && "latency" == key.m_strMachine) {
+         m_StateChangeCount += histogram.GetCount();
+      }
+      if("sampled" == key.m_strMachine) {
+         m_SampledCount += histogram.GetCount();
+      }
+      if("disabled" == key.m_strMachine) {
+         m_DisabledCount += histogram.GetCount();
+      }
+   }
+
+public:
+   std::string        m_strSlowest;
+   unsigned long long m_SlowestP99;
+   unsigned long long m_FastCount;
+   unsigned long long m_StateChangeCount;
+   unsigned long long m_SampledCount;
+   unsigned long long m_DisabledCount;
+};
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It samples the events of 2 threads, merges their histograms and
+ ** finds the slow handler.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   if(!CStateMachineCounters::IsEnabled()) {
+      printf("library compiled without runtime statistics (configure --disable-runtime-stats) --> skip\n");
+      return 77;
+   }
+   RegisterLogInfo   (FLog());
+   RegisterLogNotice (FLog());
+   RegisterLogWarning(FLog());
+
+   bool bOk(true);
+
+   //sampling disabled: nothing recorded
+   Feed("disabled", 10, 0, 0);
+
+   //sample all events, in this thread and in another (finished) thread
+   CLatencyRecorder::SetSampling(1);
+   Feed("latency", 100, 10, 2);
+   std::thread thread(Feed, "latency", 100, 0, 0);
+   thread.join();
+
+   //sample every 4th event
+   CLatencyRecorder::SetSampling(4);
+   Feed("sampled", 40, 0, 0);
+   CLatencyRecorder::SetSampling(0);
+
+   CReport report;
+   CLatencyRecorder::ForEach(TYPESEL::bind(&CReport::Add, &report, TYPESEL_PLACEHOLDERS_1, TYPESEL_PLACEHOLDERS_2));
+   printf("slowest p99: %s\n", report.m_strSlowest.c_str());
+   if(report.m_strSlowest != std::string("handler latency state-1 ") + GetId(EEventsSlow)) {
+      printf("the slow handler is not the slowest\n");
+      bOk = false;
+   }
+   if(200 != report.m_FastCount) {
+      printf("fast handler count is %llu, expected 200 (2 threads)\n", report.m_FastCount);
+      bOk = false;
+   }
+   if(2 != report.m_StateChangeCount) {
+      printf("state change count is %llu, expected 2\n", report.m_StateChangeCount);
+      bOk = false;
+   }
+   if(0 != report.m_DisabledCount) {
+      printf("%llu events recorded with sampling disabled\n", report.m_DisabledCount);
+      bOk = false;
+   }
+   if(10 != report.m_SampledCount) {
+      printf("sampled count is %llu, expected 10\n", report.m_SampledCount);
+      bOk = false;
+   }
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/** @file
+ ** @brief Log level per state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** Every state machine has 1 state, it can feed an event into another
+ ** state machine from within its handler.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork    = 1, //handled
+   EEventsForward = 2  //handled, feeds EEventsWork into the other state machine
+};
+
+enum EUnknown {
+   EUnknownEvent = 1   //nobody handles it
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+   {
+   }
+
+public:
+   unsigned int   m_Handled;
+   SPStateMachine m_spOther;
+};
+
+class CStateWork : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWork(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("work", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateWork, Handler), CCreateState(), EEventsWork);
+      EventRegister(HANDLER(int, CStateWork, Forward), CCreateState(), EEventsForward);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+   void Forward(const int* const pData)
+   {
+      ++m_pData->m_Handled;
+      if(m_pData->m_spOther) {
+         m_pData->m_spOther->EventHandle(pData, EEventsWork);
+      }
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** The number of loggings per level since the last Reset.
+ **/
+unsigned int g_Logs[ELogLevelCount];
+
+void LogDebugCount  (const std::string&) { ++g_Logs[ELogLevelDebug  ]; }
+void LogInfoCount   (const std::string&) { ++g_Logs[ELogLevelInfo   ]; }
+void LogNoticeCount (const std::string&) { ++g_Logs[ELogLevelNotice ]; }
+void LogWarningCount(const std::string&) { ++g_Logs[ELogLevelWarning]; }
+void LogErrCount    (const std::string&) { ++g_Logs[ELogLevelErr    ]; }
+
+/** Forget the loggings counted so far.
+ **/
+void Reset(void)
+{
+   for(unsigned int i = 0 ; i < ELogLevelCount ; ++i) {
+      g_Logs[i] = 0;
+   }
+}
+
+/** Get the number of loggings since the last Reset.
+ **
+ ** @return the number of loggings of all levels.
+ **/
+unsigned int Count(void)
+{
+   unsigned int count(0);
+   for(unsigned int i = 0 ; i < ELogLevelCount ; ++i) {
+      count += g_Logs[i];
+   }
+   return count;
+}
+
+SPStateMachine Construct(const char* szName)
+{
+   CDemoData* const pData(new CDemoData());
+   return CStateMachine::ConstructStateMachine(szName, TCreateState<CStateWork, CDemoData>(pData), pData);
+}
+
+/** Check a value is not 0.
+ **
+ ** @return true when not 0.
+ **/
+bool CheckSome(const char* szWhat, const unsigned long long value)
+{
+   if(0 != value) {
+      return true;
+   }
+   printf("%s is 0\n", szWhat);
+   return false;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It silences the engine for all state machines, raises the level of 1
+ ** session by ID and of the state machines with a name, and checks which
+ ** state machines log.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug  (LogDebugCount);
+   RegisterLogInfo   (LogInfoCount);
+   RegisterLogNotice (LogNoticeCount);
+   RegisterLogWarning(LogWarningCount);
+   RegisterLogErr    (LogErrCount);
+
+   bool           bOk(true);
+   const int      iEvtData(0);
+   SPStateMachine spSession1(Construct("session"));
+   SPStateMachine spSession2(Construct("session"));
+   SPStateMachine spOther   (Construct("other"));
+   bOk &= CheckSome("ID of session 2", spSession2->GetId());
+   if(spSession1->GetId() == spSession2->GetId()) {
+      printf("session 1 and 2 have the same ID\n");
+      bOk = false;
+   }
+
+   //default: the engine logs everything (the registered functions decide)
+   Reset();
+   spSession1->EventHandle(&iEvtData, EEventsWork);
+   bOk &= CheckSome("default: debug loggings", g_Logs[ELogLevelDebug ]);
+   bOk &= CheckSome("default: notice loggings", g_Logs[ELogLevelNotice]);
+
+   //nothing logged by the engine
+   CLogLevel::SetGlobal(ELogLevelCount);
+   bOk &= Check("session 1 level (global off)", spSession1->GetLogLevel(), ELogLevelCount);
+   Reset();
+   spSession1->EventHandle(&iEvtData, EEventsWork);
+   spSession2->EventHandle(&iEvtData, EEventsWork);
+   spOther   ->EventHandle(&iEvtData, EUnknownEvent);
+   bOk &= Check("global off: loggings", Count(), 0);
+
+   //debug for session 1 only, by ID
+   CLogLevel::SetId(spSession1->GetId(), ELogLevelDebug);
+   Reset();
+   spSession2->EventHandle(&iEvtData, EEventsWork);
+   bOk &= Check("session 2 loggings", Count(), 0);
+   spSession1->EventHandle(&iEvtData, EEventsWork);
+   bOk &= CheckSome("session 1 debug loggings", g_Logs[ELogLevelDebug]);
+
+   //notices for the state machines named "other", also the ones constructed later
+   CLogLevel::SetName("other", ELogLevelNotice);
+   SPStateMachine spOtherLater(Construct("other"));
+   bOk &= Check("later other level", spOtherLater->GetLogLevel(), ELogLevelNotice);
+   Reset();
+   spOther->EventHandle(&iEvtData, EUnknownEvent);
+   bOk &= Check   ("other debug loggings (no handler trace)", g_Logs[ELogLevelDebug], 0);
+   bOk &= CheckSome("other notice loggings", g_Logs[ELogLevelNotice]);
+
+   //the rule by ID has priority over the rule by name
+   CLogLevel::SetId(spOther->GetId(), ELogLevelCount);
+   Reset();
+   spOther->EventHandle(&iEvtData, EEventsWork);
+   bOk &= Check("other with ID rule loggings", Count(), 0);
+
+   //a silent state machine called from a handler of a logging one: the
+   //caller logs again once the silent one is done
+   {
+      CDemoData* const pData(new CDemoData());
+      SPStateMachine   spForward(CStateMachine::ConstructStateMachine("forward", TCreateState<CStateWork, CDemoData>(pData), pData));
+      pData->m_spOther = spSession2;
+      CLogLevel::SetId(spForward->GetId(), ELogLevelNotice);
+      Reset();
+      spForward->EventHandle(&iEvtData, EEventsForward);
+      //in, calling handler, handler done, done: all from "forward"
+      bOk &= Check("forward notice loggings", g_Logs[ELogLevelNotice], 4);
+      bOk &= Check("forward debug loggings",  g_Logs[ELogLevelDebug ], 0);
+      pData->m_spOther.reset();
+   }
+
+   //back to the default
+   CLogLevel::ResetAll();
+   CLogLevel::SetGlobal(ELogLevelDebug);
+   bOk &= Check("session 2 level (reset)", spSession2->GetLogLevel(), ELogLevelDebug);
+   Reset();
+   spSession2->EventHandle(&iEvtData, EEventsWork);
+   bOk &= CheckSome("session 2 loggings (reset)", Count());
+
+   UnRegisterLogErr    ();
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   UnRegisterLogDebug  ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/** @file
+ ** @brief Stress test re-registering logging functions while logging
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "atomic"
+#include "iostream"
+#include "thread"
+#include "vector"
+
+/****************************************************************************************
+ ** 
+ ** Logging functions
+ **
+ ***************************************************************************************/
+const unsigned int ALIVE = 0xA11CE;
+const unsigned int DEAD  = 0xDEAD;
+
+std::atomic<unsigned long long> g_Calls[2];    ///< Calls per info logging function.
+std::atomic<unsigned long long> g_Notices(0);  ///< Calls of the notice logging function.
+std::atomic<unsigned long long> g_Dead(0);     ///< Calls of a deleted logging function.
+std::atomic<unsigned long long> g_Nested(0);   ///< Re-registrations from a logging function.
+
+/** @brief Info logging function counting its calls, detecting being
+ ** called after it has been deleted.
+ **
+ ** Every 1000th call logs a notice and re-registers from within the
+ ** logging function.
+ **/
+class CSink {
+public:
+   explicit CSink(const unsigned int index)
+      : m_Index(index)
+      , m_Magic(ALIVE)
+   {
+   }
+
+   CSink(const CSink& ref)
+      : m_Index(ref.m_Index)
+      , m_Magic(ref.m_Magic)
+   {
+   }
+
+   ~CSink(void)
+   {
+      m_Magic = DEAD;
+   }
+
+public:
+   void operator()(const std::string&) const
+   {
+      if(ALIVE != m_Magic) {
+         ++g_Dead;
+         return;
+      }
+      if(0 == ++g_Calls[m_Index] % 1000) {
+         LogNotice("nested %u\n", m_Index);
+         RegisterLogInfo(CSink(1 - m_Index));
+         ++g_Nested;
+      }
+   }
+
+private:
+   const unsigned int    m_Index;
+   volatile unsigned int m_Magic;
+};
+
+void CountNotice(const std::string&)
+{
+   ++g_Notices;
+}
+
+/****************************************************************************************
+ ** 
+ ** main
+ **
+ ***************************************************************************************/
+int main (int, char**)
+{
+   int ret = 0;
+   try {
+      const unsigned int threads (4);
+      const unsigned int messages(100000);
+      g_Calls[0] = 0;
+      g_Calls[1] = 0;
+      RegisterLogNotice(CountNotice);
+      RegisterLogInfo(CSink(0));
+
+      //log from 4 threads while re-registering the info logging function
+      std::atomic<bool>        bDone(false);
+      unsigned long long       registrations(0);
+      std::thread              writer([&bDone, &registrations](){
+            while(!bDone.load()) {
+               RegisterLogInfo(CSink(registrations % 2));
+               ++registrations;
+            }
+         });
+      std::vector<std::thread> loggers;
+      for(unsigned int t = 0 ; t < threads ; ++t) {
+         loggers.push_back(std::thread([t, messages](){
+                  for(unsigned int u = 0 ; u < messages ; ++u) {
+                     LogInfo("thread %u message %u\n", t, u);
+                  }
+               }));
+      }
+      for(std::vector<std::thread>::iterator it = loggers.begin() ; loggers.end() != it ; ++it) {
+         it->join();
+      }
+      bDone.store(true);
+      writer.join();
+      UnRegisterLogInfo();
+      UnRegisterLogNotice();
+
+      const unsigned long long calls(g_Calls[0] + g_Calls[1]);
+      std::cout << "logged " << calls << " messages (" << g_Calls[0] << " + " << g_Calls[1] << ")"
+                << ", " << registrations << " registrations"
+                << ", " << g_Nested << " from a logging function" << std::endl;
+      if(threads * messages != calls) {
+         throw std::runtime_error("messages lost");
+      }
+      if(0 != g_Dead) {
+         throw std::runtime_error("deleted logging function called");
+      }
+      if(g_Nested != g_Notices) {
+         throw std::runtime_error("nested notices lost");
+      }
+      if(0 == registrations) {
+         throw std::runtime_error("no registrations");
+      }
+   } catch(std::exception& e) {
+      std::cerr << "exception: " << e.what() << std::endl;
+      ret = 1;
+   } catch(...) {
+      std::cerr << "unknown exception" << std::endl;
+      ret = 1;
+   }
+   return ret;
+}
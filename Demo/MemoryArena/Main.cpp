@@ -0,0 +1,225 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "chrono"
+#include "vector"
+
+/****************************************************************************************
+ ** 
+ ** Event enums and state machine data.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsChild = 1,
+   EEventsDone  = 2
+};
+
+/** The state machine data: counts the handlers called so the behaviour
+ ** with and without arena can be compared.
+ **/
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(const size_t arenaChunkSize)
+      : CStateMachineData()
+      , m_ArenaChunkSize(arenaChunkSize)
+      , m_Handled(0)
+   {
+   }
+
+public:
+   const size_t m_ArenaChunkSize;
+   unsigned int m_Handled;
+};
+
+/****************************************************************************************
+ ** 
+ ** Child state machine: child-1 --> child-2 --> finished.
+ **
+ ***************************************************************************************/
+class CStateChild2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateChild2(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("child-2", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateChild2, Handler), CCreateStateFinished(), EEventsChild);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateChild1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateChild1(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("child-1", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateChild1, Handler), TCreateState<CStateChild2, CDemoData>(m_pData), EEventsChild);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Parent state machine: parent-1 owns the child state machine and forwards the child
+ ** events to it. When it has finished, the parent moves on to parent-2.
+ **
+ ***************************************************************************************/
+class CStateParent2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateParent2(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("parent-2", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateParent2, Handler), CCreateState(), EEventsDone);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateParent1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateParent1(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("parent-1", wpStateMachine)
+      , m_pData(pData)
+      , m_spChild(CStateMachine::ConstructStateMachine("child", TCreateState<CStateChild1, CDemoData>(pData), NULL, pData->m_ArenaChunkSize))
+   {
+      EventRegister(HANDLER(int, CStateParent1, HandlerChild), CCreateState(),                                  EEventsChild);
+      EventRegister(HANDLER(int, CStateParent1, HandlerDone),  TCreateState<CStateParent2, CDemoData>(m_pData), EEventsDone );
+   }
+
+public:
+   void HandlerChild(const int* const pEvtData)
+   {
+      m_spChild->EventHandle(pEvtData, EEventsChild);
+   }
+
+   void HandlerDone(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+   SPStateMachine   m_spChild;
+};
+
+/****************************************************************************************
+ ** 
+ ** Measurement helpers.
+ **
+ ***************************************************************************************/
+/** Create iCount parent state machines (each with a child), feed each of
+ ** them the same events and destruct them all at once.
+ **
+ ** @return the number of handlers called.
+ **/
+unsigned int Run(const size_t arenaChunkSize, const unsigned int iCount, double& dispatchMs, double& teardownMs)
+{
+   std::vector<SPStateMachine> stateMachines;
+   std::vector<CDemoData*>     datas;
+   stateMachines.reserve(iCount);
+   datas.reserve(iCount);
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      CDemoData* const pData(new CDemoData(arenaChunkSize));
+      datas.push_back(pData);
+      stateMachines.push_back(CStateMachine::ConstructStateMachine("parent", TCreateState<CStateParent1, CDemoData>(pData), pData, arenaChunkSize));
+   }
+   const int iEvtData(0);
+   const std::chrono::steady_clock::time_point startDispatch(std::chrono::steady_clock::now());
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      stateMachines[i]->EventHandle(&iEvtData, EEventsChild);
+      stateMachines[i]->EventHandle(&iEvtData, EEventsChild);
+      stateMachines[i]->EventHandle(&iEvtData, EEventsDone );
+      stateMachines[i]->EventHandle(&iEvtData, EEventsDone );
+   }
+   dispatchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startDispatch).count();
+   unsigned int iHandled(0);
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      iHandled += datas[i]->m_Handled;
+   }
+   const std::chrono::steady_clock::time_point startTeardown(std::chrono::steady_clock::now());
+   stateMachines.clear();
+   teardownMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTeardown).count();
+   return iHandled;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It runs the same nested state machines allocating from the heap and
+ ** allocating from a per state machine arena, checks that both behave the
+ ** same and reports the time it takes to destruct all of them.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   const unsigned int iCount(10000);
+   LogInfo("[%s][%u] memory-arena demo in\n", __FUNCTION__, __LINE__);
+   RegisterLogNotice(FLog());
+
+   const size_t       arenaChunkSize(2048);
+   double             dispatchHeapMs (0);
+   double             dispatchArenaMs(0);
+   double             teardownHeapMs (0);
+   double             teardownArenaMs(0);
+   const unsigned int iHandledHeap  (Run(0,              iCount, dispatchHeapMs,  teardownHeapMs ));
+   const unsigned int iHandledArena (Run(arenaChunkSize, iCount, dispatchArenaMs, teardownArenaMs));
+
+   UnRegisterLogNotice();
+   LogInfo("[%s][%u] heap:  %u handlers called, dispatch %.3f ms, destructing %u state machines %.3f ms\n", __FUNCTION__, __LINE__, iHandledHeap,  dispatchHeapMs,  iCount, teardownHeapMs );
+   LogInfo("[%s][%u] arena: %u handlers called, dispatch %.3f ms, destructing %u state machines %.3f ms (chunk size %lu)\n", __FUNCTION__, __LINE__, iHandledArena, dispatchArenaMs, iCount, teardownArenaMs, (long unsigned int)arenaChunkSize);
+
+   int iResult(0);
+   if((iHandledHeap != iHandledArena) || (iHandledHeap != 4 * iCount)) {
+      LogErr("[%s][%u] both flavours should handle the events in the same way\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+
+   LogInfo("[%s][%u] memory-arena demo out\n", __FUNCTION__, __LINE__);
+   return iResult;
+}
@@ -0,0 +1,310 @@
+/** @file
+ ** @brief Orthogonal regions demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "string"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ **
+ ** The state machine's own state (device) and 3 regions:
+ **    link:  down, up
+ **    auth:  anonymous, authenticated
+ **    media: stopped, playing (region-local)
+ **
+ ** Every region state records its entry and exit in g_strLog.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsLinkUp   = 1, //link:  down          --> up
+   EEventsLinkDown = 2, //link:  up            --> down
+   EEventsLogin    = 3, //auth:  anonymous     --> authenticated
+   EEventsReset    = 4, //device (counts), link: up --> down, auth: authenticated --> anonymous
+   EEventsPlay     = 5, //media: stopped       --> playing
+   EEventsFrame    = 6, //media: playing (counts)
+   EEventsStop     = 7, //media: playing       --> stopped
+   EEventsLogout   = 8  //auth:  authenticated --> finished
+};
+
+/** Entry and exit of the region states.
+ **/
+std::string g_strLog;
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Resets(0)
+      , m_Frames(0)
+   {
+   }
+
+public:
+   unsigned int m_Resets;
+   unsigned int m_Frames; //only used by the media region
+};
+
+/** Base class of the region states: records the entry and exit.
+ **/
+class CStateDemo : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDemo(const char* const szName, WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId(szName, wpStateMachine)
+      , m_pData(pData)
+   {
+      g_strLog += "+" + GetName() + " ";
+   }
+
+   ~CStateDemo(void)
+   {
+      g_strLog += "-" + GetName() + " ";
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+
+protected:
+   CDemoData* const m_pData;
+};
+
+class CStateDevice : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDevice(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("device", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateDevice, Reset), CCreateState(), EEventsReset);
+   }
+
+public:
+   void Reset(const int* const)
+   {
+      ++m_pData->m_Resets;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateLinkDown : public CStateDemo {
+public:
+   CStateLinkDown(WPStateMachine wpStateMachine, CDemoData* const pData);
+};
+
+class CStateLinkUp : public CStateDemo {
+public:
+   CStateLinkUp(WPStateMachine wpStateMachine, CDemoData* const pData);
+};
+
+class CStateAnonymous : public CStateDemo {
+public:
+   CStateAnonymous(WPStateMachine wpStateMachine, CDemoData* const pData);
+};
+
+class CStateAuthenticated : public CStateDemo {
+public:
+   CStateAuthenticated(WPStateMachine wpStateMachine, CDemoData* const pData);
+};
+
+class CStateStopped : public CStateDemo {
+public:
+   CStateStopped(WPStateMachine wpStateMachine, CDemoData* const pData);
+};
+
+class CStatePlaying : public CStateDemo {
+public:
+   CStatePlaying(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Frame(const int* const)
+   {
+      ++m_pData->m_Frames;
+   }
+};
+
+/****************************************************************************************
+ ** 
+ ** The state constructors register the handlers in their own region:
+ ** all states are declared by now.
+ **
+ ***************************************************************************************/
+CStateLinkDown::CStateLinkDown(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("down", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStateLinkUp, CDemoData>(), EEventsLinkUp);
+}
+
+CStateLinkUp::CStateLinkUp(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("up", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStateLinkDown, CDemoData>(), EEventsLinkDown);
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStateLinkDown, CDemoData>(), EEventsReset   );
+}
+
+CStateAnonymous::CStateAnonymous(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("anonymous", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStateAuthenticated, CDemoData>(), EEventsLogin);
+}
+
+CStateAuthenticated::CStateAuthenticated(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("authenticated", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStateAnonymous, CDemoData>(), EEventsReset );
+   EventRegister(HANDLER(int, CStateDemo, Handler), CCreateStateFinished(),                           EEventsLogout);
+}
+
+CStateStopped::CStateStopped(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("stopped", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStateDemo, Handler), TCreateStateShared<CStatePlaying, CDemoData>(), EEventsPlay);
+}
+
+CStatePlaying::CStatePlaying(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateDemo("playing", wpStateMachine, pData)
+{
+   EventRegister(HANDLER(int, CStatePlaying, Frame),   CCreateState(),                                  EEventsFrame);
+   EventRegister(HANDLER(int, CStateDemo,    Handler), TCreateStateShared<CStateStopped, CDemoData>(), EEventsStop );
+}
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed an event and compare the entries and exits it caused with the
+ ** expected ones.
+ **
+ ** @return true when equal.
+ **/
+bool Step(SPStateMachine spStateMachine, const EEvents event, const char* szExpected)
+{
+   const int iEvtData(0);
+   g_strLog.clear();
+   spStateMachine->EventHandle(&iEvtData, event);
+   printf("event %d: %s\n", event, g_strLog.c_str());
+   if(g_strLog == szExpected) {
+      return true;
+   }
+   printf("expected: %s\n", szExpected);
+   return false;
+}
+
+/** Compare the current state of a region with the expected state.
+ **
+ ** @return true when equal.
+ **/
+bool CheckState(SPStateMachine spStateMachine, const size_t region, const char* szExpected)
+{
+   const std::string strState(spStateMachine->GetRegionStateName(region));
+   if(strState == szExpected) {
+      return true;
+   }
+   printf("region %zu is in state %s, expected %s\n", region, strState.c_str(), szExpected);
+   return false;
+}
+
+/** Run the demo with a state machine, with or without thread pool.
+ **
+ ** @return true when all checks pass.
+ **/
+bool Run(CThreadPool* const pThreadPool)
+{
+   printf("%s thread pool\n", NULL == pThreadPool ? "without" : "with");
+
+   bool           bOk(true);
+   CDemoData*     pData(new CDemoData());
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine("regions", TCreateStateShared<CStateDevice, CDemoData>(), pData));
+   spStateMachine->SetThreadPool(pThreadPool);
+
+   //the regions enter their initial state when added
+   g_strLog.clear();
+   bOk &= Check("link",    spStateMachine->RegionAdd("link",  TCreateStateShared<CStateLinkDown,  CDemoData>()      ), 1);
+   bOk &= Check("auth",    spStateMachine->RegionAdd("auth",  TCreateStateShared<CStateAnonymous, CDemoData>()      ), 2);
+   bOk &= Check("media",   spStateMachine->RegionAdd("media", TCreateStateShared<CStateStopped,   CDemoData>(), true), 3);
+   bOk &= Check("regions", spStateMachine->GetRegionCount(), 4);
+   printf("regions: %s\n", g_strLog.c_str());
+   bOk &= (g_strLog == "+down +anonymous +stopped ");
+
+   //every region gets every event
+   bOk &= Step(spStateMachine, EEventsLinkUp, "-down +up ");
+   bOk &= Step(spStateMachine, EEventsLogin,  "-anonymous +authenticated ");
+   bOk &= Step(spStateMachine, EEventsPlay,   "-stopped +playing ");
+   bOk &= Step(spStateMachine, EEventsFrame,  "");
+   bOk &= Step(spStateMachine, EEventsFrame,  "");
+   bOk &= Check("frames", pData->m_Frames, 2);
+   bOk &= CheckState(spStateMachine, 1, "up"           );
+   bOk &= CheckState(spStateMachine, 2, "authenticated");
+   bOk &= CheckState(spStateMachine, 3, "playing"      );
+
+   //an event handled by the own state and 2 regions: the state changes are made in region order
+   bOk &= Step(spStateMachine, EEventsReset,  "-up +down -authenticated +anonymous ");
+   bOk &= Check("resets", pData->m_Resets, 1);
+   bOk &= CheckState(spStateMachine, 3, "playing");
+
+   //a region can finish without finishing the state machine
+   bOk &= Step(spStateMachine, EEventsLogin,  "-anonymous +authenticated ");
+   bOk &= Step(spStateMachine, EEventsLogout, "-authenticated ");
+   bOk &= Check("auth finished",    spStateMachine->HasRegionFinished(2), true );
+   bOk &= Check("machine finished", spStateMachine->HasFinished(),        false);
+   bOk &= Step(spStateMachine, EEventsStop,   "-playing +stopped ");
+
+   //destructing the state machine exits the regions, last added first
+   g_strLog.clear();
+   spStateMachine.reset();
+   printf("destruct: %s\n", g_strLog.c_str());
+   bOk &= (g_strLog == "-stopped -down ");
+   return bOk;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It runs the demo on the calling thread and with the media region
+ ** dispatched on a thread pool: the results are the same.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogNotice(FLog());
+
+   bool        bOk(true);
+   CThreadPool threadPool(2);
+   bOk &= Run(NULL);
+   bOk &= Run(&threadPool);
+
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
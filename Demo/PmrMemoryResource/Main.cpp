@@ -0,0 +1,271 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#if __cplusplus >= 201703L
+#include "memory_resource"
+
+//include the allocation counter shared by the demos
+#include "CAllocationCounter.h"
+using ILUDemo::CAllocationCounter;
+
+/****************************************************************************************
+ ** 
+ ** Allocation accounting: the global allocations are counted by the demo
+ ** library, the allocations from the resource by CCountingResource.
+ **
+ ***************************************************************************************/
+/** A memory resource counting the allocations made from it and the
+ ** bytes outstanding. Allocates from a fixed buffer that never falls
+ ** back to the heap.
+ **/
+class CCountingResource : public std::pmr::memory_resource {
+public:
+   CCountingResource(void)
+      : std::pmr::memory_resource()
+      , m_Upstream(m_Buffer, sizeof(m_Buffer), std::pmr::null_memory_resource())
+      , m_Count(0)
+      , m_Outstanding(0)
+   {
+   }
+
+public:
+   unsigned int GetCount      (void) const { return m_Count;       }
+   std::size_t  GetOutstanding(void) const { return m_Outstanding; }
+   void         Reset         (void)       { m_Count = 0;          }
+
+private:
+   virtual void* do_allocate(std::size_t bytes, std::size_t alignment)
+   {
+      ++m_Count;
+      m_Outstanding += bytes;
+      return m_Upstream.allocate(bytes, alignment);
+   }
+
+   virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+   {
+      m_Outstanding -= bytes;
+      m_Upstream.deallocate(p, bytes, alignment);
+   }
+
+   virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+   {
+      return this == &other;
+   }
+
+private:
+   alignas(std::max_align_t) char      m_Buffer[1024 * 1024];
+   std::pmr::monotonic_buffer_resource m_Upstream;
+   unsigned int                        m_Count;
+   std::size_t                         m_Outstanding;
+};
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** state-1 --> state-2 --> state-1 ..., a default state counts the events
+ ** the current state does not handle.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsNext  = 1,
+   EEventsOther = 2
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+      , m_Bound(0)
+   {
+   }
+
+public:
+   unsigned int m_Handled;
+   unsigned int m_Bound;   ///< Number of handlers bound to a state instance (HANDLER) registered.
+};
+
+class CState1;
+class CState2;
+
+class CStateDefault : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDefault(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-default", wpStateMachine, true /* default state */)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateDefault, Handler), CCreateState(), EEventsOther);
+      m_pData->m_Bound += 1;
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CState2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState2(WPStateMachine wpStateMachine, CDemoData* const pData);
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CState1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState1(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-1", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CState1, Handler), TCreateState<CState2, CDemoData>(m_pData), EEventsNext);
+      m_pData->m_Bound += 1;
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+CState2::CState2(WPStateMachine wpStateMachine, CDemoData* const pData)
+   : CStateEvtId("state-2", wpStateMachine)
+   , m_pData(pData)
+{
+   EventRegister(HANDLER(int, CState2, Handler), TCreateState<CState1, CDemoData>(m_pData), EEventsNext, 7);
+   EventRegister(HANDLER(int, CState2, Handler), CCreateState(),                            EEventsOther, 7);
+   m_pData->m_Bound += 2;
+}
+
+/****************************************************************************************
+ ** 
+ ** Measurement helpers.
+ **
+ ***************************************************************************************/
+/** Construct a state machine (from the resource when provided), feed it
+ ** events and destruct it. The global allocations are counted during
+ ** the whole lifetime of the state machine, the state machine data is
+ ** allocated by the caller, before counting starts.
+ **
+ ** @return the number of handlers called.
+ **/
+unsigned int Run(std::pmr::memory_resource* const pResource, unsigned int& iBound, unsigned int& iGlobal)
+{
+   const int                iEvtData(0);
+   CDemoData* const         pData(new CDemoData());
+   const unsigned long long before(CAllocationCounter::GetCount());
+   SPStateMachine spStateMachine(NULL == pResource
+      ? CStateMachine::ConstructStateMachine("pmr", TCreateState<CState1, CDemoData>(pData), TCreateState<CStateDefault, CDemoData>(pData), pData)
+      : CStateMachine::ConstructStateMachine("pmr", TCreateState<CState1, CDemoData>(pData), TCreateState<CStateDefault, CDemoData>(pData), pData, pResource));
+   for(unsigned int i = 0 ; i < 10 ; ++i) {
+      spStateMachine->EventHandle(&iEvtData, EEventsNext);
+      spStateMachine->EventHandle(&iEvtData, EEventsOther);
+      spStateMachine->EventHandle(&iEvtData, EEventsNext, 7);
+      spStateMachine->EventHandle(&iEvtData, EEventsOther, 7);
+   }
+   const unsigned int iHandled(pData->m_Handled);
+   iBound = pData->m_Bound;
+   spStateMachine.reset();
+   iGlobal = (unsigned int)(CAllocationCounter::GetCount() - before);
+   return iHandled;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It runs the same state machine allocating from the heap and allocating
+ ** from a counting std::pmr::memory_resource. Every allocation the state
+ ** machine makes from the heap in the first run, has to move to the
+ ** resource in the second run, except for the targets of the std::function
+ ** handlers: no resource can be passed to a std::function.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   LogInfo("[%s][%u] pmr memory-resource demo in\n", __FUNCTION__, __LINE__);
+   RegisterLogNotice(FLog());
+
+   CCountingResource  resource;
+   unsigned int       iBound(0);
+   unsigned int       iGlobalHeap(0);
+   unsigned int       iGlobalResource(0);
+   Run(&resource, iBound, iGlobalResource); //warm-up: one-time allocations (e.g. logging) are not part of the comparison
+   resource.Reset();
+   const unsigned int iHandledHeap    (Run(NULL, iBound, iGlobalHeap));
+   const unsigned int iHandledResource(Run(&resource, iBound, iGlobalResource));
+   //the only global allocations allowed with the resource: per bound handler
+   //registered, the std::function target HANDLER builds in the state
+   //constructor and the copy the handler table keeps (none at all when the
+   //standard library stores such a bind inside the std::function itself)
+   const unsigned int iFunctionTargets(2 * iBound);
+
+   UnRegisterLogNotice();
+   LogInfo("[%s][%u] heap:     %u handlers called, %u global allocations\n", __FUNCTION__, __LINE__, iHandledHeap, iGlobalHeap);
+   LogInfo("[%s][%u] resource: %u handlers called, %u global allocations (%u bound handlers registered), %u resource allocations, %lu bytes outstanding\n", __FUNCTION__, __LINE__, iHandledResource, iGlobalResource, iBound, resource.GetCount(), (long unsigned int)resource.GetOutstanding());
+
+   int iResult(0);
+   if((iHandledHeap != iHandledResource) || (iHandledHeap != 30)) {
+      LogErr("[%s][%u] both flavours should handle the events in the same way\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+   if((0 != iGlobalResource) && (iFunctionTargets != iGlobalResource)) {
+      LogErr("[%s][%u] stray global allocations: %u while the resource is in use, only the %u std::function targets are allowed\n", __FUNCTION__, __LINE__, iGlobalResource, iFunctionTargets);
+      iResult = 1;
+   }
+   //+1: the adapter around the resource
+   if((0 == resource.GetCount()) || (iGlobalResource + resource.GetCount() != iGlobalHeap + 1)) {
+      LogErr("[%s][%u] each allocation made from the heap should be made from the resource\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+   if(0 != resource.GetOutstanding()) {
+      LogErr("[%s][%u] the state machine should return all memory to the resource\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+
+   LogInfo("[%s][%u] pmr memory-resource demo out\n", __FUNCTION__, __LINE__);
+   return iResult;
+}
+#else
+/** Without C++17 there is no std::pmr: skip the test.
+ **/
+int main (void)
+{
+   return 77;
+}
+#endif
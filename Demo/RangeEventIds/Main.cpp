@@ -0,0 +1,211 @@
+/** @file
+ ** @brief RangeEventIds demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+
+/****************************************************************************************
+ ** 
+ ** Event enum: error codes, only the bounds of the ranges are named.
+ **
+ ***************************************************************************************/
+enum EErrors {
+   EErrorsClientFirst = 1000,
+   EErrorsClientQuota = 1500,
+   EErrorsClientLast  = 1999,
+   EErrorsServerFirst = 2000,
+   EErrorsServerLast  = 2999,
+   EErrorsOther       = 3000
+};
+
+/****************************************************************************************
+ ** 
+ ** State machine data and the state.
+ **
+ ** The handlers record which one of them handled the last event.
+ **
+ ***************************************************************************************/
+enum EHandler {
+   EHandlerNone,
+   EHandlerQuota,       //1500
+   EHandlerClient,      //1000..1999
+   EHandlerClientRetry, //1000..1999, guarded
+   EHandlerServer,      //2000..2999, shared
+   EHandlerType         //the event-type handler
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handler(EHandlerNone)
+   {
+   }
+
+public:
+   EHandler m_Handler;
+};
+
+class CStateRange : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateRange(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("range", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(                                          HANDLER(int, CStateRange, HandlerQuota),              CCreateState(), EErrorsClientQuota);
+      EventRegister(                                          HANDLER(int, CStateRange, HandlerClient),             CCreateState(), EVTID_RANGE(EErrorsClientFirst, EErrorsClientLast));
+      EventRegister(GUARD(int, CStateRange, GuardRetry),      HANDLER(int, CStateRange, HandlerClientRetry),        CCreateState(), EVTID_RANGE(EErrorsClientFirst, EErrorsClientLast));
+      EventRegister(                                          HANDLER_SHARED(int, CStateRange, HandlerServer),      CCreateState(), EVTID_RANGE(EErrorsServerFirst, EErrorsServerLast));
+      //overlaps the client range: rejected
+      EventRegister(                                          HANDLER(int, CStateRange, HandlerClient),             CCreateState(), EVTID_RANGE(EErrorsClientLast, EErrorsServerFirst));
+      EventTypeRegister(TEventEvtId<EErrors>::IdTypeInit().c_str(), HANDLER_TYPE(int, CStateRange, HandlerType), CCreateState());
+   }
+
+public:
+   bool GuardRetry(const int* const pEvtData)
+   {
+      return 1 == *pEvtData;
+   }
+
+   void HandlerQuota(const int* const)
+   {
+      m_pData->m_Handler = EHandlerQuota;
+   }
+
+   void HandlerClient(const int* const)
+   {
+      m_pData->m_Handler = EHandlerClient;
+   }
+
+   void HandlerClientRetry(const int* const)
+   {
+      m_pData->m_Handler = EHandlerClientRetry;
+   }
+
+   void HandlerServer(const int* const)
+   {
+      m_pData->m_Handler = EHandlerServer;
+   }
+
+   void HandlerType(SPEventBase, const int* const)
+   {
+      m_pData->m_Handler = EHandlerType;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/** A state of another state machine, with a range overlapping the ranges
+ ** of CStateRange.
+ **/
+class CStateWide : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWide(WPStateMachine wpStateMachine, CDemoData* const)
+      : CStateEvtId("wide", wpStateMachine)
+   {
+      EventRegister(HANDLER(int, CStateWide, Handler), CCreateState(), EVTID_RANGE(EErrorsClientFirst, EErrorsServerLast));
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed an error code.
+ **
+ ** @return the handler that handled it.
+ **/
+size_t Feed(SPStateMachine spStateMachine, CDemoData* const pData, const int error, const int iEvtData = 0)
+{
+   pData->m_Handler = EHandlerNone;
+   spStateMachine->EventHandle(&iEvtData, static_cast<EErrors>(error));
+   return pData->m_Handler;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It checks that an error code without its own handler is handled by the
+ ** range containing it, and that broadcasting finds the state machines
+ ** interested through a range.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogNotice(FLog());
+   RegisterLogErr   (FLog());
+
+   const int      iEvtData(0);
+   bool           bOk(true);
+   CDemoData*     pData(new CDemoData());
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine("range", TCreateStateShared<CStateRange, CDemoData>(), pData));
+
+   //the event ID before the range
+   bOk &= Check("1500: quota",          Feed(spStateMachine, pData, 1500),    EHandlerQuota);
+   //the bounds and the inside of the ranges
+   bOk &= Check("1000: client",         Feed(spStateMachine, pData, 1000),    EHandlerClient);
+   bOk &= Check("1234: client",         Feed(spStateMachine, pData, 1234),    EHandlerClient);
+   bOk &= Check("1999: client",         Feed(spStateMachine, pData, 1999),    EHandlerClient);
+   bOk &= Check("1234: client, retry",  Feed(spStateMachine, pData, 1234, 1), EHandlerClientRetry);
+   bOk &= Check("2000: server",         Feed(spStateMachine, pData, 2000),    EHandlerServer);
+   bOk &= Check("2999: server",         Feed(spStateMachine, pData, 2999),    EHandlerServer);
+   //outside the ranges
+   bOk &= Check("999: type",            Feed(spStateMachine, pData, 999),     EHandlerType);
+   bOk &= Check("3000: type",           Feed(spStateMachine, pData, 3000),    EHandlerType);
+
+   //broadcasting finds the range registrations, also when the ranges of state machines overlap
+   {
+      CDemoData*     pWideData(new CDemoData());
+      SPStateMachine spWide(CStateMachine::ConstructStateMachine("wide", TCreateStateShared<CStateWide, CDemoData>(), pWideData));
+      CBroadcast     broadcast;
+      broadcast.Subscribe(spStateMachine);
+      bOk &= Check("broadcast 1234",    broadcast.Broadcast(&iEvtData, static_cast<EErrors>(1234)), 1);
+      bOk &= Check("broadcast 2500",    broadcast.Broadcast(&iEvtData, static_cast<EErrors>(2500)), 1);
+      broadcast.Subscribe(spWide);
+      bOk &= Check("broadcast 1234, wide", broadcast.Broadcast(&iEvtData, static_cast<EErrors>(1234)), 2);
+      bOk &= Check("broadcast 2500, wide", broadcast.Broadcast(&iEvtData, static_cast<EErrors>(2500)), 2);
+      bOk &= Check("broadcast 3000, wide", broadcast.Broadcast(&iEvtData, static_cast<EErrors>(3000)), 1);
+      broadcast.Unsubscribe(*spStateMachine);
+      bOk &= Check("broadcast 999, wide",  broadcast.Broadcast(&iEvtData, static_cast<EErrors>(999)),  0);
+      bOk &= Check("broadcast 2999, wide", broadcast.Broadcast(&iEvtData, static_cast<EErrors>(2999)), 1);
+   }
+
+   UnRegisterLogErr   ();
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "stdexcept"
+
+/****************************************************************************************
+ ** 
+ ** Event enums, state machine data and states.
+ ** state-1 --> state-2 --> state-1 ...
+ ** Every event takes another path through the engine.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsGuarded = 1, //guarded handler in state-1: 2 guards, the second one passes
+   EEventsNext    = 2, //state change
+   EEventsThrow   = 3, //handler throws
+   EEventsDefault = 4, //handler in the default state
+   EEventsType    = 5  //no handler: state-1 type handler
+};
+
+enum EOther {
+   EOtherType = 1      //default state type handler
+};
+
+enum EUnknown {
+   EUnknownEvent = 1   //nobody handles it
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handled(0)
+   {
+   }
+
+public:
+   unsigned int m_Handled;
+};
+
+class CState2;
+
+class CState1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState1(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-1", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(GUARD(int, CState1, GuardFalse), HANDLER(int, CState1, Handler), CCreateState(),                            EEventsGuarded);
+      EventRegister(GUARD(int, CState1, GuardTrue),  HANDLER(int, CState1, Handler), CCreateState(),                            EEventsGuarded);
+      EventRegister(                                 HANDLER(int, CState1, Handler), TCreateState<CState2, CDemoData>(m_pData), EEventsNext);
+      EventRegister(                                 HANDLER(int, CState1, Throw),   CCreateState(),                            EEventsThrow);
+      EventTypeRegister(TEventEvtId<EEvents>::IdTypeInit().c_str(), HANDLER_TYPE(int, CState1, HandlerType), CCreateState());
+   }
+
+public:
+   bool GuardFalse(const int* const)
+   {
+      return false;
+   }
+
+   bool GuardTrue(const int* const)
+   {
+      return true;
+   }
+
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+   void Throw(const int* const)
+   {
+      throw std::runtime_error("demo exception");
+   }
+
+   void HandlerType(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateDefault : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDefault(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-default", wpStateMachine, true /* default state */)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateDefault, Handler), CCreateState(), EEventsDefault);
+      EventTypeRegister(TEventEvtId<EOther>::IdTypeInit().c_str(), HANDLER_TYPE(int, CStateDefault, HandlerType), CCreateState());
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+   void HandlerType(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CState2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState2(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("state-2", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CState2, Handler), TCreateState<CState1, CDemoData>(m_pData), EEventsNext);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+      ++m_pData->m_Handled;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+SPStateMachine Construct(const char* szName)
+{
+   CDemoData* const pData(new CDemoData());
+   return CStateMachine::ConstructStateMachine(szName, TCreateState<CState1, CDemoData>(pData), TCreateState<CStateDefault, CDemoData>(pData), pData);
+}
+
+/** Print the statistics of a state machine.
+ **/
+void Print(const CStateMachine& stateMachine)
+{
+   const CStateMachineStats stats(stateMachine.GetStats());
+   printf("%-10s state %llu default %llu type-state %llu type-default %llu unhandled %llu guards %llu/%llu transitions %llu exceptions %llu handler-time %s\n",
+          stateMachine.GetName().c_str(),
+          stats.m_EventsState,
+          stats.m_EventsDefault,
+          stats.m_EventsTypeState,
+          stats.m_EventsTypeDefault,
+          stats.m_EventsUnhandled,
+          stats.m_GuardsPassed,
+          stats.m_GuardsEvaluated,
+          stats.m_Transitions,
+          stats.m_Exceptions,
+          0 < stats.m_HandlerNs ? "yes" : "no"
+          );
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It sends every event once to a state machine and checks its statistics,
+ ** then reports all state machines in the registry.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   if(!CStateMachineCounters::IsEnabled()) {
+      printf("library compiled without runtime statistics (configure --disable-runtime-stats) --> skip\n");
+      return 77;
+   }
+   RegisterLogInfo   (FLog());
+   RegisterLogNotice (FLog());
+   RegisterLogWarning(FLog());
+   RegisterLogErr    (FLog());
+
+   bool           bOk(true);
+   const int      iEvtData(0);
+   SPStateMachine spStateMachine1(Construct("machine-1"));
+   SPStateMachine spStateMachine2(Construct("machine-2"));
+
+   //every path once, handler timing disabled
+   spStateMachine1->EventHandle(&iEvtData, EEventsGuarded);
+   spStateMachine1->EventHandle(&iEvtData, EEventsThrow);
+   spStateMachine1->EventHandle(&iEvtData, EEventsDefault);
+   spStateMachine1->EventHandle(&iEvtData, EEventsType);
+   spStateMachine1->EventHandle(&iEvtData, EOtherType);
+   spStateMachine1->EventHandle(&iEvtData, EUnknownEvent);
+   bOk &= Check("handler time (disabled)", spStateMachine1->GetStats().m_HandlerNs, 0);
+
+   //2 state changes, handler timing enabled
+   CStateMachineCounters::EnableHandlerTiming(true);
+   spStateMachine1->EventHandle(&iEvtData, EEventsNext);
+   spStateMachine1->EventHandle(&iEvtData, EEventsNext);
+   CStateMachineCounters::EnableHandlerTiming(false);
+
+   const CStateMachineStats stats(spStateMachine1->GetStats());
+   bOk &= Check("state events",        stats.m_EventsState,       4);
+   bOk &= Check("default events",      stats.m_EventsDefault,     1);
+   bOk &= Check("type-state events",   stats.m_EventsTypeState,   1);
+   bOk &= Check("type-default events", stats.m_EventsTypeDefault, 1);
+   bOk &= Check("unhandled events",    stats.m_EventsUnhandled,   1);
+   bOk &= Check("guards evaluated",    stats.m_GuardsEvaluated,   2);
+   bOk &= Check("guards passed",       stats.m_GuardsPassed,      1);
+   bOk &= Check("transitions",         stats.m_Transitions,       2);
+   bOk &= Check("exceptions",          stats.m_Exceptions,        1);
+   if(0 == stats.m_HandlerNs) {
+      printf("handler time (enabled) is 0\n");
+      bOk = false;
+   }
+   bOk &= Check("machine-2 state events", spStateMachine2->GetStats().m_EventsState, 0);
+
+   //the registry lists the live state machines
+   bOk &= Check("registry count", CStateMachineRegistry::GetCount(), 2);
+   CStateMachineRegistry::ForEach(&Print);
+   spStateMachine2.reset();
+   bOk &= Check("registry count after destruct", CStateMachineRegistry::GetCount(), 1);
+
+   UnRegisterLogErr    ();
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+#include "vector"
+#if defined(__GLIBC__)
+#include "malloc.h"
+#endif
+
+/****************************************************************************************
+ ** 
+ ** Event enums and state machine data.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsWork  = 1,
+   EEventsStart = 2,
+   EEventsStop  = 3,
+   EEventsOther = 4
+};
+
+/** The state machine data: counts the handlers called so the behaviour
+ ** of both state machine flavours can be compared.
+ **/
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Small(0)
+      , m_Work(0)
+      , m_Other(0)
+      , m_Transitions(0)
+   {
+   }
+
+public:
+   unsigned int m_Small;
+   unsigned int m_Work;
+   unsigned int m_Other;
+   unsigned int m_Transitions;
+};
+
+/****************************************************************************************
+ ** 
+ ** Per-instance flavour.
+ **
+ ** The states register handlers bound to the state instance (HANDLER, GUARD, HANDLER_TYPE).
+ ** Every state machine instance stores its own copy of all registrations.
+ **
+ ***************************************************************************************/
+class CStateBusyInstance;
+
+class CStateIdleInstance : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateIdleInstance(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("idle", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(GUARD(int, CStateIdleInstance, GuardSmall), HANDLER(int, CStateIdleInstance, HandlerSmall), CCreateState(),                                       EEventsWork );
+      EventRegister(                                            HANDLER(int, CStateIdleInstance, HandlerWork),  CCreateState(),                                       EEventsWork );
+      EventRegister(                                            HANDLER(int, CStateIdleInstance, HandlerStart), TCreateState<CStateBusyInstance, CDemoData>(m_pData), EEventsStart);
+      EventTypeRegister(TEventEvtId<EEvents>::IdTypeInit().c_str(), HANDLER_TYPE(int, CStateIdleInstance, HandlerOther), CCreateState());
+   }
+
+public:
+   bool GuardSmall(const int* const pEvtData)
+   {
+      return *pEvtData < 10;
+   }
+
+   void HandlerSmall(const int* const)
+   {
+      ++m_pData->m_Small;
+   }
+
+   void HandlerWork(const int* const)
+   {
+      ++m_pData->m_Work;
+   }
+
+   void HandlerStart(const int* const)
+   {
+      ++m_pData->m_Transitions;
+   }
+
+   void HandlerOther(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Other;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateBusyInstance : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateBusyInstance(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("busy", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateBusyInstance, HandlerWork), CCreateState(),                                       EEventsWork);
+      EventRegister(HANDLER(int, CStateBusyInstance, HandlerStop), TCreateState<CStateIdleInstance, CDemoData>(m_pData), EEventsStop);
+   }
+
+public:
+   void HandlerWork(const int* const)
+   {
+      ++m_pData->m_Work;
+   }
+
+   void HandlerStop(const int* const)
+   {
+      ++m_pData->m_Transitions;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Shared flavour.
+ **
+ ** Identical states, but the handlers are registered as plain functions (HANDLER_SHARED,
+ ** GUARD_SHARED, HANDLER_TYPE_SHARED) and the state transitions do not refer to the data
+ ** of one state machine (TCreateStateShared). The registrations are stored once in a
+ ** handler table shared by all state machine instances.
+ **
+ ***************************************************************************************/
+class CStateBusyShared;
+
+class CStateIdleShared : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateIdleShared(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("idle", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(GUARD_SHARED(int, CStateIdleShared, GuardSmall), HANDLER_SHARED(int, CStateIdleShared, HandlerSmall), CCreateState(),                                   EEventsWork );
+      EventRegister(                                                 HANDLER_SHARED(int, CStateIdleShared, HandlerWork),  CCreateState(),                                   EEventsWork );
+      EventRegister(                                                 HANDLER_SHARED(int, CStateIdleShared, HandlerStart), TCreateStateShared<CStateBusyShared, CDemoData>(), EEventsStart);
+      EventTypeRegister(TEventEvtId<EEvents>::IdTypeInit().c_str(), HANDLER_TYPE_SHARED(int, CStateIdleShared, HandlerOther), CCreateState());
+   }
+
+public:
+   bool GuardSmall(const int* const pEvtData)
+   {
+      return *pEvtData < 10;
+   }
+
+   void HandlerSmall(const int* const)
+   {
+      ++m_pData->m_Small;
+   }
+
+   void HandlerWork(const int* const)
+   {
+      ++m_pData->m_Work;
+   }
+
+   void HandlerStart(const int* const)
+   {
+      ++m_pData->m_Transitions;
+   }
+
+   void HandlerOther(SPEventBase, const int* const)
+   {
+      ++m_pData->m_Other;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateBusyShared : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateBusyShared(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("busy", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER_SHARED(int, CStateBusyShared, HandlerWork), CCreateState(),                                   EEventsWork);
+      EventRegister(HANDLER_SHARED(int, CStateBusyShared, HandlerStop), TCreateStateShared<CStateIdleShared, CDemoData>(), EEventsStop);
+   }
+
+public:
+   void HandlerWork(const int* const)
+   {
+      ++m_pData->m_Work;
+   }
+
+   void HandlerStop(const int* const)
+   {
+      ++m_pData->m_Transitions;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Measurement helpers.
+ **
+ ***************************************************************************************/
+/** Get the number of heap bytes in use.
+ **
+ ** @return the number of bytes; 0 when not supported on this platform.
+ **/
+size_t HeapInUse(void)
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+   return mallinfo2().uordblks;
+#else
+   return 0;
+#endif
+}
+
+/** Create iCount state machines, feed each of them the same events and
+ ** measure the heap used per state machine while they are alive.
+ **
+ ** @return the heap bytes used per state machine.
+ **/
+size_t Run(const bool bShared, CDemoData& total, const unsigned int iCount)
+{
+   std::vector<SPStateMachine> stateMachines;
+   std::vector<CDemoData*>     datas;
+   stateMachines.reserve(iCount);
+   datas.reserve(iCount);
+   const size_t heapBefore(HeapInUse());
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      CDemoData* const pData(new CDemoData());
+      datas.push_back(pData);
+      const CCreateState createState(bShared ? TCreateStateShared<CStateIdleShared, CDemoData>() : TCreateState<CStateIdleInstance, CDemoData>(pData));
+      stateMachines.push_back(CStateMachine::ConstructStateMachine("state-machine", createState, pData));
+   }
+   const int iWork (1  );
+   const int iLarge(100);
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      stateMachines[i]->EventHandle(&iWork,  EEventsWork );
+      stateMachines[i]->EventHandle(&iLarge, EEventsWork );
+      stateMachines[i]->EventHandle(&iWork,  EEventsOther);
+      stateMachines[i]->EventHandle(&iWork,  EEventsStart);
+      stateMachines[i]->EventHandle(&iWork,  EEventsWork );
+      stateMachines[i]->EventHandle(&iWork,  EEventsStop );
+      stateMachines[i]->EventHandle(&iWork,  EEventsWork );
+   }
+   const size_t heapAfter(HeapInUse());
+   for(unsigned int i = 0 ; i < iCount ; ++i) {
+      total.m_Small       += datas[i]->m_Small;
+      total.m_Work        += datas[i]->m_Work;
+      total.m_Other       += datas[i]->m_Other;
+      total.m_Transitions += datas[i]->m_Transitions;
+   }
+   return heapAfter > heapBefore ? (heapAfter - heapBefore) / iCount : 0;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It runs the same state machine with per-instance and with shared
+ ** handler tables, checks that both behave the same and reports the
+ ** heap memory used per state machine instance.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   const unsigned int iCount(10000);
+   LogInfo("[%s][%u] shared-handler-tables demo in\n", __FUNCTION__, __LINE__);
+   RegisterLogNotice(FLog());
+
+   CDemoData    totalInstance;
+   CDemoData    totalShared;
+   const size_t bytesInstance(Run(false, totalInstance, iCount));
+   const size_t bytesShared  (Run(true,  totalShared,   iCount));
+
+   UnRegisterLogNotice();
+   LogInfo("[%s][%u] per-instance tables: %lu bytes per state machine (small %u work %u other %u transitions %u)\n", __FUNCTION__, __LINE__,
+           (long unsigned int)bytesInstance, totalInstance.m_Small, totalInstance.m_Work, totalInstance.m_Other, totalInstance.m_Transitions);
+   LogInfo("[%s][%u] shared tables:       %lu bytes per state machine (small %u work %u other %u transitions %u)\n", __FUNCTION__, __LINE__,
+           (long unsigned int)bytesShared,   totalShared.m_Small,   totalShared.m_Work,   totalShared.m_Other,   totalShared.m_Transitions);
+
+   int iResult(0);
+   if((totalInstance.m_Small       != totalShared.m_Small      ) ||
+      (totalInstance.m_Work        != totalShared.m_Work       ) ||
+      (totalInstance.m_Other       != totalShared.m_Other      ) ||
+      (totalInstance.m_Transitions != totalShared.m_Transitions) ||
+      (totalShared.m_Small         != 2 * iCount               ) ||
+      (totalShared.m_Transitions   != 2 * iCount               )) {
+      LogErr("[%s][%u] both flavours should handle the events in the same way\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+   if((0 != bytesInstance) && (bytesShared >= bytesInstance)) {
+      LogErr("[%s][%u] shared tables should use less memory per state machine\n", __FUNCTION__, __LINE__);
+      iResult = 1;
+   }
+
+   LogInfo("[%s][%u] shared-handler-tables demo out\n", __FUNCTION__, __LINE__);
+   return iResult;
+}
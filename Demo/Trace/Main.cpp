@@ -0,0 +1,216 @@
+/** @file
+ ** @brief 1-file state machine demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+#include "fstream"
+#include "sstream"
+#include "thread"
+
+/****************************************************************************************
+ ** 
+ ** Event enums and states.
+ ** state-1 --> state-2 --> finished
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsGuarded   = 1, //2 guards, the second passes
+   EEventsNext      = 2, //state change
+   EEventsDefault   = 3, //default state handler
+   EEventsUnhandled = 4  //nobody handles it
+};
+
+class CState2;
+
+class CState1 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState1(WPStateMachine wpStateMachine)
+      : CStateEvtId("state-1", wpStateMachine)
+   {
+      EventRegister(GUARD(int, CState1, GuardFalse), HANDLER(int, CState1, Handler), CCreateState(),                EEventsGuarded);
+      EventRegister(GUARD(int, CState1, GuardTrue),  HANDLER(int, CState1, Handler), CCreateState(),                EEventsGuarded);
+      EventRegister(                                 HANDLER(int, CState1, Handler), TCreateStateNoData<CState2>(), EEventsNext);
+   }
+
+public:
+   bool GuardFalse(const int* const)
+   {
+      return false;
+   }
+
+   bool GuardTrue(const int* const)
+   {
+      return true;
+   }
+
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CState2 : public ILULibStateMachine::CStateEvtId {
+public:
+   CState2(WPStateMachine wpStateMachine)
+      : CStateEvtId("state-2", wpStateMachine)
+   {
+      EventRegister(HANDLER(int, CState2, Handler), CCreateStateFinished(), EEventsNext);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+class CStateDefault : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateDefault(WPStateMachine wpStateMachine)
+      : CStateEvtId("state-default", wpStateMachine, true /* default state */)
+   {
+      EventRegister(HANDLER(int, CStateDefault, Handler), CCreateState(), EEventsDefault);
+   }
+
+public:
+   void Handler(const int* const)
+   {
+   }
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed every event into a new state machine.
+ **/
+void Feed(const char* szName)
+{
+   const int      iEvtData(0);
+   SPStateMachine spStateMachine(CStateMachine::ConstructStateMachine(szName, TCreateStateNoData<CState1>(), TCreateStateNoData<CStateDefault>()));
+   spStateMachine->EventHandle(&iEvtData, EEventsGuarded);
+   spStateMachine->EventHandle(&iEvtData, EEventsDefault);
+   spStateMachine->EventHandle(&iEvtData, EEventsUnhandled);
+   spStateMachine->EventHandle(&iEvtData, EEventsNext);
+   spStateMachine->EventHandle(&iEvtData, EEventsNext);
+}
+
+/** Dump the trace and decode it.
+ **
+ ** @return the decoded trace, empty on failure.
+ **/
+std::string Decode(const CTraceDecoder::EFormat format)
+{
+   const char* const szFile("Trace.dump");
+   if(!CTrace::Dump(szFile)) {
+      printf("dump failed\n");
+      return "";
+   }
+   std::ifstream     in(szFile, std::ios::in | std::ios::binary);
+   std::stringstream out;
+   std::string       strError;
+   if(!CTraceDecoder::Decode(in, out, format, strError)) {
+      printf("decode failed: %s\n", strError.c_str());
+   }
+   remove(szFile);
+   return out.str();
+}
+
+/** Count the lines containing all parts.
+ **
+ ** @return the number of lines.
+ **/
+unsigned int Count(const std::string& strText, const std::string& strPart1, const std::string& strPart2 = "")
+{
+   unsigned int      count(0);
+   std::stringstream ss(strText);
+   std::string       strLine;
+   while(std::getline(ss, strLine)) {
+      if(std::string::npos != strLine.find(strPart1) && std::string::npos != strLine.find(strPart2)) {
+         ++count;
+      }
+   }
+   return count;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It traces the events of 2 threads, decodes the trace dump and checks
+ ** the records.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogInfo   (FLog());
+   RegisterLogNotice (FLog());
+   RegisterLogWarning(FLog());
+
+   bool              bOk(true);
+   const std::string strEvent(std::string("event [") + TEventEvtId<EEvents>::IdTypeInit() + " 0x000");
+
+   //not traced
+   Feed("untraced");
+
+   //traced: this thread and a finished thread
+   CTrace::Enable(true);
+   Feed("traced");
+   std::thread thread(Feed, "threaded");
+   thread.join();
+
+   //the thread buffers created from now on keep the last 3 records
+   CTrace::SetCapacity(3);
+   std::thread threadRing(Feed, "ring");
+   threadRing.join();
+   CTrace::Enable(false);
+
+   const std::string strText(Decode(CTraceDecoder::EFormatText));
+   printf("%s", strText.c_str());
+   bOk &= Check("untraced records",             Count(strText, "machine untraced#"),                                      0);
+   bOk &= Check("traced records",               Count(strText, "machine traced#"),                                        5);
+   bOk &= Check("threaded records",             Count(strText, "thread 2 machine threaded#"),                             5);
+   bOk &= Check("ring records",                 Count(strText, "machine ring#"),                                          3);
+   bOk &= Check("guarded handler",              Count(strText, "state [state-1] " + strEvent + "1] state guard 2 "),      2);
+   bOk &= Check("default handler",              Count(strText, strEvent + "3] default guard unguarded "),                 2);
+   bOk &= Check("unhandled",                    Count(strText, strEvent + "4] unhandled guard - "),                       3);
+   bOk &= Check("state change",                 Count(strText, "state [state-1] " + strEvent + "2]", "--> [state-2]"),   3);
+   bOk &= Check("finished",                     Count(strText, "state [state-2] " + strEvent + "2]", "--> [finished]"),  3);
+
+   const std::string strChrome(Decode(CTraceDecoder::EFormatChrome));
+   bOk &= Check("chrome header",                Count(strChrome, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": ["),    1);
+   bOk &= Check("chrome state machines",        Count(strChrome, "\"ph\": \"M\""),                                        3);
+   bOk &= Check("chrome events",                Count(strChrome, "\"ph\": \"X\""),                                        13);
+
+   //cleared
+   CTrace::Clear();
+   bOk &= Check("records after clear",          Count(Decode(CTraceDecoder::EFormatText), " us thread "),                0);
+
+   UnRegisterLogWarning();
+   UnRegisterLogNotice ();
+   UnRegisterLogInfo   ();
+   return bOk ? 0 : 1;
+}
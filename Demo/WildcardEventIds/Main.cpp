@@ -0,0 +1,227 @@
+/** @file
+ ** @brief WildcardEventIds demo
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+
+//include the statemachine library and make using it easy
+#include "StateMachine.h"
+using namespace ILULibStateMachine;
+
+//include the checks shared by the demos
+#include "DemoCheck.h"
+using ILUDemo::Check;
+
+#include "cstdio"
+
+/****************************************************************************************
+ ** 
+ ** Event enums.
+ **
+ ***************************************************************************************/
+enum EEvents {
+   EEventsCall,
+   EEventsTimer
+};
+
+enum ECall {
+   ECallVoice,
+   ECallData,
+   ECallFax
+};
+
+enum EPhase {
+   EPhaseSetup,
+   EPhaseAlert,
+   EPhaseRelease
+};
+
+enum ETimer {
+   ETimerShort,
+   ETimerLong
+};
+
+/****************************************************************************************
+ ** 
+ ** State machine data and the states.
+ **
+ ** The handlers record which one of them handled the last event.
+ **
+ ***************************************************************************************/
+enum EHandler {
+   EHandlerNone,
+   EHandlerExact,       //(call, voice, setup)
+   EHandlerVoice,       //(call, voice, *)
+   EHandlerCall,        //(call, *, *)
+   EHandlerTimer,       //(timer, *)
+   EHandlerType         //the event-type handler for (event, call, phase)
+};
+
+class CDemoData : public CStateMachineData {
+public:
+   CDemoData(void)
+      : CStateMachineData()
+      , m_Handler(EHandlerNone)
+   {
+   }
+
+public:
+   EHandler m_Handler;
+};
+
+class CStateWildcard : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateWildcard(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("wildcard", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateWildcard, HandlerExact), CCreateState(), EEventsCall,  ECallVoice,          EPhaseSetup);
+      EventRegister(HANDLER(int, CStateWildcard, HandlerVoice), CCreateState(), EEventsCall,  ECallVoice,          EVTSUB_ANY(EPhase));
+      EventRegister(HANDLER(int, CStateWildcard, HandlerCall),  CCreateState(), EEventsCall,  EVTSUB_ANY(ECall),   EVTSUB_ANY(EPhase));
+      EventRegister(HANDLER(int, CStateWildcard, HandlerTimer), CCreateState(), EEventsTimer, EVTSUB_ANY(ETimer));
+   }
+
+public:
+   void HandlerExact(const int* const)
+   {
+      m_pData->m_Handler = EHandlerExact;
+   }
+
+   void HandlerVoice(const int* const)
+   {
+      m_pData->m_Handler = EHandlerVoice;
+   }
+
+   void HandlerCall(const int* const)
+   {
+      m_pData->m_Handler = EHandlerCall;
+   }
+
+   void HandlerTimer(const int* const)
+   {
+      m_pData->m_Handler = EHandlerTimer;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+class CStateExact : public ILULibStateMachine::CStateEvtId {
+public:
+   CStateExact(WPStateMachine wpStateMachine, CDemoData* const pData)
+      : CStateEvtId("exact", wpStateMachine)
+      , m_pData(pData)
+   {
+      EventRegister(HANDLER(int, CStateExact, HandlerExact), CCreateState(), EEventsCall, ECallVoice, EPhaseSetup);
+      EventTypeRegister(TEventEvtId<EEvents, ECall, EPhase>::IdTypeInit().c_str(), HANDLER_TYPE(int, CStateExact, HandlerType), CCreateState());
+   }
+
+public:
+   void HandlerExact(const int* const)
+   {
+      m_pData->m_Handler = EHandlerExact;
+   }
+
+   void HandlerType(SPEventBase, const int* const)
+   {
+      m_pData->m_Handler = EHandlerType;
+   }
+
+private:
+   CDemoData* const m_pData;
+};
+
+/****************************************************************************************
+ ** 
+ ** Helpers.
+ **
+ ***************************************************************************************/
+/** Feed an event with 2 sub-ID's.
+ **
+ ** @return the handler that handled it.
+ **/
+size_t Feed(SPStateMachine spStateMachine, CDemoData* const pData, const EEvents evtId, const ECall call, const EPhase phase)
+{
+   const int iEvtData(0);
+   pData->m_Handler = EHandlerNone;
+   spStateMachine->EventHandle(&iEvtData, evtId, call, phase);
+   return pData->m_Handler;
+}
+
+/** Feed an event with 1 sub-ID.
+ **
+ ** @return the handler that handled it.
+ **/
+size_t Feed(SPStateMachine spStateMachine, CDemoData* const pData, const EEvents evtId, const ETimer timer)
+{
+   const int iEvtData(0);
+   pData->m_Handler = EHandlerNone;
+   spStateMachine->EventHandle(&iEvtData, evtId, timer);
+   return pData->m_Handler;
+}
+
+/****************************************************************************************
+ ** 
+ ** This is the main function.
+ ** It checks that an event without an exact match is handled by the most
+ ** specific wildcard registration, and that broadcasting finds the state
+ ** machines interested through a wildcard.
+ **
+ ***************************************************************************************/
+int main (void)
+{
+   RegisterLogDebug (FLog());
+   RegisterLogNotice(FLog());
+
+   const int      iEvtData(0);
+   bool           bOk(true);
+   CDemoData*     pWildcardData(new CDemoData());
+   SPStateMachine spWildcard(CStateMachine::ConstructStateMachine("wildcard", TCreateStateShared<CStateWildcard, CDemoData>(), pWildcardData));
+   CDemoData*     pExactData(new CDemoData());
+   SPStateMachine spExact(CStateMachine::ConstructStateMachine("exact", TCreateStateShared<CStateExact, CDemoData>(), pExactData));
+
+   //most specific first
+   bOk &= Check("call voice setup: exact",        Feed(spWildcard, pWildcardData, EEventsCall,  ECallVoice, EPhaseSetup),   EHandlerExact);
+   bOk &= Check("call voice alert: voice *",      Feed(spWildcard, pWildcardData, EEventsCall,  ECallVoice, EPhaseAlert),   EHandlerVoice);
+   bOk &= Check("call voice release: voice *",    Feed(spWildcard, pWildcardData, EEventsCall,  ECallVoice, EPhaseRelease), EHandlerVoice);
+   bOk &= Check("call data setup: * *",           Feed(spWildcard, pWildcardData, EEventsCall,  ECallData,  EPhaseSetup),   EHandlerCall);
+   bOk &= Check("call fax release: * *",          Feed(spWildcard, pWildcardData, EEventsCall,  ECallFax,   EPhaseRelease), EHandlerCall);
+   bOk &= Check("timer long: *",                  Feed(spWildcard, pWildcardData, EEventsTimer, ETimerLong),                EHandlerTimer);
+   //no wildcard for the event ID
+   bOk &= Check("timer call voice setup: none",   Feed(spWildcard, pWildcardData, EEventsTimer, ECallVoice, EPhaseSetup),   EHandlerNone);
+
+   //without wildcards: the event-type handler
+   bOk &= Check("exact, call voice setup: exact", Feed(spExact,    pExactData,    EEventsCall,  ECallVoice, EPhaseSetup),   EHandlerExact);
+   bOk &= Check("exact, call data setup: type",   Feed(spExact,    pExactData,    EEventsCall,  ECallData,  EPhaseSetup),   EHandlerType);
+   bOk &= Check("exact, timer long: none",        Feed(spExact,    pExactData,    EEventsTimer, ETimerLong),                EHandlerNone);
+
+   //broadcasting finds the wildcard registrations
+   {
+      CBroadcast broadcast;
+      broadcast.Subscribe(spWildcard);
+      broadcast.Subscribe(spExact);
+      bOk &= Check("broadcast call voice setup",  broadcast.Broadcast(&iEvtData, EEventsCall,  ECallVoice, EPhaseSetup), 2);
+      bOk &= Check("broadcast call data alert",   broadcast.Broadcast(&iEvtData, EEventsCall,  ECallData,  EPhaseAlert), 2);
+      bOk &= Check("broadcast timer short",       broadcast.Broadcast(&iEvtData, EEventsTimer, ETimerShort),             1);
+   }
+
+   UnRegisterLogNotice();
+   UnRegisterLogDebug ();
+   return bOk ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/** @file
+ ** @brief The CAllocationStats definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "Include/CAllocationStats.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** Statistics of the innermost scope of the current thread, NULL outside a state machine.
+       **/
+      thread_local CAllocationStats* tl_pStats = NULL;
+
+      /** Category of the innermost scope of the current thread.
+       **/
+      thread_local EAllocation       tl_Category = EAllocationDispatch;
+
+      /** Totals of all state machines of the current thread.
+       **/
+      thread_local CAllocationStats  tl_Totals;
+   }
+
+   /** Constructor: all counts 0.
+    **/
+   CAllocationStats::CAllocationStats(void)
+   {
+      for(unsigned int i = 0 ; i < EAllocationCount ; ++i) {
+         m_Count[i] = 0;
+         m_Bytes[i] = 0;
+      }
+   }
+
+   /** Indicates whether the library has been compiled with allocation
+    ** accounting (ALLOCATION_STATS).
+    **
+    ** @return true when the counts are collected.
+    **/
+   bool CAllocationStats::IsEnabled(void)
+   {
+#ifdef ALLOCATION_STATS
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   /** Get the name of a category (e.g. for reports).
+    **
+    ** @return the name.
+    **/
+   const char* CAllocationStats::GetName(
+      const EAllocation category //< The category.
+      )
+   {
+      switch(category) {
+         case EAllocationRegistration: return "registration";
+         case EAllocationDispatch:     return "dispatch";
+         case EAllocationTransition:   return "transition";
+         case EAllocationLogging:      return "logging";
+         case EAllocationTeardown:     return "teardown";
+         default:                      return "unknown";
+      }
+   }
+
+   /** Report an allocation: attributed to the state machine and category
+    ** of the innermost scope of the calling thread, ignored outside a
+    ** scope.
+    **
+    ** Does not allocate, so it can be called from a replaced global
+    ** operator new.
+    **/
+   void CAllocationStats::RecordAllocation(
+      const size_t size //< Number of bytes allocated.
+      )
+   {
+      if(NULL == tl_pStats) {
+         return;
+      }
+      tl_pStats->Record(tl_Category, size);
+      tl_Totals.Record(tl_Category, size);
+   }
+
+   /** Get the totals of all state machines of the calling thread,
+    ** including the ones already destructed (e.g. to see the teardown
+    ** allocations).
+    **
+    ** @return the totals.
+    **/
+   const CAllocationStats& CAllocationStats::GetThreadTotals(void)
+   {
+      return tl_Totals;
+   }
+
+   /** Get the number of allocations of a category.
+    **
+    ** @return the number of allocations.
+    **/
+   unsigned long long CAllocationStats::GetCount(
+      const EAllocation category //< The category.
+      ) const
+   {
+      return EAllocationCount > category ? m_Count[category] : 0;
+   }
+
+   /** Get the number of bytes allocated in a category.
+    **
+    ** @return the number of bytes.
+    **/
+   unsigned long long CAllocationStats::GetBytes(
+      const EAllocation category //< The category.
+      ) const
+   {
+      return EAllocationCount > category ? m_Bytes[category] : 0;
+   }
+
+   /** Add an allocation to a category.
+    **/
+   void CAllocationStats::Record(
+      const EAllocation category, //< The category.
+      const size_t      size      //< Number of bytes allocated.
+      )
+   {
+      if(EAllocationCount <= category) {
+         return;
+      }
+      ++m_Count[category];
+      m_Bytes[category] += size;
+   }
+
+   /** Constructor: attribute the allocations of the calling thread to the
+    ** statistics and the category.
+    **/
+   CAllocationScope::CAllocationScope(
+      CAllocationStats* const pStats,  //< Statistics of the state machine, NULL to keep the state machine of the enclosing scope.
+      const EAllocation       category //< The category.
+      )
+      : m_pPrevious       (tl_pStats  )
+      , m_PreviousCategory(tl_Category)
+   {
+      if(NULL != pStats) {
+         tl_pStats = pStats;
+      }
+      tl_Category = category;
+   }
+
+   /** Destructor: restore the previous statistics and category.
+    **/
+   CAllocationScope::~CAllocationScope(void)
+   {
+      tl_pStats   = m_pPrevious;
+      tl_Category = m_PreviousCategory;
+   }
+}
@@ -0,0 +1,1285 @@
+/** @file
+ ** @brief The CBinaryLog definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **
+ ** A thread buffer is a single-producer single-consumer byte ring of
+ ** records, every record starts with a CRecordHeader and is a multiple
+ ** of 16 bytes. A record that does not fit before the end of the ring is
+ ** preceded by a padding record.
+ ** The arguments follow the header in the order of the conversions: an
+ ** integer, pointer or double takes 8 bytes, a long double 16 bytes and a
+ ** string a 4-byte length followed by the characters (padded to 8 bytes).
+ **/
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Include/CBinaryLog.h"
+#include "Internal/LoggingInternal.h"
+
+namespace ILULibStateMachine {
+   //use the libraries internal functions (not a part of the interface)
+   using namespace Internal;
+
+   namespace {
+      /** Record kinds (besides the ELogLevel values).
+       **/
+      enum EKind {
+         EKindIndent = ELogLevelCount, ///< Increase the indentation.
+         EKindUnindent,                ///< Decrease the indentation.
+         EKindPadding,                 ///< Skip to the start of the ring (thread buffers only).
+         EKindFormat                   ///< Format string definition (files only).
+      };
+
+      /** String length indicating a NULL pointer.
+       **/
+      const uint32_t STRING_NULL = 0xFFFFFFFF;
+
+      /** @brief Precedes every record.
+       **/
+      class CRecordHeader {
+         public:
+            uint32_t m_Size;        ///< Size of the record, header included (a multiple of 16).
+            uint32_t m_Format;      ///< Format ID (ELogLevel and EKindFormat records).
+            uint8_t  m_Kind;        ///< ELogLevel or EKind.
+            uint8_t  m_Reserved[7]; ///< Padding, 0.
+      };
+
+      /** Round up to a multiple of 8 or 16.
+       **/
+      inline size_t Align(const size_t size, const size_t alignment)
+      {
+         return (size + alignment - 1) & ~(alignment - 1);
+      }
+
+      /** @brief The type of a (deferred) printf argument.
+       **/
+      enum EArg {
+         EArgInt = 0,
+         EArgLong,
+         EArgLongLong,
+         EArgIntMax,
+         EArgSize,
+         EArgPtrDiff,
+         EArgDouble,
+         EArgLongDouble,
+         EArgString,
+         EArgPointer
+      };
+
+      /** @brief 1 conversion of a format string with the literal text preceding it.
+       **/
+      class CConversion {
+         public:
+            std::string m_strLiteral;    ///< Text preceding the conversion ('%%' resolved).
+            std::string m_strSpec;       ///< The conversion specification, e.g. "%-*.3ld".
+            bool        m_bWidthArg;     ///< The width is an argument ('*').
+            bool        m_bPrecisionArg; ///< The precision is an argument ('.*').
+            int         m_Precision;     ///< Precision when given in the format, -1 otherwise.
+            EArg        m_Arg;           ///< Type of the argument.
+      };
+
+      /** @brief A parsed format string.
+       **/
+      class CFormat {
+         public:
+            CFormat(const uint32_t id, const std::string& strFormat);
+
+         public:
+            size_t                   Encode(va_list ap, uint8_t* const pOut) const;
+            size_t                   GetSize(const uint8_t* const pArgs, const size_t size) const;
+            void                     Format(const uint8_t* const pArgs, std::string& strOut) const;
+
+         private:
+            bool                     Parse(void);
+
+         public:
+            const uint32_t           m_Id;          ///< The format ID.
+            const std::string        m_strFormat;   ///< The format string.
+            std::vector<CConversion> m_Conversions; ///< The conversions.
+            std::string              m_strTail;     ///< Text following the last conversion.
+            bool                     m_bDeferrable; ///< All conversions can be deferred.
+      };
+
+      /** Constructor: parse the format.
+       **/
+      CFormat::CFormat(
+         const uint32_t     id,       //< The format ID.
+         const std::string& strFormat //< The format string.
+         )
+         : m_Id         (id       )
+         , m_strFormat  (strFormat)
+         , m_Conversions(         )
+         , m_strTail    (         )
+         , m_bDeferrable(false    )
+      {
+         m_bDeferrable = Parse();
+      }
+
+      /** Split the format in conversions.
+       **
+       ** @return false when a conversion cannot be deferred.
+       **/
+      bool CFormat::Parse(void)
+      {
+         const char* p(m_strFormat.c_str());
+         std::string strLiteral;
+         while('\0' != *p) {
+            if('%' != *p) {
+               strLiteral += *p++;
+               continue;
+            }
+            if('%' == p[1]) {
+               strLiteral += '%';
+               p += 2;
+               continue;
+            }
+            CConversion conversion;
+            conversion.m_strLiteral    = strLiteral;
+            conversion.m_bWidthArg     = false;
+            conversion.m_bPrecisionArg = false;
+            conversion.m_Precision     = -1;
+            conversion.m_Arg           = EArgInt;
+            const char* const pStart(p++);
+            while('\0' != *p && NULL != strchr("-+ #0'", *p)) {
+               ++p;
+            }
+            if('*' == *p) {
+               conversion.m_bWidthArg = true;
+               ++p;
+            } else {
+               while('0' <= *p && '9' >= *p) {
+                  ++p;
+               }
+            }
+            if('.' == *p) {
+               ++p;
+               if('*' == *p) {
+                  conversion.m_bPrecisionArg = true;
+                  ++p;
+               } else {
+                  conversion.m_Precision = 0;
+                  while('0' <= *p && '9' >= *p) {
+                     conversion.m_Precision = 10 * conversion.m_Precision + (*p++ - '0');
+                  }
+               }
+            }
+            std::string strLength;
+            while('\0' != *p && NULL != strchr("hljztLq", *p)) {
+               strLength += *p++;
+            }
+            switch(*p) {
+               case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+                  if(strLength.empty() || "h" == strLength || "hh" == strLength) conversion.m_Arg = EArgInt;
+                  else if("l"  == strLength)                                     conversion.m_Arg = EArgLong;
+                  else if("ll" == strLength || "q" == strLength || "L" == strLength) conversion.m_Arg = EArgLongLong;
+                  else if("j"  == strLength)                                     conversion.m_Arg = EArgIntMax;
+                  else if("z"  == strLength)                                     conversion.m_Arg = EArgSize;
+                  else if("t"  == strLength)                                     conversion.m_Arg = EArgPtrDiff;
+                  else return false;
+                  break;
+               case 'c':
+                  if(!strLength.empty()) return false;
+                  conversion.m_Arg = EArgInt;
+                  break;
+               case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                  if(strLength.empty() || "l" == strLength) conversion.m_Arg = EArgDouble;
+                  else if("L" == strLength)                 conversion.m_Arg = EArgLongDouble;
+                  else return false;
+                  break;
+               case 's':
+                  if(!strLength.empty()) return false;
+                  conversion.m_Arg = EArgString;
+                  break;
+               case 'p':
+                  if(!strLength.empty()) return false;
+                  conversion.m_Arg = EArgPointer;
+                  break;
+               default:
+                  //%n, %m, incomplete or unknown conversion
+                  return false;
+            }
+            ++p;
+            conversion.m_strSpec.assign(pStart, p);
+            m_Conversions.push_back(conversion);
+            strLiteral.clear();
+         }
+         m_strTail = strLiteral;
+         return true;
+      }
+
+      /** Store an 8-byte value.
+       **/
+      template <class T>
+      inline size_t Put(uint8_t* const pOut, size_t offset, const T value)
+      {
+         if(NULL != pOut) {
+            memcpy(pOut + offset, &value, sizeof(T));
+         }
+         return offset + Align(sizeof(T), 8);
+      }
+
+      /** Store the arguments (or only compute their size when pOut is NULL).
+       **
+       ** @return the size of the arguments.
+       **/
+      size_t CFormat::Encode(
+         va_list        ap,  //< The arguments.
+         uint8_t* const pOut //< Where to store the arguments, NULL to get the size.
+         ) const
+      {
+         size_t offset(0);
+         for(std::vector<CConversion>::const_iterator cit = m_Conversions.begin() ; m_Conversions.end() != cit ; ++cit) {
+            int precision(cit->m_Precision);
+            if(cit->m_bWidthArg) {
+               offset = Put<int64_t>(pOut, offset, va_arg(ap, int));
+            }
+            if(cit->m_bPrecisionArg) {
+               precision = va_arg(ap, int);
+               offset    = Put<int64_t>(pOut, offset, precision);
+            }
+            switch(cit->m_Arg) {
+               case EArgInt:        offset = Put<int64_t>(pOut, offset, va_arg(ap, int));                       break;
+               case EArgLong:       offset = Put<int64_t>(pOut, offset, va_arg(ap, long));                      break;
+               case EArgLongLong:   offset = Put<int64_t>(pOut, offset, va_arg(ap, long long));                 break;
+               case EArgIntMax:     offset = Put<int64_t>(pOut, offset, va_arg(ap, intmax_t));                  break;
+               case EArgSize:       offset = Put<uint64_t>(pOut, offset, va_arg(ap, size_t));                   break;
+               case EArgPtrDiff:    offset = Put<int64_t>(pOut, offset, va_arg(ap, ptrdiff_t));                 break;
+               case EArgDouble:     offset = Put<double>(pOut, offset, va_arg(ap, double));                     break;
+               case EArgLongDouble: offset = Put<long double>(pOut, offset, va_arg(ap, long double));           break;
+               case EArgPointer:    offset = Put<uint64_t>(pOut, offset, reinterpret_cast<uintptr_t>(va_arg(ap, void*))); break;
+               case EArgString: {
+                  const char* const sz(va_arg(ap, const char*));
+                  const uint32_t    length(NULL == sz ? STRING_NULL : static_cast<uint32_t>(0 <= precision ? strnlen(sz, static_cast<size_t>(precision)) : strlen(sz)));
+                  if(NULL != pOut) {
+                     memcpy(pOut + offset, &length, sizeof(length));
+                  }
+                  offset += sizeof(length);
+                  if(STRING_NULL != length) {
+                     if(NULL != pOut) {
+                        memcpy(pOut + offset, sz, length);
+                     }
+                     offset += length;
+                  }
+                  offset = Align(offset, 8);
+                  break;
+               }
+               default:
+                  break;
+            }
+         }
+         return offset;
+      }
+
+      /** Get the size of stored arguments (to check a record read from a file).
+       **
+       ** @return the size of the arguments, larger than size when they do not fit.
+       **/
+      size_t CFormat::GetSize(
+         const uint8_t* const pArgs, //< The stored arguments.
+         const size_t         size   //< Number of bytes available.
+         ) const
+      {
+         size_t offset(0);
+         for(std::vector<CConversion>::const_iterator cit = m_Conversions.begin() ; m_Conversions.end() != cit ; ++cit) {
+            if(cit->m_bWidthArg) {
+               offset += 8;
+            }
+            if(cit->m_bPrecisionArg) {
+               offset += 8;
+            }
+            if(EArgLongDouble == cit->m_Arg) {
+               offset += Align(sizeof(long double), 8);
+            } else if(EArgString != cit->m_Arg) {
+               offset += 8;
+            } else {
+               uint32_t length;
+               if(offset + sizeof(length) > size) {
+                  return size + 1;
+               }
+               memcpy(&length, pArgs + offset, sizeof(length));
+               offset += sizeof(length);
+               if(STRING_NULL != length) {
+                  offset += length;
+               }
+               offset = Align(offset, 8);
+            }
+            if(offset > size) {
+               return size + 1;
+            }
+         }
+         return offset;
+      }
+
+      /** Get a stored value.
+       **/
+      template <class T>
+      inline T Get(const uint8_t* const pArgs, size_t& offset)
+      {
+         T value;
+         memcpy(&value, pArgs + offset, sizeof(T));
+         offset += Align(sizeof(T), 8);
+         return value;
+      }
+
+      /** Append 1 formatted value.
+       **/
+      template <class T>
+      void Append(std::string& strOut, const std::string& strSpec, const T value)
+      {
+         char      buf[128];
+         const int length(snprintf(buf, sizeof(buf), strSpec.c_str(), value));
+         if(0 > length) {
+            return;
+         }
+         if(static_cast<size_t>(length) < sizeof(buf)) {
+            strOut.append(buf, static_cast<size_t>(length));
+            return;
+         }
+         std::vector<char> large(static_cast<size_t>(length) + 1);
+         snprintf(&large[0], large.size(), strSpec.c_str(), value);
+         strOut.append(&large[0], static_cast<size_t>(length));
+      }
+
+      /** Replace the first '*' in a conversion specification with a number.
+       **/
+      void ReplaceStar(std::string& strSpec, const long long value)
+      {
+         const size_t pos(strSpec.find('*'));
+         if(std::string::npos != pos) {
+            strSpec.replace(pos, 1, std::to_string(value));
+         }
+      }
+
+      /** Format the stored arguments.
+       **/
+      void CFormat::Format(
+         const uint8_t* const pArgs, //< The stored arguments.
+         std::string&         strOut //< Formatted message (appended).
+         ) const
+      {
+         size_t offset(0);
+         for(std::vector<CConversion>::const_iterator cit = m_Conversions.begin() ; m_Conversions.end() != cit ; ++cit) {
+            strOut += cit->m_strLiteral;
+            std::string strSpec(cit->m_strSpec);
+            if(cit->m_bWidthArg) {
+               ReplaceStar(strSpec, Get<int64_t>(pArgs, offset));
+            }
+            if(cit->m_bPrecisionArg) {
+               ReplaceStar(strSpec, Get<int64_t>(pArgs, offset));
+            }
+            switch(cit->m_Arg) {
+               case EArgInt:        Append(strOut, strSpec, static_cast<int>(Get<int64_t>(pArgs, offset)));         break;
+               case EArgLong:       Append(strOut, strSpec, static_cast<long>(Get<int64_t>(pArgs, offset)));        break;
+               case EArgLongLong:   Append(strOut, strSpec, static_cast<long long>(Get<int64_t>(pArgs, offset)));   break;
+               case EArgIntMax:     Append(strOut, strSpec, static_cast<intmax_t>(Get<int64_t>(pArgs, offset)));    break;
+               case EArgSize:       Append(strOut, strSpec, static_cast<size_t>(Get<uint64_t>(pArgs, offset)));     break;
+               case EArgPtrDiff:    Append(strOut, strSpec, static_cast<ptrdiff_t>(Get<int64_t>(pArgs, offset)));   break;
+               case EArgDouble:     Append(strOut, strSpec, Get<double>(pArgs, offset));                            break;
+               case EArgLongDouble: Append(strOut, strSpec, Get<long double>(pArgs, offset));                       break;
+               case EArgPointer:    Append(strOut, strSpec, reinterpret_cast<void*>(static_cast<uintptr_t>(Get<uint64_t>(pArgs, offset)))); break;
+               case EArgString: {
+                  uint32_t length;
+                  memcpy(&length, pArgs + offset, sizeof(length));
+                  offset += sizeof(length);
+                  if(STRING_NULL == length) {
+                     Append(strOut, strSpec, static_cast<const char*>(NULL));
+                     offset = Align(offset, 8);
+                     break;
+                  }
+                  //the stored string is not 0-terminated
+                  const std::string strValue(reinterpret_cast<const char*>(pArgs + offset), length);
+                  Append(strOut, strSpec, strValue.c_str());
+                  offset = Align(offset + length, 8);
+                  break;
+               }
+               default:
+                  break;
+            }
+         }
+         strOut += m_strTail;
+      }
+
+      /** Protects the thread list, the format registry and the sleeping consumer.
+       **/
+      std::mutex                      s_Mutex;
+
+      /** Wakes up the consumer.
+       **/
+      std::condition_variable         s_Wakeup;
+
+      /** The formats (index is the ID), never removed so pointers stay valid.
+       **/
+      std::deque<CFormat>             s_Formats;
+
+      /** The formats by format string.
+       **/
+      std::map<std::string, const CFormat*> s_FormatsByString;
+
+      /** Size of the thread buffers created from now on.
+       **/
+      std::atomic<uint32_t>           s_Capacity(CBinaryLog::DEFAULT_CAPACITY);
+
+      /** The overflow policy.
+       **/
+      EAsyncLogOverflow               s_Overflow = EAsyncLogOverflowDrop;
+
+      /** Binary log file, NULL to format on the consumer.
+       **/
+      FILE*                           s_pFile = NULL;
+
+      /** The consumer.
+       **/
+      std::thread                     s_Thread;
+
+      /** The consumer is running (s_Mutex).
+       **/
+      bool                            s_bConsumer = false;
+
+      /** The consumer finishes once all buffers are empty.
+       **/
+      std::atomic<bool>               s_bStop(false);
+
+      /** The consumer waits for records.
+       **/
+      std::atomic<bool>               s_bSleeping(false);
+
+      /** Number of threads recording right now.
+       **/
+      std::atomic<unsigned int>       s_Users(0);
+
+      /** Records dropped because a thread buffer was full.
+       **/
+      std::atomic<unsigned long long> s_Dropped(0);
+
+      /** Flushes requested.
+       **/
+      std::atomic<unsigned long long> s_FlushRequest(0);
+
+      /** Flushes done by the consumer.
+       **/
+      std::atomic<unsigned long long> s_FlushDone(0);
+
+      /** Formats known by the consumer (consumer only).
+       **/
+      std::vector<const CFormat*>     s_ConsumerFormats;
+
+      /** Formats written to the file (consumer only).
+       **/
+      std::vector<bool>               s_FileFormats;
+
+      /** Wake up the consumer when it is sleeping.
+       **/
+      void WakeUp(void)
+      {
+         if(s_bSleeping.load()) {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Wakeup.notify_one();
+         }
+      }
+
+      /** Register a format string.
+       **
+       ** @return the format.
+       **/
+      const CFormat* RegisterFormat(
+         const char* const szFormat //< The format string.
+         )
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         const std::string strFormat(szFormat);
+         std::map<std::string, const CFormat*>::const_iterator cit(s_FormatsByString.find(strFormat));
+         if(s_FormatsByString.end() != cit) {
+            return cit->second;
+         }
+         s_Formats.emplace_back(static_cast<uint32_t>(s_Formats.size()), strFormat);
+         const CFormat* const pFormat(&s_Formats.back());
+         s_FormatsByString[strFormat] = pFormat;
+         return pFormat;
+      }
+
+      /** @brief The buffer of 1 thread.
+       **
+       ** The thread writes records at m_Head, the consumer reads them at m_Tail.
+       **/
+      class CThreadLog {
+         public:
+            explicit CThreadLog(const uint32_t capacity);
+
+         public:
+            const CFormat*           Lookup(const char* const szFormat);
+            uint8_t*                 Reserve(const size_t size);
+            void                     Commit(const size_t size);
+            size_t                   GetCapacity(void) const;
+
+         public:
+            std::vector<uint8_t>     m_Buffer;    ///< The ring.
+            const uint64_t           m_Mask;      ///< m_Buffer.size() - 1.
+            std::atomic<uint64_t>    m_Head;      ///< Bytes written so far.
+            std::atomic<uint64_t>    m_Tail;      ///< Bytes consumed so far.
+            bool                     m_bFinished; ///< The thread exited (s_Mutex).
+
+         private:
+            std::unordered_map<const char*, const CFormat*> m_Formats; ///< Formats by format string address (thread only).
+      };
+
+      /** Constructor.
+       **/
+      CThreadLog::CThreadLog(
+         const uint32_t capacity //< Buffer size (a power of 2).
+         )
+         : m_Buffer   (capacity    )
+         , m_Mask     (capacity - 1)
+         , m_Head     (0           )
+         , m_Tail     (0           )
+         , m_bFinished(false       )
+         , m_Formats  (            )
+      {
+      }
+
+      /** Find the format, registering it upon first use.
+       **
+       ** The address of the format string is cached, the string is
+       ** compared to handle formats that are not string literals.
+       **
+       ** @return the format.
+       **/
+      const CFormat* CThreadLog::Lookup(
+         const char* const szFormat //< The format string.
+         )
+      {
+         std::unordered_map<const char*, const CFormat*>::const_iterator cit(m_Formats.find(szFormat));
+         if(m_Formats.end() != cit && 0 == strcmp(szFormat, cit->second->m_strFormat.c_str())) {
+            return cit->second;
+         }
+         const CFormat* const pFormat(RegisterFormat(szFormat));
+         m_Formats[szFormat] = pFormat;
+         return pFormat;
+      }
+
+      /** Get room for a record.
+       **
+       ** @return where to write the record, NULL when dropped.
+       **/
+      uint8_t* CThreadLog::Reserve(
+         const size_t size //< Size of the record (a multiple of 16).
+         )
+      {
+         const uint64_t capacity(m_Mask + 1);
+         for(;;) {
+            const uint64_t head      (m_Head.load(std::memory_order_relaxed));
+            const uint64_t offset    (head & m_Mask);
+            const uint64_t contiguous(capacity - offset);
+            const uint64_t needed    (contiguous < size ? contiguous + size : size);
+            if(capacity - (head - m_Tail.load(std::memory_order_acquire)) >= needed) {
+               if(contiguous >= size) {
+                  return &m_Buffer[offset];
+               }
+               //skip to the start of the ring
+               CRecordHeader header;
+               memset(&header, 0, sizeof(header));
+               header.m_Size = static_cast<uint32_t>(contiguous);
+               header.m_Kind = EKindPadding;
+               memcpy(&m_Buffer[offset], &header, sizeof(header));
+               m_Head.store(head + contiguous, std::memory_order_release);
+               continue;
+            }
+            if(EAsyncLogOverflowDrop == s_Overflow) {
+               return NULL;
+            }
+            WakeUp();
+            std::this_thread::yield();
+         }
+      }
+
+      /** Publish the record written in the room got from Reserve.
+       **/
+      void CThreadLog::Commit(
+         const size_t size //< Size of the record.
+         )
+      {
+         m_Head.store(m_Head.load(std::memory_order_relaxed) + size);
+         WakeUp();
+      }
+
+      /** Get the buffer size.
+       **
+       ** @return the size in bytes.
+       **/
+      size_t CThreadLog::GetCapacity(void) const
+      {
+         return m_Buffer.size();
+      }
+
+      /** Threads that have recorded (s_Mutex).
+       **/
+      std::vector<CThreadLog*>        s_Threads;
+
+      /** Delete the buffers of the finished threads that have been consumed, s_Mutex locked.
+       **/
+      void DeleteFinishedLocked(void)
+      {
+         std::vector<CThreadLog*>::iterator it(s_Threads.begin());
+         while(s_Threads.end() != it) {
+            if((*it)->m_bFinished && (*it)->m_Head.load() == (*it)->m_Tail.load()) {
+               delete *it;
+               it = s_Threads.erase(it);
+            } else {
+               ++it;
+            }
+         }
+      }
+
+      /** @brief Owns the buffer of the calling thread.
+       **/
+      class CThreadLogHolder {
+         public:
+            CThreadLogHolder(void);
+            ~CThreadLogHolder(void);
+
+         public:
+            CThreadLog& Get(void);
+
+         private:
+            CThreadLog* m_pLog; ///< The buffer, created upon the first record.
+      };
+
+      /** Constructor.
+       **/
+      CThreadLogHolder::CThreadLogHolder(void)
+         : m_pLog(NULL)
+      {
+      }
+
+      /** Destructor: the consumer deletes the buffer once it is consumed.
+       **/
+      CThreadLogHolder::~CThreadLogHolder(void)
+      {
+         if(NULL == m_pLog) {
+            return;
+         }
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         m_pLog->m_bFinished = true;
+         if(!s_bConsumer) {
+            DeleteFinishedLocked();
+         }
+      }
+
+      /** Get the buffer of the calling thread.
+       **
+       ** @return the buffer.
+       **/
+      CThreadLog& CThreadLogHolder::Get(void)
+      {
+         if(NULL == m_pLog) {
+            uint32_t capacity(4096);
+            while(capacity < s_Capacity.load()) {
+               capacity <<= 1;
+            }
+            m_pLog = new CThreadLog(capacity);
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Threads.push_back(m_pLog);
+         }
+         return *m_pLog;
+      }
+
+      /** The buffer of the calling thread.
+       **/
+      thread_local CThreadLogHolder   tl_Log;
+
+      /** Get a format on the consumer.
+       **
+       ** @return the format.
+       **/
+      const CFormat* GetConsumerFormat(
+         const uint32_t id //< The format ID.
+         )
+      {
+         if(id >= s_ConsumerFormats.size()) {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            for(size_t i = s_ConsumerFormats.size() ; i < s_Formats.size() ; ++i) {
+               s_ConsumerFormats.push_back(&s_Formats[i]);
+            }
+         }
+         return s_ConsumerFormats[id];
+      }
+
+      /** Write a record.
+       **
+       ** @return true on success.
+       **/
+      bool WriteRecord(
+         FILE* const          pFile,  //< The file.
+         const CRecordHeader& header, //< The record header.
+         const void* const    pData,  //< The data following the header.
+         const size_t         size    //< Size of the data (padded with 0's up to header.m_Size).
+         )
+      {
+         static const uint8_t zeros[16] = {0};
+         const size_t padding(header.m_Size - sizeof(header) - size);
+         return 1 == fwrite(&header, sizeof(header), 1, pFile)
+            && (0 == size    || 1 == fwrite(pData, size, 1, pFile))
+            && (0 == padding || 1 == fwrite(zeros, padding, 1, pFile));
+      }
+
+      /** Write a record to the file, preceded by its format upon first use.
+       **/
+      void WriteToFile(
+         const CRecordHeader& header, //< The record header.
+         const uint8_t* const p       //< The record.
+         )
+      {
+         if(ELogLevelCount > header.m_Kind) {
+            if(header.m_Format >= s_FileFormats.size()) {
+               s_FileFormats.resize(header.m_Format + 1, false);
+            }
+            if(!s_FileFormats[header.m_Format]) {
+               s_FileFormats[header.m_Format] = true;
+               const std::string& strFormat(GetConsumerFormat(header.m_Format)->m_strFormat);
+               CRecordHeader format;
+               memset(&format, 0, sizeof(format));
+               format.m_Size   = static_cast<uint32_t>(Align(sizeof(format) + strFormat.size(), 16));
+               format.m_Format = header.m_Format;
+               format.m_Kind   = EKindFormat;
+               WriteRecord(s_pFile, format, strFormat.data(), strFormat.size());
+            }
+         }
+         fwrite(p, header.m_Size, 1, s_pFile);
+      }
+
+      /** Format a record and pass it to the registered logging function.
+       **/
+      void Output(
+         const CRecordHeader& header, //< The record header.
+         const uint8_t* const p       //< The record.
+         )
+      {
+         try {
+            CLogReadScope scope;
+            switch(header.m_Kind) {
+               case EKindIndent:
+                  LogSinkIndent().Get()();
+                  break;
+               case EKindUnindent:
+                  LogSinkUnindent().Get()();
+                  break;
+               default: {
+                  std::string strMsg;
+                  GetConsumerFormat(header.m_Format)->Format(p + sizeof(header), strMsg);
+                  const FLog* pLog(NULL);
+                  switch(header.m_Kind) {
+                     case ELogLevelDebug:   pLog = &LogSinkDebug  ().Get(); break;
+                     case ELogLevelInfo:    pLog = &LogSinkInfo   ().Get(); break;
+                     case ELogLevelNotice:  pLog = &LogSinkNotice ().Get(); break;
+                     case ELogLevelWarning: pLog = &LogSinkWarning().Get(); break;
+                     default:               pLog = &LogSinkErr    ().Get(); break;
+                  }
+                  if(*pLog) {
+                     (*pLog)(strMsg);
+                  }
+                  break;
+               }
+            }
+         } catch(...) {
+            //a logging function failed: nothing to report it to
+         }
+      }
+
+      /** Consume the records of 1 thread.
+       **
+       ** @return the number of records consumed.
+       **/
+      size_t Drain(
+         CThreadLog& thread //< The thread buffer.
+         )
+      {
+         size_t         count(0);
+         uint64_t       tail (thread.m_Tail.load(std::memory_order_relaxed));
+         const uint64_t head (thread.m_Head.load(std::memory_order_acquire));
+         while(tail != head) {
+            const uint8_t* const p(&thread.m_Buffer[tail & thread.m_Mask]);
+            CRecordHeader header;
+            memcpy(&header, p, sizeof(header));
+            if(EKindPadding != header.m_Kind) {
+               if(NULL != s_pFile) {
+                  WriteToFile(header, p);
+               } else {
+                  Output(header, p);
+               }
+               ++count;
+            }
+            tail += header.m_Size;
+            thread.m_Tail.store(tail, std::memory_order_release);
+         }
+         return count;
+      }
+
+      /** Consume the records of all threads.
+       **
+       ** @return the number of records consumed.
+       **/
+      size_t DrainAll(void)
+      {
+         std::vector<CThreadLog*> threads;
+         {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            threads = s_Threads;
+         }
+         size_t count(0);
+         for(std::vector<CThreadLog*>::iterator it = threads.begin() ; threads.end() != it ; ++it) {
+            count += Drain(**it);
+         }
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         DeleteFinishedLocked();
+         return count;
+      }
+
+      /** Indicates whether a thread buffer contains records, s_Mutex locked.
+       **
+       ** @return true when there is something to consume.
+       **/
+      bool PendingLocked(void)
+      {
+         for(std::vector<CThreadLog*>::const_iterator cit = s_Threads.begin() ; s_Threads.end() != cit ; ++cit) {
+            if((*cit)->m_Head.load() != (*cit)->m_Tail.load(std::memory_order_relaxed)) {
+               return true;
+            }
+         }
+         return false;
+      }
+
+      /** The consumer: consume records until stopped and all buffers are empty.
+       **/
+      void Consume(void)
+      {
+         for(;;) {
+            const unsigned long long request(s_FlushRequest.load());
+            const size_t             count  (DrainAll());
+            if(NULL != s_pFile && s_FlushDone.load() != request) {
+               fflush(s_pFile);
+            }
+            s_FlushDone.store(request);
+            if(0 != count) {
+               continue;
+            }
+            std::unique_lock<std::mutex> lock(s_Mutex);
+            s_bSleeping.store(true);
+            if(!PendingLocked() && s_FlushRequest.load() == request) {
+               if(s_bStop.load()) {
+                  s_bSleeping.store(false);
+                  return;
+               }
+               s_Wakeup.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            s_bSleeping.store(false);
+         }
+      }
+
+      /** Exit handler: consume the buffered records.
+       **/
+      void StopOnExit(void)
+      {
+         CBinaryLog::Stop();
+      }
+
+      /** Start the consumer.
+       **
+       ** @return the levels to record (a bit per level).
+       **/
+      unsigned int StartConsumer(
+         FILE* const             pFile,    //< Binary log file, NULL to format on the consumer.
+         const EAsyncLogOverflow overflow, //< What to do with a record when a thread buffer is full.
+         const bool              bDebug    //< Also record LogDebug.
+         )
+      {
+         static bool s_bExitHandler(false);
+         s_Overflow = overflow;
+         s_pFile    = pFile;
+         s_ConsumerFormats.clear();
+         s_FileFormats.clear();
+         s_bStop.store(false);
+         {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_bConsumer = true;
+         }
+         s_Thread = std::thread(Consume);
+         unsigned int mask((1u << ELogLevelInfo) | (1u << ELogLevelNotice) | (1u << ELogLevelWarning) | (1u << ELogLevelErr));
+         if(bDebug) {
+            mask |= 1u << ELogLevelDebug;
+         }
+         if(!s_bExitHandler) {
+            s_bExitHandler = true;
+            atexit(StopOnExit);
+         }
+         return mask;
+      }
+
+      /** Format a message immediately.
+       **
+       ** @return the formatted message.
+       **/
+      std::string FormatNow(
+         const char* const szFormat, //< The format string.
+         va_list           ap        //< The arguments (not consumed).
+         )
+      {
+         va_list copy;
+         va_copy(copy, ap);
+         const int length(vsnprintf(NULL, 0, szFormat, copy));
+         va_end(copy);
+         if(0 >= length) {
+            return std::string();
+         }
+         std::vector<char> msg(static_cast<size_t>(length) + 1);
+         va_copy(copy, ap);
+         vsnprintf(&msg[0], msg.size(), szFormat, copy);
+         va_end(copy);
+         return std::string(&msg[0], static_cast<size_t>(length));
+      }
+
+      /** Fill in a record header.
+       **/
+      void PutHeader(
+         uint8_t* const p,      //< Where to write the header.
+         const size_t   size,   //< Size of the record.
+         const uint32_t format, //< Format ID.
+         const uint8_t  kind    //< ELogLevel or EKind.
+         )
+      {
+         CRecordHeader header;
+         memset(&header, 0, sizeof(header));
+         header.m_Size   = static_cast<uint32_t>(size);
+         header.m_Format = format;
+         header.m_Kind   = kind;
+         memcpy(p, &header, sizeof(header));
+      }
+
+      /** Record the arguments of a deferrable format.
+       **
+       ** @return false when the record does not fit in the thread buffer.
+       **/
+      bool RecordFormat(
+         CThreadLog&     thread, //< The buffer of the calling thread.
+         const ELogLevel level,  //< The logging level.
+         const CFormat&  format, //< The format.
+         va_list         ap      //< The arguments (not consumed).
+         )
+      {
+         va_list copy;
+         va_copy(copy, ap);
+         const size_t size(Align(sizeof(CRecordHeader) + format.Encode(copy, NULL), 16));
+         va_end(copy);
+         if(size > thread.GetCapacity() / 2) {
+            return false;
+         }
+         uint8_t* const p(thread.Reserve(size));
+         if(NULL == p) {
+            s_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+         }
+         PutHeader(p, size, format.m_Id, static_cast<uint8_t>(level));
+         va_copy(copy, ap);
+         format.Encode(copy, p + sizeof(CRecordHeader));
+         va_end(copy);
+         thread.Commit(size);
+         return true;
+      }
+
+      /** Record a formatted message (as the argument of format "%s").
+       **
+       ** @return false when the record does not fit in the thread buffer.
+       **/
+      bool RecordString(
+         CThreadLog&        thread, //< The buffer of the calling thread.
+         const ELogLevel    level,  //< The logging level.
+         const std::string& strMsg  //< The formatted message.
+         )
+      {
+         static const CFormat* const s_pString(RegisterFormat("%s"));
+         const uint32_t length(static_cast<uint32_t>(strMsg.size()));
+         const size_t   size  (Align(sizeof(CRecordHeader) + sizeof(length) + strMsg.size(), 16));
+         if(size > thread.GetCapacity() / 2) {
+            return false;
+         }
+         uint8_t* const p(thread.Reserve(size));
+         if(NULL == p) {
+            s_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+         }
+         PutHeader(p, size, s_pString->m_Id, static_cast<uint8_t>(level));
+         memcpy(p + sizeof(CRecordHeader), &length, sizeof(length));
+         memcpy(p + sizeof(CRecordHeader) + sizeof(length), strMsg.data(), strMsg.size());
+         thread.Commit(size);
+         return true;
+      }
+
+      /** Names of the levels in a decoded log.
+       **/
+      const char* const s_LevelNames[ELogLevelCount] = {"debug", "info", "notice", "warning", "err"};
+   };
+
+   const char CBinaryLog::MAGIC[9] = "ILUSMLG1";
+
+   std::atomic<unsigned int> CBinaryLog::s_Levels(0);
+
+   /** Start recording: the background thread formats the records and
+    ** passes the messages to the registered logging functions.
+    **
+    ** When already started, it is stopped first.
+    **/
+   void CBinaryLog::Start(
+      const EAsyncLogOverflow overflow, //< What to do with a record when a thread buffer is full.
+      const bool              bDebug    //< Also record LogDebug.
+      )
+   {
+      Stop();
+      s_Levels.store(StartConsumer(NULL, overflow, bDebug));
+      LogConsumersUpdate();
+   }
+
+   /** Start recording: the background thread writes the records to a
+    ** binary log file (formatted offline with Decode).
+    **
+    ** When already started, it is stopped first.
+    **
+    ** @return false when the file cannot be created.
+    **/
+   bool CBinaryLog::Start(
+      const char* const       szFile,   //< The binary log file.
+      const EAsyncLogOverflow overflow, //< What to do with a record when a thread buffer is full.
+      const bool              bDebug    //< Also record LogDebug.
+      )
+   {
+      Stop();
+      FILE* const pFile(fopen(szFile, "wb"));
+      if(NULL == pFile) {
+         return false;
+      }
+      if(1 != fwrite(MAGIC, 8, 1, pFile)) {
+         fclose(pFile);
+         return false;
+      }
+      s_Levels.store(StartConsumer(pFile, overflow, bDebug));
+      LogConsumersUpdate();
+      return true;
+   }
+
+   /** Stop recording after the background thread has consumed all records.
+    ** From now on the messages are formatted immediately again.
+    **/
+   void CBinaryLog::Stop(void)
+   {
+      if(!s_Thread.joinable()) {
+         return;
+      }
+      s_Levels.store(0);
+      LogConsumersUpdate();
+      while(0 != s_Users.load()) {
+         std::this_thread::yield();
+      }
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         s_bStop.store(true);
+         s_Wakeup.notify_one();
+      }
+      s_Thread.join();
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_bConsumer = false;
+      DeleteFinishedLocked();
+      if(NULL != s_pFile) {
+         fclose(s_pFile);
+         s_pFile = NULL;
+      }
+   }
+
+   /** Wait until the records of the calling thread (and the ones of the
+    ** other threads recorded so far) are consumed.
+    **/
+   void CBinaryLog::Flush(void)
+   {
+      if(!IsRunning()) {
+         return;
+      }
+      const unsigned long long request(s_FlushRequest.fetch_add(1) + 1);
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         s_Wakeup.notify_one();
+      }
+      while(s_FlushDone.load() < request) {
+         std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+   }
+
+   /** Set the size of the thread buffers created from now on (rounded up
+    ** to a power of 2, at least 4096).
+    **/
+   void CBinaryLog::SetCapacity(
+      const uint32_t bytes //< Buffer size per thread.
+      )
+   {
+      s_Capacity.store(bytes);
+   }
+
+   /** Record a message (LogDebug..LogErr).
+    **
+    ** A format that cannot be deferred is formatted immediately and its
+    ** message is recorded as a string, so the order is kept.
+    **
+    ** @return false when the message has to be formatted by the caller:
+    ** the level is not recorded or the record does not fit in the thread
+    ** buffer.
+    **/
+   bool CBinaryLog::Record(
+      const ELogLevel   level,    //< The logging level.
+      const char* const szFormat, //< The format string.
+      va_list           ap        //< The arguments (not consumed).
+      )
+   {
+      s_Users.fetch_add(1);
+      bool bRecorded(false);
+      if(IsEnabled(level)) {
+         CThreadLog&          thread (tl_Log.Get());
+         const CFormat* const pFormat(thread.Lookup(szFormat));
+         if(pFormat->m_bDeferrable) {
+            bRecorded = RecordFormat(thread, level, *pFormat, ap);
+         } else {
+            bRecorded = RecordString(thread, level, FormatNow(szFormat, ap));
+         }
+      }
+      s_Users.fetch_sub(1);
+      return bRecorded;
+   }
+
+   /** Record an indentation change (LogIndent, LogUnindent), so it is
+    ** applied in order with the recorded messages.
+    **
+    ** @return false when not recording.
+    **/
+   bool CBinaryLog::RecordIndent(
+      const bool bIncrement //< Increase or decrease the indentation.
+      )
+   {
+      s_Users.fetch_add(1);
+      bool bRecorded(false);
+      if(IsRunning()) {
+         bRecorded = true;
+         CThreadLog&    thread(tl_Log.Get());
+         uint8_t* const p     (thread.Reserve(sizeof(CRecordHeader)));
+         if(NULL == p) {
+            s_Dropped.fetch_add(1, std::memory_order_relaxed);
+         } else {
+            PutHeader(p, sizeof(CRecordHeader), 0, bIncrement ? EKindIndent : EKindUnindent);
+            thread.Commit(sizeof(CRecordHeader));
+         }
+      }
+      s_Users.fetch_sub(1);
+      return bRecorded;
+   }
+
+   /** Get the number of records dropped because a thread buffer was full.
+    **
+    ** @return the number of dropped records since the program started.
+    **/
+   unsigned long long CBinaryLog::GetDropped(void)
+   {
+      return s_Dropped.load(std::memory_order_relaxed);
+   }
+
+   /** Format a binary log file: 1 line per message, prefixed with its level.
+    **
+    ** @return false when the input is not a valid binary log (strError
+    ** tells why), the messages decoded so far have been written.
+    **/
+   bool CBinaryLog::Decode(
+      std::istream& in,      //< The binary log.
+      std::ostream& out,     //< The formatted messages.
+      std::string&  strError //< Why decoding failed.
+      )
+   {
+      char magic[8];
+      if(!in.read(magic, sizeof(magic)) || 0 != memcmp(magic, MAGIC, sizeof(magic))) {
+         strError = "not a binary log";
+         return false;
+      }
+      std::map<uint32_t, CFormat> formats;
+      std::string                 strIndent;
+      std::vector<uint8_t>        data;
+      for(;;) {
+         CRecordHeader header;
+         in.read(reinterpret_cast<char*>(&header), sizeof(header));
+         if(0 == in.gcount() && in.eof()) {
+            return true;
+         }
+         if(sizeof(header) != static_cast<size_t>(in.gcount()) || sizeof(header) > header.m_Size || 0 != header.m_Size % 16) {
+            strError = "corrupt record";
+            return false;
+         }
+         data.resize(header.m_Size - sizeof(header) + 1);
+         if(!in.read(reinterpret_cast<char*>(&data[0]), static_cast<std::streamsize>(data.size() - 1))) {
+            strError = "truncated record";
+            return false;
+         }
+         switch(header.m_Kind) {
+            case EKindFormat: {
+               const char* const sz(reinterpret_cast<const char*>(&data[0]));
+               formats.insert(std::make_pair(header.m_Format, CFormat(header.m_Format, std::string(sz, strnlen(sz, data.size() - 1)))));
+               break;
+            }
+            case EKindIndent:
+               strIndent += "   ";
+               break;
+            case EKindUnindent:
+               if(3 <= strIndent.size()) {
+                  strIndent.resize(strIndent.size() - 3);
+               }
+               break;
+            default: {
+               if(ELogLevelCount <= header.m_Kind) {
+                  strError = "unknown record kind";
+                  return false;
+               }
+               std::map<uint32_t, CFormat>::const_iterator cit(formats.find(header.m_Format));
+               if(formats.end() == cit || !cit->second.m_bDeferrable) {
+                  strError = "unknown format";
+                  return false;
+               }
+               if(cit->second.GetSize(&data[0], data.size() - 1) > data.size() - 1) {
+                  strError = "corrupt arguments";
+                  return false;
+               }
+               std::string strMsg;
+               cit->second.Format(&data[0], strMsg);
+               out << s_LevelNames[header.m_Kind] << ' ' << strIndent << strMsg;
+               break;
+            }
+         }
+      }
+   }
+};
@@ -0,0 +1,441 @@
+/** @file
+ ** @brief The CBroadcast definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "Include/CBroadcast.h"
+
+namespace ILULibStateMachine {
+   /** Constructor: no state machines subscribed.
+    **/
+   CBroadcast::CBroadcast(void)
+      : m_Subscribers()
+      , m_Events()
+      , m_EventTypes()
+      , m_Ranges()
+   {
+   }
+
+   /** Destructor: unsubscribes all state machines.
+    **/
+   CBroadcast::~CBroadcast(void)
+   {
+      for(Subscribers::iterator it = m_Subscribers.begin() ; m_Subscribers.end() != it ; ++it) {
+         it->second.m_pStateMachine->m_pBroadcast = NULL;
+      }
+   }
+
+   /** Subscribe a state machine: it gets the broadcast events its current
+    ** states have a handler for.
+    **
+    ** A state machine subscribed to another broadcast is unsubscribed
+    ** from that one first.
+    **/
+   void CBroadcast::Subscribe(
+      SPStateMachine spStateMachine //< The state machine.
+      )
+   {
+      if(!spStateMachine || this == spStateMachine->m_pBroadcast) {
+         return;
+      }
+      if(NULL != spStateMachine->m_pBroadcast) {
+         spStateMachine->m_pBroadcast->Unsubscribe(*spStateMachine);
+      }
+      CSubscriber& subscriber(m_Subscribers[spStateMachine->GetId()]);
+      subscriber.m_pStateMachine  = spStateMachine.get();
+      subscriber.m_wpStateMachine = spStateMachine;
+      spStateMachine->m_pBroadcast = this;
+      spStateMachine->EventKeysDefault(subscriber.m_Default.m_Events, subscriber.m_Default.m_EventTypes);
+      LevelAdd(spStateMachine->GetId(), subscriber, subscriber.m_Default);
+      for(size_t region = 0 ; region < spStateMachine->GetRegionCount() ; ++region) {
+         Update(*spStateMachine, region, 0);
+      }
+   }
+
+   /** Unsubscribe a state machine, ignored when it is not subscribed to
+    ** this broadcast.
+    **/
+   void CBroadcast::Unsubscribe(
+      CStateMachine& stateMachine //< The state machine.
+      )
+   {
+      if(this != stateMachine.m_pBroadcast) {
+         return;
+      }
+      Remove(stateMachine);
+   }
+
+   /** Get the number of subscribed state machines.
+    **
+    ** @return the number of subscribed state machines.
+    **/
+   size_t CBroadcast::GetSubscriberCount(void) const
+   {
+      return m_Subscribers.size();
+   }
+
+   /** Get the number of subscribed state machines a broadcast event would
+    ** be fed into.
+    **
+    ** @return the number of interested state machines.
+    **/
+   size_t CBroadcast::GetInterestedCount(
+      const SPEventBase& spEventBase //< Class instance describing the event in all detail.
+      ) const
+   {
+      std::vector<SPStateMachine> stateMachines;
+      Collect(spEventBase, stateMachines);
+      return stateMachines.size();
+   }
+
+   /** Collect the subscribed state machines with a handler for an event
+    ** ID, for a prefix of it (see TEvtSubAny), for a range containing it
+    ** (see TEvtIdRange) or for its event-type, in the order they were
+    ** constructed.
+    **/
+   void CBroadcast::Collect(
+      const SPEventBase&           spEventBase,  //< Class instance describing the event in all detail.
+      std::vector<SPStateMachine>& stateMachines //< The interested state machines are appended.
+      ) const
+   {
+      std::set<uint64_t> ids;
+      CollectIds(m_Events, spEventBase, ids);
+      CPrefixCollect prefixCollect;
+      prefixCollect.m_pEvents = &m_Events;
+      prefixCollect.m_pIds    = &ids;
+      spEventBase->ForEachPrefix(&CBroadcast::PrefixCollect, &prefixCollect);
+      CRange range;
+      if(!m_Ranges.empty() && spEventBase->RangeValue(range.m_pTag, range.m_First)) {
+         //the ranges of the type starting at or before the value, back to the first one no range before it reaches
+         const long value(range.m_First);
+         range.m_Last = std::numeric_limits<long>::max();
+         Ranges::const_iterator citRange(std::upper_bound(m_Ranges.begin(), m_Ranges.end(), range, &CBroadcast::RangeLess));
+         while(m_Ranges.begin() != citRange) {
+            --citRange;
+            if(range.m_pTag != citRange->m_pTag || citRange->m_MaxLast < value) {
+               break;
+            }
+            if(value <= citRange->m_Last) {
+               CollectIds(m_Events, citRange->m_spEvent, ids);
+            }
+         }
+      }
+      const EventTypeIndex::const_iterator citType(m_EventTypes.find(spEventBase->GetIdType()));
+      if(m_EventTypes.end() != citType) {
+         ids.insert(citType->second.begin(), citType->second.end());
+      }
+      for(std::set<uint64_t>::const_iterator citId = ids.begin() ; ids.end() != citId ; ++citId) {
+         const Subscribers::const_iterator citSubscriber(m_Subscribers.find(*citId));
+         if(m_Subscribers.end() == citSubscriber) {
+            continue;
+         }
+         const SPStateMachine spStateMachine(citSubscriber->second.m_wpStateMachine.lock());
+         if(spStateMachine) {
+            //not being destructed
+            stateMachines.push_back(spStateMachine);
+         }
+      }
+   }
+
+   /** Collect the ID's of the state machines indexed with an event ID.
+    **/
+   void CBroadcast::CollectIds(
+      const EventIndex&   events,      //< The index on event ID.
+      const SPEventBase&  spEventBase, //< The event ID.
+      std::set<uint64_t>& ids          //< The ID's are added.
+      )
+   {
+      const EventIndex::const_iterator cit(events.find(spEventBase));
+      if(events.end() == cit) {
+         return;
+      }
+      for(Interested::const_iterator citId = cit->second.begin() ; cit->second.end() != citId ; ++citId) {
+         ids.insert(citId->first);
+      }
+   }
+
+   /** Collect the ID's of the state machines indexed with 1 prefix of an
+    ** event ID (see CEventBase::ForEachPrefix). The prefix lives on the
+    ** stack of the caller: it is wrapped in a shared pointer that does not
+    ** own it.
+    **
+    ** @return false: all prefixes are collected.
+    **/
+   bool CBroadcast::PrefixCollect(
+      void*       pContext, //< The CPrefixCollect context.
+      CEventBase& prefix    //< The prefix.
+      )
+   {
+      CPrefixCollect* const pPrefixCollect(static_cast<CPrefixCollect*>(pContext));
+      CollectIds(*pPrefixCollect->m_pEvents, SPEventBase(SPEventBase(), &prefix), *pPrefixCollect->m_pIds);
+      return false;
+   }
+
+   /** Update the index of a state machine that changed state: only the
+    ** state of the region and the parents after the ones kept are read
+    ** again.
+    **/
+   void CBroadcast::Update(
+      CStateMachine& stateMachine, //< The state machine.
+      const size_t   region,       //< The region that changed state, 0 for the state machine's own state.
+      const size_t   parentsKept   //< The number of (outermost) parents of the region that did not change.
+      )
+   {
+      const uint64_t              id(stateMachine.GetId());
+      const Subscribers::iterator it(m_Subscribers.find(id));
+      if(m_Subscribers.end() == it) {
+         return;
+      }
+      CSubscriber& subscriber(it->second);
+      if(subscriber.m_Regions.size() <= region) {
+         subscriber.m_Regions.resize(region + 1);
+      }
+      Levels& levels(subscriber.m_Regions[region]);
+
+      //the new levels are added before the old ones are removed: what they have in common does not touch the index
+      const size_t keep  (std::min(levels.size(), 1 + parentsKept));
+      Levels       entered(stateMachine.EventKeyLevels(region));
+      for(size_t level = 0 ; level < entered.size() ; ++level) {
+         if(0 == level || keep <= level) {
+            stateMachine.EventKeys(region, level, entered[level].m_Events, entered[level].m_EventTypes);
+            LevelAdd(id, subscriber, entered[level]);
+         }
+      }
+      for(size_t level = 0 ; level < levels.size() ; ++level) {
+         if(0 == level || keep <= level) {
+            LevelRemove(id, subscriber, levels[level]);
+         } else {
+            entered[level].m_Events.swap(levels[level].m_Events);
+            entered[level].m_EventTypes.swap(levels[level].m_EventTypes);
+         }
+      }
+      levels.swap(entered);
+   }
+
+   /** Index the event ID's and event-types of 1 level of a subscribed
+    ** state machine: the ones no other level has are added to the index.
+    **/
+   void CBroadcast::LevelAdd(
+      const uint64_t    id,         //< The state machine ID.
+      CSubscriber&      subscriber, //< The state machine.
+      const CLevelKeys& keys        //< The keys of the level.
+      )
+   {
+      for(std::vector<SPEventBase>::const_iterator cit = keys.m_Events.begin() ; keys.m_Events.end() != cit ; ++cit) {
+         const EventCounts::iterator itCount(subscriber.m_Events.find(*cit));
+         if(subscriber.m_Events.end() != itCount) {
+            ++itCount->second;
+            continue;
+         }
+         subscriber.m_Events[*cit] = 1;
+         EventAdd(id, *cit);
+      }
+      for(std::vector<std::string>::const_iterator cit = keys.m_EventTypes.begin() ; keys.m_EventTypes.end() != cit ; ++cit) {
+         if(0 == subscriber.m_EventTypes[*cit]++) {
+            m_EventTypes[*cit].insert(id);
+         }
+      }
+   }
+
+   /** Stop indexing the event ID's and event-types of 1 level of a
+    ** subscribed state machine: the ones no other level has are removed
+    ** from the index.
+    **/
+   void CBroadcast::LevelRemove(
+      const uint64_t    id,         //< The state machine ID.
+      CSubscriber&      subscriber, //< The state machine.
+      const CLevelKeys& keys        //< The keys the level was indexed with.
+      )
+   {
+      for(std::vector<SPEventBase>::const_iterator cit = keys.m_Events.begin() ; keys.m_Events.end() != cit ; ++cit) {
+         const EventCounts::iterator itCount(subscriber.m_Events.find(*cit));
+         if(subscriber.m_Events.end() == itCount || 0 != --itCount->second) {
+            continue;
+         }
+         EventRemove(id, itCount->first);
+         subscriber.m_Events.erase(itCount);
+      }
+      for(std::vector<std::string>::const_iterator cit = keys.m_EventTypes.begin() ; keys.m_EventTypes.end() != cit ; ++cit) {
+         const EventTypeCounts::iterator itCount(subscriber.m_EventTypes.find(*cit));
+         if(subscriber.m_EventTypes.end() == itCount || 0 != --itCount->second) {
+            continue;
+         }
+         subscriber.m_EventTypes.erase(itCount);
+         const EventTypeIndex::iterator itType(m_EventTypes.find(*cit));
+         itType->second.erase(id);
+         if(itType->second.empty()) {
+            m_EventTypes.erase(itType);
+         }
+      }
+   }
+
+   /** Remove a state machine from the index and the subscribers.
+    **/
+   void CBroadcast::Remove(
+      CStateMachine& stateMachine //< The state machine.
+      )
+   {
+      const uint64_t              id(stateMachine.GetId());
+      const Subscribers::iterator it(m_Subscribers.find(id));
+      if(m_Subscribers.end() != it) {
+         const CSubscriber& subscriber(it->second);
+         for(EventCounts::const_iterator cit = subscriber.m_Events.begin() ; subscriber.m_Events.end() != cit ; ++cit) {
+            EventRemove(id, cit->first);
+         }
+         for(EventTypeCounts::const_iterator cit = subscriber.m_EventTypes.begin() ; subscriber.m_EventTypes.end() != cit ; ++cit) {
+            const EventTypeIndex::iterator itType(m_EventTypes.find(cit->first));
+            itType->second.erase(id);
+            if(itType->second.empty()) {
+               m_EventTypes.erase(itType);
+            }
+         }
+         m_Subscribers.erase(it);
+      }
+      stateMachine.m_pBroadcast = NULL;
+   }
+
+   /** Add a state machine to the index of an event ID.
+    **/
+   void CBroadcast::EventAdd(
+      const uint64_t     id,         //< The state machine ID.
+      const SPEventBase& spEventBase //< The event ID instance of the state machine.
+      )
+   {
+      Interested& interested(m_Events[spEventBase]);
+      const bool  bNew(interested.empty());
+      interested[id] = spEventBase;
+      CRange range;
+      if(bNew && RangeGet(spEventBase, range)) {
+         RangeMaxUpdate(m_Ranges.insert(std::upper_bound(m_Ranges.begin(), m_Ranges.end(), range, &CBroadcast::RangeLess), range));
+      }
+   }
+
+   /** Remove a state machine from the index of an event ID.
+    **
+    ** The event ID instance used as key can be allocated from the memory
+    ** resource of the state machine (e.g. its arena): the instance of
+    ** another interested state machine replaces it.
+    **/
+   void CBroadcast::EventRemove(
+      const uint64_t     id,         //< The state machine ID.
+      const SPEventBase& spEventBase //< The event ID.
+      )
+   {
+      const EventIndex::iterator it(m_Events.find(spEventBase));
+      if(m_Events.end() == it) {
+         return;
+      }
+      const Interested::iterator itId(it->second.find(id));
+      if(it->second.end() == itId) {
+         return;
+      }
+      const bool bKey(it->first.get() == itId->second.get());
+      it->second.erase(itId);
+      CRange                 range;
+      const bool             bRange (RangeGet(spEventBase, range));
+      const Ranges::iterator itRange(bRange ? RangeFind(range) : m_Ranges.end());
+      if(it->second.empty()) {
+         m_Events.erase(it);
+         if(m_Ranges.end() != itRange) {
+            RangeMaxUpdate(m_Ranges.erase(itRange));
+         }
+      } else if(bKey) {
+         Interested interested;
+         interested.swap(it->second);
+         m_Events.erase(it);
+         const SPEventBase spKey(interested.begin()->second);
+         m_Events[spKey].swap(interested);
+         if(m_Ranges.end() != itRange) {
+            itRange->m_spEvent = spKey;
+         }
+      }
+   }
+
+   /** Get the range an event ID registers (see TEvtIdRange).
+    **
+    ** @return false when the event ID is not a range.
+    **/
+   bool CBroadcast::RangeGet(
+      const SPEventBase& spEventBase, //< The event ID.
+      CRange&            range        //< The range (output).
+      )
+   {
+      if(!spEventBase->RangeKey(range.m_pTag, range.m_First, range.m_Last)) {
+         return false;
+      }
+      range.m_MaxLast = range.m_Last;
+      range.m_spEvent = spEventBase;
+      return true;
+   }
+
+   /** Sort ranges on event ID type (tag), then on first and last event ID.
+    **
+    ** @return true when a sorts before b.
+    **/
+   bool CBroadcast::RangeLess(
+      const CRange& a, //< First range.
+      const CRange& b  //< Second range.
+      )
+   {
+      if(a.m_pTag != b.m_pTag) {
+         return std::less<const void*>()(a.m_pTag, b.m_pTag);
+      }
+      if(a.m_First != b.m_First) {
+         return a.m_First < b.m_First;
+      }
+      return a.m_Last < b.m_Last;
+   }
+
+   /** Find a range.
+    **
+    ** @return the range or m_Ranges.end() when not found.
+    **/
+   CBroadcast::Ranges::iterator CBroadcast::RangeFind(
+      const CRange& range //< The range to find (tag, first and last event ID).
+      )
+   {
+      const Ranges::iterator it(std::lower_bound(m_Ranges.begin(), m_Ranges.end(), range, &CBroadcast::RangeLess));
+      if(m_Ranges.end() == it || RangeLess(range, *it)) {
+         return m_Ranges.end();
+      }
+      return it;
+   }
+
+   /** Update the largest last event ID of the ranges of 1 type, from a
+    ** range that was inserted or from the range after 1 that was erased.
+    **/
+   void CBroadcast::RangeMaxUpdate(
+      Ranges::iterator it //< The first range to update.
+      )
+   {
+      if(m_Ranges.end() == it) {
+         return;
+      }
+      const void* const pTag(it->m_pTag);
+      long maxLast((m_Ranges.begin() != it && pTag == (it - 1)->m_pTag) ? (it - 1)->m_MaxLast : std::numeric_limits<long>::min());
+      for( ; m_Ranges.end() != it && pTag == it->m_pTag ; ++it) {
+         maxLast       = std::max(maxLast, it->m_Last);
+         it->m_MaxLast = maxLast;
+      }
+   }
+}
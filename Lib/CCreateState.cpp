@@ -19,53 +19,94 @@
  ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  **
  **/
+#include <atomic>
+
 #include "Include/CCreateState.h"
 
 namespace ILULibStateMachine {
-   /** Default constructor: no valid state create function set.
+#if __cplusplus >= 201300
+   static_assert(sizeof(CCreateState) == 3 * sizeof(void*), "CCreateState is a function, a context and a parent pointer");
+#endif
+
+   /** @brief A generic create state function owned by all CCreateState
+    ** instances copied from the one it was constructed for.
     **/
-   CCreateState::CCreateState(void)
-      : m_bValid(false)
-      , m_fCreateState()
+   class CCreateState::CGeneric {
+      public:
+         explicit CGeneric(const FCreateState& fCreateState)
+            : m_Refs(1)
+            , m_fCreateState(fCreateState)
+         {
+         }
+
+      public:
+         std::atomic<unsigned int> m_Refs;         //< Number of CCreateState instances referring to this one.
+         const FCreateState        m_fCreateState; //< The generic create state function.
+   };
+
+   /** Its address marks the context of an instance created by
+    ** WithStateMachineData.
+    **/
+   char CCreateState::s_StateMachineData = 0;
+
+   /** Constructor.
+    **/
+   CStateParent::CStateParent(
+      FCreateStateRaw           fCreateStateRaw, ///< Raw create function of the parent state.
+      const CStateParent* const pParent          ///< Parent of the parent state, NULL for a top-level state.
+      )
+      : m_fCreateStateRaw(fCreateStateRaw)
+      , m_pParent(pParent)
    {
    }
 
-   /** Copy constructor.
+   /** Default constructor: no valid state create function set.
     **/
-   CCreateState::CCreateState(
-      const CCreateState& ref ///< Instance to be copied.
-      )
-      : m_bValid(ref.m_bValid)
-      , m_fCreateState(ref.m_fCreateState)
+   CCreateState::CCreateState(void)
+      : m_fCreateStateRaw(NULL)
+      , m_pContext(NULL)
+      , m_pParent(NULL)
    {
    }
 
-   /** Constructor setting a state create function.
+   /** Constructor setting a generic state create function.
+    **
+    ** The function is copied once to the heap; all copies of this
+    ** instance share (and own) it.
     **/
    CCreateState::CCreateState(
       FCreateState fCreateState ///< Create state function to be embedded.
       )
-      : m_bValid(true)
-      , m_fCreateState(fCreateState)
+      : m_fCreateStateRaw(CreateGeneric)
+      , m_pContext(new CGeneric(fCreateState))
+      , m_pParent(NULL)
    {
    }
 
-   /** Destructor.
+   /** Constructor setting a raw state create function and its context.
     **/
-   CCreateState::~CCreateState(void)
+   CCreateState::CCreateState(
+      FCreateStateRaw           fCreateStateRaw, ///< Create state function to be embedded, NULL results in an invalid instance.
+      void* const               pContext,        ///< Context provided to the create state function when it is called.
+      const CStateParent* const pParent          ///< Parent of the state created, NULL for a top-level state.
+      )
+      : m_fCreateStateRaw(fCreateStateRaw)
+      , m_pContext(pContext)
+      , m_pParent(pParent)
    {
    }
 
-   /** Copy operator.
+   /** Construct an instance calling the raw state create function with
+    ** the data of the state machine creating the state as its context.
+    **
+    ** @return the constructed instance.
     **/
-   CCreateState& CCreateState::operator=(
-      const CCreateState& ref ///< Instance to be copied.
+   CCreateState CCreateState::WithStateMachineData(
+      FCreateStateRaw           fCreateStateRaw, ///< Create state function to be embedded, it gets a CStateMachineData pointer as its context.
+      const CStateParent* const pParent          ///< Parent of the state created, NULL for a top-level state.
       )
    {
-      if(this == &ref) return *this;
-      m_bValid       = ref.m_bValid;
-      m_fCreateState = ref.m_fCreateState;
-      return *this;
+      return CCreateState(fCreateStateRaw, &s_StateMachineData, pParent);
    }
 
    /** Check whether the embedded create state function is valid.
@@ -74,16 +115,123 @@ namespace ILULibStateMachine {
     **/
    bool CCreateState::IsValid(void) const
    {
-      return m_bValid;
+      return NULL != m_fCreateStateRaw;
    }
 
-   /** Get a reference to the embedded create state function.
+   /** Call the embedded create state function.
     **
-    ** @return a reference to the embedded create state function.
+    ** Pre-condition: IsValid() returns true.
+    **
+    ** @return the newly created state, NULL for the finished state.
     **/
-   const FCreateState& CCreateState::Get(void) const
+   CState* CCreateState::Create(
+      TYPESEL::weak_ptr<CStateMachine> wpStateMachine,   ///< The state machine the new state will belong to.
+      CStateMachineData* const         pStateMachineData ///< The data of that state machine, used as context when requested by WithStateMachineData.
+      ) const
    {
-      return m_fCreateState;
+      return m_fCreateStateRaw(wpStateMachine, (&s_StateMachineData == m_pContext) ? static_cast<void*>(pStateMachineData) : m_pContext);
+   }
+
+   /** Get the embedded create state function as a generic function.
+    **
+    ** Only meant for backwards compatibility: the state machine itself
+    ** uses Create. Not available for instances created by
+    ** WithStateMachineData (returns an empty function): the context is
+    ** only known by the state machine.
+    **
+    ** @return the embedded create state function (empty when not valid).
+    **/
+   FCreateState CCreateState::Get(void) const
+   {
+      if(CreateGeneric == m_fCreateStateRaw) {
+         return static_cast<const CGeneric*>(m_pContext)->m_fCreateState;
+      }
+      if(!IsValid() || &s_StateMachineData == m_pContext) {
+         return FCreateState();
+      }
+      return TYPESEL::bind(m_fCreateStateRaw, TYPESEL_PLACEHOLDERS_1, m_pContext);
+   }
+
+   /** Trampoline calling a generic create state function stored in the context.
+    **
+    ** @return the newly created state, NULL for the finished state.
+    **/
+   CState* CCreateState::CreateGeneric(
+      TYPESEL::weak_ptr<CStateMachine> wpStateMachine, ///< The state machine the new state will belong to.
+      void*                            pContext        ///< Pointer to the CGeneric with the FCreateState to be called.
+      )
+   {
+      return static_cast<const CGeneric*>(pContext)->m_fCreateState(wpStateMachine);
+   }
+
+   /** Add a reference to a generic create state function (an instance
+    ** is copied).
+    **/
+   void CCreateState::GenericAddRef(
+      void* const pContext ///< Pointer to the CGeneric.
+      )
+   {
+      static_cast<CGeneric*>(pContext)->m_Refs.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   /** Remove a reference to a generic create state function, deleting it
+    ** when this was the last one.
+    **/
+   void CCreateState::GenericRelease(
+      void* const pContext ///< Pointer to the CGeneric.
+      )
+   {
+      CGeneric* const pGeneric(static_cast<CGeneric*>(pContext));
+      if(1 == pGeneric->m_Refs.fetch_sub(1, std::memory_order_acq_rel)) {
+         delete pGeneric;
+      }
+   }
+
+   /** Get the key identifying the state class created, used to find the
+    ** shared handler table of that state (see CHandlerTable).
+    **
+    ** @return the raw create function; NULL when it does not identify the state class (invalid or generic).
+    **/
+   FCreateStateRaw CCreateState::GetSharedKey(void) const
+   {
+      if(CreateGeneric == m_fCreateStateRaw) {
+         return NULL;
+      }
+      return m_fCreateStateRaw;
    }
-}
 
+   /** Check whether this instance can be stored in a handler table shared
+    ** by several state machines: it should not refer to data of one
+    ** specific state machine.
+    **
+    ** @return true when it can be shared.
+    **/
+   bool CCreateState::IsShareable(void) const
+   {
+      if(!IsValid() || &s_StateMachineData == m_pContext) {
+         return true;
+      }
+      return (CreateGeneric != m_fCreateStateRaw) && (NULL == m_pContext);
+   }
+
+   /** Get the parent of the state created.
+    **
+    ** @return the parent, NULL for a top-level state.
+    **/
+   const CStateParent* CCreateState::GetParent(void) const
+   {
+      return m_pParent;
+   }
+
+   /** Get the create function of a parent (or grand-parent ...) of the
+    ** state created: the same context as this instance.
+    **
+    ** @return the create function of the parent.
+    **/
+   CCreateState CCreateState::CreateParent(
+      const CStateParent& parent ///< The parent, from the chain starting at GetParent.
+      ) const
+   {
+      return CCreateState(parent.m_fCreateStateRaw, m_pContext, parent.m_pParent);
+   }
+}
@@ -19,19 +19,20 @@
  ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  **
  **/
+#include <cstdlib>
+#ifdef ABI_DEMANGLE
+#include <cxxabi.h>
+#endif
+
 #include "Include/CEventBase.h"
 
 namespace ILULibStateMachine {
    /** Protected constructor.
     **/
    CEventBase::CEventBase(
-      const std::string& strId,      //< Textual description of the event, used in logging only.
-      const std::string& strIdType,  //< Textual description of the ID class belonging to this event.
-      const std::string& strDataType //< Textual description of the data class belonging to this event.
+      const std::type_info& typeinfo //< Typeinfo describing the data type belonging to this event, logging only.
       )
-      : m_strId(strId)
-      , m_strIdType(strIdType)
-      , m_strDataType(strDataType)
+      : m_pDataType(&typeinfo)
    {
    }
 
@@ -59,31 +60,93 @@ namespace ILULibStateMachine {
       return CompareTypeIdIdentical(ref);
    }
 
-   /** Get the textual description of the event.
+   /** Get the slot of the event in a flat array of handlers, see
+    ** TEvtIdDense.
+    **
+    ** @return false: not a dense event ID.
+    **/
+   bool CEventBase::DenseSlot(
+      const void*& /* pTag */, //< Out: identifies the array, the same for all events of the type.
+      size_t&      /* slot */, //< Out: the index in the array.
+      size_t&      /* slots */ //< Out: the size of the array.
+      ) const
+   {
+      return false;
+   }
+
+   /** Indicates whether this is a wildcard registration, see TEvtSubAny.
     **
-    ** @return the textual description of the event.
+    ** @return false: not a wildcard.
     **/
-   const std::string& CEventBase::GetId(void) const
+   bool CEventBase::IsPrefix(void) const
    {
-      return m_strId;
+      return false;
    }
 
-   /** Get the textual description of the event ID.
+   /** Call a function for the wildcard registrations that can match this
+    ** event, most specific first, see TEvtSubAny.
     **
-    ** @return the textual description of the event ID.
+    ** @return false: no wildcards.
     **/
-   const std::string& CEventBase::GetIdType(void) const
+   bool CEventBase::ForEachPrefix(
+      FPrefix /* fPrefix */, //< The function to call, it returns true to stop.
+      void*   /* pContext */ //< Passed to fPrefix.
+      ) const
+   {
+      return false;
+   }
+
+   /** Get the range of a range registration, see TEvtIdRange.
+    **
+    ** @return false: not a range registration.
+    **/
+   bool CEventBase::RangeKey(
+      const void*& /* pTag */,  //< Out: identifies the ranges of the event ID type.
+      long&        /* first */, //< Out: the first event ID of the range.
+      long&        /* last */   //< Out: the last event ID of the range.
+      ) const
    {
-      return m_strIdType;
+      return false;
+   }
+
+   /** Get the value to look up in the range registrations, see
+    ** TEvtIdRange.
+    **
+    ** @return false: no value.
+    **/
+   bool CEventBase::RangeValue(
+      const void*& /* pTag */,  //< Out: identifies the ranges of the event ID type.
+      long&        /* value */  //< Out: the event ID.
+      ) const
+   {
+      return false;
    }
 
    /** Get the textual description of the data class belonging to this event.
     **
     ** @return the textual description of the data class belonging to this event.
     **/
-   const std::string& CEventBase::GetDataType(void) const
+   std::string CEventBase::GetDataType(void) const
    {
-      return m_strDataType;
+      return Demangle(*m_pDataType);
    }
-};
 
+   /** Demangle the typename when the compiler supports it.
+    **
+    ** @return the (demangled) type name.
+    **/
+   std::string CEventBase::Demangle(
+      const std::type_info& typeinfo //< The type to describe.
+      )
+   {
+#ifdef ABI_DEMANGLE
+      int status = 0;
+      char* const szDemangled = abi::__cxa_demangle(typeinfo.name(), 0, 0, &status);
+      const std::string strDemangled(NULL != szDemangled ? szDemangled : typeinfo.name());
+      free(szDemangled);
+      return strDemangled;
+#else
+      return typeinfo.name();
+#endif      
+   }
+};
@@ -0,0 +1,391 @@
+/** @file
+ ** @brief The CHandlerTable definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "algorithm"
+#include "functional"
+#include "mutex"
+#include "stdexcept"
+
+#include "Include/CHandlerTable.h"
+#include "Include/Logging.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** @brief Registry entry for one shared handler table.
+       **/
+      class CSharedEntry {
+         public:
+            CSharedEntry(void)
+               : m_Table()
+               , m_bSealed(false)
+               , m_bBuilding(false)
+            {
+            }
+
+         public:
+            CHandlerTable m_Table;     //< The shared table.
+            bool          m_bSealed;   //< The table is complete: it will not change anymore.
+            bool          m_bBuilding; //< A state machine is filling the table right now.
+      };
+
+      /** Map from raw create-state function to shared table entry.
+       **/
+      typedef std::map<FCreateStateRaw, CSharedEntry*> SharedMap;
+
+      /** Get the mutex protecting the shared table registry.
+       **/
+      std::mutex& SharedMutex(void)
+      {
+         static std::mutex s_Mutex;
+         return s_Mutex;
+      }
+
+      /** Get the shared table registry.
+       **
+       ** Allocated once and never deleted: state machines can outlive
+       ** function-local statics.
+       **/
+      SharedMap& SharedGetMap(void)
+      {
+         static SharedMap* s_pMap(new SharedMap());
+         return *s_pMap;
+      }
+   }
+
+   /** Constructor.
+    **/
+   CHandlerTable::CHandlerTable(
+      CMemoryResource* const pResource //< Resource the table contents are allocated from, NULL for the heap.
+      )
+      : m_pResource   (pResource                                                        )
+      , m_EventMap    (CSPEventBaseSort(), EventMap::allocator_type(pResource)          )
+      , m_EventTypeMap(std::less<std::string>(), EventTypeMap::allocator_type(pResource))
+      , m_DenseTables (DenseTables::allocator_type(pResource)                           )
+      , m_Prefixes    (0                                                                )
+      , m_Ranges      (Ranges::allocator_type(pResource)                                )
+   {
+   }
+
+   /** Constructor: an array without handlers.
+    **/
+   CHandlerTable::CDenseTable::CDenseTable(
+      const void* const      pTag,     //< Identifies the event ID type, see CEventBase::DenseSlot.
+      const size_t           slots,    //< The number of event ID's in the range of the type.
+      CMemoryResource* const pResource //< Resource the array is allocated from, NULL for the heap.
+      )
+      : m_pTag (pTag                                        )
+      , m_Slots(slots, NULL, Slots::allocator_type(pResource))
+   {
+   }
+
+   /** Destructor.
+    **/
+   CHandlerTable::~CHandlerTable(void)
+   {
+   }
+
+   /** Get the shared table for the state created by fCreateStateRaw.
+    **
+    ** Three outcomes:
+    ** - the table is sealed: it is returned and bBuild is false, the state
+    **   can skip its shared registrations;
+    ** - the table is not built yet: it is returned and bBuild is true, the
+    **   caller fills it and has to call SharedRelease afterwards;
+    ** - another state machine is building the table right now: NULL is
+    **   returned, the caller registers in its own table instead.
+    **
+    ** @return the shared table or NULL.
+    **/
+   CHandlerTable* CHandlerTable::SharedAcquire(
+      FCreateStateRaw fCreateStateRaw, //< Raw function creating the state, identifies the state class.
+      bool&           bBuild           //< Out: true when the caller has to fill the table.
+      )
+   {
+      bBuild = false;
+      std::lock_guard<std::mutex> lock(SharedMutex());
+      SharedMap& map(SharedGetMap());
+      SharedMap::iterator it(map.find(fCreateStateRaw));
+      if(map.end() == it) {
+         it = map.insert(std::make_pair(fCreateStateRaw, new CSharedEntry())).first;
+      }
+      CSharedEntry* const pEntry(it->second);
+      if(pEntry->m_bSealed) {
+         return &pEntry->m_Table;
+      }
+      if(pEntry->m_bBuilding) {
+         return NULL;
+      }
+      pEntry->m_bBuilding = true;
+      bBuild              = true;
+      return &pEntry->m_Table;
+   }
+
+   /** Finish building the shared table acquired by SharedAcquire.
+    **
+    ** When the state could not be constructed the registrations are
+    ** discarded and the next state machine constructing the state gets the
+    ** chance to build the table.
+    **/
+   void CHandlerTable::SharedRelease(
+      FCreateStateRaw fCreateStateRaw, //< Raw function creating the state, identifies the state class.
+      const bool      bSeal            //< When true: the state was constructed, seal the table; when false: discard the table.
+      )
+   {
+      std::lock_guard<std::mutex> lock(SharedMutex());
+      SharedMap& map(SharedGetMap());
+      const SharedMap::iterator it(map.find(fCreateStateRaw));
+      if(map.end() == it) {
+         return;
+      }
+      CSharedEntry* const pEntry(it->second);
+      pEntry->m_bBuilding = false;
+      pEntry->m_bSealed   = bSeal;
+      if(!bSeal) {
+         pEntry->m_Table.Clear();
+      }
+   }
+
+   /** Find the handle-event-info registered for an event.
+    **
+    ** @return the handle-event-info or NULL when not found.
+    **/
+   CHandleEventInfoBase* CHandlerTable::EventFind(
+      const SPEventBase& spEventBase //< The complete event identification.
+      ) const
+   {
+      if(!m_DenseTables.empty()) {
+         const void* pTag (NULL);
+         size_t      slot (0);
+         size_t      slots(0);
+         if(spEventBase->DenseSlot(pTag, slot, slots)) {
+            for(DenseTables::const_iterator cit = m_DenseTables.begin() ; m_DenseTables.end() != cit ; ++cit) {
+               if(pTag == cit->m_pTag && NULL != cit->m_Slots[slot]) {
+                  return cit->m_Slots[slot];
+               }
+            }
+            //no handler for this dense event ID
+            return RangeFind(spEventBase);
+         }
+      }
+      const EventMapCIt cit(m_EventMap.find(spEventBase));
+      if(m_EventMap.end() != cit) {
+         return cit->second.get();
+      }
+      if(0 != m_Prefixes) {
+         //no exact match: try the wildcard registrations, most specific first
+         CPrefixFind prefixFind;
+         prefixFind.m_pEventMap        = &m_EventMap;
+         prefixFind.m_pHandleEventInfo = NULL;
+         if(spEventBase->ForEachPrefix(&CHandlerTable::PrefixFind, &prefixFind)) {
+            return prefixFind.m_pHandleEventInfo;
+         }
+      }
+      return RangeFind(spEventBase);
+   }
+
+   /** Find the handle-event-info registered for an event-type.
+    **
+    ** @return the handle-event-info or NULL when not found.
+    **/
+   CHandleEventInfoBase* CHandlerTable::EventTypeFind(
+      const std::string& strEventType //< String representation of the event type.
+      ) const
+   {
+      const EventTypeMapCIt cit(m_EventTypeMap.find(strEventType));
+      if(m_EventTypeMap.end() == cit) {
+         return NULL;
+      }
+      return cit->second.get();
+   }
+
+   /** Get the number of registered event ID's.
+    **
+    ** @return the number of registered event ID's.
+    **/
+   size_t CHandlerTable::EventCount(void) const
+   {
+      return m_EventMap.size();
+   }
+
+   /** Get the number of registered event-types.
+    **
+    ** @return the number of registered event-types.
+    **/
+   size_t CHandlerTable::EventTypeCount(void) const
+   {
+      return m_EventTypeMap.size();
+   }
+
+   /** Append the registered event ID's and event-types.
+    **/
+   void CHandlerTable::EventKeys(
+      std::vector<SPEventBase>& events,    //< The event ID's are appended.
+      std::vector<std::string>& eventTypes //< The event-types are appended.
+      ) const
+   {
+      for(EventMapCIt cit = m_EventMap.begin() ; m_EventMap.end() != cit ; ++cit) {
+         events.push_back(cit->first);
+      }
+      for(EventTypeMapCIt cit = m_EventTypeMap.begin() ; m_EventTypeMap.end() != cit ; ++cit) {
+         eventTypes.push_back(cit->first);
+      }
+   }
+
+   /** Unregister all event handlers and event-type handlers.
+    **/
+   void CHandlerTable::Clear(void)
+   {
+      m_EventMap.clear();
+      m_EventTypeMap.clear();
+      m_DenseTables.clear();
+      m_Prefixes = 0;
+      m_Ranges.clear();
+   }
+
+   /** Index a handle-event-info just added to the map: in the flat array
+    ** of its event ID type when the event ID is dense (see TEvtIdDense),
+    ** in the wildcard count when it is a prefix (see TEvtSubAny), in the
+    ** sorted ranges when it is a range (see TEvtIdRange).
+    **
+    ** A range overlapping another range of the same event ID type is
+    ** removed from the map again and an exception is thrown.
+    **/
+   void CHandlerTable::EventIndex(
+      const SPEventBase&          spEventBase,      //< The event identification.
+      CHandleEventInfoBase* const pHandleEventInfo //< The handle-event-info, owned by the map.
+      )
+   {
+      const void* pTag (NULL);
+      size_t      slot (0);
+      size_t      slots(0);
+      if(spEventBase->IsPrefix()) {
+         ++m_Prefixes;
+      }
+      CRange range;
+      if(spEventBase->RangeKey(range.m_pTag, range.m_First, range.m_Last)) {
+         range.m_pHandleEventInfo = pHandleEventInfo;
+         const Ranges::iterator it(std::upper_bound(m_Ranges.begin(), m_Ranges.end(), range, &CHandlerTable::RangeLess));
+         if(range.m_Last < range.m_First
+            || (m_Ranges.end()   != it && range.m_pTag == it->m_pTag       && it->m_First <= range.m_Last)
+            || (m_Ranges.begin() != it && range.m_pTag == (it - 1)->m_pTag && range.m_First <= (it - 1)->m_Last)
+            ) {
+            m_EventMap.erase(spEventBase);
+            throw std::runtime_error("empty range or overlapping another range");
+         }
+         m_Ranges.insert(it, range);
+         return;
+      }
+      if(!spEventBase->DenseSlot(pTag, slot, slots)) {
+         return;
+      }
+      DenseTables::iterator it(m_DenseTables.begin());
+      while(m_DenseTables.end() != it && pTag != it->m_pTag) {
+         ++it;
+      }
+      if(m_DenseTables.end() == it) {
+         it = m_DenseTables.insert(m_DenseTables.end(), CDenseTable(pTag, slots, m_pResource));
+      }
+      it->m_Slots[slot] = pHandleEventInfo;
+   }
+
+   /** Look up 1 prefix of an event (see CEventBase::ForEachPrefix).
+    **
+    ** The prefix lives on the stack of the caller: it is wrapped in a
+    ** shared pointer that does not own it (aliasing constructor), nothing
+    ** is allocated.
+    **
+    ** @return true when found: stop.
+    **/
+   bool CHandlerTable::PrefixFind(
+      void*       pContext, //< The CPrefixFind context.
+      CEventBase& prefix    //< The prefix.
+      )
+   {
+      CPrefixFind* const pPrefixFind(static_cast<CPrefixFind*>(pContext));
+      const EventMapCIt  cit(pPrefixFind->m_pEventMap->find(SPEventBase(SPEventBase(), &prefix)));
+      if(pPrefixFind->m_pEventMap->end() == cit) {
+         return false;
+      }
+      pPrefixFind->m_pHandleEventInfo = cit->second.get();
+      return true;
+   }
+
+   /** Look up the event ID of an event in the range registrations with
+    ** a binary search: the last range of its type starting at or before
+    ** the event ID is the only candidate.
+    **
+    ** @return the handle-event-info or NULL when not found.
+    **/
+   CHandleEventInfoBase* CHandlerTable::RangeFind(
+      const SPEventBase& spEventBase //< The complete event identification.
+      ) const
+   {
+      if(m_Ranges.empty()) {
+         return NULL;
+      }
+      CRange range;
+      if(!spEventBase->RangeValue(range.m_pTag, range.m_First)) {
+         return NULL;
+      }
+      Ranges::const_iterator cit(std::upper_bound(m_Ranges.begin(), m_Ranges.end(), range, &CHandlerTable::RangeLess));
+      if(m_Ranges.begin() == cit) {
+         return NULL;
+      }
+      --cit;
+      if(range.m_pTag != cit->m_pTag || cit->m_Last < range.m_First) {
+         return NULL;
+      }
+      return cit->m_pHandleEventInfo;
+   }
+
+   /** Sort ranges on event ID type (tag), then on first event ID.
+    **
+    ** @return true when a sorts before b.
+    **/
+   bool CHandlerTable::RangeLess(
+      const CRange& a, //< First range.
+      const CRange& b  //< Second range.
+      )
+   {
+      if(a.m_pTag != b.m_pTag) {
+         return std::less<const void*>()(a.m_pTag, b.m_pTag);
+      }
+      return a.m_First < b.m_First;
+   }
+
+   /** Trace all registered event handlers.
+    **/
+   void CHandlerTable::TraceHandlers(void) const
+   {
+      for(EventMapCIt cit = m_EventMap.begin() ; m_EventMap.end() != cit ; ++cit) {
+         LogDebug("ID [%s] event type [%s] with data type [%s])\n", cit->first->GetId().c_str(), cit->first->GetIdType().c_str(), cit->first->GetDataType().c_str());
+      }
+   }
+
+   /** Trace all registered event-type handlers.
+    **/
+   void CHandlerTable::TraceTypeHandlers(void) const
+   {
+      for(EventTypeMapCIt cit = m_EventTypeMap.begin() ; m_EventTypeMap.end() != cit ; ++cit) {
+         LogDebug("%s\n", cit->first.c_str());
+      }
+   }
+}
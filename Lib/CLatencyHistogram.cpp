@@ -0,0 +1,366 @@
+/** @file
+ ** @brief The CLatencyKey, CLatencyHistogram and CLatencyRecorder definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "Include/CLatencyHistogram.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** Histograms per key.
+       **/
+      typedef std::map<CLatencyKey, CLatencyHistogram> Histograms;
+
+      /** Iterator on the histograms.
+       **/
+      typedef Histograms::const_iterator               HistogramsCIt;
+
+      /** Add all histograms of a source to the ones of a destination.
+       **/
+      void Merge(
+         Histograms&       dst, //< Destination.
+         const Histograms& src  //< Source.
+         )
+      {
+         for(HistogramsCIt cit = src.begin() ; src.end() != cit ; ++cit) {
+            dst[cit->first].Merge(cit->second);
+         }
+      }
+
+      class CThreadLatency;
+
+      /** Protects the thread list and the histograms of the finished threads.
+       **/
+      std::mutex                s_Mutex;
+
+      /** Threads that have recorded latencies.
+       **/
+      std::set<CThreadLatency*> s_Threads;
+
+      /** Histograms of the finished threads.
+       **/
+      Histograms                s_Finished;
+
+      /** @brief The histograms of 1 thread.
+       **
+       ** Only the owning thread changes the map, under m_Mutex. It can
+       ** look up without locking. Other threads only read, under m_Mutex.
+       **/
+      class CThreadLatency {
+         public:
+            CThreadLatency(void)
+               : m_Mutex()
+               , m_Histograms()
+               , m_Sample(0)
+            {
+               std::lock_guard<std::mutex> lock(s_Mutex);
+               s_Threads.insert(this);
+            }
+
+            ~CThreadLatency(void)
+            {
+               std::lock_guard<std::mutex> lock(s_Mutex);
+               s_Threads.erase(this);
+               Merge(s_Finished, m_Histograms);
+            }
+
+         public:
+            std::mutex   m_Mutex;      ///< Protects adding histograms.
+            Histograms   m_Histograms; ///< The histograms of the thread.
+            unsigned int m_Sample;     ///< Events since the last sampled event.
+      };
+
+      /** The histograms of the calling thread, created upon first use.
+       **/
+      thread_local CThreadLatency tl_Latency;
+   }
+
+   /** Constructor.
+    **/
+   CLatencyKey::CLatencyKey(
+      const ELatency     latency,    //< What is measured.
+      const std::string& strMachine, //< State machine name.
+      const std::string& strState,   //< State name.
+      const std::string& strEvent    //< Event ID.
+      )
+      : m_Latency   (latency   )
+      , m_strMachine(strMachine)
+      , m_strState  (strState  )
+      , m_strEvent  (strEvent  )
+   {
+   }
+
+   /** Get the name of a latency kind (e.g. for reports).
+    **
+    ** @return the name.
+    **/
+   const char* CLatencyKey::GetName(
+      const ELatency latency //< The latency kind.
+      )
+   {
+      switch(latency) {
+         case ELatencyHandler:     return "handler";
+         case ELatencyStateChange: return "state-change";
+         default:                  return "unknown";
+      }
+   }
+
+   /** Order keys (to use them in a map).
+    **
+    ** @return true when this key comes before the other key.
+    **/
+   bool CLatencyKey::operator<(
+      const CLatencyKey& ref //< The other key.
+      ) const
+   {
+      if(m_Latency != ref.m_Latency) {
+         return m_Latency < ref.m_Latency;
+      }
+      if(m_strMachine != ref.m_strMachine) {
+         return m_strMachine < ref.m_strMachine;
+      }
+      if(m_strState != ref.m_strState) {
+         return m_strState < ref.m_strState;
+      }
+      return m_strEvent < ref.m_strEvent;
+   }
+
+   /** Constructor: empty histogram.
+    **/
+   CLatencyHistogram::CLatencyHistogram(void)
+      : m_Count(0)
+      , m_Sum  (0)
+      , m_Max  (0)
+   {
+      for(unsigned int i = 0 ; i < BUCKETS ; ++i) {
+         m_Buckets[i].store(0, std::memory_order_relaxed);
+      }
+   }
+
+   /** Add a value to a counter: a relaxed load and store (single writer).
+    **/
+   void CLatencyHistogram::Add(
+      std::atomic<unsigned long long>& counter, //< The counter.
+      const unsigned long long         n        //< Value to add.
+      )
+   {
+      counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+   }
+
+   /** Record a latency.
+    **/
+   void CLatencyHistogram::Record(
+      const unsigned long long ns //< The latency (ns).
+      )
+   {
+      Add(m_Buckets[GetBucket(ns)], 1);
+      Add(m_Count, 1);
+      Add(m_Sum, ns);
+      if(m_Max.load(std::memory_order_relaxed) < ns) {
+         m_Max.store(ns, std::memory_order_relaxed);
+      }
+   }
+
+   /** Add all values of another histogram.
+    **/
+   void CLatencyHistogram::Merge(
+      const CLatencyHistogram& ref //< The other histogram.
+      )
+   {
+      for(unsigned int i = 0 ; i < BUCKETS ; ++i) {
+         Add(m_Buckets[i], ref.m_Buckets[i].load(std::memory_order_relaxed));
+      }
+      Add(m_Count, ref.m_Count.load(std::memory_order_relaxed));
+      Add(m_Sum,   ref.m_Sum  .load(std::memory_order_relaxed));
+      const unsigned long long max(ref.m_Max.load(std::memory_order_relaxed));
+      if(m_Max.load(std::memory_order_relaxed) < max) {
+         m_Max.store(max, std::memory_order_relaxed);
+      }
+   }
+
+   /** Get the number of values.
+    **
+    ** @return the number of values.
+    **/
+   unsigned long long CLatencyHistogram::GetCount(void) const
+   {
+      return m_Count.load(std::memory_order_relaxed);
+   }
+
+   /** Get the highest value.
+    **
+    ** @return the highest value (ns), 0 when empty.
+    **/
+   unsigned long long CLatencyHistogram::GetMax(void) const
+   {
+      return m_Max.load(std::memory_order_relaxed);
+   }
+
+   /** Get the mean value.
+    **
+    ** @return the mean (ns), 0 when empty.
+    **/
+   unsigned long long CLatencyHistogram::GetMean(void) const
+   {
+      const unsigned long long count(GetCount());
+      return 0 == count ? 0 : m_Sum.load(std::memory_order_relaxed) / count;
+   }
+
+   /** Get the value below which a percentage of the values fall.
+    **
+    ** @return the highest value of the bucket holding the percentile, limited to the highest value (ns); 0 when empty.
+    **/
+   unsigned long long CLatencyHistogram::GetPercentile(
+      const double percentile //< The percentile (0..100), e.g. 99 for p99.
+      ) const
+   {
+      const unsigned long long count(GetCount());
+      if(0 == count) {
+         return 0;
+      }
+      unsigned long long target(static_cast<unsigned long long>(percentile * count / 100.0 + 0.5));
+      if(0 == target) {
+         target = 1;
+      }
+      unsigned long long cumulative(0);
+      for(unsigned int i = 0 ; i < BUCKETS ; ++i) {
+         cumulative += m_Buckets[i].load(std::memory_order_relaxed);
+         if(target <= cumulative) {
+            const unsigned long long bucketMax(GetBucketMax(i));
+            return bucketMax < GetMax() ? bucketMax : GetMax();
+         }
+      }
+      return GetMax();
+   }
+
+   /** Get the bucket of a value.
+    **
+    ** @return the bucket index.
+    **/
+   unsigned int CLatencyHistogram::GetBucket(
+      const unsigned long long ns //< The value (ns).
+      )
+   {
+      if(ns < SUB_BUCKETS) {
+         return static_cast<unsigned int>(ns);
+      }
+      const unsigned int exponent(63 - __builtin_clzll(ns));
+      if(MAX_EXPONENT < exponent) {
+         return BUCKETS - 1;
+      }
+      const unsigned int sub(static_cast<unsigned int>(ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+      return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+   }
+
+   /** Get the highest value of a bucket.
+    **
+    ** @return the highest value (ns).
+    **/
+   unsigned long long CLatencyHistogram::GetBucketMax(
+      const unsigned int bucket //< The bucket index.
+      )
+   {
+      if(bucket < SUB_BUCKETS) {
+         return bucket;
+      }
+      const unsigned int exponent(bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1);
+      const unsigned int sub     (bucket % SUB_BUCKETS);
+      return ((static_cast<unsigned long long>(SUB_BUCKETS + sub + 1)) << (exponent - SUB_BUCKET_BITS)) - 1;
+   }
+
+   std::atomic<unsigned int> CLatencyRecorder::s_SampleEvery(0);
+
+   /** Set the sampling rate of all state machines.
+    **/
+   void CLatencyRecorder::SetSampling(
+      const unsigned int every //< Sample every Nth event of a thread, 1 for all events, 0 to disable.
+      )
+   {
+      s_SampleEvery.store(every, std::memory_order_relaxed);
+   }
+
+   /** Get the sampling rate.
+    **
+    ** @return every Nth event is sampled, 0 when disabled.
+    **/
+   unsigned int CLatencyRecorder::GetSampling(void)
+   {
+      return s_SampleEvery.load(std::memory_order_relaxed);
+   }
+
+   /** Count an event of the calling thread while sampling is enabled.
+    **
+    ** @return true when the event has to be sampled.
+    **/
+   bool CLatencyRecorder::SampleNext(
+      const unsigned int every //< Sample every Nth event.
+      )
+   {
+      CThreadLatency& thread(tl_Latency);
+      if(++thread.m_Sample < every) {
+         return false;
+      }
+      thread.m_Sample = 0;
+      return true;
+   }
+
+   /** Record a latency in the histogram of the calling thread.
+    **/
+   void CLatencyRecorder::Record(
+      const CLatencyKey&       key, //< Identification of the histogram.
+      const unsigned long long ns   //< The latency (ns).
+      )
+   {
+      CThreadLatency&      thread(tl_Latency);
+      Histograms::iterator it    (thread.m_Histograms.find(key));
+      if(thread.m_Histograms.end() != it) {
+         it->second.Record(ns);
+         return;
+      }
+      std::lock_guard<std::mutex> lock(thread.m_Mutex);
+      thread.m_Histograms[key].Record(ns);
+   }
+
+   /** Merge the histograms of all threads and call a function for each
+    ** of them.
+    **
+    ** The function is called without holding a lock.
+    **/
+   void CLatencyRecorder::ForEach(
+      TYPESEL::function<void(const CLatencyKey&, const CLatencyHistogram&)> callback //< Function to call.
+      )
+   {
+      Histograms merged;
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         Merge(merged, s_Finished);
+         for(std::set<CThreadLatency*>::const_iterator cit = s_Threads.begin() ; s_Threads.end() != cit ; ++cit) {
+            std::lock_guard<std::mutex> lockThread((*cit)->m_Mutex);
+            Merge(merged, (*cit)->m_Histograms);
+         }
+      }
+      for(HistogramsCIt cit = merged.begin() ; merged.end() != cit ; ++cit) {
+         callback(cit->first, cit->second);
+      }
+   }
+}
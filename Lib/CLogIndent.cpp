@@ -5,12 +5,24 @@
 #include "Include/Logging.h"
 
 namespace ILULibStateMachine {
-   CLogIndent::CLogIndent(void) {
+   CLogIndent::CLogIndent(void)
+      : m_bIndent(true)
+   {
       LogIndent();
    }
+
+   CLogIndent::CLogIndent(const bool bIndent)
+      : m_bIndent(bIndent)
+   {
+      if(m_bIndent) {
+         LogIndent();
+      }
+   }
     
    CLogIndent::~CLogIndent(void) {
-      LogUnindent();
+      if(m_bIndent) {
+         LogUnindent();
+      }
    }
 };
 
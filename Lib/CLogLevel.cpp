@@ -0,0 +1,186 @@
+/** @file
+ ** @brief The CLogLevel definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <map>
+#include <mutex>
+
+#include "Include/CLogLevel.h"
+#include "Include/CStateMachine.h"
+
+namespace ILULibStateMachine {
+   thread_local uint8_t CLogLevelScope::s_Level = ELogLevelDebug;
+
+   //all levels but debug have a consumer by default (see Logging.h)
+   std::atomic<unsigned int> CLogLevelScope::s_Consumers(((1u << ELogLevelCount) - 1) & ~(1u << ELogLevelDebug));
+
+   /** Set the levels with a consumer, only called by the logging
+    ** administration (LogConsumersUpdate).
+    **/
+   void CLogLevelScope::SetConsumers(
+      const unsigned int consumers //< Bit per level with a consumer.
+      )
+   {
+      s_Consumers.store(consumers, std::memory_order_relaxed);
+   }
+
+   namespace {
+      typedef std::map<std::string, ELogLevel> NameLevels; ///< Log level per state machine name.
+      typedef std::map<uint64_t,    ELogLevel> IdLevels;   ///< Log level per state machine ID.
+
+      /** Protects the levels below. Taken before the registry lock
+       ** (see CStateMachineRegistry) when both are required.
+       **/
+      std::mutex s_Mutex;
+
+      /** The level of the state machines without a rule.
+       **/
+      ELogLevel  s_Global = ELogLevelDebug;
+
+      /** The rules by name.
+       **/
+      NameLevels s_NameLevels;
+
+      /** The rules by ID, they have priority over the rules by name.
+       **/
+      IdLevels   s_IdLevels;
+   }
+
+   /** Set the level of the state machines without a rule (default
+    ** ELogLevelDebug).
+    **/
+   void CLogLevel::SetGlobal(
+      const ELogLevel level //< The level, ELogLevelCount to log nothing.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_Global = level;
+      ApplyAll();
+   }
+
+   /** Get the level of the state machines without a rule.
+    **
+    ** @return the level.
+    **/
+   ELogLevel CLogLevel::GetGlobal(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      return s_Global;
+   }
+
+   /** Set the level of all state machines with a name, the live ones and
+    ** the ones constructed later (unless a rule matches their ID).
+    **/
+   void CLogLevel::SetName(
+      const std::string& strName, //< The state machine name.
+      const ELogLevel    level    //< The level, ELogLevelCount to log nothing.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_NameLevels[strName] = level;
+      ApplyAll();
+   }
+
+   /** Set the level of 1 state machine.
+    **/
+   void CLogLevel::SetId(
+      const uint64_t  id,   //< The state machine ID, see CStateMachine::GetId.
+      const ELogLevel level //< The level, ELogLevelCount to log nothing.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_IdLevels[id] = level;
+      ApplyAll();
+   }
+
+   /** Remove the rule for a state machine name.
+    **/
+   void CLogLevel::ResetName(
+      const std::string& strName //< The state machine name.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_NameLevels.erase(strName);
+      ApplyAll();
+   }
+
+   /** Remove the rule for a state machine ID.
+    **/
+   void CLogLevel::ResetId(
+      const uint64_t id //< The state machine ID.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_IdLevels.erase(id);
+      ApplyAll();
+   }
+
+   /** Remove all rules: all state machines take the global level.
+    **/
+   void CLogLevel::ResetAll(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_NameLevels.clear();
+      s_IdLevels.clear();
+      ApplyAll();
+   }
+
+   /** Set the level of a state machine that has just been constructed
+    ** (and registered).
+    **
+    ** The level is set holding the lock, so a rule added at the same time
+    ** is either applied here or by ApplyAll afterwards.
+    **/
+   void CLogLevel::Apply(
+      const CStateMachine& stateMachine //< The state machine.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      ApplyLocked(stateMachine);
+   }
+
+   /** Set the level of a state machine according to the rules, the
+    ** caller holds the lock.
+    **/
+   void CLogLevel::ApplyLocked(
+      const CStateMachine& stateMachine //< The state machine.
+      )
+   {
+      ELogLevel level(s_Global);
+      const IdLevels::const_iterator citId(s_IdLevels.find(stateMachine.GetId()));
+      if(s_IdLevels.end() != citId) {
+         level = citId->second;
+      } else {
+         const NameLevels::const_iterator citName(s_NameLevels.find(stateMachine.GetName()));
+         if(s_NameLevels.end() != citName) {
+            level = citName->second;
+         }
+      }
+      stateMachine.m_LogLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+   }
+
+   /** Set the level of all live state machines according to the rules,
+    ** the caller holds the lock.
+    **/
+   void CLogLevel::ApplyAll(void)
+   {
+      CStateMachineRegistry::ForEach(&CLogLevel::ApplyLocked);
+   }
+};
@@ -0,0 +1,140 @@
+/** @file
+ ** @brief The CMemoryArena definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <new>
+
+#include "Include/CMemoryArena.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** Round a size up to a multiple of the arena granule.
+       **
+       ** @return the rounded size.
+       **/
+      size_t RoundUp(const size_t size)
+      {
+         return (size + CMemoryArena::GRANULE - 1) & ~(CMemoryArena::GRANULE - 1);
+      }
+   }
+
+   /** Constructor.
+    **
+    ** The first chunk is only allocated upon the first allocation.
+    **/
+   CMemoryArena::CMemoryArena(
+      const size_t chunkSize //< Size of each chunk (bytes), at least MAX_SMALL_SIZE is used.
+      )
+      : m_ChunkSize (RoundUp(chunkSize < 2 * MAX_SMALL_SIZE ? 2 * MAX_SMALL_SIZE : chunkSize))
+      , m_pChunks   (NULL)
+      , m_pCurrent  (NULL)
+      , m_pEnd      (NULL)
+      , m_ChunkBytes(0)
+   {
+      for(size_t i = 0 ; i < MAX_SMALL_SIZE / GRANULE ; ++i) {
+         m_FreeLists[i] = NULL;
+      }
+   }
+
+   /** Destructor: releases all chunks at once.
+    **
+    ** The objects allocated from the arena must have been destructed.
+    **/
+   CMemoryArena::~CMemoryArena(void)
+   {
+      while(NULL != m_pChunks) {
+         SChunk* const pNext(m_pChunks->m_pNext);
+         ::operator delete(m_pChunks);
+         m_pChunks = pNext;
+      }
+   }
+
+   /** Allocate a block.
+    **
+    ** @return the block, aligned on GRANULE; throws std::bad_alloc on failure.
+    **/
+   void* CMemoryArena::Allocate(
+      const size_t size,     //< Number of bytes.
+      const size_t alignment //< Required alignment, at most GRANULE for blocks from the arena.
+      )
+   {
+      const size_t rounded(RoundUp(0 == size ? 1 : size));
+      if((MAX_SMALL_SIZE < rounded) || (GRANULE < alignment)) {
+         return ::operator new(size);
+      }
+      SFree*& pFree(m_FreeLists[rounded / GRANULE - 1]);
+      if(NULL != pFree) {
+         SFree* const pBlock(pFree);
+         pFree = pBlock->m_pNext;
+         return pBlock;
+      }
+      if(static_cast<size_t>(m_pEnd - m_pCurrent) < rounded) {
+         AddChunk();
+      }
+      void* const p(m_pCurrent);
+      m_pCurrent += rounded;
+      return p;
+   }
+
+   /** Return a block: small blocks are kept for reuse, large blocks go
+    ** back to the heap.
+    **/
+   void CMemoryArena::Deallocate(
+      void* const  p,        //< The block.
+      const size_t size,     //< Number of bytes, as provided to Allocate.
+      const size_t alignment //< Alignment, as provided to Allocate.
+      )
+   {
+      if(NULL == p) {
+         return;
+      }
+      const size_t rounded(RoundUp(0 == size ? 1 : size));
+      if((MAX_SMALL_SIZE < rounded) || (GRANULE < alignment)) {
+         ::operator delete(p);
+         return;
+      }
+      SFree* const pBlock(static_cast<SFree*>(p));
+      SFree*&      pFree(m_FreeLists[rounded / GRANULE - 1]);
+      pBlock->m_pNext = pFree;
+      pFree           = pBlock;
+   }
+
+   /** Get the number of bytes taken from the heap for chunks.
+    **
+    ** @return the number of bytes.
+    **/
+   size_t CMemoryArena::GetChunkBytes(void) const
+   {
+      return m_ChunkBytes;
+   }
+
+   /** Add a new chunk, the remainder of the current chunk is lost.
+    **/
+   void CMemoryArena::AddChunk(void)
+   {
+      SChunk* const pChunk(static_cast<SChunk*>(::operator new(m_ChunkSize)));
+      pChunk->m_pNext = m_pChunks;
+      pChunk->m_Size  = m_ChunkSize;
+      m_pChunks       = pChunk;
+      m_pCurrent      = reinterpret_cast<char*>(pChunk) + RoundUp(sizeof(SChunk));
+      m_pEnd          = reinterpret_cast<char*>(pChunk) + m_ChunkSize;
+      m_ChunkBytes   += m_ChunkSize;
+   }
+}
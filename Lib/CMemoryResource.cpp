@@ -0,0 +1,70 @@
+/** @file
+ ** @brief The CMemoryResource definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <new>
+
+#include "Include/CAllocationStats.h"
+#include "Include/CMemoryResource.h"
+
+namespace ILULibStateMachine {
+   /** Destructor to make this a virtual class.
+    **/
+   CMemoryResource::~CMemoryResource(void)
+   {
+   }
+
+   /** Allocate memory from a resource, or from the heap when no resource
+    ** is provided.
+    **
+    ** Allocations from a resource are reported to CAllocationStats, heap
+    ** allocations are left to a replaced global operator new.
+    **
+    ** @return the allocated memory, throws std::bad_alloc on failure.
+    **/
+   void* MemoryAllocate(
+      CMemoryResource* const pResource, //< The resource to allocate from, NULL for the heap.
+      const size_t           size,      //< Number of bytes.
+      const size_t           alignment  //< Required alignment, the heap only guarantees the fundamental alignment.
+      )
+   {
+      if(NULL == pResource) {
+         return ::operator new(size);
+      }
+      CAllocationStats::RecordAllocation(size);
+      return pResource->Allocate(size, alignment);
+   }
+
+   /** Return memory allocated by MemoryAllocate.
+    **/
+   void MemoryDeallocate(
+      CMemoryResource* const pResource, //< The resource the memory was allocated from, NULL for the heap.
+      void* const            p,         //< The memory to return.
+      const size_t           size,      //< Number of bytes, as provided to MemoryAllocate.
+      const size_t           alignment  //< Alignment, as provided to MemoryAllocate.
+      )
+   {
+      if(NULL == pResource) {
+         ::operator delete(p);
+         return;
+      }
+      pResource->Deallocate(p, size, alignment);
+   }
+}
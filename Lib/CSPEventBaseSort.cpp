@@ -25,7 +25,7 @@ namespace ILULibStateMachine {
    /** The sort operator, comparing the instances the shared pointers are pointing to
     ** instead of the pointers themselves.
     **/
-   bool CSPEventBaseSort::operator()(SPEventBase a, SPEventBase b)
+   bool CSPEventBaseSort::operator()(SPEventBase a, SPEventBase b) const
    {
       CEventBase& rA(*a);
       CEventBase& rB(*b);
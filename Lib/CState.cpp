@@ -20,8 +20,59 @@
  **
  **/
 #include "Include/CState.h"
+#include "Internal/CStateResourceScope.h"
 
 namespace ILULibStateMachine {
+   namespace {
+      /** @brief Stored in front of each state by CState::operator new.
+       **/
+      class StateHeader {
+         public:
+            CMemoryResource* m_pResource; //< Resource the state was allocated from, NULL for the heap.
+            size_t           m_Size;      //< Size of the allocation, header included.
+      };
+
+      /** Alignment of the states, as guaranteed by the heap.
+       **/
+      const size_t STATE_HEADER_ALIGN = alignof(std::max_align_t);
+
+      /** Size of the header, keeping the state aligned.
+       **/
+      const size_t STATE_HEADER_SIZE  = (sizeof(StateHeader) + STATE_HEADER_ALIGN - 1) & ~(STATE_HEADER_ALIGN - 1);
+   }
+
+   namespace Internal {
+      /** Resource selected for the current thread.
+       **/
+      thread_local CMemoryResource* tl_pStateResource = NULL;
+
+      /** Constructor: select the resource.
+       **/
+      CStateResourceScope::CStateResourceScope(
+         CMemoryResource* const pResource //< Resource to allocate states from, NULL for the heap.
+         )
+         : m_pPrevious(tl_pStateResource)
+      {
+         tl_pStateResource = pResource;
+      }
+
+      /** Destructor: restore the previous resource.
+       **/
+      CStateResourceScope::~CStateResourceScope(void)
+      {
+         tl_pStateResource = m_pPrevious;
+      }
+
+      /** Get the resource selected for the current thread.
+       **
+       ** @return the resource, NULL for the heap.
+       **/
+      CMemoryResource* CStateResourceScope::Get(void)
+      {
+         return tl_pStateResource;
+      }
+   }
+
    /** Constructor.
     **/
    CState::CState(
@@ -39,6 +90,39 @@ namespace ILULibStateMachine {
    {
    };
 
+   /** Allocate a state from the resource selected by the CStateResourceScope
+    ** of the current thread (the heap when there is none).
+    **
+    ** The resource and size are stored in front of the state, so the state
+    ** can be returned to the right resource in operator delete.
+    **
+    ** @return the memory for the state.
+    **/
+   void* CState::operator new(
+      size_t size //< Size of the state.
+      )
+   {
+      CMemoryResource* const pResource(Internal::CStateResourceScope::Get());
+      char* const            p        (static_cast<char*>(MemoryAllocate(pResource, STATE_HEADER_SIZE + size, STATE_HEADER_ALIGN)));
+      StateHeader* const     pHeader  (reinterpret_cast<StateHeader*>(p));
+      pHeader->m_pResource = pResource;
+      pHeader->m_Size      = STATE_HEADER_SIZE + size;
+      return p + STATE_HEADER_SIZE;
+   }
+
+   /** Return a state to the resource it was allocated from.
+    **/
+   void CState::operator delete(
+      void* p //< The state memory.
+      )
+   {
+      if(NULL == p) {
+         return;
+      }
+      StateHeader* const pHeader(reinterpret_cast<StateHeader*>(static_cast<char*>(p) - STATE_HEADER_SIZE));
+      MemoryDeallocate(pHeader->m_pResource, pHeader, pHeader->m_Size, STATE_HEADER_ALIGN);
+   }
+
    /** Get the state name.
     **
     ** @return the state name.
@@ -19,12 +19,74 @@
  ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  **
  **/
+#include <algorithm>
+
+#include "CBroadcast.h"
 #include "CStateChangeException.h"
 #include "CState.h"
 #include "CStateMachine.h"
 #include "Logging.h"
+#include "Internal/CStateResourceScope.h"
 
 namespace ILULibStateMachine {
+   namespace {
+      std::atomic<uint64_t> s_NextId(1); //< The ID of the next state machine, see CStateMachine::GetId.
+
+      /** Get a parent from the parent chain of a state.
+       **
+       ** @return the parent.
+       **/
+      const CStateParent* GetParentAt(
+         const CCreateState& createState, //< Class that describes the state.
+         const size_t        depth,       //< The number of parents of the state.
+         const size_t        level        //< The level of the parent: 0 for the outermost parent.
+         )
+      {
+         const CStateParent* pParent(createState.GetParent());
+         for(size_t i = level + 1 ; i < depth ; ++i) {
+            pParent = pParent->m_pParent;
+         }
+         return pParent;
+      }
+
+      /** Append the event ID's and event-types a parent state registered
+       ** handlers for.
+       **/
+      void EventKeysLevel(
+         const CStateLevel&        level,     //< The parent state.
+         std::vector<SPEventBase>& events,    //< The event ID's are appended.
+         std::vector<std::string>& eventTypes //< The event-types are appended.
+         )
+      {
+         if(NULL != level.m_pHandlers) {
+            level.m_pHandlers->EventKeys(events, eventTypes);
+         }
+         if(NULL != level.m_pShared) {
+            level.m_pShared->EventKeys(events, eventTypes);
+         }
+      }
+   }
+
+   /** Constructor: a region without state.
+    **/
+   CStateRegion::CStateRegion(
+      const char* const      szName,   //< The region name, logging only.
+      const bool             bLocal,   //< The handlers of the region only use the region's own states and data.
+      CMemoryResource* const pResource //< The resource of the state machine, NULL for the heap.
+      )
+      : m_strName  (szName   )
+      , m_bLocal   (bLocal   )
+      , m_pState   (NULL     )
+      , m_pHandlers(NULL     )
+      , m_pShared  (NULL     )
+      , m_Parents  (TAllocator<CStateLevel>(pResource))
+      , m_pCounters(NULL     )
+      , m_bHandled (false    )
+      , m_bType    (false    )
+      , m_Next     (         )
+   {
+   }
+
    /** Factory function to instantiate a state machine without a default state.
     ** 
     ** This factory function and the private state machine constructors ensure
@@ -37,11 +99,12 @@ namespace ILULibStateMachine {
     **/
    SPStateMachine CStateMachine::ConstructStateMachine(
       const char* szName,                        //< State machine name, logging only.
-      CCreateState createState,                  //< Class to create the initial state.
-      CStateMachineData* const pStateMachineData //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CCreateState createState,                   //< Class to create the initial state.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      const size_t arenaChunkSize                 //< When not 0: the state machine allocates from its own arena with chunks of this size (bytes); when 0: it allocates from the heap.
       )
    {
-      SPStateMachine sp(new CStateMachine(szName, pStateMachineData));
+      SPStateMachine sp(ConstructArena(szName, pStateMachineData, arenaChunkSize));
       sp->SetInitialState(createState);
       return sp;
    }
@@ -59,11 +122,54 @@ namespace ILULibStateMachine {
    SPStateMachine CStateMachine::ConstructStateMachine(
       const char* szName,                        //< State machine name, logging only.
       CCreateState createState,                  //< Class to create the initial state.
-      CCreateState createDefaultState,           //< Class to create the default state.
-      CStateMachineData* const pStateMachineData //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CCreateState createDefaultState,            //< Class to create the default state.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      const size_t arenaChunkSize                 //< When not 0: the state machine allocates from its own arena with chunks of this size (bytes); when 0: it allocates from the heap.
       )
    {
-      SPStateMachine sp(new CStateMachine(szName, pStateMachineData));
+      SPStateMachine sp(ConstructArena(szName, pStateMachineData, arenaChunkSize));
+      sp->SetInitialState(createState, createDefaultState);
+      return sp;
+   }
+
+   /** Factory function to instantiate a state machine allocating from
+    ** a memory resource provided by the caller.
+    **
+    ** The state machine itself, the shared pointer control block, its states,
+    ** handler tables and event identifications are allocated from the resource.
+    ** The resource is not owned: it has to outlive the state machine and all
+    ** weak pointers to it.
+    **
+    ** @return a shared pointer to the instantiated state machine.
+    **/
+   SPStateMachine CStateMachine::ConstructStateMachine(
+      const char* szName,                        //< State machine name, logging only.
+      CCreateState createState,                   //< Class to create the initial state.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CMemoryResource& resource                   //< The resource to allocate from.
+      )
+   {
+      SPStateMachine sp(Construct(szName, pStateMachineData, &resource, false), &CStateMachine::Destroy, TAllocator<CStateMachine>(&resource));
+      sp->SetInitialState(createState);
+      return sp;
+   }
+
+   /** Factory function to instantiate a state machine with a default state,
+    ** allocating from a memory resource provided by the caller.
+    **
+    ** See the overload without default state.
+    **
+    ** @return a shared pointer to the instantiated state machine.
+    **/
+   SPStateMachine CStateMachine::ConstructStateMachine(
+      const char* szName,                        //< State machine name, logging only.
+      CCreateState createState,                  //< Class to create the initial state.
+      CCreateState createDefaultState,            //< Class to create the default state.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CMemoryResource& resource                   //< The resource to allocate from.
+      )
+   {
+      SPStateMachine sp(Construct(szName, pStateMachineData, &resource, false), &CStateMachine::Destroy, TAllocator<CStateMachine>(&resource));
       sp->SetInitialState(createState, createDefaultState);
       return sp;
    }
@@ -72,14 +178,36 @@ namespace ILULibStateMachine {
     **/
    CStateMachine::~CStateMachine(void)
    {
+      CStateMachineRegistry::Unregister(this);
+      if(NULL != m_pBroadcast) {
+         m_pBroadcast->Remove(*this);
+      }
+
       //unregister state handlers
       EventUnregister(true);
       EventUnregister(false);
 
       //delete in reverse order
+      while(!m_Regions.empty()) {
+         CStateRegion& region(m_Regions.back());
+         if(NULL != region.m_pHandlers) {
+            region.m_pHandlers->Clear();
+         }
+         delete region.m_pState;
+         ExitParents(region.m_Parents, 0);
+         EventDeleteTable(region.m_pHandlers);
+         if(NULL != region.m_pCounters) {
+            region.m_pCounters->~CStateMachineCounters();
+            MemoryDeallocate(m_pResource, region.m_pCounters, sizeof(CStateMachineCounters), alignof(CStateMachineCounters));
+         }
+         m_Regions.pop_back();
+      }
       delete m_pState;
+      ExitParents(m_Parents, 0);
       delete m_pDefaultState;
       delete m_pStateMachineData;
+      EventDeleteTable(m_pHandlersState);
+      EventDeleteTable(m_pHandlersDefault);
    }
 
    /** Get the state machine name.
@@ -91,6 +219,27 @@ namespace ILULibStateMachine {
       return m_strName;
    }
 
+   /** Get the ID of the state machine: unique in the process (numbered
+    ** from 1 in the order of construction), e.g. to set its log level
+    ** with CLogLevel::SetId.
+    **
+    ** @return the ID.
+    **/
+   uint64_t CStateMachine::GetId(void) const
+   {
+      return m_Id;
+   }
+
+   /** Get the lowest level of the engine's logging for this state machine
+    ** (see CLogLevel).
+    **
+    ** @return the log level, ELogLevelCount when the engine does not log.
+    **/
+   ELogLevel CStateMachine::GetLogLevel(void) const
+   {
+      return static_cast<ELogLevel>(m_LogLevel.load(std::memory_order_relaxed));
+   }
+
    /** Indicates whether the state machine has finished (state is null) or not.
     **
     ** @return true: when the state machine has finished (state is null); false when the state machine still has a valid state (not null), meaning it has not finished.
@@ -100,21 +249,232 @@ namespace ILULibStateMachine {
       return NULL == m_pState;
    }
 
+   /** Get the allocations of this state machine per category.
+    **
+    ** @return the allocation counts, all 0 when the library is not compiled with ALLOCATION_STATS.
+    **/
+   const CAllocationStats& CStateMachine::GetAllocationStats(void) const
+   {
+      static const CAllocationStats s_None;
+      return NULL == m_pAllocationStats ? s_None : *m_pAllocationStats;
+   }
+
+   /** Get the runtime statistics of this state machine.
+    **
+    ** Can be called from another thread than the one using the state machine.
+    **
+    ** @return a snapshot of the statistics, all 0 when the library is compiled with NO_RUNTIME_STATS.
+    **/
+   CStateMachineStats CStateMachine::GetStats(void) const
+   {
+      return m_Counters.Get();
+   }
+
    /** Constructor.
     **/
    CStateMachine::CStateMachine(
       const char* szName,                        //< State machine name, logging only.
-      CStateMachineData* const pStateMachineData //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      CMemoryResource* const   pResource,         //< The resource this state machine allocates from (NULL for the heap).
+      const bool               bOwnResource       //< The state machine owns the resource: deleted by Destroy.
       )
-      : m_strName            (szName           )
-      , m_EventMapDefault    (                 )
-      , m_EventMapState      (                 )
-      , m_EventTypeMapDefault(                 )
-      , m_EventTypeMapState  (                 )
+      : m_pResource          (pResource        )
+      , m_bOwnResource       (bOwnResource     )
+      , m_strName            (szName           )
+      , m_Id                 (s_NextId.fetch_add(1, std::memory_order_relaxed))
+      , m_LogLevel           (ELogLevelDebug   )
+      , m_pHandlersDefault   (NULL             )
+      , m_pHandlersState     (NULL             )
+      , m_pSharedDefault     (NULL             )
+      , m_pSharedState       (NULL             )
+      , m_pSharedBuild       (NULL             )
+      , m_bSharedSealed      (false            )
       , m_pDefaultState      (NULL             )
       , m_pState             (NULL             )
+      , m_Parents            (TAllocator<CStateLevel>(pResource))
+      , m_pBuildLevel        (NULL             )
+      , m_Regions            (TAllocator<CStateRegion>(pResource))
+      , m_BuildRegion        (0                )
+      , m_ParentsKept        (0                )
+      , m_pThreadPool        (NULL             )
+      , m_pBroadcast         (NULL             )
+#ifdef ALLOCATION_STATS
+      , m_pAllocationStats   (new CAllocationStats())
+#else
+      , m_pAllocationStats   (NULL             )
+#endif
+      , m_Counters           (                 )
+      , m_pRegistryPrev      (NULL             )
+      , m_pRegistryNext      (NULL             )
+      , m_TraceId            (0                )
+      , m_TraceState         (0                )
+      , m_pTrace             (NULL             )
       , m_pStateMachineData  (pStateMachineData)
    {
+      CStateMachineRegistry::Register(this);
+      CLogLevel::Apply(*this);
+   }
+
+   /** Allocate and construct a state machine, in its own arena when requested.
+    **
+    ** The shared pointer control block stays on the heap: weak pointers to the
+    ** state machine can outlive the arena.
+    **
+    ** @return a shared pointer to the constructed state machine, without states.
+    **/
+   SPStateMachine CStateMachine::ConstructArena(
+      const char* szName,                         //< State machine name, logging only.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine.
+      const size_t arenaChunkSize                 //< When not 0: chunk size of the state machine's arena; when 0: no arena.
+      )
+   {
+      if(0 == arenaChunkSize) {
+         return SPStateMachine(Construct(szName, pStateMachineData, NULL, false), &CStateMachine::Destroy);
+      }
+      return SPStateMachine(Construct(szName, pStateMachineData, new CMemoryArena(arenaChunkSize), true), &CStateMachine::Destroy);
+   }
+
+   /** Allocate and construct a state machine from a memory resource.
+    **
+    ** When the state machine owns the resource, it is deleted when
+    ** construction fails.
+    **
+    ** @return the constructed state machine, without states: to be destructed with Destroy.
+    **/
+   CStateMachine* CStateMachine::Construct(
+      const char* szName,                         //< State machine name, logging only.
+      CStateMachineData* const pStateMachineData, //< Pointer to the state machine data belonging to this state machine.
+      CMemoryResource* const   pResource,         //< The resource to allocate from, NULL for the heap.
+      const bool               bOwnResource       //< The state machine takes ownership of the resource.
+      )
+   {
+      void* p(NULL);
+      try {
+         p = MemoryAllocate(pResource, sizeof(CStateMachine), alignof(CStateMachine));
+         return new(p) CStateMachine(szName, pStateMachineData, pResource, bOwnResource);
+      } catch(...) {
+         if(NULL != p) {
+            MemoryDeallocate(pResource, p, sizeof(CStateMachine), alignof(CStateMachine));
+         }
+         if(bOwnResource) {
+            delete pResource;
+         }
+         throw;
+      }
+   }
+
+   /** Deleter of the state machine shared pointer.
+    **
+    ** Destructs the state machine and returns its memory to the resource
+    ** it was allocated from. An owned resource (e.g. the arena) is deleted
+    ** afterwards, releasing all memory allocated from it in one operation.
+    **/
+   void CStateMachine::Destroy(
+      CStateMachine* pStateMachine //< The state machine to destroy.
+      )
+   {
+      CMemoryResource* const  pResource   (pStateMachine->m_pResource       );
+      const bool              bOwnResource(pStateMachine->m_bOwnResource    );
+      CAllocationStats* const pStats      (pStateMachine->m_pAllocationStats);
+      {
+         ALLOCATION_SCOPE(pStats, EAllocationTeardown);
+         pStateMachine->~CStateMachine();
+         MemoryDeallocate(pResource, pStateMachine, sizeof(CStateMachine), alignof(CStateMachine));
+      }
+      if(bOwnResource) {
+         delete pResource;
+      }
+      delete pStats;
+   }
+
+   /** Get the memory resource everything owned by this state machine is
+    ** allocated from.
+    **
+    ** @return the state machine's resource (e.g. its arena), NULL for the heap.
+    **/
+   CMemoryResource* CStateMachine::GetMemoryResource(void) const
+   {
+      return m_pResource;
+   }
+
+   /** Add an orthogonal region to the state machine and create its
+    ** initial state.
+    **
+    ** The registrations made by the constructors of the region's states
+    ** (and their parents) belong to the region. Add the regions before
+    ** feeding events into the state machine, not from within a handler.
+    **
+    ** @return the region number: 1 for the first region added, 0 being the state machine's own state.
+    **/
+   size_t CStateMachine::RegionAdd(
+      const char*  szName,      //< Region name, logging only.
+      CCreateState createState, //< Class to create the initial state of the region.
+      const bool   bLocal       //< The handlers of the region only use the region's own states and data: the region can be dispatched on a thread pool (see SetThreadPool).
+      )
+   {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationTransition);
+      CLogLevelScope logLevelScope(m_LogLevel.load(std::memory_order_relaxed));
+      m_Regions.push_back(CStateRegion(szName, bLocal, m_pResource));
+      const size_t region(m_Regions.size());
+      if(bLocal) {
+         m_Regions.back().m_pCounters = new(MemoryAllocate(m_pResource, sizeof(CStateMachineCounters), alignof(CStateMachineCounters))) CStateMachineCounters();
+      }
+      ChangeState(createState, region);
+      return region;
+   }
+
+   /** Get the number of regions of the state machine.
+    **
+    ** @return the number of regions, the state machine's own state (region 0) included.
+    **/
+   size_t CStateMachine::GetRegionCount(void) const
+   {
+      return m_Regions.size() + 1;
+   }
+
+   /** Get the name of the current state of a region.
+    **
+    ** @return the state name.
+    **/
+   std::string CStateMachine::GetRegionStateName(
+      const size_t region //< The region, 0 for the state machine's own state.
+      ) const
+   {
+      if(0 == region) {
+         return GetStateName(false);
+      }
+      const CStateRegion& ref(m_Regions.at(region - 1));
+      if(NULL == ref.m_pState) {
+         return "no current state";
+      }
+      return ref.m_pState->GetName();
+   }
+
+   /** Indicates whether a region has finished (state is null) or not.
+    **
+    ** @return true when the region has finished.
+    **/
+   bool CStateMachine::HasRegionFinished(
+      const size_t region //< The region, 0 for the state machine's own state (see HasFinished).
+      ) const
+   {
+      if(0 == region) {
+         return HasFinished();
+      }
+      return NULL == m_Regions.at(region - 1).m_pState;
+   }
+
+   /** Dispatch the region-local regions on a thread pool, or on the calling
+    ** thread again.
+    **
+    ** The pool is not owned: it has to outlive the state machine or be
+    ** reset first.
+    **/
+   void CStateMachine::SetThreadPool(
+      CThreadPool* const pThreadPool //< The pool, NULL to dispatch all regions on the calling thread.
+      )
+   {
+      m_pThreadPool = pThreadPool;
    }
 
    /** Set the initial state of the state machine.
@@ -130,25 +490,56 @@ namespace ILULibStateMachine {
       CCreateState  createDefaultState //< Class to create the default state. Cannot be a reference due to the default value.
       )
    {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationTransition);
+      CLogLevelScope logLevelScope(m_LogLevel.load(std::memory_order_relaxed));
       if(createDefaultState.IsValid()) {
-        m_pDefaultState = createDefaultState.Get()(WPStateMachine(shared_from_this()));
+        m_pDefaultState = CreateState(createDefaultState, m_pSharedDefault);
       }
       if(createState.IsValid()) {
-        m_pState = createState.Get()(WPStateMachine(shared_from_this()));
+        ChangeParents(createState, m_Parents);
+        m_pState = CreateState(createState, m_pSharedState);
       } else if(createDefaultState.IsValid()) {
-        LogErr("Creating a state machine without initial and default state.\n");
+        if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+          LogErr("Creating a state machine without initial and default state.\n");
+        }
       } else {
-        LogWarning("Creating a state machine without initial state.\n");
+        if(CLogLevelScope::IsEnabled(ELogLevelWarning)) {
+          LogWarning("Creating a state machine without initial state.\n");
+        }
       }
    }
 
-   /** Take all actions required to change the current state of the state machine.
+   /** Record the latencies of a sampled event: the handler time (measured
+    ** by CStateMachineHandlerTimer) and the state change requested by the
+    ** handler.
+    **/
+   void CStateMachine::ChangeStateSampled(
+      const CCreateState& createState, //< Class that describes the next state, see ChangeState.
+      const std::string&  strState,    //< Name of the state the handler belongs to.
+      const SPEventBase&  spEventBase  //< The event.
+      )
+   {
+      const std::string strEvent(spEventBase->GetId());
+      CLatencyRecorder::Record(CLatencyKey(ELatencyHandler, m_strName, strState, strEvent), m_Counters.GetSampleNs());
+      if(!createState.IsValid()) {
+         return;
+      }
+      const std::string                           strLeft(GetStateName(false));
+      const std::chrono::steady_clock::time_point start  (std::chrono::steady_clock::now());
+      ChangeState(createState);
+      const unsigned long long                    ns     (std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      CLatencyRecorder::Record(CLatencyKey(ELatencyStateChange, m_strName, strLeft, strEvent), ns);
+   }
+
+   /** Take all actions required to change the current state of the state machine
+    ** or of one of its regions.
     **
     ** This includes desctructing the current state (and unregistering all its event
     ** handlers) and constructing the new state.
     **/
    void CStateMachine::ChangeState(
-      const CCreateState& createState //< Class that describes the next state to be created. Class can describe that no new state has to be created, in which case the state machine remains in the same state.
+      const CCreateState& createState, //< Class that describes the next state to be created. Class can describe that no new state has to be created, in which case the state machine remains in the same state.
+      const size_t        region       //< The region changing state, 0 for the state machine's own state.
       )
    {
       //step 1: check if a state change is required
@@ -157,92 +548,389 @@ namespace ILULibStateMachine {
          return;
       }
       //yes, state change requested
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationTransition);
+      RUNTIME_STATS_ADD(m_Counters, ECounterTransitions, 1);
+      if(0 == region) {
+         m_TraceState = 0;
+      }
+      if(NULL != m_pTrace) {
+         m_pTrace->SetStateChange();
+      }
+      CStateRegion* const   pRegion (0 == region ? NULL : &m_Regions[region - 1]);
+      CState*&              pState  (NULL == pRegion ? m_pState      : pRegion->m_pState);
+      const CHandlerTable*& pShared (NULL == pRegion ? m_pSharedState : pRegion->m_pShared);
+      StateLevels&          parents (NULL == pRegion ? m_Parents     : pRegion->m_Parents);
+      m_ParentsKept = parents.size();
 
       //step 2: unregister state handlers
-      EventUnregister(false);
+      if(NULL == pRegion) {
+         EventUnregister(false);
+      } else {
+         if(NULL != pRegion->m_pHandlers) {
+            pRegion->m_pHandlers->Clear();
+         }
+         pShared = NULL;
+      }
 
       //step 3: delete existing state
       {
-         const std::string strStateName(GetStateName(false));
-         LogDebug("State-change destructing state [%s]\n", strStateName.c_str());
+         const bool        bDebug      (CLogLevelScope::IsEnabled(ELogLevelDebug));
+         const std::string strStateName(bDebug ? GetRegionStateName(region) : std::string());
+         if(bDebug) {
+            LogDebug("State-change destructing state [%s]\n", strStateName.c_str());
+         }
          {
-            CLogIndent logIndent;
-            delete m_pState;
+            CLogIndent logIndent(CLogLevelScope::IsIndented());
+            delete pState;
+         }
+         if(bDebug) {
+            LogDebug("State-change destructing state [%s] done\n", strStateName.c_str());
          }
-         LogDebug("State-change destructing state [%s] done\n", strStateName.c_str());
-         m_pState = NULL;
+         pState = NULL;
       }
 
       //step 4: create the new state
       //        store the new state
       //        when a 'CStateChangeException' occures, propagate to creating the next state
-      for(CCreateState createStateLoop = createState.Get() ; createStateLoop.IsValid() ; /* createStateLoop changed inside the loop */) {
+      for(CCreateState createStateLoop = createState ; createStateLoop.IsValid() ; /* createStateLoop changed inside the loop */) {
          try {
             CCreateState createStateTmp = createStateLoop;
             createStateLoop = CCreateState(); //make invalid (break loop)
-            LogDebug("State-change constructing new state\n");
+            const bool bDebug(CLogLevelScope::IsEnabled(ELogLevelDebug));
+            if(bDebug) {
+               LogDebug("State-change constructing new state\n");
+            }
             {
-               CLogIndent logIndent;
-               m_pState = createStateTmp.Get()(WPStateMachine(shared_from_this()));
+               CLogIndent logIndent(CLogLevelScope::IsIndented());
+               ChangeParents(createStateTmp, parents);
+               m_BuildRegion = region;
+               pState = CreateState(createStateTmp, pShared);
+               m_BuildRegion = 0;
+            }
+            if(bDebug) {
+               LogDebug("State-change constructing new state [%s] done\n", GetRegionStateName(region).c_str());
             }
-            LogDebug("State-change constructing new state [%s] done\n", GetStateName(false).c_str());
          } catch(CStateChangeException& ex) {
-            LogWarning("Caught state-change-exception while creating new state --> create next state: %s\n", ex.what());
+            m_BuildRegion = 0;
+            if(CLogLevelScope::IsEnabled(ELogLevelWarning)) {
+               LogWarning("Caught state-change-exception while creating new state --> create next state: %s\n", ex.what());
+            }
             createStateLoop = ex.GetCreateState();
          } catch(std::exception& ex) {
-            LogErr("Caught exeption while creating new state --> setting null-state (state machine finished): %s\n", ex.what());
-            m_pState = NULL;
+            m_BuildRegion = 0;
+            if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+               LogErr("Caught exeption while creating new state --> setting null-state (state machine finished): %s\n", ex.what());
+            }
+            pState = NULL;
+            ExitParents(parents, 0);
+         } catch(...) {
+            m_BuildRegion = 0;
+            if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+               LogErr("Caught exeption while creating new state --> setting null-state (state machine finished): %s\n", "unknown");
+            }
+            pState = NULL;
+            ExitParents(parents, 0);
+         }
+      }
+
+      //step 5: update the broadcast index with the state and the parents that changed
+      if(NULL != m_pBroadcast) {
+         m_pBroadcast->Update(*this, region, m_ParentsKept);
+      }
+   }
+
+   /** Make the active parents match the parents of the state to be
+    ** created next: exit the parents it does not share with the
+    ** current parents (innermost first), enter its missing parents
+    ** (outermost first).
+    **
+    ** Only the parents are changed: the current state has been deleted
+    ** already and the next state is created by the caller. A
+    ** CStateChangeException thrown by a parent constructor is propagated:
+    ** the parents entered so far remain active.
+    **/
+   void CStateMachine::ChangeParents(
+      const CCreateState& createState, //< Class that describes the state to be created next.
+      StateLevels&        parents      //< The active parents: of the state machine's own state or of a region.
+      )
+   {
+      //the depth of the next state
+      size_t depth(0);
+      for(const CStateParent* pParent = createState.GetParent() ; NULL != pParent ; pParent = pParent->m_pParent) {
+         ++depth;
+      }
+
+      //exit the parents not shared with the next state
+      size_t common(0);
+      while(common < depth && common < parents.size() && GetParentAt(createState, depth, common)->m_fCreateStateRaw == parents[common].m_Key) {
+         ++common;
+      }
+      ExitParents(parents, common);
+
+      //enter the missing parents
+      for(size_t level = common ; level < depth ; ++level) {
+         const CStateParent& parentInfo(*GetParentAt(createState, depth, level));
+         CStateLevel parent;
+         parent.m_pState    = NULL;
+         parent.m_pHandlers = NULL;
+         parent.m_pShared   = NULL;
+         parent.m_Key       = parentInfo.m_fCreateStateRaw;
+         const bool bDebug(CLogLevelScope::IsEnabled(ELogLevelDebug));
+         if(bDebug) {
+            LogDebug("State-change constructing parent state\n");
+         }
+         try {
+            CLogIndent logIndent(CLogLevelScope::IsIndented());
+            m_pBuildLevel = &parent;
+            parent.m_pState = CreateState(createState.CreateParent(parentInfo), parent.m_pShared);
+            m_pBuildLevel = NULL;
          } catch(...) {
-            LogErr("Caught exeption while creating new state --> setting null-state (state machine finished): %s\n", "unknown");
-            m_pState = NULL;
+            m_pBuildLevel = NULL;
+            EventDeleteTable(parent.m_pHandlers);
+            throw;
+         }
+         if(NULL == parent.m_pState) {
+            //a parent does not create a state: the chain stops here
+            EventDeleteTable(parent.m_pHandlers);
+            break;
+         }
+         if(bDebug) {
+            LogDebug("State-change constructing parent state [%s] done\n", parent.m_pState->GetName().c_str());
          }
+         parents.push_back(parent);
       }
    }
 
-   /** Get a reference to the event map for the current or default state.
+   /** Exit the active parents from the innermost up to (not including)
+    ** the given level: delete each parent state and the handlers it
+    ** registered.
     **/
-   CStateMachine::EventMap& CStateMachine::EventGetMap(
-      const bool bDefault //< When true get a reference to the default map; when false get a reference to the current map.
+   void CStateMachine::ExitParents(
+      StateLevels& parents, //< The active parents: of the state machine's own state or of a region.
+      const size_t keep     //< The number of (outermost) parents that remain active.
       )
    {
-      return bDefault ? m_EventMapDefault : m_EventMapState;
+      m_ParentsKept = std::min(m_ParentsKept, keep);
+      while(keep < parents.size()) {
+         CStateLevel&      parent      (parents.back());
+         const bool        bDebug      (CLogLevelScope::IsEnabled(ELogLevelDebug));
+         const std::string strStateName(bDebug ? parent.m_pState->GetName() : std::string());
+         if(bDebug) {
+            LogDebug("State-change destructing parent state [%s]\n", strStateName.c_str());
+         }
+         EventDeleteTable(parent.m_pHandlers);
+         {
+            CLogIndent logIndent(CLogLevelScope::IsIndented());
+            delete parent.m_pState;
+         }
+         if(bDebug) {
+            LogDebug("State-change destructing parent state [%s] done\n", strStateName.c_str());
+         }
+         parents.pop_back();
+      }
+   }
+
+   /** Get the number of levels of a region that registered handlers: its
+    ** current state and its parents, see CBroadcast.
+    **
+    ** @return 1 plus the number of active parents.
+    **/
+   size_t CStateMachine::EventKeyLevels(
+      const size_t region //< The region, 0 for the state machine's own state.
+      ) const
+   {
+      return 1 + (0 == region ? m_Parents : m_Regions[region - 1].m_Parents).size();
+   }
+
+   /** Append the event ID's and event-types 1 level of a region registered
+    ** handlers for, see CBroadcast.
+    **/
+   void CStateMachine::EventKeys(
+      const size_t              region,    //< The region, 0 for the state machine's own state.
+      const size_t              level,     //< 0 for the current state, 1 for the outermost parent and so on.
+      std::vector<SPEventBase>& events,    //< The event ID's are appended, duplicates included.
+      std::vector<std::string>& eventTypes //< The event-types are appended, duplicates included.
+      ) const
+   {
+      const CStateRegion* const pRegion(0 == region ? NULL : &m_Regions[region - 1]);
+      if(0 < level) {
+         EventKeysLevel((NULL == pRegion ? m_Parents : pRegion->m_Parents)[level - 1], events, eventTypes);
+         return;
+      }
+      const CHandlerTable* const tables[] = {
+         NULL == pRegion ? m_pHandlersState : pRegion->m_pHandlers,
+         NULL == pRegion ? m_pSharedState   : pRegion->m_pShared
+      };
+      for(size_t table = 0 ; table < sizeof(tables) / sizeof(tables[0]) ; ++table) {
+         if(NULL != tables[table]) {
+            tables[table]->EventKeys(events, eventTypes);
+         }
+      }
    }
 
-   /** Get a const reference to the event map for the current or default state.
+   /** Append the event ID's and event-types the default state registered
+    ** handlers for, see CBroadcast.
     **/
-   const CStateMachine::EventMap& CStateMachine::EventGetMap(
-      const bool bDefault //< When true get a reference to the default map; when false get a reference to the current map.
+   void CStateMachine::EventKeysDefault(
+      std::vector<SPEventBase>& events,    //< The event ID's are appended, duplicates included.
+      std::vector<std::string>& eventTypes //< The event-types are appended, duplicates included.
       ) const
    {
-      return bDefault ? m_EventMapDefault : m_EventMapState;
+      if(NULL != m_pHandlersDefault) {
+         m_pHandlersDefault->EventKeys(events, eventTypes);
+      }
+      if(NULL != m_pSharedDefault) {
+         m_pSharedDefault->EventKeys(events, eventTypes);
+      }
+   }
+
+   /** Count the event a region handled and make the state change its
+    ** handler requested.
+    **/
+   void CStateMachine::RegionHandled(
+      const size_t region //< The region (1 for the first region added).
+      )
+   {
+      CStateRegion& ref(m_Regions[region - 1]);
+      if(ref.m_bType) {
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsTypeState, 1);
+      } else {
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsState, 1);
+      }
+      const CCreateState next(ref.m_Next);
+      ref.m_Next     = CCreateState();
+      ref.m_bHandled = false;
+      ChangeState(next, region);
    }
 
-   /** Get a reference to the event-type map for the current or default state.
+   /** Create a state and attach its shared handler table.
+    **
+    ** When this is the first state machine constructing the state, the
+    ** shared registrations done by the state constructor fill the shared
+    ** table, which is sealed once the constructor succeeded. When the shared
+    ** table is already sealed, the state constructor skips its shared
+    ** registrations.
+    **
+    ** @return the newly created state, NULL for the finished state.
     **/
-   CStateMachine::EventTypeMap& CStateMachine::EventTypeGetMap(
-      const bool bDefault //< When true get a reference to the default map; when false get a reference to the current map.
+   CState* CStateMachine::CreateState(
+      const CCreateState&   createState, //< Class that describes the state to be created.
+      const CHandlerTable*& pSharedOut   //< Set to the shared handler table of the state (NULL when none) once it is created.
       )
    {
-      return bDefault ? m_EventTypeMapDefault : m_EventTypeMapState;
+      const FCreateStateRaw fSharedKey(createState.GetSharedKey());
+      bool                  bBuild    (false);
+      CHandlerTable* const  pShared   (NULL == fSharedKey ? NULL : CHandlerTable::SharedAcquire(fSharedKey, bBuild));
+      m_pSharedBuild  = bBuild ? pShared : NULL;
+      m_bSharedSealed = (NULL != pShared) && !bBuild;
+      CState* pState(NULL);
+      try {
+         Internal::CStateResourceScope stateResourceScope(m_pResource);
+         pState = createState.Create(WPStateMachine(shared_from_this()), m_pStateMachineData);
+      } catch(...) {
+         m_pSharedBuild  = NULL;
+         m_bSharedSealed = false;
+         if(bBuild) {
+            CHandlerTable::SharedRelease(fSharedKey, false);
+         }
+         throw;
+      }
+      m_pSharedBuild  = NULL;
+      m_bSharedSealed = false;
+      if(bBuild) {
+         CHandlerTable::SharedRelease(fSharedKey, true);
+      }
+      pSharedOut = pShared;
+      return pState;
    }
 
-   /** Get a const reference to the event-type map for the current or default state.
+   /** Check whether a shared registration for the state under construction
+    ** can be skipped because its shared table is already sealed.
+    **
+    ** Lets the caller skip building the event identification for the registration.
+    **
+    ** @return true when the registration can be skipped.
     **/
-   const CStateMachine::EventTypeMap& CStateMachine::EventTypeGetMap(
-      const bool bDefault //< When true get a reference to the default map; when false get a reference to the current map.
+   bool CStateMachine::EventSharedSealed(
+      const CCreateState& createState //< The state transition accompanying the registration.
       ) const
    {
-      return bDefault ? m_EventTypeMapDefault : m_EventTypeMapState;
+      return m_bSharedSealed && createState.IsShareable();
+   }
+
+   /** Get the table a registration has to be stored in.
+    **
+    ** Shared registrations go to the shared table when the state under
+    ** construction is building it. Everything else goes to the table of
+    ** this instance, which is allocated on the first registration: the
+    ** table of the parent or region under construction, if any, for the
+    ** registrations of the current state.
+    **
+    ** @return the table; NULL when the registration is already present in a sealed shared table.
+    **/
+   CHandlerTable* CStateMachine::EventGetTable(
+      const bool          bDefault,   //< When true get the table of the default state; when false get the table of the current state.
+      const bool          bShared,    //< The registration uses a shared handler.
+      const CCreateState& createState //< The state transition accompanying the registration.
+      )
+   {
+      if(bShared && createState.IsShareable()) {
+         if(m_bSharedSealed) {
+            return NULL;
+         }
+         if(NULL != m_pSharedBuild) {
+            return m_pSharedBuild;
+         }
+      }
+      CHandlerTable*& pTable(bDefault                ? m_pHandlersDefault           :
+                             NULL != m_pBuildLevel   ? m_pBuildLevel->m_pHandlers   :
+                             0 != m_BuildRegion      ? m_Regions[m_BuildRegion - 1].m_pHandlers :
+                                                       m_pHandlersState);
+      if(NULL == pTable) {
+         pTable = new(MemoryAllocate(m_pResource, sizeof(CHandlerTable), alignof(CHandlerTable))) CHandlerTable(m_pResource);
+      }
+      return pTable;
+   }
+
+   /** Destruct and free a handler table allocated by EventGetTable.
+    **/
+   void CStateMachine::EventDeleteTable(
+      CHandlerTable* const pTable //< The table, can be NULL.
+      )
+   {
+      if(NULL == pTable) {
+         return;
+      }
+      pTable->~CHandlerTable();
+      MemoryDeallocate(m_pResource, pTable, sizeof(CHandlerTable), alignof(CHandlerTable));
    }
 
-   /** Unregister all events for the current or default state.
+   /** Unregister all events and event-types for the current or default state.
     **/
    void CStateMachine::EventUnregister(
       const bool bDefault //< When true unregister handlers belonging to the default state; when false unregister handlers belonging to the current state.
       )
    {
-      EventMap& map = EventGetMap(bDefault);
-      map.clear();
+      CHandlerTable* const pTable(bDefault ? m_pHandlersDefault : m_pHandlersState);
+      if(NULL != pTable) {
+         pTable->Clear();
+      }
+      (bDefault ? m_pSharedDefault : m_pSharedState) = NULL;
+   }
+
+   /** Deal with an event without a matching handler: count it and pass
+    ** it to the dead letters (see CUnhandledEvents), trace all registered
+    ** handlers unless that has been done recently for the same state and
+    ** event.
+    **/
+   void CStateMachine::EventUnhandled(
+      const CEventBase& event //< The event.
+      ) const
+   {
+      static const std::string s_strNoState("no current state");
+      if(CUnhandledEvents::Record(*this, NULL == m_pState ? s_strNoState : m_pState->GetName(), event) && CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+         TraceAll();
+      }
    }
 
    /** Trace all registered handlers.
@@ -258,42 +946,125 @@ namespace ILULibStateMachine {
       TraceHandlers(true);
       TraceTypeHandlers(false);
       TraceTypeHandlers(true);
+      for(size_t region = 0 ; region < m_Regions.size() ; ++region) {
+         const CStateRegion& ref(m_Regions[region]);
+         LogDebug("Region [%s] state [%s]:\n", ref.m_strName.c_str(), GetRegionStateName(region + 1).c_str());
+         TraceHandlers    (GetRegionStateName(region + 1), ref.m_pHandlers, ref.m_pShared);
+         TraceTypeHandlers(GetRegionStateName(region + 1), ref.m_pHandlers, ref.m_pShared);
+         for(size_t level = ref.m_Parents.size() ; 0 < level ; --level) {
+            const CStateLevel& parent(ref.m_Parents[level - 1]);
+            TraceHandlers    (parent.m_pState->GetName(), parent.m_pHandlers, parent.m_pShared);
+            TraceTypeHandlers(parent.m_pState->GetName(), parent.m_pHandlers, parent.m_pShared);
+         }
+      }
    }
 
-   /** Trace all event handlers registered for the default or current state.
+   /** Trace all event handlers registered for the default or current state
+    ** (the current state followed by its parents, innermost first).
     **/
    void CStateMachine::TraceHandlers(
       const bool bDefault //< When true trace handlers belonging to the default state; when false trace handlers belonging to the current state.
       ) const
+   {
+      if(bDefault) {
+         TraceHandlers(GetStateName(true), m_pHandlersDefault, m_pSharedDefault);
+         return;
+      }
+      TraceHandlers(GetStateName(false), m_pHandlersState, m_pSharedState);
+      for(size_t level = m_Parents.size() ; 0 < level ; --level) {
+         const CStateLevel& parent(m_Parents[level - 1]);
+         TraceHandlers(parent.m_pState->GetName(), parent.m_pHandlers, parent.m_pShared);
+      }
+   }
+
+   /** Trace all event handlers registered for one state.
+    **/
+   void CStateMachine::TraceHandlers(
+      const std::string&         strState, //< Name of the state.
+      const CHandlerTable* const pTable,   //< Handlers registered by the state, can be NULL.
+      const CHandlerTable* const pShared   //< Shared handlers of the state, can be NULL.
+      ) const
    {
       CLogIndent logIndent1;
-      const EventMap& map = EventGetMap(bDefault);
-      LogDebug("%s event handlers (%lu):\n", GetStateName(bDefault).c_str(), (long unsigned int)map.size());
+      const size_t count((NULL == pTable ? 0 : pTable->EventCount()) + (NULL == pShared ? 0 : pShared->EventCount()));
+      LogDebug("%s event handlers (%lu):\n", strState.c_str(), (long unsigned int)count);
       {
          CLogIndent logIndent2;
-         for(EventMapCIt cit = map.begin() ; map.end() != cit ; ++cit) {
-            LogDebug("ID [%s] event type [%s] with data type [%s])\n", cit->first->GetId().c_str(), cit->first->GetIdType().c_str(), cit->first->GetDataType().c_str());
+         if(NULL != pTable) {
+            pTable->TraceHandlers();
+         }
+         if(NULL != pShared) {
+            pShared->TraceHandlers();
          }
       }
    }
 
-   /** Trace all event type handlers registered for the default or current state.
+   /** Trace all event type handlers registered for the default or current
+    ** state (the current state followed by its parents, innermost first).
     **/
    void CStateMachine::TraceTypeHandlers(
       const bool bDefault //< When true trace handlers belonging to the default state; when false trace handlers belonging to the current state.
       ) const
+   {
+      if(bDefault) {
+         TraceTypeHandlers(GetStateName(true), m_pHandlersDefault, m_pSharedDefault);
+         return;
+      }
+      TraceTypeHandlers(GetStateName(false), m_pHandlersState, m_pSharedState);
+      for(size_t level = m_Parents.size() ; 0 < level ; --level) {
+         const CStateLevel& parent(m_Parents[level - 1]);
+         TraceTypeHandlers(parent.m_pState->GetName(), parent.m_pHandlers, parent.m_pShared);
+      }
+   }
+
+   /** Trace all event type handlers registered for one state.
+    **/
+   void CStateMachine::TraceTypeHandlers(
+      const std::string&         strState, //< Name of the state.
+      const CHandlerTable* const pTable,   //< Handlers registered by the state, can be NULL.
+      const CHandlerTable* const pShared   //< Shared handlers of the state, can be NULL.
+      ) const
    {
       CLogIndent logIndent1;
-      const EventTypeMap& map = EventTypeGetMap(bDefault);
-      LogDebug("%s event type handlers (%lu):\n", GetStateName(bDefault).c_str(), (long unsigned int)map.size());
+      const size_t count((NULL == pTable ? 0 : pTable->EventTypeCount()) + (NULL == pShared ? 0 : pShared->EventTypeCount()));
+      LogDebug("%s event type handlers (%lu):\n", strState.c_str(), (long unsigned int)count);
       {
          CLogIndent logIndent2;
-         for(EventTypeMapCIt cit = map.begin() ; map.end() != cit ; ++cit) {
-            LogDebug("%s\n", cit->first.c_str());
+         if(NULL != pTable) {
+            pTable->TraceTypeHandlers();
+         }
+         if(NULL != pShared) {
+            pShared->TraceTypeHandlers();
          }
       }
    }
 
+   /** Get the ID of this state machine in the trace, registered when
+    ** it is traced for the first time.
+    **
+    ** @return the state machine ID.
+    **/
+   uint32_t CStateMachine::GetTraceId(void)
+   {
+      if(0 == m_TraceId) {
+         m_TraceId = CTrace::RegisterMachine(m_strName);
+      }
+      return m_TraceId;
+   }
+
+   /** Get the trace name ID of the current state, registered when it is
+    ** traced for the first time.
+    **
+    ** @return the name ID, 0 when there is no current state.
+    **/
+   uint32_t CStateMachine::GetTraceState(void)
+   {
+      if(0 == m_TraceState && NULL != m_pState) {
+         m_TraceState = CTrace::RegisterName(m_pState->GetName());
+      }
+      return m_TraceState;
+   }
+
    /** Get the name of the default or current state.
     **
     ** The function handles state machines without a default state.
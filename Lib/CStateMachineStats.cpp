@@ -0,0 +1,185 @@
+/** @file
+ ** @brief The CStateMachineStats, CStateMachineCounters and CStateMachineRegistry definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <mutex>
+
+#include "Include/CStateMachine.h"
+#include "Include/CStateMachineStats.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** Protects the registry.
+       **/
+      std::mutex     s_RegistryMutex;
+
+      /** First state machine of the registry, NULL when empty.
+       **/
+      CStateMachine* s_pRegistryFirst = NULL;
+
+      /** Number of state machines in the registry.
+       **/
+      unsigned int   s_RegistryCount = 0;
+   }
+
+   /** Constructor: all counters 0.
+    **/
+   CStateMachineStats::CStateMachineStats(void)
+      : m_EventsState      (0)
+      , m_EventsDefault    (0)
+      , m_EventsTypeState  (0)
+      , m_EventsTypeDefault(0)
+      , m_EventsUnhandled  (0)
+      , m_GuardsEvaluated  (0)
+      , m_GuardsPassed     (0)
+      , m_Transitions      (0)
+      , m_Exceptions       (0)
+      , m_HandlerNs        (0)
+   {
+   }
+
+   std::atomic<bool> CStateMachineCounters::s_bHandlerTiming(false);
+
+   /** Constructor: all counters 0.
+    **/
+   CStateMachineCounters::CStateMachineCounters(void)
+      : m_bSampling(false)
+      , m_SampleNs (0    )
+      , m_Guard    (0    )
+   {
+      for(unsigned int i = 0 ; i < ECounterCount ; ++i) {
+         m_Counters[i].store(0, std::memory_order_relaxed);
+      }
+   }
+
+   /** Indicates whether the library collects runtime statistics (not
+    ** compiled with NO_RUNTIME_STATS).
+    **
+    ** @return true when the statistics are collected.
+    **/
+   bool CStateMachineCounters::IsEnabled(void)
+   {
+#ifndef NO_RUNTIME_STATS
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   /** Enable or disable measuring the handler time of all state machines
+    ** (disabled by default).
+    **/
+   void CStateMachineCounters::EnableHandlerTiming(
+      const bool bEnable //< true to enable, false to disable.
+      )
+   {
+      s_bHandlerTiming.store(bEnable, std::memory_order_relaxed);
+   }
+
+   /** Take a snapshot of the counters.
+    **
+    ** @return the snapshot.
+    **/
+   CStateMachineStats CStateMachineCounters::Get(void) const
+   {
+      CStateMachineStats stats;
+      stats.m_EventsState       = m_Counters[ECounterEventsState      ].load(std::memory_order_relaxed);
+      stats.m_EventsDefault     = m_Counters[ECounterEventsDefault    ].load(std::memory_order_relaxed);
+      stats.m_EventsTypeState   = m_Counters[ECounterEventsTypeState  ].load(std::memory_order_relaxed);
+      stats.m_EventsTypeDefault = m_Counters[ECounterEventsTypeDefault].load(std::memory_order_relaxed);
+      stats.m_EventsUnhandled   = m_Counters[ECounterEventsUnhandled  ].load(std::memory_order_relaxed);
+      stats.m_GuardsEvaluated   = m_Counters[ECounterGuardsEvaluated  ].load(std::memory_order_relaxed);
+      stats.m_GuardsPassed      = m_Counters[ECounterGuardsPassed     ].load(std::memory_order_relaxed);
+      stats.m_Transitions       = m_Counters[ECounterTransitions      ].load(std::memory_order_relaxed);
+      stats.m_Exceptions        = m_Counters[ECounterExceptions       ].load(std::memory_order_relaxed);
+      stats.m_HandlerNs         = m_Counters[ECounterHandlerNs        ].load(std::memory_order_relaxed);
+      return stats;
+   }
+
+   /** Add the counters of another instance and reset them, e.g. the
+    ** counters a region of the state machine used on a thread of a pool
+    ** (see CThreadPool). Nobody may write to the other instance meanwhile.
+    **/
+   void CStateMachineCounters::Merge(
+      CStateMachineCounters& ref //< The counters to add, 0 afterwards.
+      )
+   {
+      for(unsigned int i = 0 ; i < ECounterCount ; ++i) {
+         Add(static_cast<ECounter>(i), ref.m_Counters[i].exchange(0, std::memory_order_relaxed));
+      }
+   }
+
+   /** Get the number of live state machines.
+    **
+    ** @return the number of state machines.
+    **/
+   unsigned int CStateMachineRegistry::GetCount(void)
+   {
+      std::lock_guard<std::mutex> lock(s_RegistryMutex);
+      return s_RegistryCount;
+   }
+
+   /** Call a function for each live state machine, holding the registry
+    ** lock.
+    **/
+   void CStateMachineRegistry::ForEach(
+      TYPESEL::function<void(const CStateMachine&)> callback //< Function to call.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_RegistryMutex);
+      for(const CStateMachine* p = s_pRegistryFirst ; NULL != p ; p = p->m_pRegistryNext) {
+         callback(*p);
+      }
+   }
+
+   /** Add a state machine to the registry.
+    **/
+   void CStateMachineRegistry::Register(
+      CStateMachine* const pStateMachine //< The state machine to add.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_RegistryMutex);
+      pStateMachine->m_pRegistryPrev = NULL;
+      pStateMachine->m_pRegistryNext = s_pRegistryFirst;
+      if(NULL != s_pRegistryFirst) {
+         s_pRegistryFirst->m_pRegistryPrev = pStateMachine;
+      }
+      s_pRegistryFirst = pStateMachine;
+      ++s_RegistryCount;
+   }
+
+   /** Remove a state machine from the registry.
+    **/
+   void CStateMachineRegistry::Unregister(
+      CStateMachine* const pStateMachine //< The state machine to remove.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_RegistryMutex);
+      if(NULL != pStateMachine->m_pRegistryPrev) {
+         pStateMachine->m_pRegistryPrev->m_pRegistryNext = pStateMachine->m_pRegistryNext;
+      } else {
+         s_pRegistryFirst = pStateMachine->m_pRegistryNext;
+      }
+      if(NULL != pStateMachine->m_pRegistryNext) {
+         pStateMachine->m_pRegistryNext->m_pRegistryPrev = pStateMachine->m_pRegistryPrev;
+      }
+      --s_RegistryCount;
+   }
+}
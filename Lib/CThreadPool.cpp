@@ -0,0 +1,156 @@
+/** @file
+ ** @brief The CThreadPool definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "Include/CThreadPool.h"
+
+namespace ILULibStateMachine {
+   /** @brief The progress of 1 call to CThreadPool::Run, protected by the
+    ** mutex of the pool.
+    **/
+   class CThreadPool::CBatch {
+      public:
+         CBatch(const size_t count, const FTask& task)
+            : m_Task (task )
+            , m_Count(count)
+            , m_Next (0    )
+            , m_Done (0    )
+         {
+         }
+
+      public:
+         const FTask& m_Task;  ///< The task.
+         const size_t m_Count; ///< Number of indexes.
+         size_t       m_Next;  ///< Next index to be started.
+         size_t       m_Done;  ///< Number of indexes finished.
+   };
+
+   /** Constructor: start the threads.
+    **/
+   CThreadPool::CThreadPool(
+      const unsigned int threads //< Number of threads, next to the threads calling Run.
+      )
+      : m_Mutex  ()
+      , m_Wakeup ()
+      , m_Done   ()
+      , m_Batches()
+      , m_bStop  (false)
+      , m_Threads()
+   {
+      m_Threads.reserve(threads);
+      for(unsigned int i = 0 ; i < threads ; ++i) {
+         m_Threads.push_back(std::thread(&CThreadPool::Worker, this));
+      }
+   }
+
+   /** Destructor: stop and join the threads.
+    **/
+   CThreadPool::~CThreadPool(void)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_Mutex);
+         m_bStop = true;
+      }
+      m_Wakeup.notify_all();
+      for(std::vector<std::thread>::iterator it = m_Threads.begin() ; m_Threads.end() != it ; ++it) {
+         it->join();
+      }
+   }
+
+   /** Get the number of threads of the pool.
+    **
+    ** @return the number of threads, next to the threads calling Run.
+    **/
+   unsigned int CThreadPool::GetThreadCount(void) const
+   {
+      return static_cast<unsigned int>(m_Threads.size());
+   }
+
+   /** Run a task for the indexes 0 up to count on the threads of the pool
+    ** and the calling thread, return when all have finished.
+    **
+    ** Exceptions thrown by the task are caught and ignored: the task is
+    ** expected to deal with them.
+    **/
+   void CThreadPool::Run(
+      const size_t count, //< Number of indexes.
+      const FTask& task   //< The task.
+      )
+   {
+      if(0 == count) {
+         return;
+      }
+      CBatch                       batch(count, task);
+      std::unique_lock<std::mutex> lock (m_Mutex);
+      m_Batches.push_back(&batch);
+      m_Wakeup.notify_all();
+      while(batch.m_Next < batch.m_Count) {
+         RunOne(lock, batch);
+      }
+      while(batch.m_Done < batch.m_Count) {
+         m_Done.wait(lock);
+      }
+   }
+
+   /** The thread function of the workers: run tasks until stopped.
+    **/
+   void CThreadPool::Worker(void)
+   {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      for(;;) {
+         while(!m_bStop && m_Batches.empty()) {
+            m_Wakeup.wait(lock);
+         }
+         if(m_Batches.empty()) {
+            return;
+         }
+         RunOne(lock, *m_Batches.front());
+      }
+   }
+
+   /** Start the next index of a batch and run it without holding the lock.
+    **
+    ** The batch is removed from the list once its last index is started.
+    **/
+   void CThreadPool::RunOne(
+      std::unique_lock<std::mutex>& lock, //< The lock on m_Mutex, held when called and when returning.
+      CBatch&                       batch //< The batch, with indexes not started yet.
+      )
+   {
+      const size_t index(batch.m_Next++);
+      if(batch.m_Count == batch.m_Next) {
+         for(std::deque<CBatch*>::iterator it = m_Batches.begin() ; m_Batches.end() != it ; ++it) {
+            if(&batch == *it) {
+               m_Batches.erase(it);
+               break;
+            }
+         }
+      }
+      lock.unlock();
+      try {
+         batch.m_Task(index);
+      } catch(...) {
+      }
+      lock.lock();
+      if(batch.m_Count == ++batch.m_Done) {
+         m_Done.notify_all();
+      }
+   }
+}
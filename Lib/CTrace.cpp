@@ -0,0 +1,369 @@
+/** @file
+ ** @brief The CTrace, CTraceRecord and CStateMachineTrace definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "Include/CEventBase.h"
+#include "Include/CStateMachine.h"
+#include "Include/CTrace.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** Records of 1 thread.
+       **/
+      typedef std::vector<CTraceRecord> Records;
+
+      /** @brief The trace buffer of 1 thread.
+       **
+       ** Only the owning thread writes, m_Next is published after the
+       ** record has been written.
+       **/
+      class CThreadTrace {
+         public:
+            CThreadTrace(void);
+            ~CThreadTrace(void);
+
+         public:
+            void                            Copy(Records& records) const;
+
+         public:
+            uint32_t                        m_Thread;  ///< Thread index in the dump.
+            Records                         m_Records; ///< The ring, allocated upon the first record.
+            std::atomic<unsigned long long> m_Next;    ///< Number of records written so far.
+      };
+
+      /** Protects all data below.
+       **/
+      std::mutex                            s_Mutex;
+
+      /** Threads that have traced.
+       **/
+      std::set<CThreadTrace*>               s_Threads;
+
+      /** Records of the finished threads, per thread index.
+       **/
+      std::map<uint32_t, Records>           s_Finished;
+
+      /** Names (index + 1 is the ID).
+       **/
+      std::vector<std::string>              s_Names;
+
+      /** Name ID's.
+       **/
+      std::map<std::string, uint32_t>       s_NameIds;
+
+      /** Name ID per state machine (index + 1 is the state machine ID).
+       **/
+      std::vector<uint32_t>                 s_Machines;
+
+      /** Index of the next thread.
+       **/
+      uint32_t                              s_NextThread = 1;
+
+      /** Number of records of the thread buffers created from now on.
+       **/
+      std::atomic<uint32_t>                 s_Capacity(CTrace::DEFAULT_CAPACITY);
+
+      /** Register a name, s_Mutex locked.
+       **
+       ** @return the name ID.
+       **/
+      uint32_t RegisterNameLocked(
+         const std::string& strName //< The name.
+         )
+      {
+         std::map<std::string, uint32_t>::const_iterator cit(s_NameIds.find(strName));
+         if(s_NameIds.end() != cit) {
+            return cit->second;
+         }
+         s_Names.push_back(strName);
+         const uint32_t id(static_cast<uint32_t>(s_Names.size()));
+         s_NameIds[strName] = id;
+         return id;
+      }
+
+      /** Write a block of memory.
+       **
+       ** @return true on success.
+       **/
+      bool Write(
+         FILE* const       pFile, //< The file.
+         const void* const p,     //< The data.
+         const size_t      size   //< Number of bytes.
+         )
+      {
+         return 0 == size || 1 == fwrite(p, size, 1, pFile);
+      }
+
+      /** Write a 32-bit value.
+       **
+       ** @return true on success.
+       **/
+      bool Write(
+         FILE* const    pFile, //< The file.
+         const uint32_t value  //< The value.
+         )
+      {
+         return Write(pFile, &value, sizeof(value));
+      }
+
+      /** Write the records of 1 thread.
+       **
+       ** @return true on success.
+       **/
+      bool Write(
+         FILE* const    pFile,   //< The file.
+         const uint32_t thread,  //< Thread index.
+         const Records& records  //< The records, oldest first.
+         )
+      {
+         return Write(pFile, thread)
+            && Write(pFile, static_cast<uint32_t>(records.size()))
+            && Write(pFile, records.data(), records.size() * sizeof(CTraceRecord));
+      }
+
+      /** Constructor: register the thread.
+       **/
+      CThreadTrace::CThreadTrace(void)
+         : m_Thread (0)
+         , m_Records()
+         , m_Next   (0)
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         m_Thread = s_NextThread++;
+         s_Threads.insert(this);
+      }
+
+      /** Destructor: keep the records of the thread.
+       **/
+      CThreadTrace::~CThreadTrace(void)
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         s_Threads.erase(this);
+         if(0 != m_Next.load(std::memory_order_relaxed)) {
+            Copy(s_Finished[m_Thread]);
+         }
+      }
+
+      /** Copy the records, oldest first.
+       **/
+      void CThreadTrace::Copy(
+         Records& records //< Destination.
+         ) const
+      {
+         const unsigned long long next(m_Next.load(std::memory_order_acquire));
+         if(0 == next) {
+            //nothing written, the ring might not even be allocated
+            return;
+         }
+         const unsigned long long capacity(m_Records.size());
+         const unsigned long long first   (capacity < next ? next - capacity : 0);
+         records.reserve(records.size() + (next - first));
+         for(unsigned long long i = first ; i < next ; ++i) {
+            records.push_back(m_Records[i % capacity]);
+         }
+      }
+
+      /** The trace buffer of the calling thread, created upon first use.
+       **/
+      thread_local CThreadTrace tl_Trace;
+   }
+
+   const char CTrace::MAGIC[9] = "ILUSMTR1";
+
+   std::atomic<bool> CTrace::s_bEnabled(false);
+
+   /** Get the name of a dispatch kind.
+    **
+    ** @return the name.
+    **/
+   const char* CTraceRecord::GetKindName(
+      const ETraceKind kind //< The kind.
+      )
+   {
+      switch(kind) {
+         case ETraceKindState:       return "state";
+         case ETraceKindDefault:     return "default";
+         case ETraceKindTypeState:   return "type-state";
+         case ETraceKindTypeDefault: return "type-default";
+         case ETraceKindUnhandled:   return "unhandled";
+         default:                    return "unknown";
+      }
+   }
+
+   /** Enable or disable tracing (disabled by default).
+    **/
+   void CTrace::Enable(
+      const bool bEnable //< true to enable, false to disable.
+      )
+   {
+      s_bEnabled.store(bEnable, std::memory_order_relaxed);
+   }
+
+   /** Set the number of records of the trace buffers created from now on
+    ** (a thread creates its buffer when it records for the first time).
+    **/
+   void CTrace::SetCapacity(
+      const uint32_t records //< Number of records, at least 1.
+      )
+   {
+      s_Capacity.store(0 == records ? 1 : records, std::memory_order_relaxed);
+   }
+
+   /** Register a state machine.
+    **
+    ** @return the state machine ID.
+    **/
+   uint32_t CTrace::RegisterMachine(
+      const std::string& strName //< State machine name.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_Machines.push_back(RegisterNameLocked(strName));
+      return static_cast<uint32_t>(s_Machines.size());
+   }
+
+   /** Register a name (state, event type).
+    **
+    ** @return the name ID, the same for the same name.
+    **/
+   uint32_t CTrace::RegisterName(
+      const std::string& strName //< The name.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      return RegisterNameLocked(strName);
+   }
+
+   /** Add a record to the trace buffer of the calling thread.
+    **/
+   void CTrace::Record(
+      const CTraceRecord& record //< The record.
+      )
+   {
+      CThreadTrace& thread(tl_Trace);
+      if(thread.m_Records.empty()) {
+         //the size is only changed here, while m_Next is 0: readers copy nothing
+         thread.m_Records.resize(s_Capacity.load(std::memory_order_relaxed));
+      }
+      const unsigned long long next(thread.m_Next.load(std::memory_order_relaxed));
+      thread.m_Records[next % thread.m_Records.size()] = record;
+      thread.m_Next.store(next + 1, std::memory_order_release);
+   }
+
+   /** Write the trace to a file.
+    **
+    ** Layout (native byte order): MAGIC (8 bytes); the number of names and
+    ** per name its length and characters (the ID is the index + 1); the
+    ** number of state machines and per state machine its name ID (the ID
+    ** is the index + 1); the number of threads and per thread its index,
+    ** the number of records and the records (oldest first).
+    **
+    ** @return true on success.
+    **/
+   bool CTrace::Dump(
+      const char* const szFile //< Path of the file to write.
+      )
+   {
+      FILE* const pFile(fopen(szFile, "wb"));
+      if(NULL == pFile) {
+         return false;
+      }
+      bool bOk(Write(pFile, MAGIC, 8));
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         bOk = bOk && Write(pFile, static_cast<uint32_t>(s_Names.size()));
+         for(std::vector<std::string>::const_iterator cit = s_Names.begin() ; bOk && s_Names.end() != cit ; ++cit) {
+            bOk = Write(pFile, static_cast<uint32_t>(cit->size())) && Write(pFile, cit->data(), cit->size());
+         }
+         bOk = bOk && Write(pFile, static_cast<uint32_t>(s_Machines.size()));
+         for(std::vector<uint32_t>::const_iterator cit = s_Machines.begin() ; bOk && s_Machines.end() != cit ; ++cit) {
+            bOk = Write(pFile, *cit);
+         }
+         bOk = bOk && Write(pFile, static_cast<uint32_t>(s_Finished.size() + s_Threads.size()));
+         for(std::map<uint32_t, Records>::const_iterator cit = s_Finished.begin() ; bOk && s_Finished.end() != cit ; ++cit) {
+            bOk = Write(pFile, cit->first, cit->second);
+         }
+         for(std::set<CThreadTrace*>::const_iterator cit = s_Threads.begin() ; bOk && s_Threads.end() != cit ; ++cit) {
+            Records records;
+            (*cit)->Copy(records);
+            bOk = Write(pFile, (*cit)->m_Thread, records);
+         }
+      }
+      return 0 == fclose(pFile) && bOk;
+   }
+
+   /** Drop the records of all threads, the registered names are kept.
+    **
+    ** Only call while no events are being dispatched.
+    **/
+   void CTrace::Clear(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_Finished.clear();
+      for(std::set<CThreadTrace*>::const_iterator cit = s_Threads.begin() ; s_Threads.end() != cit ; ++cit) {
+         (*cit)->m_Next.store(0, std::memory_order_release);
+      }
+   }
+
+   /** Start the record: everything known before the event is handled.
+    **/
+   void CStateMachineTrace::Start(
+      const CEventBase& event //< The event.
+      )
+   {
+      m_Record.m_TimestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      m_Record.m_Machine     = m_StateMachine.GetTraceId();
+      m_Record.m_State       = m_StateMachine.GetTraceState();
+      m_Record.m_Target      = CTraceRecord::TARGET_NONE;
+      m_Record.m_DurationNs  = 0;
+      m_Record.m_Kind        = ETraceKindUnhandled;
+      m_Record.m_Guard       = CTraceRecord::GUARD_NONE;
+      m_Record.m_Reserved    = 0;
+      event.TraceKey(m_Record);
+      m_pPrevious                 = m_StateMachine.m_pTrace;
+      m_StateMachine.m_pTrace     = this;
+      m_StateMachine.m_Counters.SetGuard(CTraceRecord::GUARD_NONE);
+   }
+
+   /** Complete the record and add it to the trace.
+    **/
+   void CStateMachineTrace::Stop(void)
+   {
+      const uint64_t now(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+      const uint64_t duration(now - m_Record.m_TimestampNs);
+      m_Record.m_DurationNs = 0xFFFFFFFF < duration ? 0xFFFFFFFF : static_cast<uint32_t>(duration);
+      if(ETraceKindUnhandled != m_Record.m_Kind) {
+         const unsigned int guard(m_StateMachine.m_Counters.GetGuard());
+         m_Record.m_Guard = CTraceRecord::GUARD_NONE < guard ? CTraceRecord::GUARD_NONE : static_cast<uint8_t>(guard);
+      }
+      if(m_bStateChange) {
+         m_Record.m_Target = m_StateMachine.HasFinished() ? CTraceRecord::TARGET_FINISHED : m_StateMachine.GetTraceState();
+      }
+      m_StateMachine.m_pTrace = m_pPrevious;
+      CTrace::Record(m_Record);
+   }
+}
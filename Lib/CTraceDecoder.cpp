@@ -0,0 +1,335 @@
+/** @file
+ ** @brief The CTraceDecoder definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Include/CTrace.h"
+#include "Include/CTraceDecoder.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** @brief A record and the thread that recorded it.
+       **/
+      class CThreadRecord {
+         public:
+            CThreadRecord(const uint32_t thread, const CTraceRecord& record)
+               : m_Thread(thread)
+               , m_Record(record)
+            {
+            }
+
+         public:
+            bool operator<(const CThreadRecord& ref) const
+            {
+               return m_Record.m_TimestampNs < ref.m_Record.m_TimestampNs;
+            }
+
+         public:
+            uint32_t     m_Thread; ///< Thread index.
+            CTraceRecord m_Record; ///< The record.
+      };
+
+      /** @brief The contents of a dump.
+       **/
+      class CDump {
+         public:
+            bool                       Read(std::istream& in, std::string& strError);
+            const std::string&         GetName(const uint32_t id) const;
+            std::string                GetMachine(const uint32_t id) const;
+            std::string                GetEvent(const CTraceRecord& record) const;
+            std::string                GetTarget(const CTraceRecord& record) const;
+
+         public:
+            std::vector<std::string>   m_Names;    ///< Names, index + 1 is the ID.
+            std::vector<uint32_t>      m_Machines; ///< Name ID per state machine, index + 1 is the ID.
+            std::vector<CThreadRecord> m_Records;  ///< All records, in time order.
+      };
+
+      /** Read a 32-bit value.
+       **
+       ** @return true on success.
+       **/
+      bool ReadValue(
+         std::istream& in,   //< The dump.
+         uint32_t&     value //< The value read.
+         )
+      {
+         return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+      }
+
+      /** Read the dump.
+       **
+       ** @return true on success, false when the dump is invalid.
+       **/
+      bool CDump::Read(
+         std::istream& in,      //< The dump.
+         std::string&  strError //< Reason when the dump is invalid.
+         )
+      {
+         char magic[8];
+         if(!in.read(magic, sizeof(magic)) || 0 != memcmp(magic, CTrace::MAGIC, sizeof(magic))) {
+            strError = "not a state machine trace dump";
+            return false;
+         }
+         uint32_t count(0);
+         if(!ReadValue(in, count)) {
+            strError = "truncated name table";
+            return false;
+         }
+         for(uint32_t i = 0 ; i < count ; ++i) {
+            uint32_t size(0);
+            if(!ReadValue(in, size)) {
+               strError = "truncated name table";
+               return false;
+            }
+            std::string strName(size, '\0');
+            if(0 != size && !in.read(&strName[0], size)) {
+               strError = "truncated name table";
+               return false;
+            }
+            m_Names.push_back(strName);
+         }
+         if(!ReadValue(in, count)) {
+            strError = "truncated state machine table";
+            return false;
+         }
+         m_Machines.resize(count);
+         for(uint32_t i = 0 ; i < count ; ++i) {
+            if(!ReadValue(in, m_Machines[i])) {
+               strError = "truncated state machine table";
+               return false;
+            }
+         }
+         if(!ReadValue(in, count)) {
+            strError = "truncated thread table";
+            return false;
+         }
+         for(uint32_t i = 0 ; i < count ; ++i) {
+            uint32_t thread (0);
+            uint32_t records(0);
+            if(!ReadValue(in, thread) || !ReadValue(in, records)) {
+               strError = "truncated thread table";
+               return false;
+            }
+            for(uint32_t j = 0 ; j < records ; ++j) {
+               CTraceRecord record;
+               if(!in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+                  strError = "truncated records";
+                  return false;
+               }
+               m_Records.push_back(CThreadRecord(thread, record));
+            }
+         }
+         std::stable_sort(m_Records.begin(), m_Records.end());
+         return true;
+      }
+
+      /** Get a name.
+       **
+       ** @return the name, "?" for an unknown ID.
+       **/
+      const std::string& CDump::GetName(
+         const uint32_t id //< Name ID.
+         ) const
+      {
+         static const std::string s_strUnknown("?");
+         return (0 < id && id <= m_Names.size()) ? m_Names[id - 1] : s_strUnknown;
+      }
+
+      /** Get the name of a state machine, followed by its ID (names need
+       ** not be unique).
+       **
+       ** @return the name.
+       **/
+      std::string CDump::GetMachine(
+         const uint32_t id //< State machine ID.
+         ) const
+      {
+         char szId[16];
+         snprintf(szId, sizeof(szId), "#%u", id);
+         return ((0 < id && id <= m_Machines.size()) ? GetName(m_Machines[id - 1]) : std::string("?")) + szId;
+      }
+
+      /** Get the description of the event: type and ID's (see
+       ** TEventEvtId::GetId).
+       **
+       ** @return the description.
+       **/
+      std::string CDump::GetEvent(
+         const CTraceRecord& record //< The record.
+         ) const
+      {
+         std::string strEvent(GetName(record.m_EventType) + " ");
+         for(unsigned int i = 0 ; i < record.m_EventCount && i < 4 ; ++i) {
+            char szValue[16];
+            snprintf(szValue, sizeof(szValue), "%s0x%04X", 0 == i ? "" : "-", record.m_EventValues[i]);
+            strEvent += szValue;
+         }
+         return strEvent;
+      }
+
+      /** Get the description of the state change.
+       **
+       ** @return the description, empty when there was no state change.
+       **/
+      std::string CDump::GetTarget(
+         const CTraceRecord& record //< The record.
+         ) const
+      {
+         switch(record.m_Target) {
+            case CTraceRecord::TARGET_NONE:     return "";
+            case CTraceRecord::TARGET_FINISHED: return "finished";
+            default:                            return GetName(record.m_Target);
+         }
+      }
+
+      /** Get the description of the guard.
+       **
+       ** @return the description.
+       **/
+      std::string GetGuard(
+         const CTraceRecord& record //< The record.
+         )
+      {
+         if(CTraceRecord::GUARD_NONE == record.m_Guard) {
+            return "-";
+         }
+         if(0 == record.m_Guard) {
+            return "unguarded";
+         }
+         char szGuard[16];
+         snprintf(szGuard, sizeof(szGuard), "%u", record.m_Guard);
+         return szGuard;
+      }
+
+      /** Escape a string for JSON.
+       **
+       ** @return the escaped string, without quotes.
+       **/
+      std::string Escape(
+         const std::string& str //< The string.
+         )
+      {
+         std::string strEscaped;
+         for(std::string::const_iterator cit = str.begin() ; str.end() != cit ; ++cit) {
+            const unsigned char c(static_cast<unsigned char>(*cit));
+            if('"' == c || '\\' == c) {
+               strEscaped += '\\';
+               strEscaped += *cit;
+            } else if(0x20 > c) {
+               char szEscaped[8];
+               snprintf(szEscaped, sizeof(szEscaped), "\\u%04x", c);
+               strEscaped += szEscaped;
+            } else {
+               strEscaped += *cit;
+            }
+         }
+         return strEscaped;
+      }
+
+      /** Write the records as text, 1 line per record.
+       **/
+      void WriteText(
+         const CDump&  dump, //< The dump.
+         std::ostream& out   //< Output.
+         )
+      {
+         const uint64_t start(dump.m_Records.empty() ? 0 : dump.m_Records.front().m_Record.m_TimestampNs);
+         for(std::vector<CThreadRecord>::const_iterator cit = dump.m_Records.begin() ; dump.m_Records.end() != cit ; ++cit) {
+            const CTraceRecord& record(cit->m_Record);
+            const std::string   strTarget(dump.GetTarget(record));
+            char                szLine[512];
+            snprintf(szLine, sizeof(szLine), "%14.3f us thread %u machine %s state [%s] event [%s] %s guard %s%s%s%s %u ns\n",
+                     (record.m_TimestampNs - start) / 1000.0,
+                     cit->m_Thread,
+                     dump.GetMachine(record.m_Machine).c_str(),
+                     dump.GetName(record.m_State).c_str(),
+                     dump.GetEvent(record).c_str(),
+                     CTraceRecord::GetKindName(static_cast<ETraceKind>(record.m_Kind)),
+                     GetGuard(record).c_str(),
+                     strTarget.empty() ? "" : " --> [",
+                     strTarget.c_str(),
+                     strTarget.empty() ? "" : "]",
+                     record.m_DurationNs
+                     );
+            out << szLine;
+         }
+      }
+
+      /** Write the records as a Chrome trace: a complete event per record,
+       ** a process per state machine.
+       **/
+      void WriteChrome(
+         const CDump&  dump, //< The dump.
+         std::ostream& out   //< Output.
+         )
+      {
+         out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+         const char* szSeparator("\n");
+         for(uint32_t i = 1 ; i <= dump.m_Machines.size() ; ++i) {
+            out << szSeparator << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << i << ", \"args\": {\"name\": \"" << Escape(dump.GetMachine(i)) << "\"}}";
+            szSeparator = ",\n";
+         }
+         for(std::vector<CThreadRecord>::const_iterator cit = dump.m_Records.begin() ; dump.m_Records.end() != cit ; ++cit) {
+            const CTraceRecord& record(cit->m_Record);
+            char                szTimes[64];
+            snprintf(szTimes, sizeof(szTimes), "\"ts\": %.3f, \"dur\": %.3f", record.m_TimestampNs / 1000.0, record.m_DurationNs / 1000.0);
+            out << szSeparator
+                << "{\"name\": \"" << Escape(dump.GetEvent(record)) << "\""
+                << ", \"cat\": \"" << CTraceRecord::GetKindName(static_cast<ETraceKind>(record.m_Kind)) << "\""
+                << ", \"ph\": \"X\", " << szTimes
+                << ", \"pid\": " << record.m_Machine
+                << ", \"tid\": " << cit->m_Thread
+                << ", \"args\": {\"state\": \"" << Escape(dump.GetName(record.m_State)) << "\""
+                << ", \"guard\": \"" << GetGuard(record) << "\""
+                << ", \"target\": \"" << Escape(dump.GetTarget(record)) << "\"}}";
+            szSeparator = ",\n";
+         }
+         out << "\n]}\n";
+      }
+   }
+
+   /** Decode a trace dump.
+    **
+    ** @return true on success, false when the dump is invalid (nothing written).
+    **/
+   bool CTraceDecoder::Decode(
+      std::istream& in,      //< The dump.
+      std::ostream& out,     //< Output.
+      const EFormat format,  //< Output format.
+      std::string&  strError //< Reason when the dump is invalid.
+      )
+   {
+      CDump dump;
+      if(!dump.Read(in, strError)) {
+         return false;
+      }
+      if(EFormatChrome == format) {
+         WriteChrome(dump, out);
+      } else {
+         WriteText(dump, out);
+      }
+      return true;
+   }
+}
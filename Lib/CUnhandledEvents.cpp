@@ -0,0 +1,505 @@
+/** @file
+ ** @brief The CUnhandledKey, CDeadLetter and CUnhandledEvents definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <typeinfo>
+
+#include "Include/CEventBase.h"
+#include "Include/CStateMachine.h"
+#include "Include/CTrace.h"
+#include "Include/CUnhandledEvents.h"
+#include "Include/Logging.h"
+
+namespace ILULibStateMachine {
+   namespace {
+      /** @brief What is known about 1 CUnhandledKey.
+       **/
+      class CUnhandledInfo {
+         public:
+            CUnhandledInfo(void)
+               : m_Count  (0    )
+               , m_bTraced(false)
+               , m_TraceNs(0    )
+            {
+            }
+
+         public:
+            unsigned long long m_Count;   ///< Number of unhandled events.
+            bool               m_bTraced; ///< The handlers have been logged at least once.
+            long long          m_TraceNs; ///< Time the handlers have been logged for the last time (steady clock, ns).
+      };
+
+      /** Information per key.
+       **/
+      typedef std::map<CUnhandledKey, CUnhandledInfo> Infos;
+
+      /** Iterator on the information per key.
+       **/
+      typedef Infos::iterator                         InfosIt;
+
+      /** Constant iterator on the information per key.
+       **/
+      typedef Infos::const_iterator                   InfosCIt;
+
+      /** Bits of a recent key's word counting its unhandled events, the
+       ** other bits identify the key (a part of its hash, never 0).
+       **/
+      const uint64_t RECENT_COUNT_MASK = (1ULL << 24) - 1;
+
+      /** Number of recent keys (a power of 2).
+       **/
+      const size_t   RECENT_SLOTS      = 256;
+
+      /** @brief A key whose handlers have been logged recently.
+       **
+       ** The lock-free part (m_Word and m_TraceNs) is claimed for a key
+       ** under the mutex, unhandled events of the key are counted in it
+       ** without the mutex as long as its handlers need not be logged.
+       **/
+      class CRecentKey {
+         public:
+            CRecentKey(void)
+               : m_Word   (0   )
+               , m_TraceNs(0   )
+               , m_pInfo  (NULL)
+            {
+            }
+
+         public:
+            std::atomic<uint64_t>  m_Word;    ///< Identification and count (see RECENT_COUNT_MASK), 0 when not claimed.
+            std::atomic<long long> m_TraceNs; ///< Time the handlers of the key have been logged for the last time (steady clock, ns).
+            CUnhandledInfo*        m_pInfo;   ///< Where the count goes (mutex), NULL when not claimed.
+      };
+
+      /** Minimum time between 2 handler loggings for the same key (ns).
+       **/
+      std::atomic<long long>          s_TraceIntervalNs(CUnhandledEvents::DEFAULT_TRACE_INTERVAL_MS * 1000000LL);
+
+      /** Handler loggings skipped because of the interval.
+       **/
+      std::atomic<unsigned long long> s_TraceSuppressed(0);
+
+      /** A dead-letter function or queue is registered: every unhandled
+       ** event takes the mutex.
+       **/
+      std::atomic<bool>       s_bConsumer(false);
+
+      /** The recent keys, by hash.
+       **/
+      CRecentKey              s_Recent[RECENT_SLOTS];
+
+      /** Protects everything below (and CRecentKey::m_pInfo).
+       **/
+      std::mutex              s_Mutex;
+
+      /** Information per key.
+       **/
+      Infos                   s_Infos;
+
+      /** Maximum number of keys in s_Infos.
+       **/
+      size_t                  s_KeyCapacity = CUnhandledEvents::DEFAULT_KEY_CAPACITY;
+
+      /** Information shared by the keys that did not fit.
+       **/
+      CUnhandledInfo          s_Overflow;
+
+      /** The registered dead-letter function, empty when none.
+       **/
+      FDeadLetter             s_DeadLetter;
+
+      /** The queue, oldest first.
+       **/
+      std::deque<CDeadLetter> s_Queue;
+
+      /** Maximum number of letters in the queue, 0 when disabled.
+       **/
+      size_t                  s_QueueCapacity = 0;
+
+      /** Letters dropped because the queue was full.
+       **/
+      unsigned long long      s_QueueDropped = 0;
+
+      /** Get the steady clock time.
+       **
+       ** @return the time (ns).
+       **/
+      long long Now(void)
+      {
+         return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+      /** Combine a value into a hash.
+       **/
+      void HashCombine(
+         uint64_t&      hash, //< The hash (input and output).
+         const uint64_t value //< The value.
+         )
+      {
+         hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+      }
+
+      /** Hash a key without building its strings: the event is identified
+       ** by its type and its ID's (see CEventBase::TraceKey).
+       **
+       ** @return the hash.
+       **/
+      uint64_t KeyHash(
+         const std::string& strMachine, //< State machine name.
+         const std::string& strState,   //< State name.
+         const CEventBase&  event       //< The event.
+         )
+      {
+         CTraceRecord record;
+         record.m_EventCount = 0;
+         event.TraceKey(record);
+         uint64_t hash(std::hash<std::string>()(strMachine));
+         HashCombine(hash, std::hash<std::string>()(strState));
+         HashCombine(hash, typeid(event).hash_code());
+         for(uint8_t i = 0 ; i < record.m_EventCount && i < 4 ; ++i) {
+            HashCombine(hash, record.m_EventValues[i]);
+         }
+         return hash;
+      }
+
+      /** Add the events counted in the recent keys to their key (holding
+       ** the mutex).
+       **/
+      void RecentFoldLocked(void)
+      {
+         for(size_t slot = 0 ; slot < RECENT_SLOTS ; ++slot) {
+            CRecentKey& recent(s_Recent[slot]);
+            if(NULL != recent.m_pInfo) {
+               recent.m_pInfo->m_Count += recent.m_Word.fetch_and(~RECENT_COUNT_MASK) & RECENT_COUNT_MASK;
+            }
+         }
+      }
+
+      /** Update whether every unhandled event takes the mutex (holding
+       ** the mutex).
+       **/
+      void ConsumerUpdateLocked(void)
+      {
+         s_bConsumer.store(static_cast<bool>(s_DeadLetter) || 0 != s_QueueCapacity);
+      }
+   }
+
+   const unsigned int CUnhandledEvents::DEFAULT_TRACE_INTERVAL_MS;
+   const size_t       CUnhandledEvents::DEFAULT_KEY_CAPACITY;
+
+   /** Constructor.
+    **/
+   CUnhandledKey::CUnhandledKey(
+      const std::string& strMachine, //< State machine name.
+      const std::string& strState,   //< State name.
+      const std::string& strEvent    //< Event ID.
+      )
+      : m_strMachine(strMachine)
+      , m_strState  (strState  )
+      , m_strEvent  (strEvent  )
+   {
+   }
+
+   /** Order keys (to use them in a map).
+    **
+    ** @return true when this key comes before the other key.
+    **/
+   bool CUnhandledKey::operator<(
+      const CUnhandledKey& ref //< The other key.
+      ) const
+   {
+      if(m_strMachine != ref.m_strMachine) {
+         return m_strMachine < ref.m_strMachine;
+      }
+      if(m_strState != ref.m_strState) {
+         return m_strState < ref.m_strState;
+      }
+      return m_strEvent < ref.m_strEvent;
+   }
+
+   /** Constructor: an empty letter.
+    **/
+   CDeadLetter::CDeadLetter(void)
+      : m_strMachine  ( )
+      , m_MachineId   (0)
+      , m_strState    ( )
+      , m_strEvent    ( )
+      , m_strEventType( )
+      , m_strDataType ( )
+      , m_Count       (0)
+   {
+   }
+
+   /** Set the minimum time between 2 loggings of the registered handlers
+    ** for the same key (default DEFAULT_TRACE_INTERVAL_MS).
+    **/
+   void CUnhandledEvents::SetTraceInterval(
+      const unsigned int ms //< The interval (ms), 0 to log the handlers for every unhandled event.
+      )
+   {
+      s_TraceIntervalNs.store(ms * 1000000LL);
+   }
+
+   /** Get the minimum time between 2 loggings of the registered handlers
+    ** for the same key.
+    **
+    ** @return the interval (ms).
+    **/
+   unsigned int CUnhandledEvents::GetTraceInterval(void)
+   {
+      return static_cast<unsigned int>(s_TraceIntervalNs.load() / 1000000LL);
+   }
+
+   /** Register the function called for every unhandled event (replaces
+    ** the one registered before).
+    **
+    ** The function is called by the thread feeding the event, without
+    ** holding a lock: it can feed events into state machines.
+    **/
+   void CUnhandledEvents::RegisterDeadLetter(
+      FDeadLetter deadLetter //< The function to call.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_DeadLetter = deadLetter;
+      ConsumerUpdateLocked();
+   }
+
+   /** Unregister the dead-letter function.
+    **/
+   void CUnhandledEvents::UnRegisterDeadLetter(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_DeadLetter = FDeadLetter();
+      ConsumerUpdateLocked();
+   }
+
+   /** Set the maximum number of unhandled events kept in the queue. When
+    ** the queue is full, the oldest one is dropped (and counted).
+    **/
+   void CUnhandledEvents::SetQueueCapacity(
+      const size_t capacity //< The maximum number of letters, 0 to disable the queue (default).
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_QueueCapacity = capacity;
+      ConsumerUpdateLocked();
+      while(s_QueueCapacity < s_Queue.size()) {
+         s_Queue.pop_front();
+         ++s_QueueDropped;
+      }
+   }
+
+   /** Take the oldest unhandled event from the queue.
+    **
+    ** @return true when a letter has been taken, false when the queue is empty.
+    **/
+   bool CUnhandledEvents::Pop(
+      CDeadLetter& deadLetter //< The letter taken (output).
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      if(s_Queue.empty()) {
+         return false;
+      }
+      deadLetter = s_Queue.front();
+      s_Queue.pop_front();
+      return true;
+   }
+
+   /** Get the number of unhandled events dropped because the queue was
+    ** full.
+    **
+    ** @return the number of dropped letters.
+    **/
+   unsigned long long CUnhandledEvents::GetQueueDropped(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      return s_QueueDropped;
+   }
+
+   /** Get the number of unhandled events for which the registered handlers
+    ** have not been logged because of the interval.
+    **
+    ** @return the number of skipped handler loggings.
+    **/
+   unsigned long long CUnhandledEvents::GetTraceSuppressed(void)
+   {
+      return s_TraceSuppressed.load();
+   }
+
+   /** Set the maximum number of keys counted separately (default
+    ** DEFAULT_KEY_CAPACITY). The unhandled events of new keys are counted
+    ** together once it is reached (GetKeyOverflow), the keys counted so
+    ** far are kept.
+    **/
+   void CUnhandledEvents::SetKeyCapacity(
+      const size_t capacity //< The maximum number of keys.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_KeyCapacity = capacity;
+   }
+
+   /** Get the number of unhandled events whose key did not fit in the
+    ** table of keys (see SetKeyCapacity).
+    **
+    ** @return the number of unhandled events not counted per key.
+    **/
+   unsigned long long CUnhandledEvents::GetKeyOverflow(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      RecentFoldLocked();
+      return s_Overflow.m_Count;
+   }
+
+   /** Call a function for each key with its number of unhandled events,
+    ** holding the lock: the callback must not feed events into state
+    ** machines.
+    **/
+   void CUnhandledEvents::ForEach(
+      TYPESEL::function<void(const CUnhandledKey&, const unsigned long long count)> callback //< Function to call.
+      )
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      RecentFoldLocked();
+      for(InfosCIt cit = s_Infos.begin() ; s_Infos.end() != cit ; ++cit) {
+         callback(cit->first, cit->second.m_Count);
+      }
+   }
+
+   /** Forget the counts, the queue and the handler logging times (the
+    ** registered function, the interval and the queue capacity are kept).
+    **/
+   void CUnhandledEvents::Reset(void)
+   {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      for(size_t slot = 0 ; slot < RECENT_SLOTS ; ++slot) {
+         s_Recent[slot].m_Word.store(0);
+         s_Recent[slot].m_pInfo = NULL;
+      }
+      s_Infos.clear();
+      s_Overflow = CUnhandledInfo();
+      s_Queue.clear();
+      s_TraceSuppressed.store(0);
+      s_QueueDropped    = 0;
+   }
+
+   /** Record an unhandled event: count it, queue it and call the
+    ** dead-letter function.
+    **
+    ** @return true when the registered handlers have to be logged for this event.
+    **/
+   bool CUnhandledEvents::Record(
+      const CStateMachine& stateMachine, //< The state machine that did not handle the event.
+      const std::string&   strState,     //< Name of its current state.
+      const CEventBase&    event         //< The event.
+      )
+   {
+      //a recent key without consumer: count it without building its strings or locking
+      const uint64_t  hash(KeyHash(stateMachine.GetName(), strState, event));
+      const uint64_t  id  ((hash & ~RECENT_COUNT_MASK) | (RECENT_COUNT_MASK + 1));
+      CRecentKey&     recent(s_Recent[hash & (RECENT_SLOTS - 1)]);
+      const long long now(Now());
+      if(!s_bConsumer.load(std::memory_order_relaxed)) {
+         uint64_t word(recent.m_Word.load(std::memory_order_acquire));
+         while(id == (word & ~RECENT_COUNT_MASK) && RECENT_COUNT_MASK != (word & RECENT_COUNT_MASK)
+               && now - recent.m_TraceNs.load(std::memory_order_relaxed) < s_TraceIntervalNs.load(std::memory_order_relaxed)) {
+            if(recent.m_Word.compare_exchange_weak(word, word + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+               s_TraceSuppressed.fetch_add(1, std::memory_order_relaxed);
+               return false;
+            }
+         }
+      }
+
+      CDeadLetter deadLetter;
+      deadLetter.m_strMachine = stateMachine.GetName();
+      deadLetter.m_MachineId  = stateMachine.GetId();
+      deadLetter.m_strState   = strState;
+      deadLetter.m_strEvent   = event.GetId();
+
+      bool        bTrace(false);
+      FDeadLetter deadLetterFunction;
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         const CUnhandledKey         key(deadLetter.m_strMachine, deadLetter.m_strState, deadLetter.m_strEvent);
+         CUnhandledInfo*             pInfo(&s_Overflow);
+         InfosIt                     it(s_Infos.find(key));
+         if(s_Infos.end() != it) {
+            pInfo = &it->second;
+         } else if(s_Infos.size() < s_KeyCapacity) {
+            pInfo = &s_Infos[key];
+         }
+
+         //claim the recent key, the events counted in it belong to the key that held it
+         const uint64_t word(recent.m_Word.exchange(0));
+         if(NULL != recent.m_pInfo) {
+            recent.m_pInfo->m_Count += word & RECENT_COUNT_MASK;
+         }
+         recent.m_pInfo = pInfo;
+
+         ++pInfo->m_Count;
+         deadLetter.m_Count = (&s_Overflow == pInfo) ? 0 : pInfo->m_Count;
+         if(!pInfo->m_bTraced || s_TraceIntervalNs.load() <= now - pInfo->m_TraceNs) {
+            pInfo->m_bTraced = true;
+            pInfo->m_TraceNs = now;
+            bTrace           = true;
+         } else {
+            s_TraceSuppressed.fetch_add(1);
+         }
+         recent.m_TraceNs.store(pInfo->m_TraceNs, std::memory_order_relaxed);
+         recent.m_Word.store(id, std::memory_order_release);
+
+         if(!s_DeadLetter && 0 == s_QueueCapacity) {
+            return bTrace;
+         }
+         deadLetter.m_strEventType = event.GetIdType();
+         deadLetter.m_strDataType  = event.GetDataType();
+         if(0 != s_QueueCapacity) {
+            if(s_QueueCapacity <= s_Queue.size()) {
+               s_Queue.pop_front();
+               ++s_QueueDropped;
+            }
+            s_Queue.push_back(deadLetter);
+         }
+         deadLetterFunction = s_DeadLetter;
+      }
+      if(deadLetterFunction) {
+         try {
+            deadLetterFunction(deadLetter);
+         } catch(std::exception& ex) {
+            if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+               LogErr("Exception caught while calling the dead-letter function: %s\n", ex.what());
+            }
+         } catch(...) {
+            if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+               LogErr("Exception caught while calling the dead-letter function: %s\n", "unknown");
+            }
+         }
+      }
+      return bTrace;
+   }
+}
@@ -0,0 +1,108 @@
+/** @file
+ ** @brief The CAllocationStats declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CAllocationStats__H__
+#define __ILULibStateMachine_CAllocationStats__H__
+
+#include <cstddef>
+
+namespace ILULibStateMachine {
+   /** @brief What the state machine engine was doing when memory was allocated.
+    **/
+   enum EAllocation {
+      EAllocationRegistration = 0, ///< Registering handlers (state constructors).
+      EAllocationDispatch,         ///< Handling an event, except for the categories below.
+      EAllocationTransition,       ///< Changing state: destructing the old and constructing the new state.
+      EAllocationLogging,          ///< Formatting and writing loggings.
+      EAllocationTeardown,         ///< Destructing the state machine.
+      EAllocationCount             ///< Number of categories, not a category.
+   };
+
+   /** @brief Allocation accounting per category (opt-in instrumentation).
+    **
+    ** When the library is compiled with ALLOCATION_STATS (configure
+    ** --enable-allocation-stats), the engine marks what it is doing with a
+    ** CAllocationScope. Every allocation reported with RecordAllocation is
+    ** then attributed to the state machine and the category of the
+    ** innermost scope of the calling thread. Allocations from a state
+    ** machine's memory resource are reported by the engine itself; heap
+    ** allocations are reported by a replaced global operator new (test and
+    ** benchmark builds, the library does not replace it).
+    **
+    ** Without ALLOCATION_STATS there are no scopes and all counts stay 0.
+    **/
+   class CAllocationStats {
+      public:
+                                        CAllocationStats(void);
+
+      public:
+         static bool                    IsEnabled(void);
+         static const char*             GetName(const EAllocation category);
+         static void                    RecordAllocation(const size_t size);
+         static const CAllocationStats& GetThreadTotals(void);
+         unsigned long long             GetCount(const EAllocation category) const;
+         unsigned long long             GetBytes(const EAllocation category) const;
+         void                           Record(const EAllocation category, const size_t size);
+
+      private:
+         unsigned long long             m_Count[EAllocationCount]; ///< Number of allocations per category.
+         unsigned long long             m_Bytes[EAllocationCount]; ///< Number of bytes allocated per category.
+   };
+
+   /** @brief Attributes the allocations of the current thread to a state
+    ** machine and a category during the life-time of the instance.
+    **
+    ** Scopes nest: the previous state machine and category are restored on
+    ** destruction (e.g. logging while handling an event, or a state handling
+    ** an event by feeding it into a child state machine). A scope without
+    ** statistics keeps attributing to the state machine of the enclosing
+    ** scope and only changes the category.
+    **
+    ** Use the ALLOCATION_SCOPE macro, it compiles to nothing without
+    ** ALLOCATION_STATS.
+    **/
+   class CAllocationScope {
+      public:
+                                   CAllocationScope(CAllocationStats* const pStats, const EAllocation category);
+                                   ~CAllocationScope(void);
+
+      private:
+                                   CAllocationScope(CAllocationScope& ref); //defined, not implemented --> avoid copy
+         CAllocationScope          operator=(CAllocationScope& ref);        //defined, not implemented --> avoid copy
+
+      private:
+         CAllocationStats* const   m_pPrevious;        ///< Statistics to restore on destruction.
+         const EAllocation         m_PreviousCategory; ///< Category to restore on destruction.
+   };
+}
+
+#ifdef ALLOCATION_STATS
+/** Attribute the allocations until the end of the enclosing block to PSTATS
+ ** (NULL: the state machine of the enclosing scope) and CATEGORY.
+ **/
+#  define ALLOCATION_SCOPE(PSTATS, CATEGORY) ILULibStateMachine::CAllocationScope allocationScope((PSTATS), (CATEGORY))
+#else
+/** Allocation accounting not compiled in.
+ **/
+#  define ALLOCATION_SCOPE(PSTATS, CATEGORY)
+#endif
+
+#endif //__ILULibStateMachine_CAllocationStats__H__
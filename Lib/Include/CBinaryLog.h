@@ -0,0 +1,102 @@
+/** @file
+ ** @brief The CBinaryLog declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CBinaryLog__H__
+#define __ILULibStateMachine_CBinaryLog__H__
+
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string>
+
+#include "Logging.h"
+#include "LoggingAsync.h"
+
+namespace ILULibStateMachine {
+   /** @brief Deferred-formatting logging.
+    **
+    ** When started, LogDebug..LogErr do not format the message: the first
+    ** call with a format string registers it (parsing the conversions once)
+    ** and every call records the format ID and the raw arguments (strings
+    ** are copied) into a buffer of the calling thread.
+    ** A background thread formats the records and passes the messages to
+    ** the registered logging functions, or writes the records in binary to
+    ** a file that is formatted offline with Decode.
+    ** There is no limit on the length of a formatted message.
+    **
+    ** Formats with conversions that cannot be deferred (%n, %m, wide
+    ** characters and strings) are formatted immediately and recorded as a
+    ** string. The levels that are not recorded (debug by default) and
+    ** messages that do not fit in half a thread buffer are passed to the
+    ** logging functions immediately, ahead of the recorded ones.
+    ** The order of the recorded messages of 1 thread is kept, messages of
+    ** different threads are not ordered.
+    **
+    ** When a thread buffer is full, a record is dropped (and counted, see
+    ** GetDropped) or the calling thread waits for room, depending on the
+    ** overflow policy.
+    **/
+   class CBinaryLog {
+      public:
+         static const char         MAGIC[9];                  ///< First 8 bytes of a binary log file.
+         static const uint32_t     DEFAULT_CAPACITY = 1 << 20; ///< Default buffer size per thread (bytes).
+
+      public:
+         static void               Start(const EAsyncLogOverflow overflow = EAsyncLogOverflowDrop, const bool bDebug = false);
+         static bool               Start(const char* const szFile, const EAsyncLogOverflow overflow = EAsyncLogOverflowDrop, const bool bDebug = false);
+         static void               Stop(void);
+         static void               Flush(void);
+         static void               SetCapacity(const uint32_t bytes);
+         static bool               IsRunning(void);
+         static bool               IsEnabled(const ELogLevel level);
+         static bool               Record(const ELogLevel level, const char* const szFormat, va_list ap);
+         static bool               RecordIndent(const bool bIncrement);
+         static unsigned long long GetDropped(void);
+         static bool               Decode(std::istream& in, std::ostream& out, std::string& strError);
+
+      private:
+         static std::atomic<unsigned int> s_Levels; ///< Bit per recorded level, 0 when stopped.
+   };
+
+   /** Indicates whether deferred-formatting logging is started.
+    **
+    ** @return true when started.
+    **/
+   inline bool CBinaryLog::IsRunning(void)
+   {
+      return 0 != s_Levels.load(std::memory_order_relaxed);
+   }
+
+   /** Indicates whether the level is recorded.
+    **
+    ** @return true when LogXXX of the level records instead of formatting.
+    **/
+   inline bool CBinaryLog::IsEnabled(
+      const ELogLevel level //< The logging level.
+      )
+   {
+      return 0 != (s_Levels.load(std::memory_order_relaxed) & (1u << level));
+   }
+}
+
+#endif //__ILULibStateMachine_CBinaryLog__H__
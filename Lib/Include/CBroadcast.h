@@ -0,0 +1,192 @@
+/** @file
+ ** @brief The CBroadcast declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CBroadcast__H__
+#define __ILULibStateMachine_CBroadcast__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CSPEventBaseSort.h"
+#include "CStateMachine.h"
+#include "TEventEvtId.h"
+
+namespace ILULibStateMachine {
+   /** @brief Feeds an event into the subscribed state machines that have
+    ** a handler for it.
+    **
+    ** Events like a configuration change or a clock tick go to every state
+    ** machine that cares. Feeding them into all state machines costs a
+    ** complete EventHandle (including the unhandled-event path) for every
+    ** state machine that ignores them. A broadcast keeps an index from
+    ** event ID (and event-type) to the subscribed state machines whose
+    ** current states (default state, parents and regions included) have a
+    ** handler for it: Broadcast only feeds the event into those.
+    **
+    ** The index is updated by the state machine on every state change, only
+    ** with the handler tables that changed: the state it left and the one
+    ** it entered, the parents it exited and the ones it entered. An event
+    ** ID or event-type several of those have in common does not touch the
+    ** index. Handlers registered outside a state constructor are indexed
+    ** when their state (or parent) is entered again, the ones of the
+    ** default state when the state machine subscribes again.
+    **
+    ** The state machines are fed in the order they were constructed (see
+    ** CStateMachine::GetId). The interested state machines are collected
+    ** before the first one gets the event: a state machine subscribing
+    ** while broadcasting does not get it, one unsubscribing still does.
+    **
+    ** Like the state machines it feeds, a broadcast is not thread-safe: it
+    ** is used by the thread feeding events into its state machines. A
+    ** state machine subscribes to 1 broadcast at most, it unsubscribes
+    ** when destructed. The broadcast unsubscribes all state machines when
+    ** destructed.
+    **
+    ** The implementation of the template functions is put in a seperate header file (included by this
+    ** header) to keep the class declaration clean.
+    **/
+   class CBroadcast {
+      public:
+                                     CBroadcast(void);
+                                     ~CBroadcast(void);
+
+      public:
+         void                        Subscribe(SPStateMachine spStateMachine);
+         void                        Unsubscribe(CStateMachine& stateMachine);
+         size_t                      GetSubscriberCount(void) const;
+         size_t                      GetInterestedCount(const SPEventBase& spEventBase) const;
+         template <class TEventData, class EvtId>
+         size_t                      Broadcast(
+            const TEventData* const pEventData,
+            const EvtId             evtId
+            );
+         template <class TEventData, class EvtId, class EvtSubId1>
+         size_t                      Broadcast(
+            const TEventData* const pEventData,
+            const EvtId             evtId     ,
+            const EvtSubId1         evtSubId1
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>
+         size_t                      Broadcast(
+            const TEventData* const pEventData,
+            const EvtId             evtId     ,
+            const EvtSubId1         evtSubId1 ,
+            const EvtSubId2         evtSubId2
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+         size_t                      Broadcast(
+            const TEventData* const pEventData,
+            const EvtId             evtId     ,
+            const EvtSubId1         evtSubId1 ,
+            const EvtSubId2         evtSubId2 ,
+            const EvtSubId3         evtSubId3
+            );
+
+      private:
+                                     CBroadcast(CBroadcast& ref); //defined, not implemented --> avoid copy
+         CBroadcast                  operator=(CBroadcast& ref);  //defined, not implemented --> avoid copy
+
+      private:
+         /** @brief The event ID's and event-types 1 level (a state or a
+          ** parent) of a subscribed state machine is indexed with.
+          **/
+         class CLevelKeys {
+            public:
+               std::vector<SPEventBase> m_Events;         ///< The event ID's, duplicates included.
+               std::vector<std::string> m_EventTypes;     ///< The event-types, duplicates included.
+         };
+         typedef std::vector<CLevelKeys>                             Levels;         ///< The levels of a region: its state, then its parents outermost first.
+         typedef std::map<SPEventBase, size_t, CSPEventBaseSort>     EventCounts;    ///< The number of levels with an event ID.
+         typedef std::map<std::string, size_t>                       EventTypeCounts;///< The number of levels with an event-type.
+
+         /** @brief A subscribed state machine and the event ID's and
+          ** event-types it is indexed with.
+          **/
+         class CSubscriber {
+            public:
+               CStateMachine*           m_pStateMachine;  ///< The state machine, it unsubscribes when destructed.
+               WPStateMachine           m_wpStateMachine; ///< The state machine, to keep it alive while broadcasting.
+               EventCounts              m_Events;         ///< The event ID's, with the number of levels having them.
+               EventTypeCounts          m_EventTypes;     ///< The event-types, with the number of levels having them.
+               CLevelKeys               m_Default;        ///< The keys of the default state.
+               std::vector<Levels>      m_Regions;        ///< The keys per region, 0 being the state machine's own state.
+         };
+         typedef std::map<uint64_t, CSubscriber>                     Subscribers;    ///< The subscribed state machines by ID (see CStateMachine::GetId).
+         typedef std::map<uint64_t, SPEventBase>                     Interested;     ///< The interested state machines by ID, with their own instance of the event ID.
+         typedef std::map<SPEventBase, Interested, CSPEventBaseSort> EventIndex;     ///< The interested state machines per event ID.
+         typedef std::map<std::string, std::set<uint64_t> >          EventTypeIndex; ///< The interested state machines per event-type.
+
+         /** @brief A range some subscribed state machines are interested in
+          ** (see TEvtIdRange).
+          **/
+         class CRange {
+            public:
+               const void*              m_pTag;    ///< Identifies the event ID type, see CEventBase::RangeKey.
+               long                     m_First;   ///< The first event ID of the range.
+               long                     m_Last;    ///< The last event ID of the range.
+               long                     m_MaxLast; ///< The largest last event ID of this range and the ranges of the same type before it.
+               SPEventBase              m_spEvent; ///< The key of the range in the index on event ID.
+         };
+         typedef std::vector<CRange>                                 Ranges;         ///< The ranges, sorted on event ID type (tag), first and last event ID.
+
+         /** @brief The context collecting the state machines interested in
+          ** the prefixes of an event ID (see PrefixCollect).
+          **/
+         class CPrefixCollect {
+            public:
+               const EventIndex*        m_pEvents; ///< The index on event ID.
+               std::set<uint64_t>*      m_pIds;    ///< The interested state machines are added.
+         };
+
+      private:
+         friend class CStateMachine;
+         template <class TEventData>
+         size_t                      Deliver(const TEventData* const pEventData, const SPEventBase& spEventBase);
+         void                        Collect(const SPEventBase& spEventBase, std::vector<SPStateMachine>& stateMachines) const;
+         static void                 CollectIds(const EventIndex& events, const SPEventBase& spEventBase, std::set<uint64_t>& ids);
+         static bool                 PrefixCollect(void* pContext, CEventBase& prefix);
+         void                        Update(CStateMachine& stateMachine, const size_t region, const size_t parentsKept);
+         void                        LevelAdd(const uint64_t id, CSubscriber& subscriber, const CLevelKeys& keys);
+         void                        LevelRemove(const uint64_t id, CSubscriber& subscriber, const CLevelKeys& keys);
+         void                        Remove(CStateMachine& stateMachine);
+         void                        EventAdd(const uint64_t id, const SPEventBase& spEventBase);
+         void                        EventRemove(const uint64_t id, const SPEventBase& spEventBase);
+         static bool                 RangeGet(const SPEventBase& spEventBase, CRange& range);
+         static bool                 RangeLess(const CRange& a, const CRange& b);
+         Ranges::iterator            RangeFind(const CRange& range);
+         void                        RangeMaxUpdate(Ranges::iterator it);
+
+      private:
+         Subscribers                 m_Subscribers; ///< The subscribed state machines.
+         EventIndex                  m_Events;      ///< The index on event ID.
+         EventTypeIndex              m_EventTypes;  ///< The index on event-type.
+         Ranges                      m_Ranges;      ///< The ranges in the index on event ID, searched with a binary search.
+   };
+}
+
+//include the class template function definitions.
+#include "CBroadcastImpl.h"
+
+#endif //__ILULibStateMachine_CBroadcast__H__
@@ -0,0 +1,112 @@
+/** @file
+ ** @brief The CBroadcast template function definitions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CBroadcastImpl__H__
+#define __ILULibStateMachine_CBroadcastImpl__H__
+
+#include <typeinfo>
+
+namespace ILULibStateMachine {
+   /** Feed an event into the subscribed state machines with a handler
+    ** for it.
+    **
+    ** @return the number of state machines the event was fed into.
+    **/
+   template <class TEventData, class EvtId>
+   size_t CBroadcast::Broadcast(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const EvtId             evtId       //< Event ID as defined by TEventEvtId.
+      )
+   {
+      return Deliver(pEventData, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+   }
+
+   /** Feed an event into the subscribed state machines with a handler
+    ** for it.
+    **
+    ** @return the number of state machines the event was fed into.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1>
+   size_t CBroadcast::Broadcast(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const EvtId             evtId,      //< Event ID as defined by TEventEvtId.
+      const EvtSubId1         evtSubId1   //< First event sub-ID as defined by TEventEvtId.
+      )
+   {
+      return Deliver(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+   }
+
+   /** Feed an event into the subscribed state machines with a handler
+    ** for it.
+    **
+    ** @return the number of state machines the event was fed into.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>
+   size_t CBroadcast::Broadcast(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const EvtId             evtId,      //< Event ID as defined by TEventEvtId.
+      const EvtSubId1         evtSubId1,  //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2         evtSubId2   //< Second event sub-ID as defined by TEventEvtId.
+      )
+   {
+      return Deliver(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+   }
+
+   /** Feed an event into the subscribed state machines with a handler
+    ** for it.
+    **
+    ** @return the number of state machines the event was fed into.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   size_t CBroadcast::Broadcast(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const EvtId             evtId,      //< Event ID as defined by TEventEvtId.
+      const EvtSubId1         evtSubId1,  //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2         evtSubId2,  //< Second event sub-ID as defined by TEventEvtId.
+      const EvtSubId3         evtSubId3   //< Third event sub-ID as defined by TEventEvtId.
+      )
+   {
+      return Deliver(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>(typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
+   }
+
+   /** Feed an event into the interested state machines.
+    **
+    ** The event ID is allocated from the heap: it is shared by all state
+    ** machines, each with its own memory resource.
+    **
+    ** @return the number of state machines the event was fed into.
+    **/
+   template <class TEventData>
+   size_t CBroadcast::Deliver(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const SPEventBase&      spEventBase //< Class instance describing the event in all detail.
+      )
+   {
+      std::vector<SPStateMachine> stateMachines;
+      Collect(spEventBase, stateMachines);
+      for(std::vector<SPStateMachine>::const_iterator cit = stateMachines.begin() ; stateMachines.end() != cit ; ++cit) {
+         (*cit)->EventHandle(pEventData, spEventBase);
+      }
+      return stateMachines.size();
+   }
+}
+
+#endif //__ILULibStateMachine_CBroadcastImpl__H__
@@ -29,6 +29,7 @@ namespace ILULibStateMachine {
    //forward declarations
    //(avoiding recursive includes)
    class CStateMachine;
+   class CStateMachineData;
 
    /** Prototype of function to create a new state
     ** this cannot be a mere typedef since states can require
@@ -42,30 +43,137 @@ namespace ILULibStateMachine {
     **/
    typedef TYPESEL::function<CState*(TYPESEL::weak_ptr<CStateMachine> wpStateMachine)> FCreateState;
 
+   /** Prototype of a plain create-state function taking one context pointer.
+    **
+    ** Almost all create-state functions are 'a function plus one data pointer'
+    ** (see TCreateState, TCreateStateNoData and CCreateStateFinished).
+    ** Storing them as a raw function pointer and a context pointer avoids
+    ** the bind object and the TYPESEL::function (and its heap allocation)
+    ** every time a CCreateState is constructed or copied.
+    **/
+   typedef CState* (*FCreateStateRaw)(TYPESEL::weak_ptr<CStateMachine> wpStateMachine, void* pContext);
+
+   /** @brief Describes the parent of a substate: how to create it and
+    ** its own parent (see TStateParent).
+    **
+    ** There is 1 static instance per substate class, so a chain of parents
+    ** is known before any of its states is constructed. The parent is
+    ** created with the same context as the substate.
+    **/
+   class CStateParent {
+      public:
+                             CStateParent(FCreateStateRaw fCreateStateRaw, const CStateParent* const pParent);
+
+      public:
+         const FCreateStateRaw     m_fCreateStateRaw; //< Raw create function of the parent state, also identifies the parent state class.
+         const CStateParent* const m_pParent;         //< Parent of the parent state, NULL for a top-level state.
+   };
+
    /** @brief Wrapper of a create-state function so it is possible to check that the function is valid or not. 
     **
     ** A TYPESEL::function cannot be checked for validity.
     ** Nevertheless, event handler definitions not requireing 
     ** a state change have to be able to indicate this.
-    ** Thus the CCreateState wraps the FCreateState together
-    ** with a valid-flag.
-    ** An alternative would have been a std::pair.
+    ** Thus the CCreateState wraps the create function together
+    ** with a valid-flag (a NULL raw function pointer).
+    **
+    ** The common case is a raw function pointer plus a context pointer
+    ** (nothing to allocate when copied).
+    ** A generic FCreateState (e.g. a bind or a lambda) is still accepted:
+    ** it is copied once to the heap together with a reference count and
+    ** called through a raw trampoline function with that copy as its
+    ** context. Copies of such an instance share the copy, the last one
+    ** deletes it.
+    **
+    ** A raw create function can also be told to get the data of the state
+    ** machine creating the state as its context (WithStateMachineData).
+    ** Such an instance does not refer to any state machine instance, so
+    ** it can be stored in handler tables shared by many state machines
+    ** (see CHandlerTable).
+    **
+    ** A raw create function can describe a substate: the parent (see
+    ** CStateParent) is then created before the substate and it handles
+    ** the events the substate does not handle (see CStateMachine).
+    **
+    ** A CCreateState is copied with every registration, every handler
+    ** result and every state change: copy construction, assignment and
+    ** destruction are inline and only touch the reference count of a
+    ** generic function. For a raw function a copy copies the 3 pointers
+    ** (function, context and parent), nothing else.
     **/
    class CCreateState {
       public:
                              CCreateState(void);
-                             CCreateState(const CCreateState& ref);
-                             CCreateState(FCreateState fCreateState);         
-         virtual             ~CCreateState(void);
-         CCreateState&       operator=(const CCreateState& ref);
+                             CCreateState(FCreateState fCreateState);
+                             CCreateState(FCreateStateRaw fCreateStateRaw, void* const pContext, const CStateParent* const pParent = NULL);
+
+         /** Copy constructor.
+          **/
+         inline              CCreateState(
+            const CCreateState& ref //< Instance to be copied.
+            )
+            : m_fCreateStateRaw(ref.m_fCreateStateRaw)
+            , m_pContext       (ref.m_pContext)
+            , m_pParent        (ref.m_pParent)
+         {
+            if(CreateGeneric == m_fCreateStateRaw) {
+               GenericAddRef(m_pContext);
+            }
+         }
+
+         /** Destructor.
+          **/
+         inline              ~CCreateState(void)
+         {
+            if(CreateGeneric == m_fCreateStateRaw) {
+               GenericRelease(m_pContext);
+            }
+         }
+
+         /** Copy operator.
+          **/
+         inline CCreateState& operator=(
+            const CCreateState& ref //< Instance to be copied.
+            )
+         {
+            //reference the new generic function before releasing the old one (self-assignment)
+            if(CreateGeneric == ref.m_fCreateStateRaw) {
+               GenericAddRef(ref.m_pContext);
+            }
+            if(CreateGeneric == m_fCreateStateRaw) {
+               GenericRelease(m_pContext);
+            }
+            m_fCreateStateRaw = ref.m_fCreateStateRaw;
+            m_pContext        = ref.m_pContext;
+            m_pParent         = ref.m_pParent;
+            return *this;
+         }
+
+      public:
+         static CCreateState WithStateMachineData(FCreateStateRaw fCreateStateRaw, const CStateParent* const pParent = NULL);
 
       public:
          bool                IsValid(void) const;
-         const FCreateState& Get(void) const;
+         CState*             Create(TYPESEL::weak_ptr<CStateMachine> wpStateMachine, CStateMachineData* const pStateMachineData) const;
+         FCreateState        Get(void) const;
+         FCreateStateRaw     GetSharedKey(void) const;
+         bool                IsShareable(void) const;
+         const CStateParent* GetParent(void) const;
+         CCreateState        CreateParent(const CStateParent& parent) const;
+
+      private:
+         class CGeneric;
+         static CState*      CreateGeneric(TYPESEL::weak_ptr<CStateMachine> wpStateMachine, void* pContext);
+         static void         GenericAddRef(void* const pContext);
+         static void         GenericRelease(void* const pContext);
+
+      private:
+         static char                             s_StateMachineData; //< Its address is the context of an instance created by WithStateMachineData.
 
       private:
-         bool                m_bValid;       //< When true the FCreateFunction is valid and can be called.
-         FCreateState        m_fCreateState; //< When called this function creates a new state in the state machine.
+         FCreateStateRaw                         m_fCreateStateRaw; //< When not NULL, calling this function with m_pContext creates a new state in the state machine.
+         void*                                   m_pContext;        //< Context provided to m_fCreateStateRaw (e.g. the state machine data), the CGeneric for a generic function, &s_StateMachineData for the data of the state machine creating the state.
+         const CStateParent*                     m_pParent;         //< Parent of the state created, NULL for a top-level state.
    };
 }
 
@@ -22,28 +22,54 @@
 #ifndef __ILULibStateMachine_CEventBase_H__
 #define __ILULibStateMachine_CEventBase_H__
 
+#include <stddef.h>
+#include <string>
+#include <typeinfo>
+
 #include "Types.h"
 
 namespace ILULibStateMachine {
+   class CTraceRecord;
+
    /** @brief Virtual base class used by the state machine engine to store event handlers in a map.
     ** 
     ** This class is the event key in the map, thus it has to be strictly ordered
     ** (operator<). This is accomplished by starting the comparison with the type id
     ** and using them as the primary key. Only when these match the 'CompareTypeIdIdentical'
     ** function is called to compare 2 instances of the same type.
+    **
+    ** A key is created for every registered handler and for every event fed
+    ** into a state machine, so it is kept compact: the dynamic type acts as
+    ** the type tag, the derived class adds the event ID's and the only
+    ** member here is the type info of the event data. The textual
+    ** descriptions are only used for tracing and are derived on demand.
     **/
    class CEventBase {
+      public:
+         /** Called for each wildcard prefix of an event (see ForEachPrefix).
+          **
+          ** @return true to stop.
+          **/
+         typedef bool (*FPrefix)(void* pContext, CEventBase& prefix);
+
       public:
          virtual                    ~CEventBase(void);
 
       public:
          bool                       operator<(const CEventBase& ref) const;
-         virtual const std::string& GetId(void) const;
-         virtual const std::string& GetIdType(void) const;
-         virtual const std::string& GetDataType(void) const;
+         virtual std::string        GetId(void) const = 0;
+         virtual const std::string& GetIdType(void) const = 0;
+         std::string                GetDataType(void) const;
+         virtual void               TraceKey(CTraceRecord& record) const = 0;
+         virtual bool               DenseSlot(const void*& pTag, size_t& slot, size_t& slots) const;
+         virtual bool               IsPrefix(void) const;
+         virtual bool               ForEachPrefix(FPrefix fPrefix, void* pContext) const;
+         virtual bool               RangeKey(const void*& pTag, long& first, long& last) const;
+         virtual bool               RangeValue(const void*& pTag, long& value) const;
 
       protected:
-                                    CEventBase(const std::string& strId, const std::string& strIdType, const std::string& strDataType);
+                                    CEventBase(const std::type_info& typeinfo);
+         static std::string         Demangle(const std::type_info& typeinfo);
 
       private:
                                     CEventBase(const CEventBase& ref);
@@ -51,9 +77,7 @@ namespace ILULibStateMachine {
          virtual bool               CompareTypeIdIdentical(const CEventBase& ref) const = 0;
 
       private:
-         const std::string          m_strId;
-         const std::string          m_strIdType;
-         const std::string          m_strDataType;
+         const std::type_info* const m_pDataType; //< Type of the event data, tracing only.
 
    };
 
@@ -0,0 +1,184 @@
+/** @file
+ ** @brief The CHandlerTable declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CHandlerTable__H__
+#define __ILULibStateMachine_CHandlerTable__H__
+
+#include "map"
+#include "string"
+#include "vector"
+
+#include "CCreateState.h"
+#include "CHandleEventInfoBase.h"
+#include "CMemoryResource.h"
+#include "CSPEventBaseSort.h"
+#include "TAllocator.h"
+
+namespace ILULibStateMachine {
+   /** @brief The event handlers and event-type handlers registered by
+    ** one state.
+    **
+    ** A state machine owns one table for its current state and one for its
+    ** default state. Handlers that are not bound to a state instance (see
+    ** HANDLER_SHARED) can be registered in a table that is shared by all
+    ** state machines using the same state class: the flyweight pattern.
+    ** Such a shared table is built once, by the first state machine
+    ** constructing the state, and sealed afterwards. From then on
+    ** constructing that state does not allocate anything for its shared
+    ** registrations.
+    **
+    ** Shared tables are kept in a process wide registry (SharedAcquire and
+    ** SharedRelease) keyed on the raw function creating the state. They are
+    ** never deleted.
+    **
+    ** The maps and handle-event-info instances of a table are allocated
+    ** from the table's memory resource: the arena of the state machine
+    ** owning it (see CMemoryArena) or the heap. Shared tables always use
+    ** the heap.
+    **
+    ** Handlers for event ID's of a dense type (see TEvtIdDense) are
+    ** indexed in a flat array per event ID type as well: EventFind does
+    ** a bounds check and an indexed load for them instead of a map
+    ** lookup. The map remains the owner of the handle-event-info
+    ** instances.
+    **
+    ** Handlers can be registered for a prefix of the event sub-ID's (see
+    ** TEvtSubAny). When an event has no exact match and the table holds
+    ** such wildcard registrations, EventFind looks up the prefixes of the
+    ** event, longest first: 1 map lookup per prefix length.
+    **
+    ** Handlers can be registered for a range of event ID's (see
+    ** TEvtIdRange). The ranges are indexed in an array sorted on event ID
+    ** type and first event ID: an event without a handler for its event ID
+    ** or a prefix is looked up in it with a binary search.
+    **
+    ** The implementation of the template functions is put in a seperate header file (included by this
+    ** header) to keep the class declaration clean.
+    **/
+   class CHandlerTable {
+      public:
+         typedef std::pair<SPEventBase, SPHandleEventInfoBase>                  EventPair;       //< pair coupling an event ID to a handle-event-info instance
+         typedef std::map<SPEventBase, SPHandleEventInfoBase, CSPEventBaseSort, TAllocator<std::pair<const SPEventBase, SPHandleEventInfoBase> > > EventMap; //< map of event ID/handle-event-info pairs, do use custom sort because we do not want to sort pointer values
+         typedef EventMap::iterator                                             EventMapIt;      //< iterator for the event map
+         typedef EventMap::const_iterator                                       EventMapCIt;     //< const iterator for the event map
+         typedef std::pair<std::string, SPHandleEventInfoBase>                  EventTypePair;   //< pair coupling an event ID to a handle-event-info instance
+         typedef std::map<std::string, SPHandleEventInfoBase, std::less<std::string>, TAllocator<std::pair<const std::string, SPHandleEventInfoBase> > > EventTypeMap; //< map of event ID/handle-event-info pairs
+         typedef EventTypeMap::iterator                                         EventTypeMapIt;  //< iterator for the event map
+         typedef EventTypeMap::const_iterator                                   EventTypeMapCIt; //< const iterator for the event map
+
+      private:
+         /** @brief The flat array of handlers for the event ID's of 1
+          ** dense type, indexed by the event ID (see TEvtIdDense).
+          **/
+         class CDenseTable {
+            public:
+               typedef std::vector<CHandleEventInfoBase*, TAllocator<CHandleEventInfoBase*> > Slots; //< handle-event-info per event ID, NULL when none. Owned by the map.
+
+            public:
+                                        CDenseTable(const void* const pTag, const size_t slots, CMemoryResource* const pResource);
+
+            public:
+               const void*              m_pTag;   //< Identifies the event ID type, see CEventBase::DenseSlot.
+               Slots                    m_Slots;  //< The handle-event-info per event ID.
+         };
+         typedef std::vector<CDenseTable, TAllocator<CDenseTable> >              DenseTables;     //< the flat arrays, 1 per dense event ID type
+
+         /** @brief A range registration (see TEvtIdRange).
+          **/
+         class CRange {
+            public:
+               const void*              m_pTag;             //< Identifies the event ID type, see CEventBase::RangeKey.
+               long                     m_First;            //< The first event ID of the range.
+               long                     m_Last;             //< The last event ID of the range.
+               CHandleEventInfoBase*    m_pHandleEventInfo; //< The handle-event-info, owned by the map.
+         };
+         typedef std::vector<CRange, TAllocator<CRange> >                        Ranges;          //< the range registrations, sorted on tag and first event ID
+
+         /** @brief The context of a prefix lookup (see PrefixFind).
+          **/
+         class CPrefixFind {
+            public:
+               const EventMap*          m_pEventMap;        //< The map to look in.
+               CHandleEventInfoBase*    m_pHandleEventInfo; //< The result, NULL when not found (yet).
+         };
+
+      public:
+                                     CHandlerTable(CMemoryResource* const pResource = NULL);
+                                     ~CHandlerTable(void);
+
+      public:
+         static CHandlerTable*       SharedAcquire(FCreateStateRaw fCreateStateRaw, bool& bBuild);
+         static void                 SharedRelease(FCreateStateRaw fCreateStateRaw, const bool bSeal);
+
+      public:
+         template <class TEventData, class TTypeHandler>
+         void                        EventTypeRegister(
+            const bool         bDefault    ,
+            const std::string& strEventType,
+            const TTypeHandler& typeHandler,
+            CCreateState       createState   
+            );
+         template <class TEventData, class THandler>
+         void                        EventRegister(
+            const bool         bDefault        ,
+            const THandler&    unguardedHandler,
+            CCreateState       createState     ,
+            SPEventBase        spEventBase    
+            );
+         template <class TEventData, class TGuard, class THandler>
+         bool                        EventRegister(
+            const bool         bDefault   ,
+            const TGuard&      guard      ,
+            const THandler&    handler    ,
+            CCreateState       createState,
+            SPEventBase        spEventBase    
+            );
+         CHandleEventInfoBase*       EventFind(const SPEventBase& spEventBase) const;
+         CHandleEventInfoBase*       EventTypeFind(const std::string& strEventType) const;
+         size_t                      EventCount(void) const;
+         size_t                      EventTypeCount(void) const;
+         void                        EventKeys(std::vector<SPEventBase>& events, std::vector<std::string>& eventTypes) const;
+         void                        Clear(void);
+         void                        TraceHandlers(void) const;
+         void                        TraceTypeHandlers(void) const;
+
+      private:
+                                     CHandlerTable(CHandlerTable& ref); //defined, not implemented --> avoid copy
+         CHandlerTable               operator=(CHandlerTable& ref);     //defined, not implemented --> avoid copy
+         void                        EventIndex(const SPEventBase& spEventBase, CHandleEventInfoBase* const pHandleEventInfo);
+         static bool                 PrefixFind(void* pContext, CEventBase& prefix);
+         CHandleEventInfoBase*       RangeFind(const SPEventBase& spEventBase) const;
+         static bool                 RangeLess(const CRange& a, const CRange& b);
+
+      private:
+         CMemoryResource* const      m_pResource;    //< Resource the table contents are allocated from, NULL for the heap.
+         EventMap                    m_EventMap;     //< Map of event handlers.
+         EventTypeMap                m_EventTypeMap; //< Map of event-type handlers.
+         DenseTables                 m_DenseTables;  //< Flat arrays of the event handlers with a dense event ID, see TEvtIdDense.
+         size_t                      m_Prefixes;     //< Number of wildcard registrations, see TEvtSubAny.
+         Ranges                      m_Ranges;       //< Range registrations, see TEvtIdRange.
+   };
+}
+
+//include the class template function definitions.
+#include "CHandlerTableImpl.h"
+
+#endif //__ILULibStateMachine_CHandlerTable__H__
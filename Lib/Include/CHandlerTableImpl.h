@@ -0,0 +1,203 @@
+/** @file
+ ** @brief The CHandlerTable template function defintions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CHandlerTableImpl__H__
+#define __ILULibStateMachine_CHandlerTableImpl__H__
+
+#include "stdexcept"
+
+#include "CLogLevel.h"
+#include "Logging.h"
+#include "THandleEventInfo.h"
+#include "THandleEventTypeInfo.h"
+
+namespace ILULibStateMachine {
+   /** Register an event-type handler.
+    **
+    ** TTypeHandler is either a bound handler (THandleEventTypeInfo::BFTypeHandler)
+    ** or a shared handler (THandleEventTypeInfo::FSharedTypeHandler*).
+    **/
+   template <class TEventData, class TTypeHandler>
+   void CHandlerTable::EventTypeRegister(
+      const bool         bDefault,     //< Default state (true) or current state (false), logging only.
+      const std::string& strEventType, //< String representation of the event type.
+      const TTypeHandler& typeHandler, //< The handler to be registered.
+      CCreateState       createState   //< The state transition accompanying this event-type.
+      )
+   {
+      try {
+         const EventTypeMapIt it = m_EventTypeMap.find(strEventType);
+         if(m_EventTypeMap.end() == it) {
+            if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+               LogDebug("Register type event handler for [%s] from [%s]\n",
+                        strEventType.c_str(),
+                        (bDefault ? "default" : "state")
+                        );
+            }
+            m_EventTypeMap.insert(EventTypePair(strEventType, TYPESEL::allocate_shared<THandleEventTypeInfo<TEventData> >(TAllocator<THandleEventTypeInfo<TEventData> >(m_pResource), typeHandler, createState)));
+         } else {
+            //event already in the map
+            if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+               LogErr("Register type event handler for [%s] from [%s] failed: already registered\n",
+                      strEventType.c_str(),
+                      (bDefault ? "default" : "state")
+                      );
+            }
+         }
+      } catch(std::exception& ex) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event type handler registration failed for [%s]: %s\n",
+                   strEventType.c_str(),
+                   ex.what()
+                   );
+         }
+      } catch(...) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event type handler registration failed for [%s]: %s\n",
+                   strEventType.c_str(),
+                   "unknown"
+                   );
+         }
+      }
+   }
+
+   /** Register an unguarded event handler.
+    **
+    ** THandler is either a bound handler (THandleEventInfo::BFHandler)
+    ** or a shared handler (THandleEventInfo::FSharedHandler*).
+    **/
+   template <class TEventData, class THandler>
+   void CHandlerTable::EventRegister(
+      const bool   bDefault,         //< Default state (true) or current state (false), logging only.
+      const THandler& unguardedHandler, //< The handler to be registered.
+      CCreateState createState,      //< The state transition accompanying this event-type.
+      SPEventBase  spEventBase       //< The complete event identification that triggers this handler.
+      )
+   {
+      try {
+         const EventMapIt it = m_EventMap.find(spEventBase);
+         if(m_EventMap.end() == it) {
+            if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+               LogDebug("Register unguarded event handler for [%s] from [%s]\n",
+                        spEventBase->GetId().c_str(),
+                        (bDefault ? "default" : "state")
+                        );
+            }
+            EventIndex(spEventBase, m_EventMap.insert(EventPair(spEventBase, TYPESEL::allocate_shared<THandleEventInfo<TEventData> >(TAllocator<THandleEventInfo<TEventData> >(m_pResource), unguardedHandler, createState, m_pResource))).first->second.get());
+         } else {
+            //event already in the map
+            //--> set the default handler
+            //    (will throw when the default handler has already been set)
+            if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+               LogDebug("Set unguarded event handler for [%s] from [%s]\n",
+                        spEventBase->GetId().c_str(),
+                        (bDefault ? "default" : "state")
+                        );
+            }
+            THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(it->second.get());
+            if(NULL == pHandleEventInfo) {
+               //serious error in the implementation: mismatch in registration
+               throw std::runtime_error("IMPLEMENTATION ERROR: registration mismatch found in unguarded event handler");
+            }
+            pHandleEventInfo->SetUnguardedHandler(unguardedHandler, createState);
+         }
+      } catch(std::exception& ex) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event default handler registration failed for [%s]: %s\n",
+                   spEventBase->GetId().c_str(),
+                   ex.what()
+                   );
+         }
+      } catch(...) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event default handler registration failed for [%s]: %s\n",
+                   spEventBase->GetId().c_str(),
+                   "unknown"
+                   );
+         }
+      }
+   }
+
+   /** Register a guarded event handler.
+    **
+    ** TGuard and THandler are either bound (THandleEventInfo::BFGuard and
+    ** THandleEventInfo::BFHandler) or shared (THandleEventInfo::FSharedGuard*
+    ** and THandleEventInfo::FSharedHandler*).
+    **/
+   template <class TEventData, class TGuard, class THandler>
+   bool CHandlerTable::EventRegister(
+      const bool   bDefault,    //< Default state (true) or current state (false), logging only.
+      const TGuard&   guard,       //< The guard called before the handler. When the guard returns true, the handler is called; when the guard returns false the handler is not called.
+      const THandler& handler,     //< The handler to be registered.
+      CCreateState createState, //< The state transition accompanying this event-type.
+      SPEventBase  spEventBase  //< The complete event identification that triggers this handler.
+      )
+   {
+      try {
+         const EventMapIt it = m_EventMap.find(spEventBase);
+         if(m_EventMap.end() == it) {
+            //event with the specified ID not yet in the map
+            //--> add it with a guarded handler
+            if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+               LogDebug("Register event guard/handler combo for [%s] from [%s]\n",
+                        spEventBase->GetId().c_str(),
+                        (bDefault ? "default" : "state")
+                        );
+            }
+            EventIndex(spEventBase, m_EventMap.insert(EventPair(spEventBase, TYPESEL::allocate_shared<THandleEventInfo<TEventData> >(TAllocator<THandleEventInfo<TEventData> >(m_pResource), guard, handler, createState, m_pResource))).first->second.get());
+         } else {
+            //event already in the map
+            //--> add a guarded handler
+            if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+               LogDebug("Add event guard/handler combo for [%s] from [%s]\n",
+                        spEventBase->GetId().c_str(),
+                        (bDefault ? "default" : "state")
+                        );
+            }
+            THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(it->second.get());
+            if(NULL == pHandleEventInfo) {
+               //serious error in the implementation: mismatch in registration
+               throw std::runtime_error("IMPLEMENTATION ERROR: registration mismatch found in guarded event handler");
+            }
+            pHandleEventInfo->AddGuardedHandler(guard, handler, createState);
+         }
+         return true;
+      } catch(std::exception& ex) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event guard/handler combo registration failed for [%s]: %s\n",
+                   spEventBase->GetId().c_str(),
+                   ex.what()
+                   );
+         }
+         return false;
+      } catch(...) {
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Event guard/handler combo registration failed for [%s]: %s\n",
+                   spEventBase->GetId().c_str(),
+                   "unknown"
+                   );
+         }
+         return false;
+      }
+   }
+}
+
+#endif //__ILULibStateMachine_CHandlerTableImpl__H__
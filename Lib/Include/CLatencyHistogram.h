@@ -0,0 +1,143 @@
+/** @file
+ ** @brief The CLatencyHistogram and CLatencyRecorder declarations.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CLatencyHistogram__H__
+#define __ILULibStateMachine_CLatencyHistogram__H__
+
+#include <atomic>
+#include <string>
+
+#include "Types.h"
+
+namespace ILULibStateMachine {
+   /** @brief What a latency histogram measures.
+    **/
+   enum ELatency {
+      ELatencyHandler = 0, ///< Calling the handler (guards not included).
+      ELatencyStateChange, ///< The state change following the handler: destructing the old and constructing the new state.
+      ELatencyCount        ///< Number of latency kinds, not a kind.
+   };
+
+   /** @brief Identification of a latency histogram.
+    **/
+   class CLatencyKey {
+      public:
+                            CLatencyKey(const ELatency latency, const std::string& strMachine, const std::string& strState, const std::string& strEvent);
+
+      public:
+         static const char* GetName(const ELatency latency);
+         bool               operator<(const CLatencyKey& ref) const;
+
+      public:
+         ELatency           m_Latency;    ///< What is measured.
+         std::string        m_strMachine; ///< State machine name.
+         std::string        m_strState;   ///< State handling the event (handler) or state left (state change).
+         std::string        m_strEvent;   ///< Event ID (see CEventBase::GetId).
+   };
+
+   /** @brief Log-bucketed histogram of latencies in nanoseconds (HDR
+    ** histogram style).
+    **
+    ** Values below 8 ns have their own bucket, above that every power
+    ** of 2 is split in 8 buckets: a value is known within 12.5%. Values
+    ** beyond 2^40 ns (about 18 minutes) end up in the last bucket.
+    **
+    ** Like CStateMachineCounters, a histogram has a single writer
+    ** (relaxed load and store) and can be read by other threads.
+    **/
+   class CLatencyHistogram {
+      public:
+         static const unsigned int   SUB_BUCKET_BITS = 3;                                                  ///< 2^SUB_BUCKET_BITS buckets per power of 2.
+         static const unsigned int   SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;                               ///< Buckets per power of 2.
+         static const unsigned int   MAX_EXPONENT    = 40;                                                 ///< Highest power of 2 with its own buckets.
+         static const unsigned int   BUCKETS         = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS; ///< Number of buckets.
+
+      public:
+                                    CLatencyHistogram(void);
+
+      public:
+         void                       Record(const unsigned long long ns);
+         void                       Merge(const CLatencyHistogram& ref);
+         unsigned long long         GetCount(void) const;
+         unsigned long long         GetMax(void) const;
+         unsigned long long         GetMean(void) const;
+         unsigned long long         GetPercentile(const double percentile) const;
+         static unsigned int        GetBucket(const unsigned long long ns);
+         static unsigned long long  GetBucketMax(const unsigned int bucket);
+
+      private:
+                                    CLatencyHistogram(CLatencyHistogram& ref); //defined, not implemented --> avoid copy
+         CLatencyHistogram          operator=(CLatencyHistogram& ref);         //defined, not implemented --> avoid copy
+         static void                Add(std::atomic<unsigned long long>& counter, const unsigned long long n);
+
+      private:
+         std::atomic<unsigned long long> m_Buckets[BUCKETS]; ///< Number of values per bucket.
+         std::atomic<unsigned long long> m_Count;            ///< Number of values.
+         std::atomic<unsigned long long> m_Sum;              ///< Sum of the values (ns).
+         std::atomic<unsigned long long> m_Max;              ///< Highest value (ns).
+   };
+
+   /** @brief Collects the latency histograms of all state machines, per
+    ** state machine, state and event.
+    **
+    ** Sampling is disabled by default. When enabled, every Nth event fed
+    ** into a state machine by a thread is sampled: the handler and the
+    ** state change it triggers are timed and recorded. Events that are not
+    ** sampled cost 1 thread local counter, when disabled 1 relaxed load.
+    **
+    ** Every thread records in its own histograms: recording does not lock
+    ** (only the first sample of a new key does, to add its histogram).
+    ** ForEach merges the histograms of all threads, including the threads
+    ** that have already finished.
+    **
+    ** Compiled out with NO_RUNTIME_STATS.
+    **/
+   class CLatencyRecorder {
+      public:
+         static void                SetSampling(const unsigned int every);
+         static unsigned int        GetSampling(void);
+         static bool                Sample(void);
+         static void                Record(const CLatencyKey& key, const unsigned long long ns);
+         static void                ForEach(TYPESEL::function<void(const CLatencyKey&, const CLatencyHistogram&)> callback);
+
+      private:
+         static bool                SampleNext(const unsigned int every);
+
+      private:
+         static std::atomic<unsigned int> s_SampleEvery; ///< Sample every Nth event, 0 when disabled.
+   };
+
+   /** Decide whether the next event of the calling thread is sampled.
+    **
+    ** @return true when the event has to be sampled.
+    **/
+   inline bool CLatencyRecorder::Sample(void)
+   {
+#ifndef NO_RUNTIME_STATS
+      const unsigned int every(s_SampleEvery.load(std::memory_order_relaxed));
+      return 0 != every && SampleNext(every);
+#else
+      return false;
+#endif
+   }
+}
+
+#endif //__ILULibStateMachine_CLatencyHistogram__H__
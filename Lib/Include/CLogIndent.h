@@ -27,11 +27,17 @@ namespace ILULibStateMachine {
     **
     ** When an instance is constructed: indentation is increased 1 level.
     ** When an instance is destructed: indentation is decreased 1 level.
+    ** Constructed with false the instance does nothing (e.g. when nothing
+    ** consumes any logging, see CLogLevelScope::IsIndented).
     **/
    class CLogIndent {
       public:
          CLogIndent(void);
+         explicit CLogIndent(const bool bIndent);
          ~CLogIndent(void);
+
+      private:
+         const bool m_bIndent; //< The indentation has been increased: decrease it upon destruction.
    };
 };
 
@@ -0,0 +1,147 @@
+/** @file
+ ** @brief The CLogLevel declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CLogLevel_H__
+#define __ILULibStateMachine_CLogLevel_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include "Logging.h"
+
+namespace ILULibStateMachine {
+   //forward declaration
+   class CStateMachine;
+
+   /** @brief The log level of the engine's logging per state machine.
+    **
+    ** Every state machine has a log level: the lowest level the engine
+    ** logs for it (ELogLevelDebug: everything, ELogLevelErr: only errors,
+    ** ELogLevelCount: nothing). The engine checks it before formatting a
+    ** logging, so a state machine that does not log costs a single load
+    ** of its level per event: no state names are looked up and no
+    ** registered logging function is called. The loggings of the handlers
+    ** themselves are not affected.
+    **
+    ** A state machine takes the global level (default ELogLevelDebug, the
+    ** registered logging functions decide what is shown), unless a rule
+    ** matches its ID (see CStateMachine::GetId) or, with a lower priority,
+    ** its name. Changing the global level or the rules updates the live
+    ** state machines (see CStateMachineRegistry) and the ones constructed
+    ** afterwards, e.g. to raise the level of 1 session of a server to debug
+    ** while the other sessions only log errors.
+    **
+    ** A level without a consumer (an empty registered logging function,
+    ** e.g. the debug level by default, see Logging.h) is off for all state
+    ** machines: the engine does not format its loggings either.
+    **/
+   class CLogLevel {
+      public:
+         static void                SetGlobal(const ELogLevel level);
+         static ELogLevel           GetGlobal(void);
+         static void                SetName(const std::string& strName, const ELogLevel level);
+         static void                SetId(const uint64_t id, const ELogLevel level);
+         static void                ResetName(const std::string& strName);
+         static void                ResetId(const uint64_t id);
+         static void                ResetAll(void);
+
+      private:
+         friend class CStateMachine;
+         static void                Apply(const CStateMachine& stateMachine);
+         static void                ApplyLocked(const CStateMachine& stateMachine);
+         static void                ApplyAll(void);
+   };
+
+   /** @brief The log level of the engine's logging in this thread, while
+    ** the instance exists.
+    **
+    ** A state machine sets its level while it handles an event or changes
+    ** state, so the code it calls (handler tables, handler infos) checks
+    ** the level of the state machine it runs for without getting it
+    ** passed. The previous level is restored upon destruction: a handler
+    ** feeding an event into another state machine logs with the level of
+    ** its own state machine again once that one is done.
+    **/
+   class CLogLevelScope {
+      public:
+         inline explicit CLogLevelScope(const uint8_t level)
+            : m_Previous(s_Level)
+         {
+            s_Level = level;
+         }
+         inline ~CLogLevelScope(void)
+         {
+            s_Level = m_Previous;
+         }
+
+      public:
+         /** Indicates whether the engine logs at the level in this thread.
+          **
+          ** @return true when the engine logs at the level.
+          **/
+         static inline bool IsEnabled(
+            const ELogLevel level //< The level to check.
+            )
+         {
+            return s_Level <= static_cast<uint8_t>(level) && IsConsumed(level);
+         }
+
+         /** Indicates whether anything consumes the loggings of the level:
+          ** a registered logging function or deferred-formatting logging.
+          **
+          ** @return true when consumed.
+          **/
+         static inline bool IsConsumed(
+            const ELogLevel level //< The level to check.
+            )
+         {
+            return 0 != (s_Consumers.load(std::memory_order_relaxed) & (1u << level));
+         }
+
+         /** Indicates whether the engine indents the logging (CLogIndent).
+          **
+          ** The indentation also applies to what the states log themselves
+          ** (e.g. a LogInfo in a state constructor or a handler), whatever
+          ** the level of the engine, so it does not depend on that level:
+          ** the engine only skips it when nothing consumes any level.
+          **
+          ** @return true when indented.
+          **/
+         static inline bool IsIndented(void)
+         {
+            return 0 != s_Consumers.load(std::memory_order_relaxed);
+         }
+
+         static void        SetConsumers(const unsigned int consumers);
+
+      private:
+                                    CLogLevelScope(CLogLevelScope& ref); //defined, not implemented --> avoid copy
+         CLogLevelScope             operator=(CLogLevelScope& ref);      //defined, not implemented --> avoid copy
+
+      private:
+         const uint8_t               m_Previous; //< The level when the instance was constructed, restored upon destruction.
+         static thread_local uint8_t s_Level;    //< The current level of this thread, ELogLevelDebug outside any state machine.
+         static std::atomic<unsigned int> s_Consumers; //< Bit per level with a consumer.
+   };
+};
+
+#endif //__ILULibStateMachine_CLogLevel_H__
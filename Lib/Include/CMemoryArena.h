@@ -0,0 +1,81 @@
+/** @file
+ ** @brief The CMemoryArena declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CMemoryArena__H__
+#define __ILULibStateMachine_CMemoryArena__H__
+
+#include "CMemoryResource.h"
+
+namespace ILULibStateMachine {
+   /** @brief Per state machine arena: a monotonic memory resource.
+    **
+    ** Memory is taken from chunks allocated on the heap, by bumping a
+    ** pointer. Small blocks that are returned are kept on a free list per
+    ** size class, so the states and handler tables that come and go with
+    ** every state transition reuse the same memory. Blocks larger than
+    ** MAX_SMALL_SIZE fall back to the heap.
+    **
+    ** All chunks are released at once when the arena is destructed.
+    ** The arena is not thread safe: it belongs to 1 state machine.
+    **/
+   class CMemoryArena : public CMemoryResource {
+      public:
+         static const size_t MAX_SMALL_SIZE = 512; ///< Larger blocks are allocated on the heap.
+         static const size_t GRANULE        = 16;  ///< Size class granularity, also the alignment of all blocks.
+
+      public:
+                       CMemoryArena(const size_t chunkSize);
+         virtual       ~CMemoryArena(void);
+
+      public:
+         virtual void* Allocate  (const size_t size, const size_t alignment);
+         virtual void  Deallocate(void* const p, const size_t size, const size_t alignment);
+         size_t        GetChunkBytes(void) const;
+
+      private:
+                       CMemoryArena(CMemoryArena& ref); //defined, not implemented --> avoid copy
+         CMemoryArena  operator=(CMemoryArena& ref);    //defined, not implemented --> avoid copy
+         void          AddChunk(void);
+
+      private:
+         /** @brief Header of a chunk, chunks are kept in a single linked list.
+          **/
+         struct SChunk {
+            SChunk* m_pNext; ///< Next (older) chunk.
+            size_t  m_Size;  ///< Chunk size including this header.
+         };
+         /** @brief A returned block, kept in a single linked list per size class.
+          **/
+         struct SFree {
+            SFree*  m_pNext; ///< Next free block of the same size class.
+         };
+
+      private:
+         const size_t  m_ChunkSize;                           ///< Size of each chunk.
+         SChunk*       m_pChunks;                             ///< Most recent chunk, head of the chunk list.
+         char*         m_pCurrent;                            ///< Next free byte in the most recent chunk.
+         char*         m_pEnd;                                ///< End of the most recent chunk.
+         size_t        m_ChunkBytes;                          ///< Total number of bytes in all chunks.
+         SFree*        m_FreeLists[MAX_SMALL_SIZE / GRANULE]; ///< Free list per size class.
+   };
+}
+
+#endif //__ILULibStateMachine_CMemoryArena__H__
@@ -0,0 +1,47 @@
+/** @file
+ ** @brief The CMemoryResource declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CMemoryResource__H__
+#define __ILULibStateMachine_CMemoryResource__H__
+
+#include <cstddef>
+
+namespace ILULibStateMachine {
+   /** @brief Interface of a memory resource a state machine can allocate
+    ** its internal objects from (see CMemoryArena).
+    **
+    ** A NULL resource pointer means: use the heap. The MemoryAllocate and
+    ** MemoryDeallocate helpers take care of that fallback.
+    **/
+   class CMemoryResource {
+      public:
+         virtual       ~CMemoryResource(void);
+
+      public:
+         virtual void* Allocate  (const size_t size, const size_t alignment) = 0;
+         virtual void  Deallocate(void* const p, const size_t size, const size_t alignment) = 0;
+   };
+
+   void* MemoryAllocate  (CMemoryResource* const pResource, const size_t size, const size_t alignment);
+   void  MemoryDeallocate(CMemoryResource* const pResource, void* const p, const size_t size, const size_t alignment);
+}
+
+#endif //__ILULibStateMachine_CMemoryResource__H__
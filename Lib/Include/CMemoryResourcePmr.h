@@ -0,0 +1,158 @@
+/** @file
+ ** @brief The CMemoryResourcePmr declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CMemoryResourcePmr__H__
+#define __ILULibStateMachine_CMemoryResourcePmr__H__
+
+#if __cplusplus >= 201703L
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "CMemoryResource.h"
+
+namespace ILULibStateMachine {
+   /** @brief Adapter to let a state machine allocate from a
+    ** std::pmr::memory_resource (C++17 only).
+    **
+    ** Created by the ConstructStateMachine overloads taking a
+    ** std::pmr::memory_resource and owned by the state machine. The adapter
+    ** itself is allocated from the upstream resource as well, so nothing
+    ** owned by the state machine is allocated from the heap: its operator
+    ** new stores the upstream resource in front of the instance, so
+    ** operator delete can return the memory to it.
+    **
+    ** The upstream resource is not owned: it has to outlive the state
+    ** machine and all weak pointers to it.
+    **/
+   class CMemoryResourcePmr : public CMemoryResource {
+      public:
+         explicit            CMemoryResourcePmr(std::pmr::memory_resource* const pUpstream);
+         virtual             ~CMemoryResourcePmr(void);
+
+      public:
+         static void*        operator new   (size_t size, std::pmr::memory_resource* const pUpstream);
+         static void         operator delete(void* p, std::pmr::memory_resource* const pUpstream);
+         static void         operator delete(void* p, size_t size);
+
+      public:
+         virtual void*       Allocate  (const size_t size, const size_t alignment);
+         virtual void        Deallocate(void* const p, const size_t size, const size_t alignment);
+         std::pmr::memory_resource* GetUpstream(void) const;
+
+      private:
+                             CMemoryResourcePmr(CMemoryResourcePmr& ref); //defined, not implemented --> avoid copy
+         CMemoryResourcePmr  operator=(CMemoryResourcePmr& ref);          //defined, not implemented --> avoid copy
+
+      private:
+         static const size_t HEADER_SIZE = alignof(std::max_align_t); ///< Room in front of the instance to store the upstream resource, keeps the instance aligned.
+
+      private:
+         std::pmr::memory_resource* const m_pUpstream; ///< The resource all allocations are forwarded to, not owned.
+   };
+
+   /** Constructor.
+    **/
+   inline CMemoryResourcePmr::CMemoryResourcePmr(
+      std::pmr::memory_resource* const pUpstream //< The resource to forward all allocations to, not owned.
+      )
+      : m_pUpstream(pUpstream)
+   {
+   }
+
+   /** Destructor.
+    **/
+   inline CMemoryResourcePmr::~CMemoryResourcePmr(void)
+   {
+   }
+
+   /** Allocate an adapter instance from the upstream resource.
+    **
+    ** @return the memory for the instance, behind a header holding the upstream resource.
+    **/
+   inline void* CMemoryResourcePmr::operator new(
+      size_t                           size,     //< Size of the instance.
+      std::pmr::memory_resource* const pUpstream //< The resource to allocate from.
+      )
+   {
+      char* const pBlock(static_cast<char*>(pUpstream->allocate(HEADER_SIZE + size, alignof(std::max_align_t))));
+      *reinterpret_cast<std::pmr::memory_resource**>(pBlock) = pUpstream;
+      return pBlock + HEADER_SIZE;
+   }
+
+   /** Return the memory of an adapter instance whose constructor threw.
+    **/
+   inline void CMemoryResourcePmr::operator delete(
+      void*                            p,        //< The memory returned by operator new.
+      std::pmr::memory_resource* const pUpstream //< The resource it was allocated from.
+      )
+   {
+      pUpstream->deallocate(static_cast<char*>(p) - HEADER_SIZE, HEADER_SIZE + sizeof(CMemoryResourcePmr), alignof(std::max_align_t));
+   }
+
+   /** Return the memory of an adapter instance to the upstream resource
+    ** stored in front of it.
+    **/
+   inline void CMemoryResourcePmr::operator delete(
+      void*  p,   //< The memory returned by operator new.
+      size_t size //< Size of the instance.
+      )
+   {
+      char* const pBlock(static_cast<char*>(p) - HEADER_SIZE);
+      (*reinterpret_cast<std::pmr::memory_resource**>(pBlock))->deallocate(pBlock, HEADER_SIZE + size, alignof(std::max_align_t));
+   }
+
+   /** Allocate from the upstream resource.
+    **
+    ** @return the allocated memory, the upstream resource throws on failure.
+    **/
+   inline void* CMemoryResourcePmr::Allocate(
+      const size_t size,     //< Number of bytes.
+      const size_t alignment //< Required alignment.
+      )
+   {
+      return m_pUpstream->allocate(size, alignment);
+   }
+
+   /** Return memory to the upstream resource.
+    **/
+   inline void CMemoryResourcePmr::Deallocate(
+      void* const  p,        //< The memory to return.
+      const size_t size,     //< Number of bytes, as provided to Allocate.
+      const size_t alignment //< Alignment, as provided to Allocate.
+      )
+   {
+      m_pUpstream->deallocate(p, size, alignment);
+   }
+
+   /** Get the resource all allocations are forwarded to.
+    **
+    ** @return the upstream resource.
+    **/
+   inline std::pmr::memory_resource* CMemoryResourcePmr::GetUpstream(void) const
+   {
+      return m_pUpstream;
+   }
+}
+
+#endif //__cplusplus >= 201703L
+
+#endif //__ILULibStateMachine_CMemoryResourcePmr__H__
@@ -30,7 +30,7 @@ namespace ILULibStateMachine {
     **/
    class CSPEventBaseSort {
       public:
-         bool operator()(SPEventBase a, SPEventBase b);
+         bool operator()(SPEventBase a, SPEventBase b) const;
    };
 };
 
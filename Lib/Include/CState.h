@@ -22,6 +22,7 @@
 #ifndef __ILULibStateMachine_CState__H__
 #define __ILULibStateMachine_CState__H__
 
+#include <cstddef>
 #include <string>
 
 namespace ILULibStateMachine {
@@ -33,12 +34,19 @@ namespace ILULibStateMachine {
     **
     ** SPStateMachineData is NOT a member as this would require casting CStateMachineData to the actual
     ** data class whenever it is used. Thus it is stored directly in the derived state classes instead.
+    **
+    ** States are allocated from the arena of the state machine constructing them (when it has one),
+    ** hence the class specific operator new and delete.
     **/
    class CState {
       public:
                             CState(const char* const szName, const bool bDefault = false);
          virtual            ~CState(void);
 
+      public:
+         static void*       operator new(size_t size);
+         static void        operator delete(void* p);
+
       public:
          const std::string& GetName(void) const;
 
@@ -41,6 +41,13 @@ namespace ILULibStateMachine {
     ** invalid template instantiation, the parameters setting the handlers and create state (present in
     ** all overloads) preceed the event identification parameters.
     **
+    ** Each register function has an overload taking plain function pointers (see HANDLER_SHARED,
+    ** GUARD_SHARED and HANDLER_TYPE_SHARED) instead of bound handlers. Those registrations are
+    ** stored in a handler table shared by all state machines using the state (see CHandlerTable).
+    **
+    ** The overloads without sub-ID's register a handler for a range of event ID's when the event ID
+    ** is a TEvtIdRange (see EVTID_RANGE): 1 registration instead of 1 per event ID in the range.
+    **
     ** The implementation of the template functions is put in a seperate header file (included by this
     ** header) to keep the class declaration clean.
     **/
@@ -121,6 +128,77 @@ namespace ILULibStateMachine {
             const EvtSubId3                                  evtSubId3      
             );
 
+         template <class TEventData>                                                    
+         void EventTypeRegister(
+            const std::string&                                                        strEventType,
+            void                                                                      (*typeHandler)(CState* pState, SPEventBase spEventBase, const TEventData* const),
+            CCreateState                                                              createState   
+            );
+         template <class TEventData, class EvtId>                                                    
+         void EventRegister(
+            void                                             (*unguardedHandler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId
+            );
+         template <class TEventData, class EvtId, class EvtSubId1>                                                    
+         void EventRegister(
+            void                                             (*unguardedHandler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>                                                    
+         void EventRegister(
+            void                                             (*unguardedHandler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1,
+            const EvtSubId2                                  evtSubId2
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>                                                    
+         void EventRegister(
+            void                                             (*unguardedHandler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1,
+            const EvtSubId2                                  evtSubId2,
+            const EvtSubId3                                  evtSubId3
+            );
+         template <class TEventData, class EvtId>                                                    
+         void EventRegister(
+            bool                                             (*guard)(CState* pState, const TEventData* const),
+            void                                             (*handler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId
+            );
+         template <class TEventData, class EvtId, class EvtSubId1>                                                    
+         void EventRegister(
+            bool                                             (*guard)(CState* pState, const TEventData* const),
+            void                                             (*handler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>                                                    
+         void EventRegister(
+            bool                                             (*guard)(CState* pState, const TEventData* const),
+            void                                             (*handler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1,
+            const EvtSubId2                                  evtSubId2
+            );
+         template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>                                                    
+         void EventRegister(
+            bool                                             (*guard)(CState* pState, const TEventData* const),
+            void                                             (*handler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            const EvtId                                      evtId,
+            const EvtSubId1                                  evtSubId1,
+            const EvtSubId2                                  evtSubId2,
+            const EvtSubId3                                  evtSubId3
+            );
+
       private:
          WPStateMachine     m_wpStateMachine; ///< Weak pointer to the state machine owning this state. Used to register event handlers in the state machine.
                                               //   It is private to avoid that subclasses are using this,
@@ -41,6 +41,7 @@ namespace ILULibStateMachine {
       CCreateState                                                              createState   //< Describes the state transition following this handler. 
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
@@ -61,11 +62,12 @@ namespace ILULibStateMachine {
       const EvtId                                      evtId             //< Event ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId> >(TAllocator<TEventEvtId<EvtId> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId));
    }
 
    /** Register an unguarded handler (handler called without checking a guard first) when an event
@@ -82,11 +84,12 @@ namespace ILULibStateMachine {
       const EvtSubId1                                  evtSubId1         //< First event sub-ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1> >(TAllocator<TEventEvtId<EvtId, EvtSubId1> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1));
    }
    
    /** Register an unguarded handler (handler called without checking a guard first) when an event
@@ -104,11 +107,12 @@ namespace ILULibStateMachine {
       const EvtSubId2                                  evtSubId2         //< Second event sub-ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1, evtSubId2));
    }
    
    /** Register an unguarded handler (handler called without checking a guard first) when an event
@@ -127,11 +131,12 @@ namespace ILULibStateMachine {
       const EvtSubId3                                evtSubId3         //< Third event sub-ID as defined by TEventEvtId.      
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>(typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3));
    }
    
    /** Register a guarded handler (handler called with checking a guard first) when an event
@@ -147,11 +152,12 @@ namespace ILULibStateMachine {
       const EvtId                                      evtId         //< Event ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId> >(TAllocator<TEventEvtId<EvtId> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId));
    }
 
    /** Register a guarded handler (handler called with checking a guard first) when an event
@@ -168,11 +174,12 @@ namespace ILULibStateMachine {
       const EvtSubId1                                  evtSubId1     //< First event sub-ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1> >(TAllocator<TEventEvtId<EvtId, EvtSubId1> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1));
    }
    
    /** Register a guarded handler (handler called with checking a guard first) when an event
@@ -190,11 +197,12 @@ namespace ILULibStateMachine {
       const EvtSubId2                                  evtSubId2     //< Second event sub-ID as defined by TEventEvtId.
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
-      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1, evtSubId2));
    }
    
    /** Register a guarded handler (handler called with checking a guard first) when an event
@@ -213,10 +221,247 @@ namespace ILULibStateMachine {
       const EvtSubId3                                  evtSubId3     //< Third event sub-ID as defined by TEventEvtId.      
       )
    {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(spStateMachine->GetMemoryResource()), typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3));
+   }
+   /** Register a shared event-type handler (see HANDLER_TYPE_SHARED).
+    **
+    ** Same as the EventTypeRegister taking a bound handler, but the
+    ** registration is stored in the handler table shared by all state
+    ** machines using this state.
+    **/
+   template <class TEventData>                                                    
+   void CStateEvtId::EventTypeRegister(
+      const std::string& strEventType,                                                             //< String representation of the event type.
+      void               (*typeHandler)(CState* pState, SPEventBase spEventBase, const TEventData* const), //< The shared event handler to be called.
+      CCreateState       createState                                                               //< Describes the state transition following this handler. 
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      spStateMachine->EventTypeRegister(m_bDefault, strEventType, typeHandler, createState);
+   }
+
+   /** Register a shared unguarded handler (see HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId>                                                    
+   void CStateEvtId::EventRegister(
+      void         (*unguardedHandler)(CState* pState, const TEventData* const), //< Shared event handler to be called.
+      CCreateState createState,                                                  //< Describes the state transition following this handler. 
+      const EvtId  evtId                                                         //< Event ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+   }
+
+   /** Register a shared unguarded handler (see HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1>                                                    
+   void CStateEvtId::EventRegister(
+      void         (*unguardedHandler)(CState* pState, const TEventData* const), //< Shared event handler to be called.
+      CCreateState createState,                                                  //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                                        //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1                                                  //< First event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+   }
+
+   /** Register a shared unguarded handler (see HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>                                                    
+   void CStateEvtId::EventRegister(
+      void         (*unguardedHandler)(CState* pState, const TEventData* const), //< Shared event handler to be called.
+      CCreateState createState,                                                  //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                                        //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1,                                                 //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2 evtSubId2                                                  //< Second event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+   }
+
+   /** Register a shared unguarded handler (see HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>                                                    
+   void CStateEvtId::EventRegister(
+      void         (*unguardedHandler)(CState* pState, const TEventData* const), //< Shared event handler to be called.
+      CCreateState createState,                                                  //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                                        //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1,                                                 //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2 evtSubId2,                                                 //< Second event sub-ID as defined by TEventEvtId.
+      const EvtSubId3 evtSubId3                                                  //< Third event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
       SPStateMachine spStateMachine = m_wpStateMachine.lock();
       if(!spStateMachine) {
          return;
       }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, unguardedHandler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>(typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
+   }
+
+   /** Register a shared guarded handler (see GUARD_SHARED and HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId>                                                    
+   void CStateEvtId::EventRegister(
+      bool         (*guard)(CState* pState, const TEventData* const),   //< Shared guard to be called.
+      void         (*handler)(CState* pState, const TEventData* const), //< Shared event handler to be called when the guard passes.
+      CCreateState createState,                                         //< Describes the state transition following this handler. 
+      const EvtId  evtId                                                //< Event ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+   }
+
+   /** Register a shared guarded handler (see GUARD_SHARED and HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1>                                                    
+   void CStateEvtId::EventRegister(
+      bool         (*guard)(CState* pState, const TEventData* const),   //< Shared guard to be called.
+      void         (*handler)(CState* pState, const TEventData* const), //< Shared event handler to be called when the guard passes.
+      CCreateState createState,                                         //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                               //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1                                         //< First event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+   }
+
+   /** Register a shared guarded handler (see GUARD_SHARED and HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>                                                    
+   void CStateEvtId::EventRegister(
+      bool         (*guard)(CState* pState, const TEventData* const),   //< Shared guard to be called.
+      void         (*handler)(CState* pState, const TEventData* const), //< Shared event handler to be called when the guard passes.
+      CCreateState createState,                                         //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                               //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1,                                        //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2 evtSubId2                                         //< Second event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
+      spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+   }
+
+   /** Register a shared guarded handler (see GUARD_SHARED and HANDLER_SHARED).
+    **
+    ** Same as the EventRegister taking bound handlers, but the registration
+    ** is stored in the handler table shared by all state machines using
+    ** this state. When that table is already complete, the registration
+    ** is skipped without building the event identification.
+    **/
+   template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>                                                    
+   void CStateEvtId::EventRegister(
+      bool         (*guard)(CState* pState, const TEventData* const),   //< Shared guard to be called.
+      void         (*handler)(CState* pState, const TEventData* const), //< Shared event handler to be called when the guard passes.
+      CCreateState createState,                                         //< Describes the state transition following this handler. 
+      const EvtId  evtId,                                               //< Event ID as defined by TEventEvtId.
+      const EvtSubId1 evtSubId1,                                        //< First event sub-ID as defined by TEventEvtId.
+      const EvtSubId2 evtSubId2,                                        //< Second event sub-ID as defined by TEventEvtId.
+      const EvtSubId3 evtSubId3                                         //< Third event sub-ID as defined by TEventEvtId.
+      )
+   {
+      ALLOCATION_SCOPE(NULL, EAllocationRegistration);
+      SPStateMachine spStateMachine = m_wpStateMachine.lock();
+      if(!spStateMachine) {
+         return;
+      }
+      if(spStateMachine->EventSharedSealed(createState)) {
+         return;
+      }
       spStateMachine->EventRegister(m_bDefault, guard, handler, createState, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>(typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
    }
 }
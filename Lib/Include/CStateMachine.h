@@ -22,15 +22,68 @@
 #ifndef __ILULibStateMachine_CStateMachine__H__
 #define __ILULibStateMachine_CStateMachine__H__
 
+#include <vector>
+
 #include "Types.h"
 
+#include "CAllocationStats.h"
 #include "CCreateState.h"
 #include "CHandleEventInfoBase.h"
+#include "CHandlerTable.h"
+#include "CLogLevel.h"
+#include "CMemoryArena.h"
+#include "CMemoryResource.h"
+#include "CMemoryResourcePmr.h"
 #include "CStateMachineData.h"
+#include "CStateMachineStats.h"
+#include "CThreadPool.h"
+#include "CTrace.h"
+#include "CUnhandledEvents.h"
+#include "TAllocator.h"
 #include "TEventEvtId.h"
 #include "CSPEventBaseSort.h"
 
 namespace ILULibStateMachine {
+   //forward declaration
+   class CBroadcast;
+
+   /** @brief An active parent state of a state machine (see
+    ** CStateMachine): the state, the handlers registered while it was
+    ** constructed and its shared handlers.
+    **/
+   class CStateLevel {
+      public:
+         CState*              m_pState;    //< The parent state, owned by the state machine.
+         CHandlerTable*       m_pHandlers; //< Handlers registered by the parent state, NULL when none. Owned by the state machine.
+         const CHandlerTable* m_pShared;   //< Shared handlers of the parent state (NULL when none), not owned.
+         FCreateStateRaw      m_Key;       //< Raw create function of the parent state: identifies it in the parent chain of a substate (see CStateParent).
+   };
+
+   /** Define the active parents of a state, outermost first.
+    **/
+   typedef std::vector<CStateLevel, TAllocator<CStateLevel> > StateLevels;
+
+   /** @brief An orthogonal region of a state machine (see
+    ** CStateMachine::RegionAdd): its current state, the active parents
+    ** of that state and their handlers.
+    **/
+   class CStateRegion {
+      public:
+                              CStateRegion(const char* const szName, const bool bLocal, CMemoryResource* const pResource);
+
+      public:
+         std::string            m_strName;   //< The region name, logging only.
+         bool                   m_bLocal;    //< The handlers of the region only use the region's own states and data: the region can be dispatched on a thread pool.
+         CState*                m_pState;    //< The current state of the region, NULL when the region has finished. Owned by the state machine.
+         CHandlerTable*         m_pHandlers; //< Handlers registered by the current state of the region, NULL when none. Owned by the state machine.
+         const CHandlerTable*   m_pShared;   //< Shared handlers of the current state of the region (NULL when none), not owned.
+         StateLevels            m_Parents;   //< The active parents of the current state of the region.
+         CStateMachineCounters* m_pCounters; //< Runtime statistics while dispatched on a thread pool, merged afterwards. NULL when not region-local. Owned by the state machine.
+         bool                   m_bHandled;  //< The region handled the event being dispatched.
+         bool                   m_bType;     //< The region handled the event being dispatched by an event-type handler.
+         CCreateState           m_Next;      //< The state change requested by the handler of the event being dispatched.
+   };
+
    /** @brief This is the actual state machine engine,
     ** instantiated once per state machine.
     **
@@ -49,38 +102,154 @@ namespace ILULibStateMachine {
     **   classes, which would result in easy shared_ptr mistakes with dramatic
     **   consequences
     **
+    ** Handlers registered with a plain function pointer (see HANDLER_SHARED,
+    ** GUARD_SHARED and HANDLER_TYPE_SHARED) are stored in a handler table
+    ** shared by all state machines constructing the same state (see
+    ** CHandlerTable). Lookup first checks the handlers registered by this
+    ** instance, then the shared handlers. A state should only use shared
+    ** handlers for registrations that are the same for every instance: the
+    ** registrations of all but the first instance are skipped.
+    **
+    ** Optionally a state machine gets its own arena (arenaChunkSize in
+    ** ConstructStateMachine). The state machine itself, its states, handler
+    ** tables and event identifications registered by its states are then
+    ** allocated from it and the arena is released in one operation when
+    ** the state machine is destructed. The state machine data is allocated
+    ** by the caller and stays on the heap.
+    **
+    ** Instead of an arena, a state machine can use a memory resource
+    ** provided by the caller (a CMemoryResource or, when compiling with
+    ** C++17, a std::pmr::memory_resource: see CMemoryResourcePmr.h). Next
+    ** to the objects above, the shared pointer control block and the event
+    ** identifications fed into the state machine are then allocated from it.
+    ** The caller guarantees the resource outlives the state machine and all
+    ** weak pointers to it.
+    **
+    ** When the library is compiled with ALLOCATION_STATS, each state machine
+    ** counts the allocations done while registering handlers, handling
+    ** events, changing state, logging and destructing (see CAllocationStats
+    ** and GetAllocationStats).
+    **
+    ** Each state machine counts the events it handles per path (state,
+    ** default state, event-type handlers), the unhandled events, guards,
+    ** state changes, exceptions caught while calling a handler and,
+    ** when enabled, the time spent in the handlers (see GetStats and
+    ** CStateMachineCounters). All live state machines are listed in
+    ** CStateMachineRegistry. When sampling is enabled, the handler and
+    ** state change latencies are recorded per state machine, state and
+    ** event (see CLatencyRecorder). Compiling the library with
+    ** NO_RUNTIME_STATS removes all of them, except for the registry.
+    **
+    ** Each state machine has a unique ID (see GetId) and a log level for
+    ** the engine's logging, set through CLogLevel by name or ID, also
+    ** while the state machine is running.
+    **
+    ** When tracing is enabled, every event fed into a state machine is
+    ** recorded in a binary trace buffer (see CTrace).
+    **
+    ** Events without a matching handler are counted per state machine
+    ** name, state and event and passed to the dead-letter function and
+    ** queue; the registered handlers are logged at most once per interval
+    ** for them (see CUnhandledEvents).
+    **
+    ** A state can be a substate of another state (see TStateParent): its
+    ** parents are active as long as the current state is one of their
+    ** substates. An event is offered to the current state first, then to
+    ** its parents from the innermost outward and then to the default state
+    ** (1 lookup per level, the event-type handlers in the same order
+    ** afterwards). A state change exits the current state and the parents
+    ** the next state does not share (innermost first) and enters the
+    ** missing parents of the next state (outermost first) before the next
+    ** state itself. The handlers a parent registers while it is constructed
+    ** belong to the parent.
+    **
+    ** A state machine can have orthogonal regions next to its own state
+    ** (see RegionAdd), each with its own current state (and parents) and
+    ** handlers. An event is offered to the state machine's own state (and
+    ** its default state) first, then to every region in the order the
+    ** regions were added: the event is handled when at least 1 of them
+    ** handles it. With a thread pool (see SetThreadPool) the handlers of
+    ** the region-local regions are called in parallel, at the position of
+    ** the first region-local region, and the state changes they request
+    ** are made in region order once all of them have finished. The engine
+    ** does not log from the threads of the pool.
+    **
+    ** A state machine can subscribe to a broadcast (see CBroadcast): every
+    ** state change updates the broadcast's index of the events its current
+    ** states (default state, parents and regions included) have handlers
+    ** for.
+    **
     **/
    class CStateMachine : public TYPESEL::enable_shared_from_this<CStateMachine> {
       public:
-         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState,                                  CStateMachineData* const pStateMachineData = NULL);
-         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState, CCreateState createDefaultState, CStateMachineData* const pStateMachineData = NULL);
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState,                                  CStateMachineData* const pStateMachineData = NULL, const size_t arenaChunkSize = 0);
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState, CCreateState createDefaultState, CStateMachineData* const pStateMachineData = NULL, const size_t arenaChunkSize = 0);
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState,                                  CStateMachineData* const pStateMachineData, CMemoryResource& resource);
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState, CCreateState createDefaultState, CStateMachineData* const pStateMachineData, CMemoryResource& resource);
+#if __cplusplus >= 201703L
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState,                                  CStateMachineData* const pStateMachineData, std::pmr::memory_resource* const pResource);
+         static TYPESEL::shared_ptr<CStateMachine> ConstructStateMachine(const char* szName, CCreateState createState, CCreateState createDefaultState, CStateMachineData* const pStateMachineData, std::pmr::memory_resource* const pResource);
+#endif
          virtual                                   ~CStateMachine(void);
 
       public:
          const std::string&                         GetName(void) const;
+         uint64_t                                   GetId(void) const;
+         ELogLevel                                  GetLogLevel(void) const;
          bool                                       HasFinished(void) const;
+         const CAllocationStats&                    GetAllocationStats(void) const;
+         CStateMachineStats                         GetStats(void) const;
          template <class TEventData> 
          void                                       EventTypeRegister(
             const bool                                                                bDefault   ,
             const std::string&                                                        strEventType,
-            TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const)> typeHandler,
+            const TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const)>& typeHandler,
             CCreateState                                                              createState   
             );
          template <class TEventData> 
          void                                       EventRegister(
             const bool                                       bDefault       ,
-            TYPESEL::function<void(const TEventData* const)> unguaredHandler,
+            const TYPESEL::function<void(const TEventData* const)>& unguaredHandler,
             CCreateState                                     createState    ,
             SPEventBase                                      spEventBase    
             );
          template <class TEventData> 
          bool                                       EventRegister(
             const bool                                       bDefault   ,
-            TYPESEL::function<bool(const TEventData* const)> guard      ,
-            TYPESEL::function<void(const TEventData* const)> handler    ,
+            const TYPESEL::function<bool(const TEventData* const)>& guard,
+            const TYPESEL::function<void(const TEventData* const)>& handler,
             CCreateState                                     createState,
             SPEventBase                                      spEventBase    
             );
+         template <class TEventData> 
+         void                                       EventTypeRegister(
+            const bool                                                                bDefault    ,
+            const std::string&                                                        strEventType,
+            void                                                                      (*typeHandler)(CState* pState, SPEventBase spEventBase, const TEventData* const),
+            CCreateState                                                              createState   
+            );
+         template <class TEventData> 
+         void                                       EventRegister(
+            const bool                                       bDefault        ,
+            void                                             (*unguardedHandler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState     ,
+            SPEventBase                                      spEventBase    
+            );
+         template <class TEventData> 
+         bool                                       EventRegister(
+            const bool                                       bDefault   ,
+            bool                                             (*guard)(CState* pState, const TEventData* const),
+            void                                             (*handler)(CState* pState, const TEventData* const),
+            CCreateState                                     createState,
+            SPEventBase                                      spEventBase    
+            );
+         size_t                                     RegionAdd(const char* szName, CCreateState createState, const bool bLocal = false);
+         size_t                                     GetRegionCount(void) const;
+         std::string                                GetRegionStateName(const size_t region) const;
+         bool                                       HasRegionFinished(const size_t region) const;
+         void                                       SetThreadPool(CThreadPool* const pThreadPool);
+         bool                                       EventSharedSealed(const CCreateState& createState) const;
+         CMemoryResource*                           GetMemoryResource(void) const;
          template <class TEventData, class EvtId>                                                    
          bool                                       EventHandle(
             const TEventData* const pEventData,
@@ -114,30 +283,38 @@ namespace ILULibStateMachine {
             );
 
       private:
-         typedef std::pair<SPEventBase, SPHandleEventInfoBase>                  EventPair;       //< pair coupling an event ID to a handle-event-info instance
-         typedef std::map<SPEventBase, SPHandleEventInfoBase, CSPEventBaseSort> EventMap;        //< map of event ID/handle-event-info pairs, do use custom sort because we do not want to sort pointer values
-         typedef EventMap::iterator                                             EventMapIt;      //< iterator for the event map
-         typedef EventMap::const_iterator                                       EventMapCIt;     //< const iterator for the event map
-         typedef std::pair<std::string, SPHandleEventInfoBase>                  EventTypePair;   //< pair coupling an event ID to a handle-event-info instance
-         typedef std::map<std::string, SPHandleEventInfoBase>                   EventTypeMap;    //< map of event ID/handle-event-info pairs, do use custom sort because we do not want to sort pointer values
-         typedef EventTypeMap::iterator                                         EventTypeMapIt;  //< iterator for the event map
-         typedef EventTypeMap::const_iterator                                   EventTypeMapCIt; //< const iterator for the event map
-         
-      private:
-                                                 CStateMachine(const char* szName, CStateMachineData* const pStateMachineData);
+         friend class CBroadcast;
+         friend class CLogLevel;
+         friend class CStateMachineRegistry;
+         friend class CStateMachineTrace;
+                                                 CStateMachine(const char* szName, CStateMachineData* const pStateMachineData, CMemoryResource* const pResource, const bool bOwnResource);
                                                  CStateMachine(CStateMachine& ref); //defined, not implemented --> avoid copy
          CStateMachine                           operator=(CStateMachine& ref);     //defined, not implemented --> avoid copy
+         static TYPESEL::shared_ptr<CStateMachine> ConstructArena(const char* szName, CStateMachineData* const pStateMachineData, const size_t arenaChunkSize);
+         static CStateMachine*                   Construct(const char* szName, CStateMachineData* const pStateMachineData, CMemoryResource* const pResource, const bool bOwnResource);
+         static void                             Destroy(CStateMachine* pStateMachine);
          void                                    SetInitialState(CCreateState& createState, CCreateState createDefaultState = CCreateState());
-         void                                    ChangeState(const CCreateState& createState);
-         EventMap&                               EventGetMap(const bool bDefault);
-         const EventMap&                         EventGetMap(const bool bDefault) const;
-         EventTypeMap&                           EventTypeGetMap(const bool bDefault);
-         const EventTypeMap&                     EventTypeGetMap(const bool bDefault) const;
+         void                                    ChangeState(const CCreateState& createState, const size_t region = 0);
+         void                                    ChangeStateSampled(const CCreateState& createState, const std::string& strState, const SPEventBase& spEventBase);
+         void                                    ChangeParents(const CCreateState& createState, StateLevels& parents);
+         void                                    ExitParents(StateLevels& parents, const size_t keep);
+         void                                    RegionHandled(const size_t region);
+         size_t                                  EventKeyLevels(const size_t region) const;
+         void                                    EventKeys(const size_t region, const size_t level, std::vector<SPEventBase>& events, std::vector<std::string>& eventTypes) const;
+         void                                    EventKeysDefault(std::vector<SPEventBase>& events, std::vector<std::string>& eventTypes) const;
+         CState*                                 CreateState(const CCreateState& createState, const CHandlerTable*& pShared);
+         CHandlerTable*                          EventGetTable(const bool bDefault, const bool bShared, const CCreateState& createState);
+         void                                    EventDeleteTable(CHandlerTable* const pTable);
          void                                    EventUnregister(const bool bDefault);
+         void                                    EventUnhandled(const CEventBase& event) const;
          void                                    TraceAll(void) const;
          void                                    TraceHandlers(const bool bDefault) const;
+         void                                    TraceHandlers(const std::string& strState, const CHandlerTable* const pTable, const CHandlerTable* const pShared) const;
          void                                    TraceTypeHandlers(const bool bDefault) const;
+         void                                    TraceTypeHandlers(const std::string& strState, const CHandlerTable* const pTable, const CHandlerTable* const pShared) const;
          std::string                             GetStateName(const bool bDefault = false) const; 
+         uint32_t                                GetTraceId(void);
+         uint32_t                                GetTraceState(void);
          template <class TEventData>                                                    
          bool                                    EventHandle(
             const bool              bDefault   ,
@@ -145,20 +322,110 @@ namespace ILULibStateMachine {
             const SPEventBase       spEventBase
             );
          template <class TEventData>                                                    
+         bool                                    EventHandle(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const CHandlerTable* const pShared    ,
+            const TEventData* const    pEventData ,
+            const SPEventBase          spEventBase
+            );
+         template <class TEventData>                                                    
+         bool                                    EventHandle(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const TEventData* const    pEventData ,
+            const SPEventBase          spEventBase
+            );
+         template <class TEventData>                                                    
+         CHandleEventInfoBase::HandleResult      EventCall(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const TEventData* const    pEventData ,
+            const SPEventBase&         spEventBase,
+            CStateMachineCounters&     counters
+            );
+         template <class TEventData>                                                    
+         bool                                    EventHandleRegions(
+            const TEventData* const pEventData ,
+            const SPEventBase       spEventBase
+            );
+         template <class TEventData>                                                    
+         bool                                    EventHandleRegion(
+            const size_t            region     ,
+            const TEventData* const pEventData ,
+            const SPEventBase&      spEventBase,
+            CStateMachineCounters&  counters
+            );
+         template <class TEventData>                                                    
+         void                                    EventHandleRegionTask(
+            const TEventData* const pEventData ,
+            const SPEventBase       spEventBase,
+            const size_t            index
+            );
+         template <class TEventData>                                                    
          bool                                    EventTypeHandle(
             const bool              bDefault   ,
             const TEventData* const pEventData ,
             const SPEventBase       spEventBase
             );
+         template <class TEventData>                                                    
+         bool                                    EventTypeHandle(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const CHandlerTable* const pShared    ,
+            const TEventData* const    pEventData ,
+            const SPEventBase          spEventBase
+            );
+         template <class TEventData>                                                    
+         bool                                    EventTypeHandle(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const TEventData* const    pEventData ,
+            const SPEventBase          spEventBase
+            );
+         template <class TEventData>                                                    
+         CHandleEventInfoBase::HandleResult      EventTypeCall(
+            const bool                 bDefault   ,
+            CState* const              pState     ,
+            const CHandlerTable* const pTable     ,
+            const TEventData* const    pEventData ,
+            const SPEventBase&         spEventBase,
+            CStateMachineCounters&     counters
+            );
 
       private:
+         CMemoryResource* const                  m_pResource;           //< The resource everything owned by this state machine is allocated from, NULL for the heap.
+         const bool                              m_bOwnResource;        //< The state machine owns m_pResource (e.g. its arena): deleted after the state machine destructor (see Destroy).
          const std::string                       m_strName;             //< The state machine name, logging only.
-         EventMap                                m_EventMapDefault;     //< Map of event handlers registered for the default state.
-         EventMap                                m_EventMapState;       //< Map of event handlers registered for the current state. They precede the handlers for the default state.
-         EventTypeMap                            m_EventTypeMapDefault; //< Map of event-type handlers registered for the default state.
-         EventTypeMap                            m_EventTypeMapState;   //< Map of event-type handlers registered for the current state. They precede the handlers for the default state.
+         const uint64_t                          m_Id;                  //< The unique ID of the state machine, see GetId.
+         mutable std::atomic<uint8_t>            m_LogLevel;            //< The lowest level of the engine's logging for this state machine, see CLogLevel. Mutable: set by CLogLevel while iterating the registry.
+         CHandlerTable*                          m_pHandlersDefault;    //< Handlers registered by this instance for the default state. Allocated on the first registration.
+         CHandlerTable*                          m_pHandlersState;      //< Handlers registered by this instance for the current state. They precede the handlers for the default state. Allocated on the first registration.
+         const CHandlerTable*                    m_pSharedDefault;      //< Shared handlers of the default state (NULL when none), not owned.
+         const CHandlerTable*                    m_pSharedState;        //< Shared handlers of the current state (NULL when none), not owned.
+         CHandlerTable*                          m_pSharedBuild;        //< Shared table filled by the state under construction, NULL when not building one.
+         bool                                    m_bSharedSealed;       //< The state under construction has a sealed shared table: shared registrations are skipped.
          CState*                                 m_pDefaultState;       //< Pointer to the default state. Owned and deleted by the state machine when it is destructed itself. Raw pointer since fine-grained control over life-time is required (on-exit/on-entry functions).
          CState*                                 m_pState;              //< Pointer to the current state. Created and deleted by the state machine during state transitions. Raw pointer since fine-grained control over life-time is required (on-exit/on-entry functions)
+         StateLevels                             m_Parents;             //< The active parents of the current state, outermost first.
+         CStateLevel*                            m_pBuildLevel;         //< The parent under construction: it gets the registrations for the current state. NULL when not constructing a parent.
+         std::vector<CStateRegion, TAllocator<CStateRegion> > m_Regions; //< The orthogonal regions, in the order they are offered events. Region N is m_Regions[N - 1], region 0 being the state machine's own state.
+         size_t                                  m_BuildRegion;         //< The region a state is constructed for: it gets the registrations for the current state. 0 for the state machine's own state.
+         size_t                                  m_ParentsKept;         //< The number of (outermost) parents the running state change did not exit, see CBroadcast::Update.
+         CThreadPool*                            m_pThreadPool;         //< The pool the region-local regions are dispatched on, NULL to dispatch them on the calling thread. Not owned.
+         CBroadcast*                             m_pBroadcast;          //< The broadcast the state machine subscribed to, NULL when none. Not owned.
+         CAllocationStats* const                 m_pAllocationStats;    //< Allocation accounting, NULL when not compiled with ALLOCATION_STATS. Deleted by Destroy.
+         CStateMachineCounters                   m_Counters;            //< Runtime statistics.
+         CStateMachine*                          m_pRegistryPrev;       //< Previous state machine in CStateMachineRegistry.
+         CStateMachine*                          m_pRegistryNext;       //< Next state machine in CStateMachineRegistry.
+         uint32_t                                m_TraceId;             //< State machine ID in the trace, 0 until traced for the first time.
+         uint32_t                                m_TraceState;          //< Trace name ID of the current state, 0 until traced for the first time.
+         CStateMachineTrace*                     m_pTrace;              //< Trace of the event being handled, NULL when not tracing.
          CStateMachineData* const                m_pStateMachineData;   //< Pointer to the state machine data. Owned and deleted by the state machine when it is destructed itself. Raw pointer to avoid dynamic-casts to the type used inside the state classes of the actual state machine (which derives from CStateMachineData)
    };
 
@@ -175,9 +442,13 @@ namespace ILULibStateMachine {
 #define HANDLER(et,cl,f)      TYPESEL::function<void(const et* const)>(TYPESEL::bind(&cl::f, this, TYPESEL_PLACEHOLDERS_1))                                                          ///< Macro eases definition of an event handler upon event registration. First parameter: event data type; second parameter: class; third parameter: class method.
 #define HANDLER_NO_DATA(cl,f) TYPESEL::function<void(const CStateMachineData* const)>(TYPESEL::bind(&cl::f, this, TYPESEL_PLACEHOLDERS_1))                                           ///< Macro eases definition of an event handler upon event registration when the state machine has no accompanying data. First parameter: class; second parameter: class method.
 #define HANDLER_TYPE(et,cl,f) TYPESEL::function<void(ILULibStateMachine::SPEventBase, const et* const)>(TYPESEL::bind(&cl::f, this, TYPESEL_PLACEHOLDERS_1, TYPESEL_PLACEHOLDERS_2)) ///<Macro eases definition of an event-type handler upon event registration. First parameter: event data type; second parameter: class; third parameter: class method.
+#define GUARD_SHARED(et,cl,f)        (&ILULibStateMachine::TSharedGuard<et, cl, &cl::f>)       ///< Same as GUARD, but the guard is not bound to this instance: it can be stored in a shared handler table.
+#define HANDLER_SHARED(et,cl,f)      (&ILULibStateMachine::TSharedHandler<et, cl, &cl::f>)     ///< Same as HANDLER, but the handler is not bound to this instance: it can be stored in a shared handler table.
+#define HANDLER_TYPE_SHARED(et,cl,f) (&ILULibStateMachine::TSharedTypeHandler<et, cl, &cl::f>) ///< Same as HANDLER_TYPE, but the handler is not bound to this instance: it can be stored in a shared handler table.
 
 //include the class template function definitions.
 #include "CStateMachineImpl.h"
+#include "TSharedHandler.h"
 
 #endif //__ILULibStateMachine_CStateMachine__H__
 
@@ -24,7 +24,9 @@
 
 #include "stdexcept"
 
+#include "CHandlerTable.h"
 #include "Logging.h"
+#include "TAllocator.h"
 #include "THandleEventInfo.h"
 #include "THandleEventTypeInfo.h"
 
@@ -35,37 +37,12 @@ namespace ILULibStateMachine {
    void CStateMachine::EventTypeRegister(
       const bool                                                                bDefault,     //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
       const std::string&                                                        strEventType, //< String representation of the event type.
-      TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const)> typeHandler,  //< The handler to be registered.
+      const TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const)>& typeHandler, //< The handler to be registered.
       CCreateState                                                              createState   //< The state transition accompanying this event-type.
       )
    {
-      try {
-         EventTypeMap& map = EventTypeGetMap(bDefault);
-         const EventTypeMapIt it = map.find(strEventType);
-         if(map.end() == it) {
-            LogDebug("Register type event handler for [%s] from [%s]\n",
-                     strEventType.c_str(),
-                     (bDefault ? "default" : "state")
-                     );
-            map.insert(EventTypePair(strEventType, SPHandleEventInfoBase(new THandleEventTypeInfo<TEventData>(typeHandler, createState))));
-         } else {
-            //event already in the map
-            LogErr("Register type event handler for [%s] from [%s] failed: already registered\n",
-                   strEventType.c_str(),
-                   (bDefault ? "default" : "state")
-                   );
-         }
-      } catch(std::exception& ex) {
-         LogErr("Event type handler registration failed for [%s]: %s\n",
-                strEventType.c_str(),
-                ex.what()
-                );
-      } catch(...) {
-         LogErr("Event type handler registration failed for [%s]: %s\n",
-                strEventType.c_str(),
-                "unknown"
-                );
-      }
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      EventGetTable(bDefault, false, createState)->EventTypeRegister<TEventData>(bDefault, strEventType, typeHandler, createState);
    }
 
    /** Register an unguarded event handler.
@@ -73,46 +50,13 @@ namespace ILULibStateMachine {
    template <class TEventData> 
    void CStateMachine::EventRegister(
       const bool                                       bDefault,         //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
-      TYPESEL::function<void(const TEventData* const)> unguardedHandler, //< The handler to be registered.
+      const TYPESEL::function<void(const TEventData* const)>& unguardedHandler, //< The handler to be registered.
       CCreateState                                     createState,      //< The state transition accompanying this event-type.
       SPEventBase                                      spEventBase       //< The complete event identification that triggers this handler.
       )
    {
-      try {
-         EventMap& map = EventGetMap(bDefault);
-         const EventMapIt it = map.find(spEventBase);
-         if(map.end() == it) {
-            LogDebug("Register unguarded event handler for [%s] from [%s]\n",
-                     spEventBase->GetId().c_str(),
-                     (bDefault ? "default" : "state")
-                     );
-            map.insert(EventPair(spEventBase, SPHandleEventInfoBase(new THandleEventInfo<TEventData>(unguardedHandler, createState))));
-         } else {
-            //event already in the map
-            //--> set the default handler
-            //    (will throw when the default handler has already been set)
-            LogDebug("Set unguarded event handler for [%s] from [%s]\n",
-                     spEventBase->GetId().c_str(),
-                     (bDefault ? "default" : "state")
-                     );
-            THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(it->second.get());
-            if(NULL == pHandleEventInfo) {
-               //serious error in the implementation: mismatch in registration
-               throw std::runtime_error("IMPLEMENTATION ERROR: registration mismatch found in unguarded event handler");
-            }
-            pHandleEventInfo->SetUnguardedHandler(unguardedHandler, createState);
-         }
-      } catch(std::exception& ex) {
-         LogErr("Event default handler registration failed for [%s]: %s\n",
-                spEventBase->GetId().c_str(),
-                ex.what()
-                );
-      } catch(...) {
-         LogErr("Event default handler registration failed for [%s]: %s\n",
-                spEventBase->GetId().c_str(),
-                "unknown"
-                );
-      }
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      EventGetTable(bDefault, false, createState)->EventRegister<TEventData>(bDefault, unguardedHandler, createState, spEventBase);
    }
 
    /** Register a guarded event handler.
@@ -120,57 +64,79 @@ namespace ILULibStateMachine {
    template <class TEventData> 
    bool CStateMachine::EventRegister(
       const bool                                       bDefault,    //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
-      TYPESEL::function<bool(const TEventData* const)> guard,       //< The guard called before the handler. When the guard returns true, the handler is called; when the guard returns false the handler is not called.
-      TYPESEL::function<void(const TEventData* const)> handler,     //< The handler to be registered.
+      const TYPESEL::function<bool(const TEventData* const)>& guard,   //< The guard called before the handler. When the guard returns true, the handler is called; when the guard returns false the handler is not called.
+      const TYPESEL::function<void(const TEventData* const)>& handler, //< The handler to be registered.
       CCreateState                                     createState, //< The state transition accompanying this event-type.
       SPEventBase                                      spEventBase  //< The complete event identification that triggers this handler.
       )
    {
-      try {
-         EventMap& map = EventGetMap(bDefault);
-         const EventMapIt it = map.find(spEventBase);
-         if(map.end() == it) {
-            //event with the specified ID not yet in the map
-            //--> add it with a guarded handler
-            LogDebug("Register event guard/handler combo for [%s] from [%s]\n",
-                     spEventBase->GetId().c_str(),
-                     (bDefault ? "default" : "state")
-                     );
-            map.insert(EventPair(spEventBase, SPHandleEventInfoBase(new THandleEventInfo<TEventData>(guard, handler, createState))));
-         } else {
-            //event already in the map
-            //--> add a guarded handler
-            LogDebug("Add event guard/handler combo for [%s] from [%s]\n",
-                     spEventBase->GetId().c_str(),
-                     (bDefault ? "default" : "state")
-                     );
-            THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(it->second.get());
-            if(NULL == pHandleEventInfo) {
-               //serious error in the implementation: mismatch in registration
-               throw std::runtime_error("IMPLEMENTATION ERROR: registration mismatch found in guarded event handler");
-            }
-            pHandleEventInfo->AddGuardedHandler(guard, handler, createState);
-         }
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      return EventGetTable(bDefault, false, createState)->EventRegister<TEventData>(bDefault, guard, handler, createState, spEventBase);
+   }
+
+   /** Register a shared event-type handler (see HANDLER_TYPE_SHARED).
+    **/
+   template <class TEventData> 
+   void CStateMachine::EventTypeRegister(
+      const bool         bDefault,                                                                 //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
+      const std::string& strEventType,                                                             //< String representation of the event type.
+      void               (*typeHandler)(CState* pState, SPEventBase spEventBase, const TEventData* const), //< The handler to be registered.
+      CCreateState       createState                                                               //< The state transition accompanying this event-type.
+      )
+   {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      CHandlerTable* const pTable(EventGetTable(bDefault, true, createState));
+      if(NULL == pTable) {
+         //already present in the sealed shared table
+         return;
+      }
+      pTable->EventTypeRegister<TEventData>(bDefault, strEventType, typeHandler, createState);
+   }
+
+   /** Register a shared unguarded event handler (see HANDLER_SHARED).
+    **/
+   template <class TEventData> 
+   void CStateMachine::EventRegister(
+      const bool   bDefault,                                                 //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
+      void         (*unguardedHandler)(CState* pState, const TEventData* const), //< The handler to be registered.
+      CCreateState createState,                                              //< The state transition accompanying this event-type.
+      SPEventBase  spEventBase                                               //< The complete event identification that triggers this handler.
+      )
+   {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      CHandlerTable* const pTable(EventGetTable(bDefault, true, createState));
+      if(NULL == pTable) {
+         //already present in the sealed shared table
+         return;
+      }
+      pTable->EventRegister<TEventData>(bDefault, unguardedHandler, createState, spEventBase);
+   }
+
+   /** Register a shared guarded event handler (see GUARD_SHARED and HANDLER_SHARED).
+    **/
+   template <class TEventData> 
+   bool CStateMachine::EventRegister(
+      const bool   bDefault,                                        //< When true: register this handler in the default event-type map (default state); when false: register this handler for the current state.
+      bool         (*guard)(CState* pState, const TEventData* const),   //< The guard called before the handler. When the guard returns true, the handler is called; when the guard returns false the handler is not called.
+      void         (*handler)(CState* pState, const TEventData* const), //< The handler to be registered.
+      CCreateState createState,                                     //< The state transition accompanying this event-type.
+      SPEventBase  spEventBase                                      //< The complete event identification that triggers this handler.
+      )
+   {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationRegistration);
+      CHandlerTable* const pTable(EventGetTable(bDefault, true, createState));
+      if(NULL == pTable) {
+         //already present in the sealed shared table
          return true;
-      } catch(std::exception& ex) {
-         LogErr("Event guard/handler combo registration failed for [%s]: %s\n",
-                spEventBase->GetId().c_str(),
-                ex.what()
-                );
-         return false;
-      } catch(...) {
-         LogErr("Event guard/handler combo registration failed for [%s]: %s\n",
-                spEventBase->GetId().c_str(),
-                "unknown"
-                );
-         return false;
       }
+      return pTable->EventRegister<TEventData>(bDefault, guard, handler, createState, spEventBase);
    }
 
    /** Event handler, called when an event has to be fed into the state machine.
     **
-    ** Constructs a SPEventBase instance based on the provided event parameters
-    ** and calls the common handler with this instance.
+    ** Constructs a SPEventBase instance based on the provided event parameters,
+    ** allocated from the state machine's memory resource, and calls the common
+    ** handler with this instance.
     **/
    template <class TEventData, class EvtId>                                                    
    bool CStateMachine::EventHandle(
@@ -178,13 +144,15 @@ namespace ILULibStateMachine {
       const EvtId             evtId       //< Event ID as defined by TEventEvtId.
       )
    {
-      return EventHandle(pEventData, SPEventBase(new TEventEvtId<EvtId>(typeid(TEventData), evtId)));
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationDispatch);
+      return EventHandle(pEventData, SPEventBase(TYPESEL::allocate_shared<TEventEvtId<EvtId> >(TAllocator<TEventEvtId<EvtId> >(m_pResource), typeid(TEventData), evtId)));
    }
 
    /** Event handler, called when an event has to be fed into the state machine.
     **
-    ** Constructs a SPEventBase instance based on the provided event parameters
-    ** and calls the common handler with this instance.
+    ** Constructs a SPEventBase instance based on the provided event parameters,
+    ** allocated from the state machine's memory resource, and calls the common
+    ** handler with this instance.
     **/
    template <class TEventData, class EvtId, class EvtSubId1>                                                    
    bool CStateMachine::EventHandle(
@@ -193,13 +161,15 @@ namespace ILULibStateMachine {
       const EvtSubId1         evtSubId1   //< First event sub-ID as defined by TEventEvtId.
       )
    {
-      return EventHandle(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1>(typeid(TEventData), evtId, evtSubId1)));
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationDispatch);
+      return EventHandle(pEventData, SPEventBase(TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1> >(TAllocator<TEventEvtId<EvtId, EvtSubId1> >(m_pResource), typeid(TEventData), evtId, evtSubId1)));
    }
    
    /** Event handler, called when an event has to be fed into the state machine.
     **
-    ** Constructs a SPEventBase instance based on the provided event parameters
-    ** and calls the common handler with this instance.
+    ** Constructs a SPEventBase instance based on the provided event parameters,
+    ** allocated from the state machine's memory resource, and calls the common
+    ** handler with this instance.
     **/
    template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2>                                                    
    bool CStateMachine::EventHandle(
@@ -209,13 +179,15 @@ namespace ILULibStateMachine {
       const EvtSubId2         evtSubId2   //< Second event sub-ID as defined by TEventEvtId.
       )
    {
-      return EventHandle(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2>(typeid(TEventData), evtId, evtSubId1, evtSubId2)));
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationDispatch);
+      return EventHandle(pEventData, SPEventBase(TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2> >(m_pResource), typeid(TEventData), evtId, evtSubId1, evtSubId2)));
    }
    
    /** Event handler, called when an event has to be fed into the state machine.
     **
-    ** Constructs a SPEventBase instance based on the provided event parameters
-    ** and calls the common handler with this instance.
+    ** Constructs a SPEventBase instance based on the provided event parameters,
+    ** allocated from the state machine's memory resource, and calls the common
+    ** handler with this instance.
     **/
    template <class TEventData, class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>                                                    
    bool CStateMachine::EventHandle(
@@ -226,19 +198,22 @@ namespace ILULibStateMachine {
       const EvtSubId3         evtSubId3   //< Third event sub-ID as defined by TEventEvtId.   
       )
    {
-      return EventHandle(pEventData, SPEventBase(new TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>(typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationDispatch);
+      return EventHandle(pEventData, SPEventBase(TYPESEL::allocate_shared<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(TAllocator<TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3> >(m_pResource), typeid(TEventData), evtId, evtSubId1, evtSubId2, evtSubId3)));
    }
 
    /** Event handler, called when an event has to be fed into the state machine.
     **
     ** This function dictates the order in which the event is checked against registered event handlers
-    ** - current state event handlers;
+    ** - current state event handlers, then those of its parents (innermost first);
     ** - default state event handlers;
-    ** - current state event-type handlers;
+    ** - current state event-type handlers, then those of its parents (innermost first);
     ** - default state event-type handlers.
     ** Depending on the match, the appropriate handler is called.
+    ** The event is offered to the regions (see RegionAdd) afterwards.
     **
-    ** When no match is found, the function traces all registered handlers.
+    ** When no match is found, the event is passed to CUnhandledEvents and
+    ** the function traces all registered handlers (rate-limited).
     **
     ** @return true: when the state machine has finished (current state is null); false when the state machine still has a valid state (not null), meaning it has not finished
     **/
@@ -248,68 +223,94 @@ namespace ILULibStateMachine {
       const SPEventBase       spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
       )
    {
+      ALLOCATION_SCOPE(m_pAllocationStats, EAllocationDispatch);
+      m_Counters.StartEvent();
+      CStateMachineTrace trace(*this, *spEventBase);
+      //the log level of this state machine applies to everything the engine logs while handling the event
+      CLogLevelScope logLevelScope(m_LogLevel.load(std::memory_order_relaxed));
+      const bool     bNotice      (CLogLevelScope::IsEnabled(ELogLevelNotice));
       //store the current state name as the current state can change and the logging
       //should keep the original state name for the handling loggings
-      const std::string strCurrentState(GetStateName());
-      
-      CLogIndent logIndent;
-      LogNotice("Statemachine [%s] state [%s] handling event [%s] type [%s] in\n",
-                m_strName.c_str(),
-                strCurrentState.c_str(),
-                spEventBase->GetId().c_str(),
-                spEventBase->GetDataType().c_str()
-                );
+      const std::string strCurrentState(bNotice ? GetStateName() : std::string());
       
-      //try the state event map
-      if(EventHandle(false, pEventData, spEventBase)) {
-         //event handled
-         LogNotice("Statemachine [%s] state [%s] handling event [%s] by current state done\n",
+      CLogIndent logIndent(CLogLevelScope::IsIndented());
+      if(bNotice) {
+         LogNotice("Statemachine [%s] state [%s] handling event [%s] type [%s] in\n",
                    m_strName.c_str(),
                    strCurrentState.c_str(),
-                   spEventBase->GetId().c_str()
+                   spEventBase->GetId().c_str(),
+                   spEventBase->GetDataType().c_str()
                    );
-         return HasFinished();
       }
       
-      //try the default event map
-      if(EventHandle(true, pEventData, spEventBase)) {
-         //event handled
-         LogNotice("Statemachine [%s] state [%s] handling event [%s] by default state done\n",
-                   m_strName.c_str(),
-                   strCurrentState.c_str(),
-                   spEventBase->GetId().c_str()
-            );
-         return HasFinished();
+      //try the state event map, the default event map, the state type map and the default type map
+      bool bHandled(true);
+      if(EventHandle(false, pEventData, spEventBase)) {
+         //event handled by the state event map
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsState, 1);
+         trace.SetKind(ETraceKindState);
+         if(bNotice) {
+            LogNotice("Statemachine [%s] state [%s] handling event [%s] by current state done\n",
+                      m_strName.c_str(),
+                      strCurrentState.c_str(),
+                      spEventBase->GetId().c_str()
+                      );
+         }
+      } else if(EventHandle(true, pEventData, spEventBase)) {
+         //event handled by the default event map
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsDefault, 1);
+         trace.SetKind(ETraceKindDefault);
+         if(bNotice) {
+            LogNotice("Statemachine [%s] state [%s] handling event [%s] by default state done\n",
+                      m_strName.c_str(),
+                      strCurrentState.c_str(),
+                      spEventBase->GetId().c_str()
+                      );
+         }
+      } else if(EventTypeHandle(false, pEventData, spEventBase)) {
+         //event handled by the state type map
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsTypeState, 1);
+         trace.SetKind(ETraceKindTypeState);
+         if(bNotice) {
+            LogNotice("Statemachine [%s] state [%s] handling event type [%s] by current state done\n",
+                      m_strName.c_str(),
+                      strCurrentState.c_str(),
+                      spEventBase->GetDataType().c_str()
+                      );
+         }
+      } else if(EventTypeHandle(true, pEventData, spEventBase)) {
+         //event handled by the default type map
+         RUNTIME_STATS_ADD(m_Counters, ECounterEventsTypeDefault, 1);
+         trace.SetKind(ETraceKindTypeDefault);
+         if(bNotice) {
+            LogNotice("Statemachine [%s] state [%s] handling event type [%s] by default state done\n",
+                      m_strName.c_str(),
+                      strCurrentState.c_str(),
+                      spEventBase->GetDataType().c_str()
+                      );
+         }
+      } else {
+         bHandled = false;
       }
 
-      //try the state type map
-      if(EventTypeHandle(false, pEventData, spEventBase)) {
-         //event handled
-         LogNotice("Statemachine [%s] state [%s] handling event type [%s] by current state done\n",
-                   m_strName.c_str(),
-                   strCurrentState.c_str(),
-                   spEventBase->GetDataType().c_str()
-            );
+      //offer the event to the regions
+      if(EventHandleRegions(pEventData, spEventBase) && !bHandled) {
+         bHandled = true;
+         trace.SetKind(ETraceKindState);
+      }
+      if(bHandled) {
          return HasFinished();
       }
       
-      //try the default type map
-      if(EventTypeHandle(true, pEventData, spEventBase)) {
-         //event handled
-         LogNotice("Statemachine [%s] state [%s] handling event type [%s] by default state done\n",
+      if(bNotice) {
+         LogNotice("Statemachine [%s] state [%s] handling event [%s] looking for handler failed: no matching registered handler --> event ignored\n",
                    m_strName.c_str(),
                    strCurrentState.c_str(),
-                   spEventBase->GetDataType().c_str()
+                   spEventBase->GetId().c_str()
                    );
-         return HasFinished();
       }
-      
-      LogNotice("Statemachine [%s] state [%s] handling event [%s] looking for handler failed: no matching registered handler --> event ignored\n",
-                m_strName.c_str(),
-                strCurrentState.c_str(),
-                spEventBase->GetId().c_str()
-                );
-      TraceAll();
+      RUNTIME_STATS_ADD(m_Counters, ECounterEventsUnhandled, 1);
+      EventUnhandled(*spEventBase);
       return HasFinished();
    }
 
@@ -318,6 +319,9 @@ namespace ILULibStateMachine {
     ** The state machine calls this function to find an event match (not an event-type)
     ** match and call the handler if a match is found.
     **
+    ** For the current state, its parents are tried next, from the innermost
+    ** outward.
+    **
     ** @return true: when the event has been handled (false otherwise).
     **/
    template <class TEventData>                                                    
@@ -327,52 +331,143 @@ namespace ILULibStateMachine {
       const SPEventBase       spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
       )
    {
-      //find handler
-      EventMap&        map = EventGetMap(bDefault);
-      LogDebug("Statemachine [%s] state [%s] handling event [%s] looking for [%s] handler (%lu registered ID's)\n",
-               m_strName.c_str(),
-               GetStateName().c_str(),
-               spEventBase->GetId().c_str(),
-               (bDefault ? "default" : "state"),
-               (long unsigned int)map.size()
-               );
-      const EventMapIt it  = map.find(spEventBase);
-      if(map.end() == it) {
-         return false;
+      if(bDefault) {
+         return EventHandle(true, m_pDefaultState, m_pHandlersDefault, m_pSharedDefault, pEventData, spEventBase);
+      }
+      if(EventHandle(false, m_pState, m_pHandlersState, m_pSharedState, pEventData, spEventBase)) {
+         return true;
       }
+      for(size_t level = m_Parents.size() ; 0 < level ; --level) {
+         const CStateLevel& parent(m_Parents[level - 1]);
+         if(EventHandle(false, parent.m_pState, parent.m_pHandlers, parent.m_pShared, pEventData, spEventBase)) {
+            return true;
+         }
+      }
+      return false;
+   }
 
-      //handler found --> get info to call it
-      THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(it->second.get());
-      if(NULL == pHandleEventInfo) {
-         //serious error in the implementation: mismatch in registration
-         LogErr("Statemachine [%s] state [%s] handling event [%s] looking for [%s] handler found handler with invalid type\n",
-                m_strName.c_str(),
-                GetStateName().c_str(),
-                spEventBase->GetId().c_str(),
-                (bDefault ? "default" : "state")
-                );
-        return false;
+   /** Internal event handler.
+    **
+    ** Find an event match for one state (the current state, one of its
+    ** parents or the default state) and call the handler if a match is
+    ** found.
+    **
+    ** The handlers registered by this instance are tried before the shared handlers.
+    **
+    ** @return true: when the event has been handled (false otherwise).
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventHandle(
+      const bool                 bDefault,   //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,     //< The state the handlers belong to.
+      const CHandlerTable* const pTable,     //< Handlers registered by this instance, can be NULL.
+      const CHandlerTable* const pShared,    //< Shared handlers, can be NULL.
+      const TEventData* const    pEventData, //< The event data belonging to the event.
+      const SPEventBase          spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      )
+   {
+      if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+         LogDebug("Statemachine [%s] state [%s] handling event [%s] looking for [%s] handler (%lu registered ID's)\n",
+                  m_strName.c_str(),
+                  GetStateName().c_str(),
+                  spEventBase->GetId().c_str(),
+                  (bDefault ? "default" : (pState == m_pState ? "state" : pState->GetName().c_str())),
+                  (long unsigned int)((NULL == pTable ? 0 : pTable->EventCount()) + (NULL == pShared ? 0 : pShared->EventCount()))
+                  );
       }
-      
+      return EventHandle(bDefault, pState, pTable, pEventData, spEventBase) || EventHandle(bDefault, pState, pShared, pEventData, spEventBase);
+   }
+
+   /** Internal event handler.
+    **
+    ** Find an event match in one handler table and call the handler if a
+    ** match is found.
+    **
+    ** @return true: when the event has been handled (false otherwise).
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventHandle(
+      const bool                 bDefault,   //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,     //< The state the handlers belong to.
+      const CHandlerTable* const pTable,     //< The table to look in, can be NULL.
+      const TEventData* const    pEventData, //< The event data belonging to the event.
+      const SPEventBase          spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      )
+   {
       //call handler
-      CHandleEventInfoBase::HandleResult result(pHandleEventInfo->Handle(bDefault, pEventData));
+      //(the state name is only required when the event is sampled for the latency histograms)
+      const bool                         bSample (m_Counters.IsSampling());
+      const std::string                  strState(bSample && NULL != pTable ? pState->GetName() : std::string());
+      CHandleEventInfoBase::HandleResult result  (EventCall(bDefault, pState, pTable, pEventData, spEventBase, m_Counters));
       if(!result.first) {
          //no handler found
          return false;
       }
       
       //state change if requested by handler
-      ChangeState(result.second);
+      if(bSample) {
+         ChangeStateSampled(result.second, strState, spEventBase);
+      } else {
+         ChangeState(result.second);
+      }
       
       //event handled
       return true;
    }
 
+   /** Internal event handler.
+    **
+    ** Find an event match in one handler table and call the handler if a
+    ** match is found, without changing state.
+    **
+    ** @return a HandleResult indicating whether a handler was called and, when one was called, the state change it requests.
+    **/
+   template <class TEventData>                                                    
+   CHandleEventInfoBase::HandleResult CStateMachine::EventCall(
+      const bool                 bDefault,    //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,      //< The state the handlers belong to.
+      const CHandlerTable* const pTable,      //< The table to look in, can be NULL.
+      const TEventData* const    pEventData,  //< The event data belonging to the event.
+      const SPEventBase&         spEventBase, //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      CStateMachineCounters&     counters     //< Runtime statistics: of the state machine or, on a thread pool, of the region.
+      )
+   {
+      //find handler
+      if(NULL == pTable) {
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+      CHandleEventInfoBase* const pHandleEventInfoBase(pTable->EventFind(spEventBase));
+      if(NULL == pHandleEventInfoBase) {
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+
+      //handler found --> get info to call it
+      THandleEventInfo<TEventData>* pHandleEventInfo = dynamic_cast<THandleEventInfo<TEventData>*>(pHandleEventInfoBase);
+      if(NULL == pHandleEventInfo) {
+         //serious error in the implementation: mismatch in registration
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Statemachine [%s] state [%s] handling event [%s] looking for [%s] handler found handler with invalid type\n",
+                   m_strName.c_str(),
+                   GetStateName().c_str(),
+                   spEventBase->GetId().c_str(),
+                   (bDefault ? "default" : "state")
+                   );
+         }
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+      
+      //call handler
+      return pHandleEventInfo->Handle(bDefault, pState, pEventData, counters);
+   }
+
    /** Internal event handler.
     **
     ** The state machine calls this function to find an event-type (not an event)
     ** match and call the handler if a match is found.
     **
+    ** For the current state, its parents are tried next, from the innermost
+    ** outward.
+    **
     ** @return true: when the event has been handled (false otherwise).
     **/
    template <class TEventData>                                                    
@@ -382,46 +477,295 @@ namespace ILULibStateMachine {
       const SPEventBase       spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
       )
    {
-      //find handler
-      EventTypeMap& map = EventTypeGetMap(bDefault);
-      LogDebug("Statemachine [%s] state [%s] handling event type [%s] in [%s] (%lu registered ID's)\n",
-               m_strName.c_str(),
-               GetStateName().c_str(),
-               spEventBase->GetIdType().c_str(),
-               (bDefault ? "default" : "state"),
-               (long unsigned int)map.size()
-               );
-      const EventTypeMapIt it = map.find(spEventBase->GetIdType());
-      if(map.end() == it) {
-         return false;
+      if(bDefault) {
+         return EventTypeHandle(true, m_pDefaultState, m_pHandlersDefault, m_pSharedDefault, pEventData, spEventBase);
+      }
+      if(EventTypeHandle(false, m_pState, m_pHandlersState, m_pSharedState, pEventData, spEventBase)) {
+         return true;
+      }
+      for(size_t level = m_Parents.size() ; 0 < level ; --level) {
+         const CStateLevel& parent(m_Parents[level - 1]);
+         if(EventTypeHandle(false, parent.m_pState, parent.m_pHandlers, parent.m_pShared, pEventData, spEventBase)) {
+            return true;
+         }
       }
+      return false;
+   }
 
-      //handler found --> get info to call it
-      THandleEventTypeInfo<TEventData>* pHandleEventTypeInfo = dynamic_cast<THandleEventTypeInfo<TEventData>*>(it->second.get());
-      if(NULL == pHandleEventTypeInfo) {
-         //serious error in the implementation: mismatch in registration
-         LogErr("Statemachine [%s] state [%s] handling event type [%s] in [%s] found type handler with type\n",
+   /** Internal event handler.
+    **
+    ** Find an event-type match for one state (the current state, one of
+    ** its parents or the default state) and call the handler if a match
+    ** is found.
+    **
+    ** The handlers registered by this instance are tried before the shared handlers.
+    **
+    ** @return true: when the event has been handled (false otherwise).
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventTypeHandle(
+      const bool                 bDefault,   //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,     //< The state the handlers belong to.
+      const CHandlerTable* const pTable,     //< Handlers registered by this instance, can be NULL.
+      const CHandlerTable* const pShared,    //< Shared handlers, can be NULL.
+      const TEventData* const    pEventData, //< The event data belonging to the event.
+      const SPEventBase          spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      )
+   {
+      if(CLogLevelScope::IsEnabled(ELogLevelDebug)) {
+         LogDebug("Statemachine [%s] state [%s] handling event type [%s] in [%s] (%lu registered ID's)\n",
                   m_strName.c_str(),
                   GetStateName().c_str(),
                   spEventBase->GetIdType().c_str(),
-                  (bDefault ? "default" : "state")
+                  (bDefault ? "default" : (pState == m_pState ? "state" : pState->GetName().c_str())),
+                  (long unsigned int)((NULL == pTable ? 0 : pTable->EventTypeCount()) + (NULL == pShared ? 0 : pShared->EventTypeCount()))
                   );
-         return false;
       }
-      
+      return EventTypeHandle(bDefault, pState, pTable, pEventData, spEventBase) || EventTypeHandle(bDefault, pState, pShared, pEventData, spEventBase);
+   }
+
+   /** Internal event handler.
+    **
+    ** Find an event-type match in one handler table and call the handler
+    ** if a match is found.
+    **
+    ** @return true: when the event has been handled (false otherwise).
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventTypeHandle(
+      const bool                 bDefault,   //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,     //< The state the handlers belong to.
+      const CHandlerTable* const pTable,     //< The table to look in, can be NULL.
+      const TEventData* const    pEventData, //< The event data belonging to the event.
+      const SPEventBase          spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      )
+   {
       //call handler
-      CHandleEventInfoBase::HandleResult result(pHandleEventTypeInfo->Handle(bDefault, spEventBase, pEventData));
+      //(the state name is only required when the event is sampled for the latency histograms)
+      const bool                         bSample (m_Counters.IsSampling());
+      const std::string                  strState(bSample && NULL != pTable ? pState->GetName() : std::string());
+      CHandleEventInfoBase::HandleResult result  (EventTypeCall(bDefault, pState, pTable, pEventData, spEventBase, m_Counters));
       if(!result.first) {
          //no handler found
          return false;
       }
       
       //state change if requested by handler
-      ChangeState(result.second);
+      if(bSample) {
+         ChangeStateSampled(result.second, strState, spEventBase);
+      } else {
+         ChangeState(result.second);
+      }
       
       //event handled
       return true;
    }
+
+   /** Internal event handler.
+    **
+    ** Find an event-type match in one handler table and call the handler if a
+    ** match is found, without changing state.
+    **
+    ** @return a HandleResult indicating whether a handler was called and, when one was called, the state change it requests.
+    **/
+   template <class TEventData>                                                    
+   CHandleEventInfoBase::HandleResult CStateMachine::EventTypeCall(
+      const bool                 bDefault,    //< Use the current state (false) or the default state (true) to find a matching registered event.
+      CState* const              pState,      //< The state the handlers belong to.
+      const CHandlerTable* const pTable,      //< The table to look in, can be NULL.
+      const TEventData* const    pEventData,  //< The event data belonging to the event.
+      const SPEventBase&         spEventBase, //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      CStateMachineCounters&     counters     //< Runtime statistics: of the state machine or, on a thread pool, of the region.
+      )
+   {
+      //find handler
+      if(NULL == pTable) {
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+      CHandleEventInfoBase* const pHandleEventInfoBase(pTable->EventTypeFind(spEventBase->GetIdType()));
+      if(NULL == pHandleEventInfoBase) {
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+
+      //handler found --> get info to call it
+      THandleEventTypeInfo<TEventData>* pHandleEventTypeInfo = dynamic_cast<THandleEventTypeInfo<TEventData>*>(pHandleEventInfoBase);
+      if(NULL == pHandleEventTypeInfo) {
+         //serious error in the implementation: mismatch in registration
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Statemachine [%s] state [%s] handling event type [%s] in [%s] found type handler with type\n",
+                     m_strName.c_str(),
+                     GetStateName().c_str(),
+                     spEventBase->GetIdType().c_str(),
+                     (bDefault ? "default" : "state")
+                     );
+         }
+         return CHandleEventInfoBase::HandleResult(false, CCreateState());
+      }
+      
+      //call handler
+      return pHandleEventTypeInfo->Handle(bDefault, pState, spEventBase, pEventData, counters);
+   }
+
+   /** Offer an event to the regions (see RegionAdd), in the order they
+    ** were added.
+    **
+    ** With a thread pool (see SetThreadPool), the handlers of the
+    ** region-local regions are called in parallel at the position of the
+    ** first one. Once all of them have finished, the state changes they
+    ** request are made in region order.
+    **
+    ** @return true: when at least 1 region handled the event.
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventHandleRegions(
+      const TEventData* const pEventData, //< The event data belonging to the event.
+      const SPEventBase       spEventBase //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      )
+   {
+      bool bHandled (false);
+      bool bParallel(false);
+      for(size_t region = 1 ; region <= m_Regions.size() ; ++region) {
+         if(NULL == m_pThreadPool || !m_Regions[region - 1].m_bLocal) {
+            //on the calling thread
+            if(EventHandleRegion(region, pEventData, spEventBase, m_Counters)) {
+               bHandled = true;
+               RegionHandled(region);
+            }
+            continue;
+         }
+         if(bParallel) {
+            //already dispatched with the first region-local region
+            continue;
+         }
+         bParallel = true;
+         m_pThreadPool->Run(m_Regions.size(), TYPESEL::bind(&CStateMachine::EventHandleRegionTask<TEventData>, this, pEventData, spEventBase, TYPESEL_PLACEHOLDERS_1));
+         for(size_t local = region ; local <= m_Regions.size() ; ++local) {
+            CStateRegion& ref(m_Regions[local - 1]);
+            if(!ref.m_bLocal) {
+               continue;
+            }
+            m_Counters.Merge(*ref.m_pCounters);
+            if(ref.m_bHandled) {
+               bHandled = true;
+               RegionHandled(local);
+            }
+         }
+      }
+      return bHandled;
+   }
+
+   /** Find a match for an event in a region and call the handler if a
+    ** match is found, without changing state: the result is stored in the
+    ** region.
+    **
+    ** The event handlers of the region's current state are tried first,
+    ** then those of its parents (innermost first), then the event-type
+    ** handlers in the same order.
+    **
+    ** @return true: when the event has been handled (false otherwise).
+    **/
+   template <class TEventData>                                                    
+   bool CStateMachine::EventHandleRegion(
+      const size_t            region,      //< The region (1 for the first region added).
+      const TEventData* const pEventData,  //< The event data belonging to the event.
+      const SPEventBase&      spEventBase, //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      CStateMachineCounters&  counters     //< Runtime statistics: of the state machine or, on a thread pool, of the region.
+      )
+   {
+      CStateRegion&                      ref   (m_Regions[region - 1]);
+      const size_t                       depth (ref.m_Parents.size());
+      CHandleEventInfoBase::HandleResult result(false, CCreateState());
+      for(size_t level = depth + 1 ; 0 < level && !result.first ; --level) {
+         const bool                 bState (depth + 1 == level);
+         CState* const              pState (bState ? ref.m_pState    : ref.m_Parents[level - 1].m_pState   );
+         const CHandlerTable* const pTable (bState ? ref.m_pHandlers : ref.m_Parents[level - 1].m_pHandlers);
+         const CHandlerTable* const pShared(bState ? ref.m_pShared   : ref.m_Parents[level - 1].m_pShared  );
+         result = EventCall(false, pState, pTable, pEventData, spEventBase, counters);
+         if(!result.first) {
+            result = EventCall(false, pState, pShared, pEventData, spEventBase, counters);
+         }
+      }
+      ref.m_bType = false;
+      for(size_t level = depth + 1 ; 0 < level && !result.first ; --level) {
+         const bool                 bState (depth + 1 == level);
+         CState* const              pState (bState ? ref.m_pState    : ref.m_Parents[level - 1].m_pState   );
+         const CHandlerTable* const pTable (bState ? ref.m_pHandlers : ref.m_Parents[level - 1].m_pHandlers);
+         const CHandlerTable* const pShared(bState ? ref.m_pShared   : ref.m_Parents[level - 1].m_pShared  );
+         result = EventTypeCall(false, pState, pTable, pEventData, spEventBase, counters);
+         if(!result.first) {
+            result = EventTypeCall(false, pState, pShared, pEventData, spEventBase, counters);
+         }
+         ref.m_bType = result.first;
+      }
+      ref.m_bHandled = result.first;
+      ref.m_Next     = result.second;
+      return result.first;
+   }
+
+   /** The task dispatching an event to a region on a thread of the pool.
+    **
+    ** Regions that are not region-local are skipped: they are dispatched
+    ** on the calling thread.
+    **/
+   template <class TEventData>                                                    
+   void CStateMachine::EventHandleRegionTask(
+      const TEventData* const pEventData,  //< The event data belonging to the event.
+      const SPEventBase       spEventBase, //< Class instance describing the event in all detail (1 class instance instead of seperate parameters).
+      const size_t            index        //< Index in m_Regions.
+      )
+   {
+      CStateRegion& ref(m_Regions[index]);
+      if(!ref.m_bLocal) {
+         return;
+      }
+      //the engine does not log from the pool: the logging functions need not be thread-safe
+      CLogLevelScope logLevelScope(static_cast<uint8_t>(ELogLevelCount));
+      EventHandleRegion(index + 1, pEventData, spEventBase, *ref.m_pCounters);
+   }
+
+#if __cplusplus >= 201703L
+   /** Factory function to instantiate a state machine allocating from
+    ** a std::pmr::memory_resource provided by the caller.
+    **
+    ** The state machine owns the adapter (see CMemoryResourcePmr), the
+    ** shared pointer control block is allocated from the resource directly.
+    ** The resource is not owned: it has to outlive the state machine and all
+    ** weak pointers to it.
+    **
+    ** @return a shared pointer to the instantiated state machine.
+    **/
+   inline TYPESEL::shared_ptr<CStateMachine> CStateMachine::ConstructStateMachine(
+      const char* szName,                          //< State machine name, logging only.
+      CCreateState createState,                     //< Class to create the initial state.
+      CStateMachineData* const pStateMachineData,   //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      std::pmr::memory_resource* const pResource    //< The resource to allocate from.
+      )
+   {
+      TYPESEL::shared_ptr<CStateMachine> sp(Construct(szName, pStateMachineData, new(pResource) CMemoryResourcePmr(pResource), true), &CStateMachine::Destroy, std::pmr::polymorphic_allocator<CStateMachine>(pResource));
+      sp->SetInitialState(createState);
+      return sp;
+   }
+
+   /** Factory function to instantiate a state machine with a default state,
+    ** allocating from a std::pmr::memory_resource provided by the caller.
+    **
+    ** See the overload without default state.
+    **
+    ** @return a shared pointer to the instantiated state machine.
+    **/
+   inline TYPESEL::shared_ptr<CStateMachine> CStateMachine::ConstructStateMachine(
+      const char* szName,                          //< State machine name, logging only.
+      CCreateState createState,                     //< Class to create the initial state.
+      CCreateState createDefaultState,              //< Class to create the default state.
+      CStateMachineData* const pStateMachineData,   //< Pointer to the state machine data belonging to this state machine. The state machine takes ownership and deletes the instance when the state machine itself is destructed.
+      std::pmr::memory_resource* const pResource    //< The resource to allocate from.
+      )
+   {
+      TYPESEL::shared_ptr<CStateMachine> sp(Construct(szName, pStateMachineData, new(pResource) CMemoryResourcePmr(pResource), true), &CStateMachine::Destroy, std::pmr::polymorphic_allocator<CStateMachine>(pResource));
+      sp->SetInitialState(createState, createDefaultState);
+      return sp;
+   }
+#endif
 };
    
 #endif //__ILULibStateMachine_CStateMachineImpl__H__
@@ -0,0 +1,295 @@
+/** @file
+ ** @brief The CStateMachineStats and CStateMachineCounters declarations.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CStateMachineStats__H__
+#define __ILULibStateMachine_CStateMachineStats__H__
+
+#include <atomic>
+#include <chrono>
+
+#include "CLatencyHistogram.h"
+#include "Types.h"
+
+namespace ILULibStateMachine {
+   class CStateMachine;
+
+   /** @brief Snapshot of the runtime statistics of 1 state machine
+    ** (see CStateMachine::GetStats).
+    **/
+   class CStateMachineStats {
+      public:
+                            CStateMachineStats(void);
+
+      public:
+         unsigned long long m_EventsState;       ///< Events handled by an event handler of the current state.
+         unsigned long long m_EventsDefault;     ///< Events handled by an event handler of the default state.
+         unsigned long long m_EventsTypeState;   ///< Events handled by an event-type handler of the current state.
+         unsigned long long m_EventsTypeDefault; ///< Events handled by an event-type handler of the default state.
+         unsigned long long m_EventsUnhandled;   ///< Events without a matching handler (ignored).
+         unsigned long long m_GuardsEvaluated;   ///< Guards called.
+         unsigned long long m_GuardsPassed;      ///< Guards that returned true.
+         unsigned long long m_Transitions;       ///< State changes.
+         unsigned long long m_Exceptions;        ///< Exceptions caught while calling a guard or handler (state-change exceptions included).
+         unsigned long long m_HandlerNs;         ///< Cumulative handler time (ns), only while handler timing is enabled.
+   };
+
+   /** @brief The live runtime statistics of 1 state machine.
+    **
+    ** A state machine is only used by 1 thread at a time, so the counters
+    ** have a single writer: incrementing is a relaxed load and store, no
+    ** locked instruction. Other threads (e.g. iterating the registry) can
+    ** take a snapshot at any time.
+    **
+    ** The engine updates the counters with the RUNTIME_STATS_ADD macro,
+    ** compiling the library with NO_RUNTIME_STATS (configure
+    ** --disable-runtime-stats) removes all updates: the counters stay 0.
+    **
+    ** Measuring the handler time reads the clock twice per handler, so it
+    ** has to be enabled explicitly (for all state machines).
+    **
+    ** The counters also keep whether the event being handled is sampled
+    ** for the latency histograms (see CLatencyRecorder), the handler
+    ** time of that event and the guard of the handler that was called
+    ** (see CStateMachineTrace).
+    **/
+   class CStateMachineCounters {
+      public:
+         /** @brief The counters.
+          **/
+         enum ECounter {
+            ECounterEventsState = 0,   ///< See CStateMachineStats::m_EventsState.
+            ECounterEventsDefault,     ///< See CStateMachineStats::m_EventsDefault.
+            ECounterEventsTypeState,   ///< See CStateMachineStats::m_EventsTypeState.
+            ECounterEventsTypeDefault, ///< See CStateMachineStats::m_EventsTypeDefault.
+            ECounterEventsUnhandled,   ///< See CStateMachineStats::m_EventsUnhandled.
+            ECounterGuardsEvaluated,   ///< See CStateMachineStats::m_GuardsEvaluated.
+            ECounterGuardsPassed,      ///< See CStateMachineStats::m_GuardsPassed.
+            ECounterTransitions,       ///< See CStateMachineStats::m_Transitions.
+            ECounterExceptions,        ///< See CStateMachineStats::m_Exceptions.
+            ECounterHandlerNs,         ///< See CStateMachineStats::m_HandlerNs.
+            ECounterCount              ///< Number of counters, not a counter.
+         };
+
+      public:
+                                    CStateMachineCounters(void);
+
+      public:
+         static bool                IsEnabled(void);
+         static void                EnableHandlerTiming(const bool bEnable);
+         static bool                IsHandlerTimingEnabled(void);
+         void                       Add(const ECounter counter, const unsigned long long n);
+         CStateMachineStats         Get(void) const;
+         void                       Merge(CStateMachineCounters& ref);
+         void                       StartEvent(void);
+         bool                       IsSampling(void) const;
+         unsigned long long         GetSampleNs(void) const;
+         void                       SetSampleNs(const unsigned long long ns);
+         unsigned int               GetGuard(void) const;
+         void                       SetGuard(const unsigned int guard);
+
+      private:
+                                    CStateMachineCounters(CStateMachineCounters& ref); //defined, not implemented --> avoid copy
+         CStateMachineCounters      operator=(CStateMachineCounters& ref);             //defined, not implemented --> avoid copy
+
+      private:
+         static std::atomic<bool>        s_bHandlerTiming;          ///< Handler timing enabled (all state machines).
+         std::atomic<unsigned long long> m_Counters[ECounterCount]; ///< The counters, 1 writer.
+         bool                            m_bSampling;               ///< The event being handled is sampled for the latency histograms. Only used by the thread using the state machine.
+         unsigned long long              m_SampleNs;                ///< Handler time of the sampled event (ns). Only used by the thread using the state machine.
+         unsigned int                    m_Guard;                   ///< Guard of the handler called for the event being handled (1-based, 0 for an unguarded handler). Only used by the thread using the state machine.
+   };
+
+   /** Indicates whether the handler time is measured.
+    **
+    ** @return true when enabled.
+    **/
+   inline bool CStateMachineCounters::IsHandlerTimingEnabled(void)
+   {
+#ifndef NO_RUNTIME_STATS
+      return s_bHandlerTiming.load(std::memory_order_relaxed);
+#else
+      return false;
+#endif
+   }
+
+   /** Add to a counter: a relaxed load and store (single writer).
+    **/
+   inline void CStateMachineCounters::Add(
+      const ECounter           counter, //< The counter.
+      const unsigned long long n        //< Value to add.
+      )
+   {
+      m_Counters[counter].store(m_Counters[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+   }
+
+   /** An event is fed into the state machine: decide whether it is
+    ** sampled for the latency histograms.
+    **/
+   inline void CStateMachineCounters::StartEvent(void)
+   {
+#ifndef NO_RUNTIME_STATS
+      m_bSampling = CLatencyRecorder::Sample();
+      m_SampleNs  = 0;
+#endif
+   }
+
+   /** Indicates whether the event being handled is sampled for the latency
+    ** histograms.
+    **
+    ** @return true when sampled.
+    **/
+   inline bool CStateMachineCounters::IsSampling(void) const
+   {
+#ifndef NO_RUNTIME_STATS
+      return m_bSampling;
+#else
+      return false;
+#endif
+   }
+
+   /** Get the handler time of the sampled event.
+    **
+    ** @return the handler time (ns).
+    **/
+   inline unsigned long long CStateMachineCounters::GetSampleNs(void) const
+   {
+      return m_SampleNs;
+   }
+
+   /** Set the handler time of the sampled event.
+    **/
+   inline void CStateMachineCounters::SetSampleNs(
+      const unsigned long long ns //< The handler time (ns).
+      )
+   {
+      m_SampleNs = ns;
+   }
+
+   /** Get the guard of the handler called for the event being handled.
+    **
+    ** @return the guard number (1-based), 0 for an unguarded handler.
+    **/
+   inline unsigned int CStateMachineCounters::GetGuard(void) const
+   {
+      return m_Guard;
+   }
+
+   /** Set the guard of the handler called for the event being handled.
+    **/
+   inline void CStateMachineCounters::SetGuard(
+      const unsigned int guard //< The guard number (1-based), 0 for an unguarded handler.
+      )
+   {
+      m_Guard = guard;
+   }
+
+   /** @brief Add the time spent in a scope to the handler time of a state
+    ** machine, when handler timing is enabled, and keep it when the event
+    ** is sampled for the latency histograms.
+    **/
+   class CStateMachineHandlerTimer {
+      public:
+         explicit                   CStateMachineHandlerTimer(CStateMachineCounters& counters);
+                                    ~CStateMachineHandlerTimer(void);
+
+      private:
+                                    CStateMachineHandlerTimer(CStateMachineHandlerTimer& ref); //defined, not implemented --> avoid copy
+         CStateMachineHandlerTimer  operator=(CStateMachineHandlerTimer& ref);                 //defined, not implemented --> avoid copy
+
+      private:
+         CStateMachineCounters&                 m_Counters; ///< The counters to add the time to.
+         const bool                             m_bTiming;  ///< Handler timing was enabled when the scope was entered.
+         const bool                             m_bEnabled; ///< Handler timing was enabled or the event is sampled.
+         std::chrono::steady_clock::time_point  m_Start;    ///< Time the scope was entered (only when enabled).
+   };
+
+   /** Constructor: start measuring when handler timing is enabled or the
+    ** event is sampled.
+    **/
+   inline CStateMachineHandlerTimer::CStateMachineHandlerTimer(
+      CStateMachineCounters& counters //< The counters of the state machine.
+      )
+      : m_Counters(counters)
+      , m_bTiming (CStateMachineCounters::IsHandlerTimingEnabled())
+      , m_bEnabled(m_bTiming || counters.IsSampling())
+      , m_Start   ()
+   {
+      if(m_bEnabled) {
+         m_Start = std::chrono::steady_clock::now();
+      }
+   }
+
+   /** Destructor: add the time spent in the scope.
+    **/
+   inline CStateMachineHandlerTimer::~CStateMachineHandlerTimer(void)
+   {
+      if(!m_bEnabled) {
+         return;
+      }
+      const unsigned long long ns(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+      if(m_bTiming) {
+         m_Counters.Add(CStateMachineCounters::ECounterHandlerNs, ns);
+      }
+      if(m_Counters.IsSampling()) {
+         m_Counters.SetSampleNs(ns);
+      }
+   }
+
+   /** @brief Registry of all live state machines of the process, e.g. to
+    ** report the statistics of all of them.
+    **
+    ** State machines register themselves upon construction and unregister
+    ** upon destruction, also when compiled with NO_RUNTIME_STATS (CLogLevel
+    ** sets the log level of the live state machines through it). The
+    ** registry is protected by a mutex, which is held while ForEach calls
+    ** the callback: the callback must not construct or destruct state
+    ** machines and should not use the state machines (they can be in use
+    ** by another thread), reading their statistics is safe.
+    **/
+   class CStateMachineRegistry {
+      public:
+         static unsigned int        GetCount(void);
+         static void                ForEach(TYPESEL::function<void(const CStateMachine&)> callback);
+
+      private:
+         friend class CStateMachine;
+         static void                Register(CStateMachine* const pStateMachine);
+         static void                Unregister(CStateMachine* const pStateMachine);
+   };
+}
+
+#ifndef NO_RUNTIME_STATS
+/** Add N to COUNTER of the CStateMachineCounters instance COUNTERS.
+ **/
+#  define RUNTIME_STATS_ADD(COUNTERS, COUNTER, N) (COUNTERS).Add(ILULibStateMachine::CStateMachineCounters::COUNTER, (N))
+/** Measure the handler time of the rest of the enclosing scope.
+ **/
+#  define RUNTIME_STATS_HANDLER_TIMER(COUNTERS)   ILULibStateMachine::CStateMachineHandlerTimer handlerTimer(COUNTERS)
+#else
+/** Runtime statistics compiled out (the counters are still referenced to avoid unused parameter warnings).
+ **/
+#  define RUNTIME_STATS_ADD(COUNTERS, COUNTER, N) (void)(COUNTERS)
+/** Runtime statistics compiled out (the counters are still referenced to avoid unused parameter warnings).
+ **/
+#  define RUNTIME_STATS_HANDLER_TIMER(COUNTERS)   (void)(COUNTERS)
+#endif
+
+#endif //__ILULibStateMachine_CStateMachineStats__H__
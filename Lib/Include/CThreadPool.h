@@ -0,0 +1,79 @@
+/** @file
+ ** @brief The CThreadPool declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CThreadPool__H__
+#define __ILULibStateMachine_CThreadPool__H__
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+
+namespace ILULibStateMachine {
+   /** @brief A fixed number of threads running batches of tasks, e.g. the
+    ** region-local regions of state machines (see CStateMachine::SetThreadPool).
+    **
+    ** Run returns when all tasks of the batch have finished (join). The
+    ** calling thread runs tasks of its own batch as well, so a task can
+    ** call Run on the same pool without deadlocking, and a pool without
+    ** threads runs everything on the calling thread.
+    **
+    ** A pool can be shared by many state machines and threads. It has to
+    ** outlive the state machines using it.
+    **/
+   class CThreadPool {
+      public:
+         /** The task: called once per index of the batch.
+          **/
+         typedef TYPESEL::function<void(const size_t)> FTask;
+
+      public:
+         explicit                      CThreadPool(const unsigned int threads);
+                                       ~CThreadPool(void);
+
+      public:
+         unsigned int                  GetThreadCount(void) const;
+         void                          Run(const size_t count, const FTask& task);
+
+      private:
+                                       CThreadPool(CThreadPool& ref);     //defined, not implemented --> avoid copy
+         CThreadPool                   operator=(CThreadPool& ref);       //defined, not implemented --> avoid copy
+
+      private:
+         class CBatch;
+         void                          Worker(void);
+         void                          RunOne(std::unique_lock<std::mutex>& lock, CBatch& batch);
+
+      private:
+         std::mutex                    m_Mutex;   ///< Protects the batches and their progress.
+         std::condition_variable       m_Wakeup;  ///< Signals the workers: a new batch or stop.
+         std::condition_variable       m_Done;    ///< Signals the callers of Run: a task has finished.
+         std::deque<CBatch*>           m_Batches; ///< The batches with tasks not started yet, oldest first.
+         bool                          m_bStop;   ///< The workers stop once there are no batches left.
+         std::vector<std::thread>      m_Threads; ///< The workers.
+   };
+}
+
+#endif //__ILULibStateMachine_CThreadPool__H__
@@ -0,0 +1,186 @@
+/** @file
+ ** @brief The CTrace, CTraceRecord and CStateMachineTrace declarations.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CTrace__H__
+#define __ILULibStateMachine_CTrace__H__
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+namespace ILULibStateMachine {
+   class CEventBase;
+   class CStateMachine;
+
+   /** @brief How an event was dispatched.
+    **/
+   enum ETraceKind {
+      ETraceKindState = 0,   ///< Handled by an event handler of the current state.
+      ETraceKindDefault,     ///< Handled by an event handler of the default state.
+      ETraceKindTypeState,   ///< Handled by an event-type handler of the current state.
+      ETraceKindTypeDefault, ///< Handled by an event-type handler of the default state.
+      ETraceKindUnhandled,   ///< No matching handler (ignored).
+      ETraceKindCount        ///< Number of kinds, not a kind.
+   };
+
+   /** @brief 1 dispatched event, as stored in the trace buffers and in a
+    ** trace dump (native byte order).
+    **
+    ** Names (state machine, state, event type) are stored as ID's, the
+    ** dump contains the tables to translate them.
+    **/
+   class CTraceRecord {
+      public:
+         static const uint32_t TARGET_NONE     = 0;          ///< m_Target: no state change.
+         static const uint32_t TARGET_FINISHED = 0xFFFFFFFF; ///< m_Target: the state machine finished.
+         static const uint8_t  GUARD_NONE      = 0xFF;       ///< m_Guard: no handler called.
+
+      public:
+         static const char*    GetKindName(const ETraceKind kind);
+
+      public:
+         uint64_t              m_TimestampNs;    ///< Start of the dispatch (steady clock, ns).
+         uint32_t              m_EventValues[4]; ///< Event ID and sub-ID's.
+         uint32_t              m_Machine;        ///< State machine ID (see CTrace::RegisterMachine).
+         uint32_t              m_State;          ///< Current state when the event was fed (see CTrace::RegisterName), 0 when none.
+         uint32_t              m_EventType;      ///< Event type (see CTrace::RegisterName and CEventBase::GetIdType).
+         uint32_t              m_Target;         ///< State after the state change, TARGET_NONE or TARGET_FINISHED.
+         uint32_t              m_DurationNs;     ///< Duration of the dispatch (ns).
+         uint8_t               m_Kind;           ///< How the event was dispatched (ETraceKind).
+         uint8_t               m_Guard;          ///< Guard of the called handler (1-based), 0 for an unguarded handler, GUARD_NONE.
+         uint8_t               m_EventCount;     ///< Number of values in m_EventValues.
+         uint8_t               m_Reserved;       ///< Padding, 0.
+   };
+
+   /** @brief Binary trace of the dispatched events.
+    **
+    ** When enabled, every event fed into a state machine is recorded in a
+    ** ring buffer of the calling thread: the oldest records are overwritten.
+    ** Recording fills 1 CTraceRecord and reads the clock twice, it does
+    ** not format or lock. Only the first dispatch after a state change
+    ** registers the name of the new state (under a lock).
+    **
+    ** Dump writes the buffers of all threads (including the finished
+    ** ones) with the name tables to a file, CTraceDecoder (or the
+    ** StateMachineTraceDecode tool) turns it into text or a Chrome trace
+    ** (chrome://tracing, Perfetto). Dump while events are being
+    ** dispatched can contain garbled records at the oldest end of the
+    ** buffers that are in use.
+    **/
+   class CTrace {
+      public:
+         static const char      MAGIC[9];                  ///< First 8 bytes of a dump.
+         static const uint32_t  DEFAULT_CAPACITY = 65536;  ///< Default number of records per thread.
+
+      public:
+         static void            Enable(const bool bEnable);
+         static bool            IsEnabled(void);
+         static void            SetCapacity(const uint32_t records);
+         static uint32_t        RegisterMachine(const std::string& strName);
+         static uint32_t        RegisterName(const std::string& strName);
+         static void            Record(const CTraceRecord& record);
+         static bool            Dump(const char* const szFile);
+         static void            Clear(void);
+
+      private:
+         static std::atomic<bool> s_bEnabled; ///< Tracing enabled.
+   };
+
+   /** Indicates whether tracing is enabled.
+    **
+    ** @return true when enabled.
+    **/
+   inline bool CTrace::IsEnabled(void)
+   {
+      return s_bEnabled.load(std::memory_order_relaxed);
+   }
+
+   /** @brief Traces 1 event fed into a state machine: the record is
+    ** started upon construction and added to the trace when the scope ends.
+    **
+    ** Does nothing when tracing was disabled upon construction.
+    **/
+   class CStateMachineTrace {
+      public:
+                               CStateMachineTrace(CStateMachine& stateMachine, const CEventBase& event);
+                               ~CStateMachineTrace(void);
+
+      public:
+         void                  SetKind(const ETraceKind kind);
+         void                  SetStateChange(void);
+
+      private:
+                               CStateMachineTrace(CStateMachineTrace& ref); //defined, not implemented --> avoid copy
+         CStateMachineTrace    operator=(CStateMachineTrace& ref);          //defined, not implemented --> avoid copy
+         void                  Start(const CEventBase& event);
+         void                  Stop(void);
+
+      private:
+         CStateMachine&        m_StateMachine;  ///< The state machine handling the event.
+         const bool            m_bActive;       ///< Tracing was enabled when the event was fed.
+         bool                  m_bStateChange;  ///< The handler changed state.
+         CStateMachineTrace*   m_pPrevious;     ///< Trace of the event being handled by the state machine when this one was fed (nested events).
+         CTraceRecord          m_Record;        ///< The record being filled.
+   };
+
+   /** Constructor: start the record when tracing is enabled.
+    **/
+   inline CStateMachineTrace::CStateMachineTrace(
+      CStateMachine&    stateMachine, //< The state machine handling the event.
+      const CEventBase& event         //< The event.
+      )
+      : m_StateMachine(stateMachine         )
+      , m_bActive     (CTrace::IsEnabled()  )
+      , m_bStateChange(false                )
+      , m_pPrevious   (NULL                 )
+   {
+      if(m_bActive) {
+         Start(event);
+      }
+   }
+
+   /** Destructor: add the record to the trace.
+    **/
+   inline CStateMachineTrace::~CStateMachineTrace(void)
+   {
+      if(m_bActive) {
+         Stop();
+      }
+   }
+
+   /** Set how the event was dispatched.
+    **/
+   inline void CStateMachineTrace::SetKind(
+      const ETraceKind kind //< The dispatch path.
+      )
+   {
+      m_Record.m_Kind = static_cast<uint8_t>(kind);
+   }
+
+   /** The handler changed state: the new state is recorded as the target.
+    **/
+   inline void CStateMachineTrace::SetStateChange(void)
+   {
+      m_bStateChange = true;
+   }
+}
+
+#endif //__ILULibStateMachine_CTrace__H__
@@ -0,0 +1,53 @@
+/** @file
+ ** @brief The CTraceDecoder declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CTraceDecoder__H__
+#define __ILULibStateMachine_CTraceDecoder__H__
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace ILULibStateMachine {
+   /** @brief Turns a trace dump (see CTrace::Dump) into readable text or
+    ** a Chrome trace (JSON trace event format, for chrome://tracing and
+    ** Perfetto).
+    **
+    ** The records of all threads are merged in time order. In the Chrome
+    ** trace every state machine is a process and every thread a thread.
+    **
+    ** The dump has to be decoded on a machine with the same byte order.
+    **/
+   class CTraceDecoder {
+      public:
+         /** @brief Output formats.
+          **/
+         enum EFormat {
+            EFormatText = 0, ///< 1 line per dispatched event.
+            EFormatChrome    ///< Chrome trace event JSON.
+         };
+
+      public:
+         static bool Decode(std::istream& in, std::ostream& out, const EFormat format, std::string& strError);
+   };
+}
+
+#endif //__ILULibStateMachine_CTraceDecoder__H__
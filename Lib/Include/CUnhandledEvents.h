@@ -0,0 +1,126 @@
+/** @file
+ ** @brief The CUnhandledEvents declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CUnhandledEvents__H__
+#define __ILULibStateMachine_CUnhandledEvents__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "Types.h"
+
+namespace ILULibStateMachine {
+   class CEventBase;
+   class CStateMachine;
+
+   /** @brief Identification of unhandled events: state machine name,
+    ** state and event.
+    **/
+   class CUnhandledKey {
+      public:
+                            CUnhandledKey(const std::string& strMachine, const std::string& strState, const std::string& strEvent);
+
+      public:
+         bool               operator<(const CUnhandledKey& ref) const;
+
+      public:
+         std::string        m_strMachine; ///< State machine name.
+         std::string        m_strState;   ///< Current state when the event was not handled.
+         std::string        m_strEvent;   ///< Event ID (see CEventBase::GetId).
+   };
+
+   /** @brief An unhandled event, passed to the dead-letter function and
+    ** queue.
+    **
+    ** The event is described with strings: the event itself can be
+    ** allocated from the memory resource of the state machine, which does
+    ** not have to outlive the queue.
+    **/
+   class CDeadLetter {
+      public:
+                            CDeadLetter(void);
+
+      public:
+         std::string        m_strMachine;   ///< State machine name.
+         uint64_t           m_MachineId;    ///< State machine ID (see CStateMachine::GetId).
+         std::string        m_strState;     ///< Current state when the event was not handled.
+         std::string        m_strEvent;     ///< Event ID (see CEventBase::GetId).
+         std::string        m_strEventType; ///< Event type (see CEventBase::GetIdType).
+         std::string        m_strDataType;  ///< Type of the event data (see CEventBase::GetDataType).
+         unsigned long long m_Count;        ///< Number of unhandled events with the same CUnhandledKey so far, this one included, 0 when the key did not fit (see SetKeyCapacity).
+   };
+
+   typedef TYPESEL::function<void(const CDeadLetter& deadLetter)> FDeadLetter; ///< Prototype of a dead-letter function that can be registered.
+
+   /** @brief Counts the events no state machine handler matched, per
+    ** state machine name, state and event, and passes them on to an
+    ** optional dead-letter function and queue.
+    **
+    ** Without a matching handler the engine logs all registered handlers
+    ** of the state machine (at debug level, see CLogLevel). That is useful
+    ** for the first unexpected event, but a burst of them turns it into
+    ** the most expensive code of the process. The handlers are logged at
+    ** most once per CUnhandledKey per interval (1 second by default,
+    ** SetTraceInterval), the other unhandled events are only counted.
+    **
+    ** The dead-letter function is called for every unhandled event by the
+    ** thread feeding the event, after the engine is done with it. The
+    ** queue (disabled by default, SetQueueCapacity) keeps the most recent
+    ** unhandled events until Pop takes them, e.g. from another thread.
+    **
+    ** The keys are counted in a table of at most DEFAULT_KEY_CAPACITY keys
+    ** (SetKeyCapacity), the unhandled events of the keys that did not fit
+    ** are counted together (GetKeyOverflow).
+    **
+    ** The administration is protected by a mutex: handled events do not
+    ** touch it. Without a dead-letter function and queue, an unhandled
+    ** event of a key whose handlers have been logged recently is only
+    ** counted in a lock-free table of recent keys, identified by a hash of
+    ** the key: it does not build the strings of the key or take the mutex.
+    ** These counts are added to the keys by the next locked call.
+    **/
+   class CUnhandledEvents {
+      public:
+         static const unsigned int  DEFAULT_TRACE_INTERVAL_MS = 1000; ///< Default interval between 2 handler loggings for the same key (ms).
+         static const size_t        DEFAULT_KEY_CAPACITY      = 4096; ///< Default maximum number of keys counted separately.
+
+      public:
+         static void                SetTraceInterval(const unsigned int ms);
+         static unsigned int        GetTraceInterval(void);
+         static void                RegisterDeadLetter(FDeadLetter deadLetter);
+         static void                UnRegisterDeadLetter(void);
+         static void                SetQueueCapacity(const size_t capacity);
+         static bool                Pop(CDeadLetter& deadLetter);
+         static unsigned long long  GetQueueDropped(void);
+         static unsigned long long  GetTraceSuppressed(void);
+         static void                SetKeyCapacity(const size_t capacity);
+         static unsigned long long  GetKeyOverflow(void);
+         static void                ForEach(TYPESEL::function<void(const CUnhandledKey&, const unsigned long long count)> callback);
+         static void                Reset(void);
+
+      private:
+         friend class CStateMachine;
+         static bool                Record(const CStateMachine& stateMachine, const std::string& strState, const CEventBase& event);
+   };
+}
+
+#endif //__ILULibStateMachine_CUnhandledEvents__H__
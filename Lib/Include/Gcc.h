@@ -38,8 +38,12 @@
 # ifndef __printf
 #  define __printf(x)  __attribute__ ((format (printf, x+1, x+2))) ///< Make using the printf format check easier
 # endif
+# ifndef __noinline
+#  define __noinline   __attribute__ ((noinline))                  ///< Keep a function out of line, e.g. a replaced global operator new or delete
+# endif
 #else
 #  define __printf(x)                                              ///< Compiler does not support printf
+#  define __noinline                                               ///< Compiler does not support noinline
 #endif
 
 #endif //#ifndef __ILULibStateMachine_Gcc_H__
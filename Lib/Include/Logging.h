@@ -26,8 +26,15 @@
  ** The default behaviour of the logging functions is to use console output
  ** (stdout and stderr).
  ** LogDebug is disabled by default, it can be enabled by calling 'EnableSerialLogDebug'.
+ ** Registering an empty function disables a level: neither the engine nor
+ ** the logging functions format its messages anymore.
  ** However by registering other logging functions this behaviour can be 
  ** changed as required by the application using this library.
+ ** The asynchronous serial logging functions (LoggingAsync.h) can be
+ ** registered to write the console output from a background thread.
+ ** Functions can be registered while other threads are logging, also from
+ ** within a registered function: a replaced function is deleted once no
+ ** thread is calling it anymore.
  **
  ** Log levels according to http://man7.org/linux/man-pages/man2/syslog.2.html
  **
@@ -42,6 +49,17 @@
 #include "Types.h"
 
 namespace ILULibStateMachine {
+   /** @brief The logging levels.
+    **/
+   enum ELogLevel {
+      ELogLevelDebug = 0, ///< LogDebug.
+      ELogLevelInfo,      ///< LogInfo.
+      ELogLevelNotice,    ///< LogNotice.
+      ELogLevelWarning,   ///< LogWarning.
+      ELogLevelErr,       ///< LogErr.
+      ELogLevelCount      ///< Number of levels, not a level.
+   };
+
    typedef TYPESEL::function<void(const std::string& log)> FLog;      ///< Prototype of a logging function that can be registered.
    typedef TYPESEL::function<void(void)>                   FIndent;   ///< Prototype of a function that increases the logging indentation that can be registered.
    typedef TYPESEL::function<void(void)>                   FUnindent; ///< Prototype of a function that decreases the logging indentation that can be registered.
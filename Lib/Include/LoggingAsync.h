@@ -0,0 +1,71 @@
+/** @file
+ ** @brief The asynchronous serial logging functions declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ** The asynchronous serial logging functions write the same console output
+ ** as the default (serial) logging functions, but not from the calling
+ ** thread: the message (with its color and indentation) is copied into a
+ ** lock-free ring buffer and a background thread writes the buffered
+ ** messages in batches (1 'writev' call per batch) to stdout or stderr.
+ ** A slow terminal or pipe no longer stalls the state machines.
+ **
+ ** Usage:
+ **    StartAsyncLog(4096, EAsyncLogOverflowDrop);
+ **    RegisterLogInfo(AsyncSerialLogInfo);
+ **    ...
+ **
+ ** When the ring buffer is full, a message is either dropped (and counted,
+ ** see GetAsyncLogDropped) or the calling thread waits for room, depending
+ ** on the overflow policy.
+ ** StartAsyncLog installs an exit handler writing the buffered messages
+ ** when the program exits, FlushAsyncLog waits until all messages logged
+ ** so far are written.
+ ** While the background thread is not running the functions log
+ ** synchronously, just like the default logging functions.
+ **/
+#ifndef __ILULibStateMachine_LoggingAsync_H__
+#define __ILULibStateMachine_LoggingAsync_H__
+
+#include <stddef.h>
+#include <string>
+
+namespace ILULibStateMachine {
+   /** @brief What to do with a message when the ring buffer is full.
+    **/
+   enum EAsyncLogOverflow {
+      EAsyncLogOverflowDrop = 0, ///< Drop the message and count it.
+      EAsyncLogOverflowBlock     ///< Wait until the background thread made room.
+   };
+
+   //asynchronous logging administration functions
+   void               StartAsyncLog        (const size_t capacity = 4096, const EAsyncLogOverflow overflow = EAsyncLogOverflowDrop);
+   void               StopAsyncLog         (void);
+   void               FlushAsyncLog        (void);
+   unsigned long long GetAsyncLogDropped   (void);
+   unsigned long long GetAsyncLogWritten   (void);
+
+   //asynchronous logging functions, to be registered with RegisterLog*
+   void               AsyncSerialLogDebug  (const std::string& strLog);
+   void               AsyncSerialLogInfo   (const std::string& strLog);
+   void               AsyncSerialLogNotice (const std::string& strLog);
+   void               AsyncSerialLogWarning(const std::string& strLog);
+   void               AsyncSerialLogErr    (const std::string& strLog);
+};
+
+#endif //__ILULibStateMachine_LoggingAsync_H__
@@ -22,11 +22,20 @@
 #ifndef __ILULibStateMachine_StateMachine__H__
 #define __ILULibStateMachine_StateMachine__H__
 
+#include "CAllocationStats.h"
+#include "CBinaryLog.h"
+#include "CBroadcast.h"
 #include "CCreateState.h"
 #include "CCreateStateFinished.h"
 #include "CEventBase.h"
 #include "CHandleEventInfoBase.h"
+#include "CHandlerTable.h"
+#include "CLatencyHistogram.h"
 #include "CLogIndent.h"
+#include "CLogLevel.h"
+#include "CMemoryArena.h"
+#include "CMemoryResource.h"
+#include "CMemoryResourcePmr.h"
 #include "CSPEventBaseSort.h"
 #include "CState.h"
 #include "CStateChangeException.h"
@@ -34,14 +43,28 @@
 #include "CStateEvtIdImpl.h"
 #include "CStateMachine.h"
 #include "CStateMachineData.h"
+#include "CStateMachineStats.h"
+#include "CThreadPool.h"
+#include "CTrace.h"
+#include "CTraceDecoder.h"
+#include "CUnhandledEvents.h"
 #include "EEvtSubNotSet.h"
 #include "Logging.h"
+#include "LoggingAsync.h"
+#include "TAllocator.h"
 #include "TCreateState.h"
 #include "TCreateStateNoData.h"
 #include "TEventEvtId.h"
 #include "TEventEvtIdImpl.h"
+#include "TEventEvtIdPrefix.h"
+#include "TEventEvtIdRange.h"
+#include "TEvtIdDense.h"
+#include "TEvtIdRange.h"
+#include "TEvtSubAny.h"
 #include "THandleEventInfo.h"
 #include "THandleEventTypeInfo.h"
+#include "TSharedHandler.h"
+#include "TStateParent.h"
 #include "Types.h"
 
 #endif //__ILULibStateMachine_StateMachine__H__
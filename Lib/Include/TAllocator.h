@@ -0,0 +1,71 @@
+/** @file
+ ** @brief The TAllocator declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TAllocator__H__
+#define __ILULibStateMachine_TAllocator__H__
+
+#include <cstddef>
+
+#include "CMemoryResource.h"
+
+namespace ILULibStateMachine {
+   /** @brief Standard allocator on top of a CMemoryResource.
+    **
+    ** Used for the containers and shared pointers owned by a state machine,
+    ** so they are allocated from the state machine's arena. A NULL resource
+    ** means the heap.
+    **/
+   template <class T> class TAllocator {
+      public:
+         typedef T              value_type;      ///< Allocated type.
+         typedef T*             pointer;         ///< Pointer to the allocated type.
+         typedef const T*       const_pointer;   ///< Const pointer to the allocated type.
+         typedef T&             reference;       ///< Reference to the allocated type.
+         typedef const T&       const_reference; ///< Const reference to the allocated type.
+         typedef size_t         size_type;       ///< Size type.
+         typedef std::ptrdiff_t difference_type; ///< Difference type.
+         /** @brief Get the same allocator for another type.
+          **/
+         template <class U> struct rebind {
+            typedef TAllocator<U> other; ///< The allocator for U.
+         };
+
+      public:
+                                    TAllocator(CMemoryResource* const pResource = NULL);
+         template <class U>         TAllocator(const TAllocator<U>& ref);
+
+      public:
+         T*                         allocate(const size_t n);
+         void                       deallocate(T* const p, const size_t n);
+         CMemoryResource*           GetResource(void) const;
+
+      private:
+         CMemoryResource*           m_pResource; ///< The resource to allocate from, NULL for the heap.
+   };
+
+   template <class T, class U> bool operator==(const TAllocator<T>& a, const TAllocator<U>& b);
+   template <class T, class U> bool operator!=(const TAllocator<T>& a, const TAllocator<U>& b);
+}
+
+//include the class template function definitions.
+#include "TAllocatorImpl.h"
+
+#endif //__ILULibStateMachine_TAllocator__H__
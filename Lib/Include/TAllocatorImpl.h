@@ -0,0 +1,101 @@
+/** @file
+ ** @brief The TAllocator template function defintions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TAllocatorImpl__H__
+#define __ILULibStateMachine_TAllocatorImpl__H__
+
+namespace ILULibStateMachine {
+   /** Constructor.
+    **/
+   template <class T>
+   TAllocator<T>::TAllocator(
+      CMemoryResource* const pResource //< The resource to allocate from, NULL for the heap.
+      )
+      : m_pResource(pResource)
+   {
+   }
+
+   /** Converting constructor, required by the standard containers.
+    **/
+   template <class T>
+   template <class U>
+   TAllocator<T>::TAllocator(
+      const TAllocator<U>& ref //< Allocator for another type.
+      )
+      : m_pResource(ref.GetResource())
+   {
+   }
+
+   /** Allocate memory for n objects.
+    **
+    ** @return the memory.
+    **/
+   template <class T>
+   T* TAllocator<T>::allocate(
+      const size_t n //< Number of objects.
+      )
+   {
+      return static_cast<T*>(MemoryAllocate(m_pResource, n * sizeof(T), alignof(T)));
+   }
+
+   /** Return memory for n objects.
+    **/
+   template <class T>
+   void TAllocator<T>::deallocate(
+      T* const     p, //< The memory.
+      const size_t n  //< Number of objects, as provided to allocate.
+      )
+   {
+      MemoryDeallocate(m_pResource, p, n * sizeof(T), alignof(T));
+   }
+
+   /** Get the resource this allocator allocates from.
+    **
+    ** @return the resource, NULL for the heap.
+    **/
+   template <class T>
+   CMemoryResource* TAllocator<T>::GetResource(void) const
+   {
+      return m_pResource;
+   }
+
+   /** Allocators are equal when they allocate from the same resource.
+    **
+    ** @return true when equal.
+    **/
+   template <class T, class U>
+   bool operator==(const TAllocator<T>& a, const TAllocator<U>& b)
+   {
+      return a.GetResource() == b.GetResource();
+   }
+
+   /** Allocators are equal when they allocate from the same resource.
+    **
+    ** @return true when not equal.
+    **/
+   template <class T, class U>
+   bool operator!=(const TAllocator<T>& a, const TAllocator<U>& b)
+   {
+      return a.GetResource() != b.GetResource();
+   }
+}
+
+#endif //__ILULibStateMachine_TAllocatorImpl__H__
@@ -24,6 +24,7 @@
 
 #include "CCreateState.h"
 #include "CStateMachine.h"
+#include "TStateParent.h"
 #include "Types.h"
 
 namespace ILULibStateMachine {
@@ -38,20 +39,73 @@ namespace ILULibStateMachine {
       return new CStateType(wpStateMachine, pData);
    }
    
-   /** Wrapper template around TCreateStateInstance that binds
+   /** Same as TCreateStateInstance, but getting the state machine data
+    ** as an untyped context pointer so it can be stored directly in
+    ** CCreateState (see FCreateStateRaw).
+    **/
+   template<class CStateType, class CDataType> CState* TCreateStateInstanceContext(WPStateMachine wpStateMachine, void* pContext)
+   {
+      return new CStateType(wpStateMachine, static_cast<CDataType*>(pContext));
+   }
+   
+   /** @brief Selects TCreateStateInstanceContext as raw create function
+    ** (see TStateParent).
+    **/
+   template<class CDataType> class TCreateStateRaw {
+      public:
+         template<class CStateType> static FCreateStateRaw Get(void)
+         {
+            return &TCreateStateInstanceContext<CStateType,CDataType>;
+         }
+   };
+
+   /** Wrapper template around TCreateStateInstanceContext that returns
     ** the state create function as expected by the state machine
-    ** CCreateState.
+    ** CCreateState: a raw function pointer and the data pointer (no bind).
+    **
+    ** When CStateType is a substate (see THasParentState), its parents
+    ** are created with the same data pointer.
     **/
    template<class CStateType, class CDataType> CCreateState TCreateState(CDataType* pData)
    {
       return CCreateState(
-         TYPESEL::bind(
-            &TCreateStateInstance<CStateType,CDataType>, 
-            TYPESEL_PLACEHOLDERS_1,
-            pData
-            )
+         &TCreateStateInstanceContext<CStateType,CDataType>,
+         const_cast<void*>(static_cast<const void*>(pData)),
+         TStateParent<CStateType, TCreateStateRaw<CDataType> >::Get()
          );
    }
+
+   /** Same as TCreateStateInstance, but getting the data of the state
+    ** machine creating the state as context (see CCreateState::WithStateMachineData).
+    **/
+   template<class CStateType, class CDataType> CState* TCreateStateInstanceStateMachineData(WPStateMachine wpStateMachine, void* pContext)
+   {
+      return new CStateType(wpStateMachine, static_cast<CDataType*>(static_cast<CStateMachineData*>(pContext)));
+   }
+   
+   /** @brief Selects TCreateStateInstanceStateMachineData as raw create
+    ** function (see TStateParent).
+    **/
+   template<class CDataType> class TCreateStateSharedRaw {
+      public:
+         template<class CStateType> static FCreateStateRaw Get(void)
+         {
+            return &TCreateStateInstanceStateMachineData<CStateType,CDataType>;
+         }
+   };
+
+   /** Create-state function that does not refer to a data instance: 
+    ** the state is created with the data of the state machine it will
+    ** belong to. 
+    **
+    ** Use this for state transitions registered in shared handler tables
+    ** (see HANDLER_SHARED): the same registration is used by all state
+    ** machine instances.
+    **/
+   template<class CStateType, class CDataType> CCreateState TCreateStateShared(void)
+   {
+      return CCreateState::WithStateMachineData(&TCreateStateInstanceStateMachineData<CStateType,CDataType>, TStateParent<CStateType, TCreateStateSharedRaw<CDataType> >::Get());
+   }
 }
 
 #endif //__ILULibStateMachine_TCreateState__H__
@@ -24,6 +24,7 @@
 
 #include "CCreateState.h"
 #include "CStateMachine.h"
+#include "TStateParent.h"
 #include "Types.h"
 
 namespace ILULibStateMachine {
@@ -38,13 +39,32 @@ namespace ILULibStateMachine {
       return new CStateType(wpStateMachine);
    }
    
-   /** Wrapper template around TCreateStateInstance that binds
+   /** Same as TCreateStateInstanceNoData, matching the raw create
+    ** function prototype expected by CCreateState (the context is unused).
+    **/
+   template<class CStateType> CState* TCreateStateInstanceNoDataContext(WPStateMachine wpStateMachine, void*)
+   {
+      return new CStateType(wpStateMachine);
+   }
+   
+   /** @brief Selects TCreateStateInstanceNoDataContext as raw create
+    ** function (see TStateParent).
+    **/
+   class TCreateStateNoDataRaw {
+      public:
+         template<class CStateType> static FCreateStateRaw Get(void)
+         {
+            return &TCreateStateInstanceNoDataContext<CStateType>;
+         }
+   };
+
+   /** Wrapper template around TCreateStateInstanceNoDataContext that returns
     ** the state create function as expected by the state machine
     ** CCreateState.
     **/
    template<class CStateType> CCreateState TCreateStateNoData(void)
    {
-     return CCreateState(TCreateStateInstanceNoData<CStateType>);
+     return CCreateState(&TCreateStateInstanceNoDataContext<CStateType>, NULL, TStateParent<CStateType, TCreateStateNoDataRaw>::Get());
    }
 }
 
@@ -29,6 +29,9 @@
 #include "CCreateState.h"
 #include "CEventBase.h"
 #include "EEvtSubNotSet.h"
+#include "TEvtIdDense.h"
+#include "TEvtIdRange.h"
+#include "TEvtSubAny.h"
 
 namespace ILULibStateMachine {
    /** @brief This template class uniquely identifyies an event.
@@ -43,10 +46,14 @@ namespace ILULibStateMachine {
     ** It allows comparing an event occurence against registered events.
     **
     ** This class does not define anything about the data that comes with the event.
-    ** It does have an szDataType string to allow logging a description of the data type
-    ** going with this event. This is merely logging and servers no other comparison
+    ** It does keep the type info of the data type going with this event to allow logging
+    ** a description of it. This is merely logging and servers no other comparison
     ** or identification purposes.
     **
+    ** An instance only holds the ID values (unset sub ID's are empty enums), next to
+    ** the vtable pointer and the data type info: the event ID string is formatted
+    ** when it is logged and the ID type string is built once per template instance.
+    **
     ** An event needs a unique template instance, thus having a unique set of template
     ** parameters.
     **/
@@ -58,7 +65,15 @@ namespace ILULibStateMachine {
                                     TEventEvtId(const std::type_info& typeinfo, const EvtId evtId, const EvtSubId1 evtSubId1, const EvtSubId2 evtSubId2, const EvtSubId3 evtSubId3); 
 
       public:
-         static std::string         IdTypeInit(void);
+         virtual std::string        GetId(void) const;
+         virtual const std::string& GetIdType(void) const;
+         virtual void               TraceKey(CTraceRecord& record) const;
+         virtual bool               DenseSlot(const void*& pTag, size_t& slot, size_t& slots) const;
+         virtual bool               IsPrefix(void) const;
+         virtual bool               ForEachPrefix(FPrefix fPrefix, void* pContext) const;
+         virtual bool               RangeKey(const void*& pTag, long& first, long& last) const;
+         virtual bool               RangeValue(const void*& pTag, long& value) const;
+         static const std::string&  IdTypeInit(void);
       
       private:
                                     TEventEvtId(const TEventEvtId& ref); 
@@ -66,8 +81,8 @@ namespace ILULibStateMachine {
          virtual bool               CompareTypeIdIdentical(const CEventBase& ref) const;
 
       private:
-         static std::string         Demangle(const std::type_info& typeinfo);
          static std::string         IdInit(const EvtId evtId, const EvtSubId1 evtSubId1 = EvtSubId1(), const EvtSubId2 evtSubId2 = EvtSubId2(), const EvtSubId3 evtSubId3 = EvtSubId3());
+         static std::string         IdTypeBuild(void);
 
       private:
          const EvtId                m_EvtId;
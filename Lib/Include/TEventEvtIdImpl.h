@@ -22,9 +22,12 @@
 #ifndef __ILULibStateMachine_TEventEvtIdImpl_H__
 #define __ILULibStateMachine_TEventEvtIdImpl_H__
 
-#include <cxxabi.h>
 #include <iomanip>
 
+#include "CTrace.h"
+#include "TEventEvtIdPrefix.h"
+#include "TEventEvtIdRange.h"
+
 namespace ILULibStateMachine {
    /** Constructor.
     **/
@@ -33,7 +36,7 @@ namespace ILULibStateMachine {
       const std::type_info& typeinfo,   //< Typeinfo describing the data type belonging to this event, logging only.
       const EvtId           evtId       //< Event ID.
       ) 
-      : CEventBase(IdInit(evtId), IdTypeInit(), Demangle(typeinfo))
+      : CEventBase(typeinfo)
       , m_EvtId(evtId)
       , m_EvtSubId1()
       , m_EvtSubId2()
@@ -49,7 +52,7 @@ namespace ILULibStateMachine {
       const EvtId           evtId,      //< Event ID.
       const EvtSubId1       evtSubId1   //< First event sub-ID.
       ) 
-      : CEventBase(IdInit(evtId, evtSubId1), IdTypeInit(), Demangle(typeinfo))
+      : CEventBase(typeinfo)
       , m_EvtId(evtId)
       , m_EvtSubId1(evtSubId1)
       , m_EvtSubId2()
@@ -66,7 +69,7 @@ namespace ILULibStateMachine {
       const EvtSubId1       evtSubId1,  //< First event sub-ID.
       const EvtSubId2       evtSubId2   //< Second event sub-ID.
       ) 
-      : CEventBase(IdInit(evtId, evtSubId1, evtSubId2), IdTypeInit(), Demangle(typeinfo))
+      : CEventBase(typeinfo)
       , m_EvtId(evtId)
       , m_EvtSubId1(evtSubId1)
       , m_EvtSubId2(evtSubId2)
@@ -84,7 +87,7 @@ namespace ILULibStateMachine {
       const EvtSubId2       evtSubId2,  //< Second event sub-ID.
       const EvtSubId3       evtSubId3   //< Third event sub-ID.   
       ) 
-      : CEventBase(IdInit(evtId, evtSubId1, evtSubId2, evtSubId3), IdTypeInit(), Demangle(typeinfo))
+      : CEventBase(typeinfo)
       , m_EvtId(evtId)
       , m_EvtSubId1(evtSubId1)
       , m_EvtSubId2(evtSubId2)
@@ -97,10 +100,10 @@ namespace ILULibStateMachine {
     **/
    template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
    bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::CompareTypeIdIdentical(
-      const CEventBase& ref //< Reference against which this will be compared. Pre-condition: type is identical to this (or an exception will be thrown).
+      const CEventBase& ref //< Reference against which this will be compared. Pre-condition: type is identical to this (checked by CEventBase::operator<).
       ) const
    {
-      const TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>& refEvtId = dynamic_cast<const TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>&>(ref);
+      const TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>& refEvtId = static_cast<const TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>&>(ref);
       if(this->m_EvtId != refEvtId.m_EvtId) {
          return this->m_EvtId < refEvtId.m_EvtId;
       }
@@ -113,20 +116,131 @@ namespace ILULibStateMachine {
       return this->m_EvtSubId3 < refEvtId.m_EvtSubId3;
    }
 
-   /** Demangle the typename when the compiler supports it.
+   /** Get the textual description of the event, formatted on demand.
+    **
+    ** @return the textual description of the event.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   std::string TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::GetId(void) const
+   {
+      return IdInit(m_EvtId, m_EvtSubId1, m_EvtSubId2, m_EvtSubId3);
+   }
+
+   /** Fill in the event identification of a trace record: the event type
+    ** (registered once per template instance) and the ID values.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   void TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::TraceKey(
+      CTraceRecord& record //< The record to fill in.
+      ) const
+   {
+      static const uint32_t eventType(CTrace::RegisterName(IdTypeInit()));
+      record.m_EventType      = eventType;
+      record.m_EventValues[0] = static_cast<uint32_t>(m_EvtId);
+      record.m_EventValues[1] = static_cast<uint32_t>(m_EvtSubId1);
+      record.m_EventValues[2] = static_cast<uint32_t>(m_EvtSubId2);
+      record.m_EventValues[3] = static_cast<uint32_t>(m_EvtSubId3);
+      record.m_EventCount     = 1;
+      if(typeid(EvtSubId1) != typeid(EEvtSubNotSet)) {
+         ++record.m_EventCount;
+         if(typeid(EvtSubId2) != typeid(EEvtSubNotSet)) {
+            ++record.m_EventCount;
+            if(typeid(EvtSubId3) != typeid(EEvtSubNotSet)) {
+               ++record.m_EventCount;
+            }
+         }
+      }
+   }
+
+   /** Get the slot of the event in a flat array of handlers: only for
+    ** an event ID type declared dense (see TEvtIdDense), without sub-ID's
+    ** and within the declared range.
+    **
+    ** @return true when the event has a slot.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::DenseSlot(
+      const void*& pTag, //< Out: identifies the array, the same for all events of the type.
+      size_t&      slot, //< Out: the index in the array.
+      size_t&      slots //< Out: the size of the array.
+      ) const
+   {
+      if(!TEvtIdDense<EvtId>::value || typeid(EvtSubId1) != typeid(EEvtSubNotSet)) {
+         return false;
+      }
+      const long value(static_cast<long>(m_EvtId));
+      if(value < TEvtIdDense<EvtId>::FIRST || TEvtIdDense<EvtId>::LAST < value) {
+         return false;
+      }
+      pTag  = &IdTypeInit();
+      slot  = static_cast<size_t>(value - TEvtIdDense<EvtId>::FIRST);
+      slots = static_cast<size_t>(TEvtIdDense<EvtId>::LAST - TEvtIdDense<EvtId>::FIRST + 1);
+      return true;
+   }
+
+   /** Indicates whether this is a wildcard registration: at least 1 of
+    ** the sub-ID's is a wildcard (see TEvtSubAny).
+    **
+    ** @return true for a wildcard registration.
     **/
    template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
-   std::string TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::Demangle(const std::type_info& typeinfo)
+   bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::IsPrefix(void) const
    {
-#ifdef ABI_DEMANGLE
-      int status = 0;
-      char* const szDemangled = abi::__cxa_demangle(typeinfo.name(), 0, 0, &status);
-      const std::string strDemangled(NULL != szDemangled ? szDemangled : typeinfo.name());
-      free(szDemangled);
-      return strDemangled;
-#else
-      return typeinfo.name();
-#endif      
+      return TIsEvtSubAny<EvtSubId1>::value || TIsEvtSubAny<EvtSubId2>::value || TIsEvtSubAny<EvtSubId3>::value;
+   }
+
+   /** Call a function for the wildcard registrations that can match this
+    ** event, most specific first: the event ID and all sub-ID's but the
+    ** last, then all but the last 2, ... (see TEventEvtIdPrefix).
+    **
+    ** @return true when fPrefix stopped.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::ForEachPrefix(
+      FPrefix fPrefix, //< The function to call, it returns true to stop.
+      void*   pContext //< Passed to fPrefix.
+      ) const
+   {
+      return TEventEvtIdPrefix<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::ForEach(m_EvtId, m_EvtSubId1, m_EvtSubId2, fPrefix, pContext);
+   }
+
+   /** Get the range of a range registration: only for a TEvtIdRange
+    ** event ID without sub-ID's (see TEventEvtIdRange).
+    **
+    ** @return true for a range registration.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::RangeKey(
+      const void*& pTag,  //< Out: identifies the ranges of the event ID type.
+      long&        first, //< Out: the first event ID of the range.
+      long&        last   //< Out: the last event ID of the range.
+      ) const
+   {
+      return TEventEvtIdRange<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::Key(m_EvtId, pTag, first, last);
+   }
+
+   /** Get the value to look up in the range registrations: only for an
+    ** event without sub-ID's (see TEventEvtIdRange).
+    **
+    ** @return true when the event can be in a range.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   bool TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::RangeValue(
+      const void*& pTag,  //< Out: identifies the ranges of the event ID type.
+      long&        value  //< Out: the event ID.
+      ) const
+   {
+      return TEventEvtIdRange<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::Value(m_EvtId, pTag, value);
+   }
+
+   /** Get the textual description of the event ID.
+    **
+    ** @return the textual description of the event ID.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   const std::string& TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::GetIdType(void) const
+   {
+      return IdTypeInit();
    }
 
    /** Generate an identifier string that describes this event.
@@ -154,10 +268,23 @@ namespace ILULibStateMachine {
       return ss.str();
    }
 
+   /** Get the identifier string that describes this event ID.
+    **
+    ** It is the same for all instances: built once and shared by them.
+    **
+    ** @return the identifier string.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
+   const std::string& TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::IdTypeInit(void)
+   {
+      static const std::string strIdType(IdTypeBuild());
+      return strIdType;
+   }
+
    /** Generate an identifier string that describes this event ID.
     **/
    template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3>
-   std::string TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::IdTypeInit(void)
+   std::string TEventEvtId<EvtId, EvtSubId1, EvtSubId2, EvtSubId3>::IdTypeBuild(void)
    {
       std::stringstream ss;
       ss << Demangle(typeid(EvtId));
@@ -175,4 +302,3 @@ namespace ILULibStateMachine {
 };
 
 #endif //__ILULibStateMachine_TEventEvtIdImpl_H__
-
@@ -0,0 +1,185 @@
+/** @file
+ ** @brief The TEventEvtIdPrefix declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TEventEvtIdPrefix_H__
+#define __ILULibStateMachine_TEventEvtIdPrefix_H__
+
+#include <typeinfo>
+
+#include "CEventBase.h"
+#include "EEvtSubNotSet.h"
+#include "TEvtSubAny.h"
+
+namespace ILULibStateMachine {
+   //forward declaration
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3> class TEventEvtId;
+
+   /** @brief The wildcard registrations (see TEvtSubAny) that can match an
+    ** event with 3 sub-ID's, most specific first.
+    **
+    ** Each prefix is a TEventEvtId instance on the stack with the trailing
+    ** sub-ID's replaced by wildcards: it compares equal to the wildcard
+    ** registration for that prefix. The data type is not part of the
+    ** comparison.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3> class TEventEvtIdPrefix {
+      public:
+         /** Call a function for each prefix.
+          **
+          ** @return true when fPrefix stopped.
+          **/
+         static bool ForEach(
+            const EvtId         evtId,     //< Event ID.
+            const EvtSubId1     evtSubId1, //< First event sub-ID.
+            const EvtSubId2     evtSubId2, //< Second event sub-ID.
+            CEventBase::FPrefix fPrefix,   //< The function to call, it returns true to stop.
+            void*               pContext   //< Passed to fPrefix.
+            )
+         {
+            {
+               TEventEvtId<EvtId, EvtSubId1, EvtSubId2, TEvtSubAny<EvtSubId3> > prefix(typeid(void), evtId, evtSubId1, evtSubId2);
+               if(fPrefix(pContext, prefix)) {
+                  return true;
+               }
+            }
+            {
+               TEventEvtId<EvtId, EvtSubId1, TEvtSubAny<EvtSubId2>, TEvtSubAny<EvtSubId3> > prefix(typeid(void), evtId, evtSubId1);
+               if(fPrefix(pContext, prefix)) {
+                  return true;
+               }
+            }
+            TEventEvtId<EvtId, TEvtSubAny<EvtSubId1>, TEvtSubAny<EvtSubId2>, TEvtSubAny<EvtSubId3> > prefix(typeid(void), evtId);
+            return fPrefix(pContext, prefix);
+         }
+   };
+
+   /** @brief The wildcard registrations that can match an event with 2
+    ** sub-ID's, most specific first.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2> class TEventEvtIdPrefix<EvtId, EvtSubId1, EvtSubId2, EEvtSubNotSet> {
+      public:
+         /** Call a function for each prefix.
+          **
+          ** @return true when fPrefix stopped.
+          **/
+         static bool ForEach(
+            const EvtId         evtId,     //< Event ID.
+            const EvtSubId1     evtSubId1, //< First event sub-ID.
+            const EvtSubId2     /* evtSubId2 */,
+            CEventBase::FPrefix fPrefix,   //< The function to call, it returns true to stop.
+            void*               pContext   //< Passed to fPrefix.
+            )
+         {
+            {
+               TEventEvtId<EvtId, EvtSubId1, TEvtSubAny<EvtSubId2> > prefix(typeid(void), evtId, evtSubId1);
+               if(fPrefix(pContext, prefix)) {
+                  return true;
+               }
+            }
+            TEventEvtId<EvtId, TEvtSubAny<EvtSubId1>, TEvtSubAny<EvtSubId2> > prefix(typeid(void), evtId);
+            return fPrefix(pContext, prefix);
+         }
+   };
+
+   /** @brief The wildcard registration that can match an event with 1
+    ** sub-ID.
+    **/
+   template <class EvtId, class EvtSubId1> class TEventEvtIdPrefix<EvtId, EvtSubId1, EEvtSubNotSet, EEvtSubNotSet> {
+      public:
+         /** Call a function for the prefix.
+          **
+          ** @return true when fPrefix stopped.
+          **/
+         static bool ForEach(
+            const EvtId         evtId,     //< Event ID.
+            const EvtSubId1     /* evtSubId1 */,
+            const EEvtSubNotSet /* evtSubId2 */,
+            CEventBase::FPrefix fPrefix,   //< The function to call, it returns true to stop.
+            void*               pContext   //< Passed to fPrefix.
+            )
+         {
+            TEventEvtId<EvtId, TEvtSubAny<EvtSubId1> > prefix(typeid(void), evtId);
+            return fPrefix(pContext, prefix);
+         }
+   };
+
+   /** @brief No wildcard registration can match an event without
+    ** sub-ID's.
+    **/
+   template <class EvtId> class TEventEvtIdPrefix<EvtId, EEvtSubNotSet, EEvtSubNotSet, EEvtSubNotSet> {
+      public:
+         /** No prefixes.
+          **
+          ** @return false.
+          **/
+         static bool ForEach(const EvtId, const EEvtSubNotSet, const EEvtSubNotSet, CEventBase::FPrefix, void*)
+         {
+            return false;
+         }
+   };
+
+   /** @brief A wildcard registration has no prefixes itself: it is never
+    ** fed as an event (3 sub-ID's, the last 1 a wildcard).
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3> class TEventEvtIdPrefix<EvtId, EvtSubId1, EvtSubId2, TEvtSubAny<EvtSubId3> > {
+      public:
+         /** No prefixes.
+          **
+          ** @return false.
+          **/
+         static bool ForEach(const EvtId, const EvtSubId1, const EvtSubId2, CEventBase::FPrefix, void*)
+         {
+            return false;
+         }
+   };
+
+   /** @brief A wildcard registration has no prefixes itself: it is never
+    ** fed as an event (2 sub-ID's, the last 1 a wildcard).
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2> class TEventEvtIdPrefix<EvtId, EvtSubId1, TEvtSubAny<EvtSubId2>, EEvtSubNotSet> {
+      public:
+         /** No prefixes.
+          **
+          ** @return false.
+          **/
+         static bool ForEach(const EvtId, const EvtSubId1, const TEvtSubAny<EvtSubId2>, CEventBase::FPrefix, void*)
+         {
+            return false;
+         }
+   };
+
+   /** @brief A wildcard registration has no prefixes itself: it is never
+    ** fed as an event (1 sub-ID, a wildcard).
+    **/
+   template <class EvtId, class EvtSubId1> class TEventEvtIdPrefix<EvtId, TEvtSubAny<EvtSubId1>, EEvtSubNotSet, EEvtSubNotSet> {
+      public:
+         /** No prefixes.
+          **
+          ** @return false.
+          **/
+         static bool ForEach(const EvtId, const TEvtSubAny<EvtSubId1>, const EEvtSubNotSet, CEventBase::FPrefix, void*)
+         {
+            return false;
+         }
+   };
+};
+
+#endif //__ILULibStateMachine_TEventEvtIdPrefix_H__
@@ -0,0 +1,118 @@
+/** @file
+ ** @brief The TEventEvtIdRange declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TEventEvtIdRange_H__
+#define __ILULibStateMachine_TEventEvtIdRange_H__
+
+#include "EEvtSubNotSet.h"
+#include "TEvtIdRange.h"
+
+namespace ILULibStateMachine {
+   //forward declaration
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3> class TEventEvtId;
+
+   /** @brief Relates an event to the range registrations (see
+    ** TEvtIdRange): events with sub-ID's have no part in them.
+    **/
+   template <class EvtId, class EvtSubId1, class EvtSubId2, class EvtSubId3> class TEventEvtIdRange {
+      public:
+         /** Not a range registration.
+          **
+          ** @return false.
+          **/
+         static bool Key(const EvtId&, const void*&, long&, long&)
+         {
+            return false;
+         }
+
+         /** Not in a range.
+          **
+          ** @return false.
+          **/
+         static bool Value(const EvtId&, const void*&, long&)
+         {
+            return false;
+         }
+   };
+
+   /** @brief Relates an event without sub-ID's to the range registrations
+    ** for its event ID type: its event ID is looked up in them.
+    **/
+   template <class EvtId> class TEventEvtIdRange<EvtId, EEvtSubNotSet, EEvtSubNotSet, EEvtSubNotSet> {
+      public:
+         /** Not a range registration.
+          **
+          ** @return false.
+          **/
+         static bool Key(const EvtId&, const void*&, long&, long&)
+         {
+            return false;
+         }
+
+         /** The value to look up in the ranges.
+          **
+          ** @return true.
+          **/
+         static bool Value(
+            const EvtId& evtId, //< Event ID.
+            const void*& pTag,  //< Out: identifies the ranges of the event ID type.
+            long&        value  //< Out: the event ID.
+            )
+         {
+            pTag  = &TEventEvtId<TEvtIdRange<EvtId>, EEvtSubNotSet, EEvtSubNotSet, EEvtSubNotSet>::IdTypeInit();
+            value = static_cast<long>(evtId);
+            return true;
+         }
+   };
+
+   /** @brief A range registration.
+    **/
+   template <class EvtId> class TEventEvtIdRange<TEvtIdRange<EvtId>, EEvtSubNotSet, EEvtSubNotSet, EEvtSubNotSet> {
+      public:
+         /** The range to index.
+          **
+          ** @return true.
+          **/
+         static bool Key(
+            const TEvtIdRange<EvtId>& range, //< The range.
+            const void*&              pTag,  //< Out: identifies the ranges of the event ID type.
+            long&                     first, //< Out: the first event ID of the range.
+            long&                     last   //< Out: the last event ID of the range.
+            )
+         {
+            pTag  = &TEventEvtId<TEvtIdRange<EvtId>, EEvtSubNotSet, EEvtSubNotSet, EEvtSubNotSet>::IdTypeInit();
+            first = static_cast<long>(range.m_First);
+            last  = static_cast<long>(range.m_Last);
+            return true;
+         }
+
+         /** A range registration is never fed as an event.
+          **
+          ** @return false.
+          **/
+         static bool Value(const TEvtIdRange<EvtId>&, const void*&, long&)
+         {
+            return false;
+         }
+   };
+};
+
+#endif //__ILULibStateMachine_TEventEvtIdRange_H__
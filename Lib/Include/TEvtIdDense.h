@@ -0,0 +1,65 @@
+/** @file
+ ** @brief The TEvtIdDense declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TEvtIdDense_H__
+#define __ILULibStateMachine_TEvtIdDense_H__
+
+namespace ILULibStateMachine {
+   /** @brief Declares an event ID type as a dense enum: its values lie in
+    ** a small known range.
+    **
+    ** Handlers for an event ID (without sub-ID's) of a dense type are
+    ** found in a flat array per handler table, indexed by the event ID
+    ** (see CHandlerTable::EventFind): a bounds check and an indexed load
+    ** instead of a map lookup. Event ID's outside the range and events
+    ** with sub-ID's use the map.
+    **
+    ** This is the primary template: an event ID type is not dense unless
+    ** declared with EVTID_DENSE.
+    **/
+   template<class EvtId> class TEvtIdDense {
+      public:
+         static const bool value = false; //< true when EvtId is declared dense.
+         static const long FIRST = 0;     //< The lowest value of the range.
+         static const long LAST  = -1;    //< The highest value of the range.
+   };
+};
+
+/** Declare an event ID type as a dense enum (see TEvtIdDense), at global
+ ** scope. First parameter: event ID type; second parameter: lowest value;
+ ** third parameter: highest value.
+ **
+ ** E.g. EVTID_DENSE(LibEvents::EEvents, 1, 9)
+ **
+ ** Declare it right after the enum: before the first handler for the
+ ** type is registered or an event of the type is fed.
+ **/
+#define EVTID_DENSE(et,first,last)                             \
+   namespace ILULibStateMachine {                              \
+      template<> class TEvtIdDense<et> {                       \
+         public:                                               \
+            static const bool value = true;                    \
+            static const long FIRST = (first);                 \
+            static const long LAST  = (last);                  \
+      };                                                       \
+   }
+
+#endif //__ILULibStateMachine_TEvtIdDense_H__
@@ -0,0 +1,135 @@
+/** @file
+ ** @brief The TEvtIdRange declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TEvtIdRange_H__
+#define __ILULibStateMachine_TEvtIdRange_H__
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ILULibStateMachine {
+   /** @brief A range of event ID's of type EvtId: from first up to and
+    ** including last.
+    **
+    ** Used instead of the event ID when registering a handler (see
+    ** EVTID_RANGE), e.g. for all error codes from 1000 up to 1999:
+    **    EventRegister(HANDLER(int, CState1, Handler), CCreateState(), EVTID_RANGE(EErrors1000, EErrors1999));
+    **
+    ** An event without a handler for its event ID (or for a prefix of
+    ** its sub-ID's, see TEvtSubAny) is handled by the range containing
+    ** its event ID, before the event-type handler. Only event ID's
+    ** without sub-ID's can be registered as a range, the ranges of 1
+    ** event ID type registered by 1 state must not overlap.
+    **
+    ** The range registration is a TEventEvtId instance like any other,
+    ** the handler table indexes it in a sorted array as well (see
+    ** CHandlerTable).
+    **/
+   template<class EvtId> class TEvtIdRange {
+      public:
+         /** Constructor.
+          **/
+         TEvtIdRange(
+            const EvtId first, //< The first event ID of the range.
+            const EvtId last   //< The last event ID of the range.
+            )
+            : m_First(first)
+            , m_Last (last )
+         {
+         }
+
+      public:
+         /** Compare 2 ranges: on the first event ID, then on the last.
+          **
+          ** @return true when this sorts before ref.
+          **/
+         bool operator<(const TEvtIdRange& ref) const
+         {
+            if(m_First != ref.m_First) {
+               return m_First < ref.m_First;
+            }
+            return m_Last < ref.m_Last;
+         }
+
+         /** Compare 2 ranges.
+          **
+          ** @return true when different.
+          **/
+         bool operator!=(const TEvtIdRange& ref) const
+         {
+            return m_First != ref.m_First || m_Last != ref.m_Last;
+         }
+
+         /** The value of a range in a trace record.
+          **
+          ** @return the first event ID.
+          **/
+         explicit operator uint32_t(void) const
+         {
+            return static_cast<uint32_t>(m_First);
+         }
+
+         /** The value of a range as an event ID (see TEventEvtId::DenseSlot,
+          ** a range is never dense).
+          **
+          ** @return the first event ID.
+          **/
+         explicit operator long(void) const
+         {
+            return static_cast<long>(m_First);
+         }
+
+      public:
+         EvtId m_First; //< The first event ID of the range.
+         EvtId m_Last;  //< The last event ID of the range.
+   };
+
+   /** Log a range.
+    **
+    ** @return the stream.
+    **/
+   template<class EvtId> std::ostream& operator<<(
+      std::ostream&             os,   //< The stream.
+      const TEvtIdRange<EvtId>& range //< The range.
+      )
+   {
+      const std::streamsize width(os.width());
+      os << static_cast<long>(range.m_First) << "..0x";
+      os.width(width);
+      return os << static_cast<long>(range.m_Last);
+   }
+
+   /** Create a range, deducing the event ID type.
+    **
+    ** @return the range.
+    **/
+   template<class EvtId> TEvtIdRange<EvtId> MakeEvtIdRange(
+      const EvtId first, //< The first event ID of the range.
+      const EvtId last   //< The last event ID of the range.
+      )
+   {
+      return TEvtIdRange<EvtId>(first, last);
+   }
+};
+
+#define EVTID_RANGE(first, last) ILULibStateMachine::MakeEvtIdRange(first, last) ///< Macro eases registering a range of event ID's. First parameter: first event ID, second parameter: last event ID.
+
+#endif //__ILULibStateMachine_TEvtIdRange_H__
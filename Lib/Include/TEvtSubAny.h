@@ -0,0 +1,110 @@
+/** @file
+ ** @brief The TEvtSubAny declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TEvtSubAny_H__
+#define __ILULibStateMachine_TEvtSubAny_H__
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ILULibStateMachine {
+   /** @brief Wildcard for an event sub-ID of type EvtSubId: matches any
+    ** value.
+    **
+    ** Used instead of the trailing sub-ID's when registering a handler
+    ** (see EVTSUB_ANY), e.g. event ID X with any first sub-ID:
+    **    EventRegister(HANDLER(int, CState1, Handler), CCreateState(), EEventsX, EVTSUB_ANY(ESub1));
+    ** or event ID X, first sub-ID Y with any second sub-ID:
+    **    EventRegister(HANDLER(int, CState1, Handler), CCreateState(), EEventsX, ESub1Y, EVTSUB_ANY(ESub2));
+    **
+    ** An event without an exact match is matched against the wildcard
+    ** registrations, most specific first: the longest matching prefix of
+    ** sub-ID's wins. Only trailing sub-ID's can be wildcards: every
+    ** wildcard is followed by wildcards only.
+    **
+    ** All values compare equal: the wildcard registration for a prefix
+    ** is a TEventEvtId instance like any other, a single map lookup per
+    ** prefix length finds it (see TEventEvtId::ForEachPrefix).
+    **/
+   template<class EvtSubId> class TEvtSubAny {
+      public:
+         /** Compare 2 wildcards.
+          **
+          ** @return false: all wildcards are equal.
+          **/
+         bool operator<(const TEvtSubAny&) const
+         {
+            return false;
+         }
+
+         /** Compare 2 wildcards.
+          **
+          ** @return false: all wildcards are equal.
+          **/
+         bool operator!=(const TEvtSubAny&) const
+         {
+            return false;
+         }
+
+         /** The value of a wildcard in a trace record.
+          **
+          ** @return 0.
+          **/
+         explicit operator uint32_t(void) const
+         {
+            return 0;
+         }
+   };
+
+   /** @brief Detects whether an event sub-ID type is a wildcard.
+    **
+    ** This is the primary template: not a wildcard.
+    **/
+   template<class EvtSubId> class TIsEvtSubAny {
+      public:
+         static const bool value = false; //< true for a wildcard.
+   };
+
+   /** @brief Detects whether an event sub-ID type is a wildcard: this one
+    ** is.
+    **/
+   template<class EvtSubId> class TIsEvtSubAny<TEvtSubAny<EvtSubId> > {
+      public:
+         static const bool value = true; //< true for a wildcard.
+   };
+
+   /** Log a wildcard.
+    **
+    ** @return the stream.
+    **/
+   template<class EvtSubId> std::ostream& operator<<(
+      std::ostream&                 os, //< The stream.
+      const TEvtSubAny<EvtSubId>&       //< The wildcard.
+      )
+   {
+      os.width(0);
+      return os << "*";
+   }
+};
+
+#define EVTSUB_ANY(et) ILULibStateMachine::TEvtSubAny<et>() ///< Macro eases registering a wildcard event sub-ID. First parameter: event sub-ID type.
+
+#endif //__ILULibStateMachine_TEvtSubAny_H__
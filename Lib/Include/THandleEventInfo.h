@@ -28,6 +28,9 @@
 
 #include "CCreateState.h"
 #include "CHandleEventInfoBase.h"
+#include "CState.h"
+#include "CStateMachineStats.h"
+#include "TAllocator.h"
 
 namespace ILULibStateMachine {
    /** @brief Template class that allows storing and calling of event handlers for one specific event data
@@ -40,25 +43,31 @@ namespace ILULibStateMachine {
       public:
          typedef bool                                              FGuard(const TEventData* const pEventData);                     ///< Prototype of an event guard: depending on its return value the corresponding event handler is called.
          typedef void                                              FHandler(const TEventData* const pEventData);                   ///< Prototype of an event handler: it is provided with the event data.
+         typedef bool                                              FSharedGuard(CState* pState, const TEventData* const pEventData);   ///< Prototype of a shared event guard: not bound to a state instance, the state is provided when it is called (see TSharedGuard).
+         typedef void                                              FSharedHandler(CState* pState, const TEventData* const pEventData); ///< Prototype of a shared event handler: not bound to a state instance, the state is provided when it is called (see TSharedHandler).
          typedef TYPESEL::function<FGuard>                         BFGuard;                                                        ///< FGuard wrapped in a function, so the event guard can be a class method bound to a class instance.
          typedef TYPESEL::function<FHandler>                       BFHandler;                                                      ///< FHandler wrapped in a function, so the event handler can be a class method bound to a class instance.
-         typedef TYPESEL::tuple<BFGuard, BFHandler, CCreateState>  GuardHandlerCreateState;                                        ///< Type that fully defines one event action: guard (optional), handler, state transition. This maps 1-on-1 to 1 arrow in a state machine schema.
-         typedef std::vector<GuardHandlerCreateState>              GuardHandlerCreateStates;                                       ///< Container of event action descriptors.
+         typedef TYPESEL::tuple<BFGuard, BFHandler, CCreateState, FSharedGuard*, FSharedHandler*> GuardHandlerCreateState;         ///< Type that fully defines one event action: guard (optional), handler, state transition. This maps 1-on-1 to 1 arrow in a state machine schema. Either the bound guard/handler or the shared guard/handler is set.
+         typedef std::vector<GuardHandlerCreateState, TAllocator<GuardHandlerCreateState> > GuardHandlerCreateStates;             ///< Container of event action descriptors, allocated from the state machine's arena.
          typedef typename GuardHandlerCreateStates::iterator       GuardHandlerCreateStatesIt;                                     ///< Iterator on the container of event action descriptors.
          typedef typename GuardHandlerCreateStates::const_iterator GuardHandlerCreateStatesCIt;                                    ///< Constant iterator on the container of event action descriptors.
         
       public:
                                   THandleEventInfo   (void);
-                                  THandleEventInfo   (               BFHandler     handler, CCreateState createState);
-                                  THandleEventInfo   (BFGuard guard, BFHandler     handler, CCreateState createState);
+                                  THandleEventInfo   (                             const BFHandler& handler, CCreateState createState, CMemoryResource* const pResource = NULL);
+                                  THandleEventInfo   (const BFGuard& guard,        const BFHandler& handler, CCreateState createState, CMemoryResource* const pResource = NULL);
+                                  THandleEventInfo   (                             FSharedHandler*  handler, CCreateState createState, CMemoryResource* const pResource = NULL);
+                                  THandleEventInfo   (FSharedGuard*  guard,        FSharedHandler*  handler, CCreateState createState, CMemoryResource* const pResource = NULL);
 
       public:
-         void                     SetUnguardedHandler(               BFHandler handler, CCreateState createState);
-         void                     AddGuardedHandler  (BFGuard guard, BFHandler handler, CCreateState createState);
-         HandleResult             Handle             (const bool bDefaultState, const TEventData* const pEventData);
+         void                     SetUnguardedHandler(                             const BFHandler& handler, CCreateState createState);
+         void                     SetUnguardedHandler(                             FSharedHandler*  handler, CCreateState createState);
+         void                     AddGuardedHandler  (const BFGuard& guard,        const BFHandler& handler, CCreateState createState);
+         void                     AddGuardedHandler  (FSharedGuard*  guard,        FSharedHandler*  handler, CCreateState createState);
+         HandleResult             Handle             (const bool bDefaultState, CState* const pState, const TEventData* const pEventData, CStateMachineCounters& counters);
          
       private:
-         HandleResult             CallHandler        (const std::string& strMsg, TYPESEL::function<void(const TEventData* const pEventData)> handler, CCreateState createState, const TEventData* const pEventData, const char* const szType);
+         HandleResult             CallHandler        (const std::string& strMsg, const GuardHandlerCreateState& guardHandlerCreateState, CState* const pState, const TEventData* const pEventData, const char* const szType, CStateMachineCounters& counters);
 
       private:
 
@@ -22,6 +22,7 @@
 #ifndef __ILULibStateMachine_THandleEventInfoImpl_H__
 #define __ILULibStateMachine_THandleEventInfoImpl_H__
 
+#include "CLogLevel.h"
 #include "Logging.h"
 #include "CStateChangeException.h"
 
@@ -41,13 +42,14 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    THandleEventInfo<TEventData>::THandleEventInfo(
-      BFHandler    handler,    //< The handler to be called.
-      CCreateState createState //< Describes the state state transition once the handler has been called.
+      const BFHandler&       handler,     //< The handler to be called.
+      CCreateState           createState, //< Describes the state state transition once the handler has been called.
+      CMemoryResource* const pResource    //< Resource the guarded handlers are allocated from, NULL for the heap.
       )
       : CHandleEventInfoBase()
       , m_bUnguardedHandlerSet(true)
-      , m_UnguardedHandler(GuardHandlerCreateState(0, handler, createState))
-      , m_GuardHandlers()
+      , m_UnguardedHandler(GuardHandlerCreateState(0, handler, createState, NULL, NULL))
+      , m_GuardHandlers(TAllocator<GuardHandlerCreateState>(pResource))
    {
    }; 
    
@@ -55,16 +57,49 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    THandleEventInfo<TEventData>::THandleEventInfo(
-      BFGuard      guard,      //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
-      BFHandler    handler,    //< The handler to be called.
-      CCreateState createState //< Describes the state state transition once the handler has been called.
+      const BFGuard&         guard,       //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
+      const BFHandler&       handler,     //< The handler to be called.
+      CCreateState           createState, //< Describes the state state transition once the handler has been called.
+      CMemoryResource* const pResource    //< Resource the guarded handlers are allocated from, NULL for the heap.
       )
       : CHandleEventInfoBase()
       , m_bUnguardedHandlerSet(false)
       , m_UnguardedHandler()
-      , m_GuardHandlers()
+      , m_GuardHandlers(TAllocator<GuardHandlerCreateState>(pResource))
+   {
+      m_GuardHandlers.push_back(GuardHandlerCreateState(guard, handler, createState, NULL, NULL));
+   }; 
+
+   /** Constructor setting a shared unguarded handler.
+    **/
+   template <class TEventData> 
+   THandleEventInfo<TEventData>::THandleEventInfo(
+      FSharedHandler*        handler,     //< The handler to be called.
+      CCreateState           createState, //< Describes the state state transition once the handler has been called.
+      CMemoryResource* const pResource    //< Resource the guarded handlers are allocated from, NULL for the heap.
+      )
+      : CHandleEventInfoBase()
+      , m_bUnguardedHandlerSet(true)
+      , m_UnguardedHandler(GuardHandlerCreateState(0, 0, createState, NULL, handler))
+      , m_GuardHandlers(TAllocator<GuardHandlerCreateState>(pResource))
+   {
+   }; 
+   
+   /** Constructor configuring 1 shared guarded handler and no unguarded handler.
+    **/
+   template <class TEventData> 
+   THandleEventInfo<TEventData>::THandleEventInfo(
+      FSharedGuard*          guard,       //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
+      FSharedHandler*        handler,     //< The handler to be called.
+      CCreateState           createState, //< Describes the state state transition once the handler has been called.
+      CMemoryResource* const pResource    //< Resource the guarded handlers are allocated from, NULL for the heap.
+      )
+      : CHandleEventInfoBase()
+      , m_bUnguardedHandlerSet(false)
+      , m_UnguardedHandler()
+      , m_GuardHandlers(TAllocator<GuardHandlerCreateState>(pResource))
    {
-      m_GuardHandlers.push_back(GuardHandlerCreateState(guard, handler, createState));
+      m_GuardHandlers.push_back(GuardHandlerCreateState(0, 0, createState, guard, handler));
    }; 
 
    /** Set the unguarded handler.
@@ -73,27 +108,56 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    void THandleEventInfo<TEventData>::SetUnguardedHandler(
-      BFHandler    handler,    //< The handler to be called.
-      CCreateState createState //< Describes the state state transition once the handler has been called.
+      const BFHandler& handler,    //< The handler to be called.
+      CCreateState     createState //< Describes the state state transition once the handler has been called.
       )
    {
       if(m_bUnguardedHandlerSet) {
          throw std::runtime_error("Unguarded handler already set");
       }
       m_bUnguardedHandlerSet = true;
-      m_UnguardedHandler     = GuardHandlerCreateState(0, handler, createState);
+      m_UnguardedHandler     = GuardHandlerCreateState(0, handler, createState, NULL, NULL);
+   };
+   
+   /** Set a shared unguarded handler.
+    **
+    ** Will throw an exception when the unguarded handler has already been set before (e.g. constructor).
+    **/
+   template <class TEventData> 
+   void THandleEventInfo<TEventData>::SetUnguardedHandler(
+      FSharedHandler* handler,    //< The handler to be called.
+      CCreateState    createState //< Describes the state state transition once the handler has been called.
+      )
+   {
+      if(m_bUnguardedHandlerSet) {
+         throw std::runtime_error("Unguarded handler already set");
+      }
+      m_bUnguardedHandlerSet = true;
+      m_UnguardedHandler     = GuardHandlerCreateState(0, 0, createState, NULL, handler);
    };
    
    /** Add a guarded handler.
     **/
    template <class TEventData> 
    void THandleEventInfo<TEventData>::AddGuardedHandler(
-      BFGuard      guard,      //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
-      BFHandler    handler,    //< The handler to be called.
-      CCreateState createState //< Describes the state state transition once the handler has been called.
+      const BFGuard&   guard,      //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
+      const BFHandler& handler,    //< The handler to be called.
+      CCreateState     createState //< Describes the state state transition once the handler has been called.
       )
    {
-      m_GuardHandlers.push_back(GuardHandlerCreateState(guard, handler, createState));
+      m_GuardHandlers.push_back(GuardHandlerCreateState(guard, handler, createState, NULL, NULL));
+   };
+   
+   /** Add a shared guarded handler.
+    **/
+   template <class TEventData> 
+   void THandleEventInfo<TEventData>::AddGuardedHandler(
+      FSharedGuard*   guard,      //< The guard to be called before the handler itself is called. When the guard returns false, the handler will not be called (no event match). 
+      FSharedHandler* handler,    //< The handler to be called.
+      CCreateState    createState //< Describes the state state transition once the handler has been called.
+      )
+   {
+      m_GuardHandlers.push_back(GuardHandlerCreateState(0, 0, createState, guard, handler));
    };
    
    /** Try to find an event handler.
@@ -106,63 +170,91 @@ namespace ILULibStateMachine {
    template <class TEventData> 
    CHandleEventInfoBase::HandleResult THandleEventInfo<TEventData>::Handle(
       const bool              bDefaultState, //< Indicator whether this function is called for the default state or the current state, logging only.
-      const TEventData* const pEventData     //< Data accompanying the event, will be provided to the handler.
+      CState* const           pState,        //< The state the handlers belong to, provided to shared guards and handlers.
+      const TEventData* const pEventData,    //< Data accompanying the event, will be provided to the handler.
+      CStateMachineCounters&  counters       //< Runtime statistics of the state machine.
       )
    {
       const char* const szType = bDefaultState ? "default-state" : "state";;
+      const bool        bDebug (CLogLevelScope::IsEnabled(ELogLevelDebug ));
+      const bool        bNotice(CLogLevelScope::IsEnabled(ELogLevelNotice));
       
-      CLogIndent logIndent;
+      CLogIndent logIndent(CLogLevelScope::IsIndented());
       
       //first try find a guarded handler
-      LogDebug("Trying [%lu] %s guard's\n", (long unsigned int)m_GuardHandlers.size(), szType);
+      if(bDebug) {
+         LogDebug("Trying [%lu] %s guard's\n", (long unsigned int)m_GuardHandlers.size(), szType);
+      }
       {
          unsigned int uiGuardNbr = 1; //1-based: logging only
          for(GuardHandlerCreateStatesCIt cit = m_GuardHandlers.begin() ; m_GuardHandlers.end() != cit ; ++cit, ++uiGuardNbr) {
-            LogDebug("Trying %s guard [%u/%lu]\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size());
+            if(bDebug) {
+               LogDebug("Trying %s guard [%u/%lu]\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size());
+            }
             bool bGuardPassed = false;
+            RUNTIME_STATS_ADD(counters, ECounterGuardsEvaluated, 1);
             try {
-               CLogIndent logIndentGuard; //indent logging while calling the guard
-               bGuardPassed = TYPESEL::get<0>(*cit)(pEventData);
+               CLogIndent logIndentGuard(CLogLevelScope::IsIndented()); //indent logging while calling the guard
+               FSharedGuard* const pSharedGuard = TYPESEL::get<3>(*cit);
+               bGuardPassed = (NULL != pSharedGuard) ? pSharedGuard(pState, pEventData) : TYPESEL::get<0>(*cit)(pEventData);
             } catch(std::exception& ex) {
-               LogErr("Exception while calling %s guard [%u/%lu]: %s\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size(), ex.what());
+               RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+               if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+                  LogErr("Exception while calling %s guard [%u/%lu]: %s\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size(), ex.what());
+               }
             } catch(...) {
-               LogErr("Exception while calling %s guard [%u/%lu]: %s\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size(), "unknown");
+               RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+               if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+                  LogErr("Exception while calling %s guard [%u/%lu]: %s\n", szType, uiGuardNbr, (long unsigned int)m_GuardHandlers.size(), "unknown");
+               }
             }
             if(bGuardPassed) {
+               RUNTIME_STATS_ADD(counters, ECounterGuardsPassed, 1);
+               counters.SetGuard(uiGuardNbr);
                //guard returns true
                //--> call the handler
+               //(the message is only formatted when it is logged)
                std::stringstream ss;
-               ss << "Passed " << szType << " guard [" << uiGuardNbr << "/" << (long unsigned int)m_GuardHandlers.size() << "] --> calling accompanying " << szType << " handler\n";
+               if(bNotice) {
+                  ss << "Passed " << szType << " guard [" << uiGuardNbr << "/" << (long unsigned int)m_GuardHandlers.size() << "] --> calling accompanying " << szType << " handler\n";
+               }
                return CallHandler(
                                   ss.str(),
-                                  TYPESEL::get<1>(*cit), 
-                                  TYPESEL::get<2>(*cit), 
+                                  *cit,
+                                  pState,
                                   pEventData, 
-                                  szType
+                                  szType,
+                                  counters
                                   );
             }
          }
       }
-      if(0 != m_GuardHandlers.size()) {
+      if(bDebug && (0 != m_GuardHandlers.size())) {
          LogDebug("No matching %s guard\n", szType);
       }
       
       //no guarded handler found
       //--> check default handler
       if(!m_bUnguardedHandlerSet) {
-         LogDebug("No %s unguarded handler\n", szType);
+         if(bDebug) {
+            LogDebug("No %s unguarded handler\n", szType);
+         }
          return HandleResult(false, CCreateState());
       }
       
       //call the default handler
+      counters.SetGuard(0);
       std::stringstream ss;
-      ss << "Calling " << szType << " unguarded handler\n";
+      if(bNotice) {
+         ss << "Calling " << szType << " unguarded handler\n";
+      }
       return CallHandler(
                          ss.str(),
-                         TYPESEL::get<1>(m_UnguardedHandler), 
-                         TYPESEL::get<2>(m_UnguardedHandler), 
+                         m_UnguardedHandler,
+                         pState,
                          pEventData, 
-                         szType
+                         szType,
+                         counters
                          );
    };
 
@@ -172,28 +264,50 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    CHandleEventInfoBase::HandleResult THandleEventInfo<TEventData>::CallHandler(
-      const std::string&                                          strMsg,      //< Logging accompanying the handler call.
-      TYPESEL::function<void(const TEventData* const pEventData)> handler,     //< The handler to be called.
-      CCreateState                                                createState, //< The CCreateState instance accompanying the handler. Will not be called but will be included in the return value. Can be overridden if a state-change exception was caught while calling the handler.
-      const TEventData* const                                     pEventData,  //< Data accompanying the event, will be provided to the handler.
-      const char* const                                           szType       //< Indicator whether this function is called for the default state or the current state, logging only.
+      const std::string&             strMsg,                  //< Logging accompanying the handler call.
+      const GuardHandlerCreateState& guardHandlerCreateState, //< The handler to be called and the CCreateState instance accompanying it. The CCreateState will not be called but will be included in the return value. It can be overridden if a state-change exception was caught while calling the handler.
+      CState* const                  pState,                  //< The state the handler belongs to, provided to a shared handler.
+      const TEventData* const        pEventData,              //< Data accompanying the event, will be provided to the handler.
+      const char* const              szType,                  //< Indicator whether this function is called for the default state or the current state, logging only.
+      CStateMachineCounters&         counters                 //< Runtime statistics of the state machine.
       )
    {
+      CCreateState createState(TYPESEL::get<2>(guardHandlerCreateState));
+      const bool   bNotice    (CLogLevelScope::IsEnabled(ELogLevelNotice));
       try {
-         LogNotice("%s", strMsg.c_str());
+         if(bNotice) {
+            LogNotice("%s", strMsg.c_str());
+         }
          {
-            CLogIndent logIndent;
-            handler(pEventData);
+            CLogIndent logIndent(CLogLevelScope::IsIndented());
+            RUNTIME_STATS_HANDLER_TIMER(counters);
+            FSharedHandler* const pSharedHandler = TYPESEL::get<4>(guardHandlerCreateState);
+            if(NULL != pSharedHandler) {
+               pSharedHandler(pState, pEventData);
+            } else {
+               TYPESEL::get<1>(guardHandlerCreateState)(pEventData);
+            }
+         }
+         if(bNotice) {
+            LogNotice("Calling handler done\n");
          }
-         LogNotice("Calling handler done\n");
       } catch(CStateChangeException& ex) {
-         LogWarning("State-change caught while calling %s handler: %s\n", szType, ex.what());
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelWarning)) {
+            LogWarning("State-change caught while calling %s handler: %s\n", szType, ex.what());
+         }
          createState = ex.GetCreateState();
       } catch(std::exception& ex) {
-         LogErr("Exception caught while calling %s handler: %s\n", szType, ex.what());
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Exception caught while calling %s handler: %s\n", szType, ex.what());
+         }
          createState = CCreateState(); //remain in this state
       } catch(...) {
-         LogErr("Exception caught while calling %s handler: %s\n", szType, "unknown");
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Exception caught while calling %s handler: %s\n", szType, "unknown");
+         }
          createState = CCreateState(); //remain in this state
       }
       return HandleResult(true, createState);
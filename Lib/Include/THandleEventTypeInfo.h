@@ -23,7 +23,10 @@
 #define __ILULibStateMachine_THandleEventTypeInfo_H__
 
 #include "CCreateState.h"
+#include "CEventBase.h"
 #include "CHandleEventInfoBase.h"
+#include "CState.h"
+#include "CStateMachineStats.h"
 
 namespace ILULibStateMachine {
    /** @brief Template class that allows storing and calling of event-type handlers for one specific event data
@@ -37,17 +40,19 @@ namespace ILULibStateMachine {
    template <class TEventData> class THandleEventTypeInfo : public CHandleEventInfoBase {
       public:
          typedef void                                                FTypeHandler(SPEventBase spEventBase, const TEventData* const); ///< Prototype of a type-event handler: it is provided with the event identifier and the event data.
+         typedef void                                                FSharedTypeHandler(CState* pState, SPEventBase spEventBase, const TEventData* const); ///< Prototype of a shared type-event handler: not bound to a state instance, the state is provided when it is called (see TSharedTypeHandler).
          typedef TYPESEL::function<FTypeHandler>                     BFTypeHandler;                                                  ///< FTypeHandler wrapped in a function, so the event handler can be a class method bound to a class instance.
-         typedef TYPESEL::tuple<BFTypeHandler, CCreateState>         HandlerTypeCreateState;                                         ///< Completely describes on action: handler and state transition.
+         typedef TYPESEL::tuple<BFTypeHandler, CCreateState, FSharedTypeHandler*> HandlerTypeCreateState;                            ///< Completely describes on action: handler (bound or shared) and state transition.
          
       public:
-                                  THandleEventTypeInfo(BFTypeHandler handler, CCreateState createState);
+                                  THandleEventTypeInfo(const BFTypeHandler& handler, CCreateState createState);
+                                  THandleEventTypeInfo(FSharedTypeHandler* handler, CCreateState createState);
 
       public:
-         HandleResult             Handle(const bool bDefaultState, SPEventBase spEventBase, const TEventData* const pEventData);
+         HandleResult             Handle(const bool bDefaultState, CState* const pState, SPEventBase spEventBase, const TEventData* const pEventData, CStateMachineCounters& counters);
 
       private:
-         HandleResult             CallHandler(const std::string& strMsg, TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const pEventData)> handler, CCreateState createState, SPEventBase spEventBase, const TEventData* const pEventData, const char* const szType);
+         HandleResult             CallHandler(const std::string& strMsg, CState* const pState, SPEventBase spEventBase, const TEventData* const pEventData, const char* const szType, CStateMachineCounters& counters);
 
       private:
          HandlerTypeCreateState   m_TypeHandler; ///< Stores the action for this class: handler combined with state transition.
@@ -22,6 +22,7 @@
 #ifndef __ILULibStateMachine_THandleEventTypeInfoImpl_H__
 #define __ILULibStateMachine_THandleEventTypeInfoImpl_H__
 
+#include "CLogLevel.h"
 #include "Logging.h"
 #include "CStateChangeException.h"
 
@@ -30,11 +31,23 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    THandleEventTypeInfo<TEventData>::THandleEventTypeInfo(
-      BFTypeHandler handler,   //< Event handler to be called.
+      const BFTypeHandler& handler, //< Event handler to be called.
       CCreateState createState //< Describes the state transition following this handler. 
       )
       : CHandleEventInfoBase()
-      , m_TypeHandler(HandlerTypeCreateState(handler, createState))
+      , m_TypeHandler(HandlerTypeCreateState(handler, createState, NULL))
+   {
+   }; 
+   
+   /** Constructor setting a shared type handler.
+    **/
+   template <class TEventData> 
+   THandleEventTypeInfo<TEventData>::THandleEventTypeInfo(
+      FSharedTypeHandler* handler,    //< Event handler to be called.
+      CCreateState        createState //< Describes the state transition following this handler. 
+      )
+      : CHandleEventInfoBase()
+      , m_TypeHandler(HandlerTypeCreateState(0, createState, handler))
    {
    }; 
    
@@ -45,24 +58,31 @@ namespace ILULibStateMachine {
    template <class TEventData> 
    CHandleEventInfoBase::HandleResult THandleEventTypeInfo<TEventData>::Handle(
       const bool              bDefaultState, //< Indicator whether this function is called for the default state or the current state, logging only.
+      CState* const           pState,        //< The state the handler belongs to, provided to a shared handler.
       SPEventBase             spEventBase,   //< Event descriptor.
-      const TEventData* const pEventData     //< Data accompanying the event, will be provided to the handler.
+      const TEventData* const pEventData,    //< Data accompanying the event, will be provided to the handler.
+      CStateMachineCounters&  counters       //< Runtime statistics of the state machine.
       )
    {
       const char* const szType = bDefaultState ? "default-state" : "state";;
+      const bool        bNotice(CLogLevelScope::IsEnabled(ELogLevelNotice));
       
-      CLogIndent logIndent;
+      CLogIndent logIndent(CLogLevelScope::IsIndented());
       
       //call the type handler
+      //(the message is only formatted when it is logged)
+      counters.SetGuard(0);
       std::stringstream ss;
-      ss << "Calling " << szType << " type handler\n";
+      if(bNotice) {
+         ss << "Calling " << szType << " type handler\n";
+      }
       return CallHandler(
                          ss.str(),
-                         TYPESEL::get<0>(m_TypeHandler), 
-                         TYPESEL::get<1>(m_TypeHandler), 
+                         pState,
                          spEventBase, 
                          pEventData, 
-                         szType
+                         szType,
+                         counters
                          );
    };
 
@@ -72,29 +92,50 @@ namespace ILULibStateMachine {
     **/
    template <class TEventData> 
    CHandleEventInfoBase::HandleResult THandleEventTypeInfo<TEventData>::CallHandler(
-      const std::string&                                                                   strMsg,      //< Logging accompanying the handler call.
-      TYPESEL::function<void(SPEventBase spEventBase, const TEventData* const pEventData)> handler,     //< The handler to be called.
-      CCreateState                                                                         createState, //< The CCreateState instance accompanying the handler. Will not be called but will be included in the return value. Can be overridden if a state-change exception was caught while calling the handler.
-      SPEventBase                                                                          spEventBase, //< Event descriptor.
-      const TEventData* const                                                              pEventData,  //< Data accompanying the event, will be provided to the handler.
-      const char* const                                                                    szType       //< Indicator whether this function is called for the default state or the current state, logging only.
+      const std::string&      strMsg,      //< Logging accompanying the handler call.
+      CState* const           pState,      //< The state the handler belongs to, provided to a shared handler.
+      SPEventBase             spEventBase, //< Event descriptor.
+      const TEventData* const pEventData,  //< Data accompanying the event, will be provided to the handler.
+      const char* const       szType,      //< Indicator whether this function is called for the default state or the current state, logging only.
+      CStateMachineCounters&  counters     //< Runtime statistics of the state machine.
       )
    {
+      CCreateState createState(TYPESEL::get<1>(m_TypeHandler));
+      const bool   bNotice    (CLogLevelScope::IsEnabled(ELogLevelNotice));
       try {
-         LogNotice("%s", strMsg.c_str());
+         if(bNotice) {
+            LogNotice("%s", strMsg.c_str());
+         }
          {
-            CLogIndent logIndent;
-            handler(spEventBase, pEventData);
+            CLogIndent logIndent(CLogLevelScope::IsIndented());
+            RUNTIME_STATS_HANDLER_TIMER(counters);
+            FSharedTypeHandler* const pSharedHandler = TYPESEL::get<2>(m_TypeHandler);
+            if(NULL != pSharedHandler) {
+               pSharedHandler(pState, spEventBase, pEventData);
+            } else {
+               TYPESEL::get<0>(m_TypeHandler)(spEventBase, pEventData);
+            }
+         }
+         if(bNotice) {
+            LogNotice("Calling type handler done\n");
          }
-         LogNotice("Calling type handler done\n");
       } catch(CStateChangeException& ex) {
-         LogWarning("State-change caught while calling %s type handler: %s\n", szType, ex.what());
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelWarning)) {
+            LogWarning("State-change caught while calling %s type handler: %s\n", szType, ex.what());
+         }
          createState = ex.GetCreateState();
       } catch(std::exception& ex) {
-         LogErr("Exception caught while calling %s type handler: %s\n", szType, ex.what());
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Exception caught while calling %s type handler: %s\n", szType, ex.what());
+         }
          createState = CCreateState(); //remain in this state
       } catch(...) {
-         LogErr("Exception caught while calling %s type handler: %s\n", szType, "unknown");
+         RUNTIME_STATS_ADD(counters, ECounterExceptions, 1);
+         if(CLogLevelScope::IsEnabled(ELogLevelErr)) {
+            LogErr("Exception caught while calling %s type handler: %s\n", szType, "unknown");
+         }
          createState = CCreateState(); //remain in this state
       }
       return HandleResult(true, createState);
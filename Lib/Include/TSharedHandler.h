@@ -0,0 +1,58 @@
+/** @file
+ ** @brief The TSharedHandler template function defintions.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TSharedHandler__H__
+#define __ILULibStateMachine_TSharedHandler__H__
+
+#include "CEventBase.h"
+#include "CState.h"
+
+namespace ILULibStateMachine {
+   /** @brief Templates turning a state class method into a plain function
+    ** that is not bound to a state instance.
+    **
+    ** The state instance is provided by the state machine when the
+    ** function is called. This makes the function usable in handler tables
+    ** shared by all state machines using the state class (see CHandlerTable).
+    ** Use them via the GUARD_SHARED, HANDLER_SHARED and HANDLER_TYPE_SHARED
+    ** macros.
+    **/
+   template<class TEventData, class CStateType, void (CStateType::*Handler)(const TEventData* const)> void TSharedHandler(CState* pState, const TEventData* const pEventData)
+   {
+      (static_cast<CStateType*>(pState)->*Handler)(pEventData);
+   }
+
+   /** Shared variant of a guard, see TSharedHandler.
+    **/
+   template<class TEventData, class CStateType, bool (CStateType::*Guard)(const TEventData* const)> bool TSharedGuard(CState* pState, const TEventData* const pEventData)
+   {
+      return (static_cast<CStateType*>(pState)->*Guard)(pEventData);
+   }
+
+   /** Shared variant of an event-type handler, see TSharedHandler.
+    **/
+   template<class TEventData, class CStateType, void (CStateType::*TypeHandler)(SPEventBase, const TEventData* const)> void TSharedTypeHandler(CState* pState, SPEventBase spEventBase, const TEventData* const pEventData)
+   {
+      (static_cast<CStateType*>(pState)->*TypeHandler)(spEventBase, pEventData);
+   }
+}
+
+#endif //__ILULibStateMachine_TSharedHandler__H__
@@ -0,0 +1,87 @@
+/** @file
+ ** @brief The TStateParent declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_TStateParent__H__
+#define __ILULibStateMachine_TStateParent__H__
+
+#include "CCreateState.h"
+
+namespace ILULibStateMachine {
+   /** @brief Detects whether a state class is a substate: it declares its
+    ** parent state class as TParentState.
+    **
+    ** E.g.
+    **    class CStateIdle : public CStateEvtId {
+    **       public:
+    **          typedef CStateConnected TParentState;
+    **       ...
+    **    };
+    **/
+   template<class CStateType> class THasParentState {
+      private:
+         template<class T> static char Test(typename T::TParentState*);
+         template<class T> static long Test(...);
+
+      public:
+         static const bool value = (sizeof(char) == sizeof(Test<CStateType>(0))); //< true when CStateType declares TParentState.
+   };
+
+   /** @brief The parent chain of a state class, as used by the create-state
+    ** templates (TCreateState, TCreateStateShared, TCreateStateNoData).
+    **
+    ** TRaw selects the raw create function of a state class the same way
+    ** the create-state template does (TRaw::template Get<CStateType>()),
+    ** so a parent is identified by the same function as when it is
+    ** entered as a top-level state.
+    **
+    ** This is the primary template: a top-level state has no parent.
+    **/
+   template<class CStateType, class TRaw, bool bHasParent = THasParentState<CStateType>::value> class TStateParent {
+      public:
+         /** Get the parent of the state class.
+          **
+          ** @return NULL: a top-level state.
+          **/
+         static const CStateParent* Get(void)
+         {
+            return NULL;
+         }
+   };
+
+   /** @brief The parent chain of a substate class: a static CStateParent
+    ** per substate class, built on first use.
+    **/
+   template<class CStateType, class TRaw> class TStateParent<CStateType, TRaw, true> {
+      public:
+         /** Get the parent of the state class.
+          **
+          ** @return the parent.
+          **/
+         static const CStateParent* Get(void)
+         {
+            typedef typename CStateType::TParentState TParent;
+            static const CStateParent s_Parent(TRaw::template Get<TParent>(), TStateParent<TParent, TRaw>::Get());
+            return &s_Parent;
+         }
+   };
+}
+
+#endif //__ILULibStateMachine_TStateParent__H__
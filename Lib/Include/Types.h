@@ -28,6 +28,7 @@
 #  include "boost/bind.hpp"
 #  include "boost/enable_shared_from_this.hpp"
 #  include "boost/function.hpp"
+#  include "boost/make_shared.hpp"
 #  include "boost/shared_ptr.hpp"
 #  include "boost/tuple/tuple.hpp"
 #  include "boost/weak_ptr.hpp"
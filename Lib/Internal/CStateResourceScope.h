@@ -0,0 +1,57 @@
+/** @file
+ ** @brief The CStateResourceScope declaration.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#ifndef __ILULibStateMachine_CStateResourceScope_H__
+#define __ILULibStateMachine_CStateResourceScope_H__
+
+#include "CMemoryResource.h"
+
+namespace ILULibStateMachine {
+   namespace Internal {
+      /** @brief Selects the memory resource CState::operator new allocates
+       ** states from, for the current thread, during the life-time of the
+       ** instance.
+       **
+       ** The state machine creates one around each state construction, so
+       ** states are allocated from its arena without the create state
+       ** functions being aware of it. Scopes nest: the previous resource is
+       ** restored on destruction (e.g. a state constructing a child state
+       ** machine).
+       **/
+      class CStateResourceScope {
+         public:
+                                    CStateResourceScope(CMemoryResource* const pResource);
+                                    ~CStateResourceScope(void);
+
+         public:
+            static CMemoryResource* Get(void);
+
+         private:
+                                    CStateResourceScope(CStateResourceScope& ref); //defined, not implemented --> avoid copy
+            CStateResourceScope     operator=(CStateResourceScope& ref);           //defined, not implemented --> avoid copy
+
+         private:
+            CMemoryResource* const  m_pPrevious; ///< Resource to restore on destruction.
+      };
+   };
+};
+
+#endif //__ILULibStateMachine_CStateResourceScope_H__
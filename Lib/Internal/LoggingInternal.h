@@ -26,19 +26,19 @@
 #ifndef __ILULibStateMachine_LoggingInternal_H__
 #define __ILULibStateMachine_LoggingInternal_H__
 
-#include "Internal/TLog.h"
+#include "Internal/TLogSink.h"
 
 namespace ILULibStateMachine {
    namespace Internal {
-      FLog      RegisterLogDebug   (CFLog      log      = CFLog()     );
-      FLog      RegisterLogInfo    (CFLog      log      = CFLog()     );
-      FLog      RegisterLogNotice  (CFLog      log      = CFLog()     );
-      FLog      RegisterLogWarning (CFLog      log      = CFLog()     );
-      FLog      RegisterLogErr     (CFLog      log      = CFLog()     );
-      FIndent   RegisterLogIndent  (CFIndent   indent   = CFIndent()  );
-      FUnindent RegisterLogUnindent(CFUnindent unindent = CFUnindent());
+      TLogSink<FLog>&      LogSinkDebug   (void);
+      TLogSink<FLog>&      LogSinkInfo    (void);
+      TLogSink<FLog>&      LogSinkNotice  (void);
+      TLogSink<FLog>&      LogSinkWarning (void);
+      TLogSink<FLog>&      LogSinkErr     (void);
+      TLogSink<FIndent>&   LogSinkIndent  (void);
+      TLogSink<FUnindent>& LogSinkUnindent(void);
+      void                 LogConsumersUpdate(void);
    };
 };
 
 #endif //__ILULibStateMachine_LoggingInternal_H__
-
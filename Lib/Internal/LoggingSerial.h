@@ -33,6 +33,11 @@
 
 namespace ILULibStateMachine {
    namespace Internal {
+      extern const std::string strColorReset;
+      extern const std::string strColorFgRed;
+      extern const std::string strColorFgBlue;
+      extern const std::string strColorFgGray;
+
       std::string HandleIndent     (bool bGet = true, bool bIncrement = true);
       void        SerialLogDebug   (const std::string& strLog);
       void        SerialLogInfo    (const std::string& strLog);
@@ -22,38 +22,85 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+#include <vector>
+
+#include "Include/CAllocationStats.h"
+#include "Include/CBinaryLog.h"
+#include "Include/CLogLevel.h"
 #include "Include/Logging.h"
 #include "Internal/LoggingInternal.h"
 #include "Internal/LoggingSerial.h"
-#include "Internal/TLog.h"
 
-#define MSG_BUF_SIZE     (256) ///< set the buffer size for loggings (larger ones will be truncated)
+#define MSG_BUF_SIZE     (256) ///< set the stack buffer size for loggings (larger ones are formatted on the heap)
 
-/** @brief There are 5 log functions with the same body except for 1 parameter.
+/** @brief There are 5 log functions with the same body except for 2 parameters.
  ** This macro avoids copying those bodies.
  **
+ ** When deferred-formatting logging records the level, the message is
+ ** not formatted here (see CBinaryLog).
+ ** A level without a consumer (see CLogLevelScope::IsConsumed) returns
+ ** before formatting, an empty registered function is never called.
+ **
  ** TODO: investigate how this can be accomplished with a template.
  **/
-#define LOGXXX(REG_FUNC) \
-  FLog     flog               (REG_FUNC()); \
-  char     szMsg[MSG_BUF_SIZE]; \
+#define LOGXXX(LEVEL, SINK_FUNC) \
+  if(!CLogLevelScope::IsConsumed(LEVEL)) { \
+     return; \
+  } \
+  ALLOCATION_SCOPE(NULL, EAllocationLogging); \
   va_list  ap                 ; \
   va_start(ap, szFormat); \
-  vsnprintf(szMsg, sizeof(szMsg), szFormat, ap); \
-  va_end(ap); \
-  flog(szMsg);
+  if(!CBinaryLog::IsEnabled(LEVEL) || !CBinaryLog::Record(LEVEL, szFormat, ap)) { \
+     const std::string strMsg(Format(szFormat, ap)); \
+     CLogReadScope     scope; \
+     const FLog&       log(SINK_FUNC().Get()); \
+     if(log) { \
+        log(strMsg); \
+     } \
+  } \
+  va_end(ap);
 
 namespace ILULibStateMachine {
    //use the libraries internal functions (not a part of the interface)
    using namespace Internal;
 
+   namespace {
+      /** Format a message, without limiting its length.
+       **
+       ** @return the formatted message.
+       **/
+      std::string Format(
+         const char* const szFormat, //< Format describing the message.
+         va_list           ap        //< Format arguments (not consumed).
+         )
+      {
+         char    szMsg[MSG_BUF_SIZE];
+         va_list copy;
+         va_copy(copy, ap);
+         const int length(vsnprintf(szMsg, sizeof(szMsg), szFormat, copy));
+         va_end(copy);
+         if(0 > length) {
+            return std::string();
+         }
+         if(static_cast<size_t>(length) < sizeof(szMsg)) {
+            return std::string(szMsg, static_cast<size_t>(length));
+         }
+         std::vector<char> msg(static_cast<size_t>(length) + 1);
+         va_copy(copy, ap);
+         vsnprintf(&msg[0], msg.size(), szFormat, copy);
+         va_end(copy);
+         return std::string(&msg[0], static_cast<size_t>(length));
+      }
+   };
+
    /** Function to be called to register a debug loggings callback function.
     **/
    void RegisterLogDebug(
       FLog log //< Function to be called for debug loggings.
       )
    {
-      RegisterLogDebug(CFLog(log));
+      LogSinkDebug().Set(log);
+      LogConsumersUpdate();
    }
    
    /** Function to be called to register an info loggings callback function.
@@ -62,7 +109,8 @@ namespace ILULibStateMachine {
       FLog log //< Function to be called for info loggings.
       )
    {
-      RegisterLogInfo(CFLog(log));
+      LogSinkInfo().Set(log);
+      LogConsumersUpdate();
    }
    
    /** Function to be called to register a notice loggings callback function.
@@ -71,7 +119,8 @@ namespace ILULibStateMachine {
       FLog log //< Function to be called for notice loggings.
       )
    {
-      RegisterLogNotice(CFLog(log));
+      LogSinkNotice().Set(log);
+      LogConsumersUpdate();
    }
    
    /** Function to be called to register a warninging loggings callback function.
@@ -80,7 +129,8 @@ namespace ILULibStateMachine {
       FLog log //< Function to be called for warninging loggings.
       )
    {
-      RegisterLogWarning(CFLog(log));
+      LogSinkWarning().Set(log);
+      LogConsumersUpdate();
    }
    
    /** Function to be called to register an error loggings callback function.
@@ -89,7 +139,8 @@ namespace ILULibStateMachine {
       FLog log //< Function to be called for error loggings.
       )
    {
-      RegisterLogErr(CFLog(log));
+      LogSinkErr().Set(log);
+      LogConsumersUpdate();
    }
    
    /** Register a function to be called to increase logging indentation.
@@ -98,7 +149,7 @@ namespace ILULibStateMachine {
       FIndent indent //< Function to be called to increase logging indentation.
       )
    {
-      RegisterLogIndent(CFIndent(indent));
+      LogSinkIndent().Set(indent);
    }
 
    /** Register a function to be called to decrease logging indentation.
@@ -107,7 +158,7 @@ namespace ILULibStateMachine {
       FUnindent unindent //< Function to be called to decrease logging indentation.
       )
    {
-      RegisterLogUnindent(CFUnindent(unindent));
+      LogSinkUnindent().Set(unindent);
    }
 
    /** Unregister the debug logging function currently
@@ -117,7 +168,8 @@ namespace ILULibStateMachine {
     **/
    void UnRegisterLogDebug(void)
    {
-      RegisterLogDebug(CFLog(SerialLogDebug));
+      LogSinkDebug().Set(SerialLogDebug);
+      LogConsumersUpdate();
    }
    
    /** Unregister the info logging function currently
@@ -127,7 +179,8 @@ namespace ILULibStateMachine {
     **/
    void UnRegisterLogInfo(void)
    {
-      RegisterLogInfo(CFLog(SerialLogInfo));
+      LogSinkInfo().Set(SerialLogInfo);
+      LogConsumersUpdate();
    }
    
    /** Unregister the info logging function currently
@@ -137,7 +190,8 @@ namespace ILULibStateMachine {
     **/
    void UnRegisterLogNotice(void)
    {
-      RegisterLogNotice(CFLog(SerialLogNotice));
+      LogSinkNotice().Set(SerialLogNotice);
+      LogConsumersUpdate();
    }
    
    /** Unregister the warninging logging function currently
@@ -147,7 +201,8 @@ namespace ILULibStateMachine {
     **/
    void UnRegisterLogWarning(void)
    {
-      RegisterLogWarning(CFLog(SerialLogWarning));
+      LogSinkWarning().Set(SerialLogWarning);
+      LogConsumersUpdate();
    }
    
    /** Unregister the error logging function currently
@@ -157,28 +212,30 @@ namespace ILULibStateMachine {
     **/
    void UnRegisterLogErr(void)
    {
-      RegisterLogErr(CFLog(SerialLogErr));
+      LogSinkErr().Set(SerialLogErr);
+      LogConsumersUpdate();
    }
 
    /** Unregister the indentation increase function.
     **/
    void UnRegisterLogIndent(void)
    {
-      RegisterLogIndent(CFIndent(SerialLogIndent));
+      LogSinkIndent().Set(SerialLogIndent);
    }
    
    /** Unregister the indentation decrease function.
     **/
    void UnRegisterLogUnindent(void)
    {
-      RegisterLogUnindent(CFUnindent(SerialLogUnindent));
+      LogSinkUnindent().Set(SerialLogUnindent);
    }
 
    /** Register the standard serial debug logging function.
     **/
    void EnableSerialLogDebug (void)
    {
-      RegisterLogDebug(CFLog(SerialLogDebug));
+      LogSinkDebug().Set(SerialLogDebug);
+      LogConsumersUpdate();
    }
 
    /** Generate a debug logging.
@@ -188,7 +245,7 @@ namespace ILULibStateMachine {
                  ...                         //< Format arguments
       )
    {
-      LOGXXX(RegisterLogDebug);
+      LOGXXX(ELogLevelDebug, LogSinkDebug);
    }
 
    /** Generate a info logging.
@@ -198,7 +255,7 @@ namespace ILULibStateMachine {
                 ...                         //< Format arguments
       )
    {
-      LOGXXX(RegisterLogInfo);
+      LOGXXX(ELogLevelInfo, LogSinkInfo);
    }
 
    /** Generate a notice logging.
@@ -208,7 +265,7 @@ namespace ILULibStateMachine {
                   ...                         //< Format arguments
       )
    {
-      LOGXXX(RegisterLogNotice);
+      LOGXXX(ELogLevelNotice, LogSinkNotice);
    }
 
    /** Generate a warninging logging.
@@ -218,7 +275,7 @@ namespace ILULibStateMachine {
                    ...                         //< Format arguments
                    )
    {
-      LOGXXX(RegisterLogWarning);
+      LOGXXX(ELogLevelWarning, LogSinkWarning);
    }
 
    /** Generate an error logging.
@@ -228,23 +285,31 @@ namespace ILULibStateMachine {
                ...                         //< Format arguments
       )
    {
-      LOGXXX(RegisterLogErr);
+      LOGXXX(ELogLevelErr, LogSinkErr);
    }
 
    /** Request to increase the logging indentation.
     **/
    void LogIndent(void)
    {
-      FIndent findent = RegisterLogIndent();
-      findent();
+      ALLOCATION_SCOPE(NULL, EAllocationLogging);
+      if(CBinaryLog::IsRunning() && CBinaryLog::RecordIndent(true)) {
+         return;
+      }
+      CLogReadScope scope;
+      LogSinkIndent().Get()();
    }
 
    /** Request to decrease the logging indentation.
     **/
    void LogUnindent(void)
    {
-      FIndent findent = RegisterLogUnindent();
-      findent();
+      ALLOCATION_SCOPE(NULL, EAllocationLogging);
+      if(CBinaryLog::IsRunning() && CBinaryLog::RecordIndent(false)) {
+         return;
+      }
+      CLogReadScope scope;
+      LogSinkUnindent().Get()();
    }
 };
 
@@ -0,0 +1,452 @@
+/** @file
+ ** @brief The asynchronous serial logging functions definition.
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ** The ring buffer is a bounded multi-producer queue: every slot carries a
+ ** sequence number telling whether it is free for the producer of a given
+ ** position or filled for the consumer (the background thread).
+ ** Producers reserve a position with 1 compare-and-swap, the consumer is
+ ** the only one advancing the read position.
+ **/
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Include/LoggingAsync.h"
+#include "Internal/LoggingSerial.h"
+
+namespace ILULibStateMachine {
+   //use the libraries internal functions (not a part of the interface)
+   using namespace Internal;
+
+   namespace {
+      /** Maximum number of messages written by 1 'writev' call.
+       **/
+      const size_t BATCH_SIZE = 64;
+
+      /** Number of bytes reserved per slot upon start, longer messages
+       ** allocate when copied into the slot.
+       **/
+      const size_t SLOT_RESERVE = 256;
+
+      /** @brief 1 message in the ring buffer.
+       **/
+      class CSlot {
+         public:
+            CSlot(void)
+               : m_Sequence(0)
+               , m_Fd      (STDOUT_FILENO)
+               , m_Msg     ()
+            {
+            }
+
+            CSlot(const CSlot& ref)
+               : m_Sequence(ref.m_Sequence.load())
+               , m_Fd      (ref.m_Fd             )
+               , m_Msg     (ref.m_Msg            )
+            {
+            }
+
+         public:
+            std::atomic<size_t> m_Sequence; ///< Position + 1 when filled, position when free for the producer of that position.
+            int                 m_Fd;       ///< File descriptor to write the message to.
+            std::string         m_Msg;      ///< The message, color and indentation included.
+      };
+
+      /** Protects starting and stopping, and the sleeping consumer.
+       **/
+      std::mutex                      s_Mutex;
+
+      /** Wakes up the consumer.
+       **/
+      std::condition_variable         s_Wakeup;
+
+      /** The ring buffer (the size is a power of 2).
+       **/
+      std::vector<CSlot>              s_Slots;
+
+      /** s_Slots.size() - 1.
+       **/
+      size_t                          s_Mask = 0;
+
+      /** The overflow policy.
+       **/
+      EAsyncLogOverflow               s_Overflow = EAsyncLogOverflowDrop;
+
+      /** The consumer.
+       **/
+      std::thread                     s_Thread;
+
+      /** Producers use the ring buffer.
+       **/
+      std::atomic<bool>               s_bRunning(false);
+
+      /** The consumer finishes once the ring buffer is empty.
+       **/
+      std::atomic<bool>               s_bStop(false);
+
+      /** The consumer waits for messages.
+       **/
+      std::atomic<bool>               s_bSleeping(false);
+
+      /** Number of producers using the ring buffer right now.
+       **/
+      std::atomic<unsigned int>       s_Users(0);
+
+      /** Next position to be reserved by a producer.
+       **/
+      std::atomic<size_t>             s_EnqueuePos(0);
+
+      /** Next position to be written by the consumer.
+       **/
+      std::atomic<size_t>             s_DequeuePos(0);
+
+      /** Messages dropped because the ring buffer was full.
+       **/
+      std::atomic<unsigned long long> s_Dropped(0);
+
+      /** Messages written by the consumer.
+       **/
+      std::atomic<unsigned long long> s_Written(0);
+
+      /** Wake up the consumer when it is sleeping.
+       **/
+      void WakeUp(void)
+      {
+         if(s_bSleeping.load()) {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Wakeup.notify_one();
+         }
+      }
+
+      /** Write all buffers, retrying on partial writes and interrupts.
+       **
+       ** Gives up on any other error: the messages are lost.
+       **/
+      void WriteAll(
+         const int    fd,    //< File descriptor.
+         struct iovec iov[], //< The buffers (modified).
+         size_t       count  //< Number of buffers.
+         )
+      {
+         struct iovec* pIov(iov);
+         while(0 < count) {
+            const ssize_t written(writev(fd, pIov, static_cast<int>(count)));
+            if(0 > written) {
+               if(EINTR == errno) {
+                  continue;
+               }
+               return;
+            }
+            size_t left(static_cast<size_t>(written));
+            while(0 < count && left >= pIov->iov_len) {
+               left -= pIov->iov_len;
+               ++pIov;
+               --count;
+            }
+            if(0 < count) {
+               pIov->iov_base  = static_cast<char*>(pIov->iov_base) + left;
+               pIov->iov_len  -= left;
+            }
+         }
+      }
+
+      /** Write the filled slots following the read position with the same
+       ** file descriptor (at most BATCH_SIZE) and free them.
+       **
+       ** @return the number of messages written.
+       **/
+      size_t WriteBatch(void)
+      {
+         const size_t pos(s_DequeuePos.load(std::memory_order_relaxed));
+         struct iovec iov[BATCH_SIZE];
+         size_t       count(0);
+         int          fd   (STDOUT_FILENO);
+         for( ; count < BATCH_SIZE ; ++count) {
+            CSlot& slot(s_Slots[(pos + count) & s_Mask]);
+            if(pos + count + 1 != slot.m_Sequence.load()) {
+               break;
+            }
+            if(0 == count) {
+               fd = slot.m_Fd;
+            } else if(fd != slot.m_Fd) {
+               break;
+            }
+            iov[count].iov_base = const_cast<char*>(slot.m_Msg.data());
+            iov[count].iov_len  = slot.m_Msg.size();
+         }
+         if(0 == count) {
+            return 0;
+         }
+         WriteAll(fd, iov, count);
+         for(size_t i = 0 ; i < count ; ++i) {
+            s_Slots[(pos + i) & s_Mask].m_Sequence.store(pos + i + s_Mask + 1, std::memory_order_release);
+         }
+         s_DequeuePos.store(pos + count);
+         s_Written.store(s_Written.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+         return count;
+      }
+
+      /** The consumer: write batches until stopped and the ring buffer is empty.
+       **/
+      void Consume(void)
+      {
+         for(;;) {
+            if(0 != WriteBatch()) {
+               continue;
+            }
+            std::unique_lock<std::mutex> lock(s_Mutex);
+            s_bSleeping.store(true);
+            const size_t pos(s_DequeuePos.load(std::memory_order_relaxed));
+            if(pos + 1 != s_Slots[pos & s_Mask].m_Sequence.load()) {
+               if(s_bStop.load()) {
+                  s_bSleeping.store(false);
+                  return;
+               }
+               s_Wakeup.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            s_bSleeping.store(false);
+         }
+      }
+
+      /** Copy a message into the ring buffer.
+       **
+       ** @return false when the message was dropped.
+       **/
+      bool Push(
+         const int          fd,       //< File descriptor to write the message to.
+         const std::string& strColor, //< Color set before the message.
+         const std::string& strLog,   //< The message.
+         const std::string& strReset  //< Appended after the message (empty or a color reset).
+         )
+      {
+         size_t pos(s_EnqueuePos.load(std::memory_order_relaxed));
+         CSlot* pSlot(NULL);
+         for(;;) {
+            pSlot = &s_Slots[pos & s_Mask];
+            const size_t seq(pSlot->m_Sequence.load(std::memory_order_acquire));
+            if(seq == pos) {
+               if(s_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                  break;
+               }
+            } else if(seq < pos) {
+               //full
+               if(EAsyncLogOverflowDrop == s_Overflow) {
+                  s_Dropped.fetch_add(1, std::memory_order_relaxed);
+                  return false;
+               }
+               WakeUp();
+               std::this_thread::yield();
+               pos = s_EnqueuePos.load(std::memory_order_relaxed);
+            } else {
+               pos = s_EnqueuePos.load(std::memory_order_relaxed);
+            }
+         }
+         pSlot->m_Fd = fd;
+         pSlot->m_Msg.assign(strColor);
+         pSlot->m_Msg.append(HandleIndent());
+         pSlot->m_Msg.append(strLog);
+         pSlot->m_Msg.append(strReset);
+         pSlot->m_Sequence.store(pos + 1);
+         WakeUp();
+         return true;
+      }
+
+      /** Log a message through the ring buffer, or synchronously when the
+       ** consumer is not running.
+       **/
+      void Log(
+         const int          fd,        //< File descriptor to write the message to.
+         const std::string& strColor,  //< Color set before the message.
+         const std::string& strLog,    //< The message.
+         const std::string& strReset,  //< Appended after the message (empty or a color reset).
+         void (*serial)(const std::string&) //< Synchronous logging function.
+         )
+      {
+         s_Users.fetch_add(1);
+         if(s_bRunning.load()) {
+            Push(fd, strColor, strLog, strReset);
+            s_Users.fetch_sub(1);
+            return;
+         }
+         s_Users.fetch_sub(1);
+         serial(strLog);
+      }
+
+      /** Exit handler: write the buffered messages.
+       **/
+      void FlushOnExit(void)
+      {
+         StopAsyncLog();
+      }
+   };
+
+   /** Start the background thread writing the messages logged by the
+    ** AsyncSerialLog* functions.
+    **
+    ** When already running, it is stopped first (writing the buffered
+    ** messages). Not to be called concurrently with StopAsyncLog.
+    **/
+   void StartAsyncLog(
+      const size_t            capacity, //< Number of messages the ring buffer can hold (rounded up to a power of 2).
+      const EAsyncLogOverflow overflow  //< What to do with a message when the ring buffer is full.
+      )
+   {
+      static bool s_bExitHandler(false);
+      StopAsyncLog();
+
+      //what was logged synchronously comes first
+      std::cout.flush();
+      std::cerr.flush();
+
+      size_t size(1);
+      while(size < capacity) {
+         size <<= 1;
+      }
+      s_Slots.clear();
+      s_Slots.resize(size);
+      for(size_t i = 0 ; i < size ; ++i) {
+         s_Slots[i].m_Sequence.store(i, std::memory_order_relaxed);
+         s_Slots[i].m_Msg.reserve(SLOT_RESERVE);
+      }
+      s_Mask     = size - 1;
+      s_Overflow = overflow;
+      s_EnqueuePos.store(0);
+      s_DequeuePos.store(0);
+      s_bStop.store(false);
+      s_Thread   = std::thread(Consume);
+      s_bRunning.store(true);
+      if(!s_bExitHandler) {
+         s_bExitHandler = true;
+         atexit(FlushOnExit);
+      }
+   }
+
+   /** Stop the background thread after it has written the buffered messages.
+    **
+    ** From now on the AsyncSerialLog* functions log synchronously.
+    **/
+   void StopAsyncLog(void)
+   {
+      if(!s_Thread.joinable()) {
+         return;
+      }
+      s_bRunning.store(false);
+      while(0 != s_Users.load()) {
+         std::this_thread::yield();
+      }
+      {
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         s_bStop.store(true);
+         s_Wakeup.notify_one();
+      }
+      s_Thread.join();
+   }
+
+   /** Wait until all messages logged so far are written.
+    **/
+   void FlushAsyncLog(void)
+   {
+      if(!s_bRunning.load()) {
+         return;
+      }
+      const size_t pos(s_EnqueuePos.load());
+      while(s_DequeuePos.load() < pos) {
+         {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Wakeup.notify_one();
+         }
+         std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+   }
+
+   /** Get the number of messages dropped because the ring buffer was full.
+    **
+    ** @return the number of dropped messages since the program started.
+    **/
+   unsigned long long GetAsyncLogDropped(void)
+   {
+      return s_Dropped.load(std::memory_order_relaxed);
+   }
+
+   /** Get the number of messages written by the background thread.
+    **
+    ** @return the number of written messages since the program started.
+    **/
+   unsigned long long GetAsyncLogWritten(void)
+   {
+      return s_Written.load(std::memory_order_relaxed);
+   }
+
+   /** Log the string asynchronously to the console in the defined debug color.
+    **/
+   void AsyncSerialLogDebug(
+      const std::string& strLog //< String that will be logged.
+      )
+   {
+      Log(STDOUT_FILENO, strColorFgGray, strLog, strColorReset, SerialLogDebug);
+   }
+
+   /** Log the string asynchronously to the console in the defined info color.
+    **/
+   void AsyncSerialLogInfo(
+      const std::string& strLog //< String that will be logged.
+      )
+   {
+      static const std::string strNone;
+      Log(STDOUT_FILENO, strColorReset, strLog, strNone, SerialLogInfo);
+   }
+
+   /** Log the string asynchronously to the console in the defined notice color.
+    **/
+   void AsyncSerialLogNotice(
+      const std::string& strLog //< String that will be logged.
+      )
+   {
+      static const std::string strNone;
+      Log(STDOUT_FILENO, strColorReset, strLog, strNone, SerialLogNotice);
+   }
+
+   /** Log the string asynchronously to the console in the defined warning color.
+    **/
+   void AsyncSerialLogWarning(
+      const std::string& strLog //< String that will be logged.
+      )
+   {
+      Log(STDOUT_FILENO, strColorFgBlue, strLog, strColorReset, SerialLogWarning);
+   }
+
+   /** Log the string asynchronously to the console in the defined error color.
+    **/
+   void AsyncSerialLogErr(
+      const std::string& strLog //< String that will be logged.
+      )
+   {
+      Log(STDERR_FILENO, strColorFgRed, strLog, strColorReset, SerialLogErr);
+   }
+};
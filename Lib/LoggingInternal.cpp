@@ -19,135 +19,228 @@
  ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  **
  **/
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Include/CBinaryLog.h"
+#include "Include/CLogLevel.h"
 #include "Internal/LoggingInternal.h"
 #include "Internal/LoggingSerial.h"
 
 namespace ILULibStateMachine {
    namespace {
-     void LogNone(const std::string&)
-      {
-      }
+      /** Serializes the grace periods, a reader is not deleted during a grace period.
+       **/
+      std::mutex                             s_SyncMutex;
+
+      /** Protects the readers and the deferred deleters (never held while waiting).
+       **/
+      std::mutex                             s_Mutex;
+
+      /** The threads that have read a registered function.
+       **/
+      std::vector<Internal::CLogReader*>     s_Readers;
+
+      /** Replaced functions to be deleted after the next grace period.
+       **/
+      std::vector<Internal::FDeleter>        s_Deferred;
+
+      /** The reader of the calling thread (trivially destructible: it can
+       ** be used after the holder has been destructed, e.g. logging from
+       ** the destructor of a static object).
+       **/
+      thread_local Internal::CLogReader*     tl_pReader = NULL;
+
+      /** The holder of the reader of the calling thread has been destructed.
+       **/
+      thread_local bool                      tl_bReaderReleased = false;
+
+      /** @brief Unregisters and deletes the reader of a thread when the thread exits.
+       **/
+      class CLogReaderHolder {
+         public:
+            ~CLogReaderHolder(void)
+            {
+               std::lock_guard<std::mutex> syncLock(s_SyncMutex);
+               std::lock_guard<std::mutex> lock    (s_Mutex);
+               for(std::vector<Internal::CLogReader*>::iterator it = s_Readers.begin() ; s_Readers.end() != it ; ++it) {
+                  if(tl_pReader == *it) {
+                     s_Readers.erase(it);
+                     break;
+                  }
+               }
+               delete tl_pReader;
+               tl_pReader         = NULL;
+               tl_bReaderReleased = true;
+            }
+
+         public:
+            void Use(void)
+            {
+            }
+      };
+
+      /** The holder of the reader of the calling thread.
+       **/
+      thread_local CLogReaderHolder          tl_ReaderHolder;
    };
 
    namespace Internal {
-      /** Get/set the registered debug loggings callback function.
-       **
-       ** When CFLog indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+      /** The epoch, incremented by every grace period.
        **/
-      FLog RegisterLogDebug(
-         CFLog log //< Wraps an embedded logging callback function.
-         )
+      std::atomic<uint64_t> CLogRcu::s_Epoch(1);
+
+      /** Constructor.
+       **/
+      CLogReader::CLogReader(void)
+         : m_Epoch  (0)
+         , m_Nesting(0)
       {
-         static FLog s_FLog(LogNone);
-         if(log.IsSet()) {
-            s_FLog = log.Get();
-         }
-         return s_FLog;
       }
 
-      /** Get/set the registered info loggings callback function.
+      /** Get the reader of the calling thread, registering it upon first use.
        **
-       ** When CFLog indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+       ** @return the reader.
        **/
-      FLog RegisterLogInfo(
-         CFLog log //< Wraps an embedded logging callback function.
-         )
+      CLogReader& CLogRcu::GetReader(void)
       {
-         static FLog s_FLog(SerialLogInfo);
-         if(log.IsSet()) {
-            s_FLog = log.Get();
+         if(NULL == tl_pReader) {
+            CLogReader* const pReader(new CLogReader());
+            if(!tl_bReaderReleased) {
+               //thread exit deletes it (once the holder is destructed a reader is never deleted)
+               tl_ReaderHolder.Use();
+            }
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Readers.push_back(pReader);
+            tl_pReader = pReader;
          }
-         return s_FLog;
+         return *tl_pReader;
       }
 
-      /** Get/set the registered notice loggings callback function.
+      /** Wait until every reader that could be using a replaced function
+       ** has left its scope, then run the deferred deleters.
        **
-       ** When CFLog indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+       ** @return false when called in a CLogReadScope (the calling thread
+       ** could be using the replaced function): nothing was waited for.
        **/
-      FLog RegisterLogNotice(
-         CFLog log //< Wraps an embedded logging callback function.
-         )
+      bool CLogRcu::Synchronize(void)
       {
-         static FLog s_FLog(SerialLogNotice);
-         if(log.IsSet()) {
-            s_FLog = log.Get();
+         if(NULL != tl_pReader && 0 != tl_pReader->m_Nesting) {
+            return false;
          }
-         return s_FLog;
+         std::vector<FDeleter> deferred;
+         {
+            std::lock_guard<std::mutex> syncLock(s_SyncMutex);
+            std::vector<CLogReader*>    readers;
+            {
+               //only the functions replaced before the epoch changes are deleted
+               std::lock_guard<std::mutex> lock(s_Mutex);
+               deferred.swap(s_Deferred);
+               readers = s_Readers;
+            }
+            const uint64_t epoch(s_Epoch.fetch_add(1) + 1);
+            for(std::vector<CLogReader*>::const_iterator cit = readers.begin() ; readers.end() != cit ; ++cit) {
+               for(;;) {
+                  const uint64_t readerEpoch((*cit)->m_Epoch.load());
+                  if(0 == readerEpoch || epoch <= readerEpoch) {
+                     break;
+                  }
+                  std::this_thread::yield();
+               }
+            }
+         }
+         for(std::vector<FDeleter>::iterator it = deferred.begin() ; deferred.end() != it ; ++it) {
+            (*it)();
+         }
+         return true;
       }
 
-      /** Get/set the registered warninging loggings callback function.
-       **
-       ** When CFLog indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+      /** Delete a replaced function after the next grace period.
        **/
-      FLog RegisterLogWarning(
-         CFLog log //< Wraps an embedded logging callback function.
+      void CLogRcu::Defer(
+         FDeleter deleter //< Deletes the function.
          )
       {
-         static FLog s_FLog(SerialLogWarning);
-         if(log.IsSet()) {
-            s_FLog = log.Get();
-         }
-         return s_FLog;
+         std::lock_guard<std::mutex> lock(s_Mutex);
+         s_Deferred.push_back(deleter);
       }
 
-      /** Get/set the registered error loggings callback function.
+      /** Get the registered debug loggings callback function.
        **
-       ** When CFLog indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+       ** Empty until EnableSerialLogDebug or RegisterLogDebug: the debug
+       ** loggings are disabled.
        **/
-      FLog RegisterLogErr(
-         CFLog log //< Wraps an embedded logging callback function.
-         )
+      TLogSink<FLog>& LogSinkDebug(void)
       {
-         static FLog s_FLog(SerialLogErr);
-         if(log.IsSet()) {
-            s_FLog = log.Get();
-         }
-         return s_FLog;
+         static TLogSink<FLog> s_Sink((FLog()));
+         return s_Sink;
       }
 
-      /** Get/set the registered increase indentation function.
-       **
-       ** When CFIndent indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+      /** Get the registered info loggings callback function.
        **/
-      FIndent RegisterLogIndent(
-         CFIndent indent //< Wraps an embedded increase indentation logging callback function.
-         )
+      TLogSink<FLog>& LogSinkInfo(void)
       {
-         static FIndent s_FIndent(SerialLogIndent);
-         if(indent.IsSet()) {
-            s_FIndent = indent.Get();
-         }
-         return s_FIndent;
+         static TLogSink<FLog> s_Sink((FLog(SerialLogInfo)));
+         return s_Sink;
       }
 
-      /** Get/set the registered decrease indentation function.
-       **
-       ** When CFIndent indicates it has an embedded funtion, the registered function
-       ** is updated.
-       ** In any case the registered function is returned.
+      /** Get the registered notice loggings callback function.
        **/
-      FUnindent RegisterLogUnindent(
-         CFUnindent unindent //< Wraps an embedded increase indentation logging callback function.
-         )
+      TLogSink<FLog>& LogSinkNotice(void)
       {
-         static FUnindent s_FUnindent(SerialLogUnindent);
-         if(unindent.IsSet()) {
-            s_FUnindent = unindent.Get();
+         static TLogSink<FLog> s_Sink((FLog(SerialLogNotice)));
+         return s_Sink;
+      }
+
+      /** Get the registered warninging loggings callback function.
+       **/
+      TLogSink<FLog>& LogSinkWarning(void)
+      {
+         static TLogSink<FLog> s_Sink((FLog(SerialLogWarning)));
+         return s_Sink;
+      }
+
+      /** Get the registered error loggings callback function.
+       **/
+      TLogSink<FLog>& LogSinkErr(void)
+      {
+         static TLogSink<FLog> s_Sink((FLog(SerialLogErr)));
+         return s_Sink;
+      }
+
+      /** Get the registered increase indentation function.
+       **/
+      TLogSink<FIndent>& LogSinkIndent(void)
+      {
+         static TLogSink<FIndent> s_Sink((FIndent(SerialLogIndent)));
+         return s_Sink;
+      }
+
+      /** Get the registered decrease indentation function.
+       **/
+      TLogSink<FUnindent>& LogSinkUnindent(void)
+      {
+         static TLogSink<FUnindent> s_Sink((FUnindent(SerialLogUnindent)));
+         return s_Sink;
+      }
+
+      /** Recompute the levels with a consumer (see
+       ** CLogLevelScope::IsConsumed): a registered logging function or
+       ** deferred-formatting logging (see CBinaryLog).
+       **/
+      void LogConsumersUpdate(void)
+      {
+         static std::mutex           s_ConsumersMutex;
+         std::lock_guard<std::mutex> lock(s_ConsumersMutex);
+         TLogSink<FLog>* const       sinks[ELogLevelCount] = {&LogSinkDebug(), &LogSinkInfo(), &LogSinkNotice(), &LogSinkWarning(), &LogSinkErr()};
+         unsigned int                consumers(0);
+         for(unsigned int level = 0 ; level < ELogLevelCount ; ++level) {
+            if(sinks[level]->IsConsumer() || CBinaryLog::IsEnabled(static_cast<ELogLevel>(level))) {
+               consumers |= (1u << level);
+            }
          }
-         return s_FUnindent;
+         CLogLevelScope::SetConsumers(consumers);
       }
    };
 };
-
@@ -0,0 +1,68 @@
+/** @file
+ ** @brief Trace dump decoder tool
+ **
+ ** ILUStateMachine is a library implementing a generic state machine engine.
+ ** Copyright (C) 2018 Ivo Luyckx
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with this program; if not, write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ **/
+#include "CTraceDecoder.h"
+using namespace ILULibStateMachine;
+
+#include "cstdio"
+#include "cstring"
+#include "fstream"
+#include "iostream"
+
+/****************************************************************************************
+ ** 
+ ** Decode a state machine trace dump (see CTrace::Dump) to stdout.
+ **
+ ** Usage: StateMachineTraceDecode [--chrome] <dump>
+ ** --chrome: write a Chrome trace (chrome://tracing, Perfetto) instead of text.
+ **
+ ***************************************************************************************/
+int main (int argc, char* argv[])
+{
+   CTraceDecoder::EFormat format(CTraceDecoder::EFormatText);
+   const char*            szFile(NULL);
+   for(int i = 1 ; i < argc ; ++i) {
+      if(0 == strcmp("--chrome", argv[i])) {
+         format = CTraceDecoder::EFormatChrome;
+      } else if(NULL == szFile) {
+         szFile = argv[i];
+      } else {
+         szFile = NULL;
+         break;
+      }
+   }
+   if(NULL == szFile) {
+      fprintf(stderr, "usage: %s [--chrome] <dump>\n", argv[0]);
+      return 2;
+   }
+
+   std::ifstream in(szFile, std::ios::in | std::ios::binary);
+   if(!in) {
+      fprintf(stderr, "cannot open [%s]\n", szFile);
+      return 1;
+   }
+   std::string strError;
+   if(!CTraceDecoder::Decode(in, std::cout, format, strError)) {
+      fprintf(stderr, "cannot decode [%s]: %s\n", szFile, strError.c_str());
+      return 1;
+   }
+   return 0;
+}